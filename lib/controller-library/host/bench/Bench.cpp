@@ -0,0 +1,107 @@
+/**
+ * Bench.cpp
+ */
+
+#include "Bench.h"
+
+#include <stdio.h>
+#include <string.h>
+
+Bench::Bench(int argc, char **argv) : _quick(false)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--quick") == 0)
+        {
+            _quick = true;
+        }
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+        {
+            _jsonPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            _filter = argv[++i];
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--quick] [--json FILE] [--filter SUBSTRING]\n", argv[0]);
+            exit(2);
+        }
+    }
+}
+
+bool Bench::selected(const std::string &name) const
+{
+    return _filter.empty() || name.find(_filter) != std::string::npos;
+}
+
+Bench::Result &Bench::find(const std::string &name)
+{
+    for (Result &r : _results)
+    {
+        if (r.name == name)
+        {
+            return r;
+        }
+    }
+    _results.push_back(Result{name, 0, 0.0, {}});
+    return _results.back();
+}
+
+void Bench::record(const std::string &name, uint64_t iterations, double nsPerOp)
+{
+    Result &r = find(name);
+    r.iterations = iterations;
+    r.nsPerOp = nsPerOp;
+}
+
+void Bench::counter(const std::string &name, const std::string &key, double value)
+{
+    if (selected(name))
+    {
+        find(name).counters[key] = value;
+    }
+}
+
+int Bench::finish()
+{
+    printf("%-44s %12s %12s  %s\n", "benchmark", "iterations", "ns/op", "counters");
+    for (const Result &r : _results)
+    {
+        printf("%-44s %12llu %12.1f ", r.name.c_str(), (unsigned long long)r.iterations, r.nsPerOp);
+        for (const auto &c : r.counters)
+        {
+            printf(" %s=%g", c.first.c_str(), c.second);
+        }
+        printf("\n");
+    }
+
+    if (_jsonPath.empty())
+    {
+        return 0;
+    }
+
+    FILE *f = fopen(_jsonPath.c_str(), "w");
+    if (f == NULL)
+    {
+        perror(_jsonPath.c_str());
+        return 1;
+    }
+    fprintf(f, "{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < _results.size(); i++)
+    {
+        const Result &r = _results[i];
+        fprintf(f, "    {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.2f, \"counters\": {",
+                r.name.c_str(), (unsigned long long)r.iterations, r.nsPerOp);
+        size_t n = 0;
+        for (const auto &c : r.counters)
+        {
+            fprintf(f, "%s\"%s\": %.17g", n++ ? ", " : "", c.first.c_str(), c.second);
+        }
+        fprintf(f, "}}%s\n", i + 1 < _results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+    return 0;
+}
@@ -0,0 +1,98 @@
+/**
+ * Bench.h
+ *
+ * Minimal benchmark runner for the host build.
+ *
+ * Each benchmark reports wall time per operation, which depends on the PC, and optional
+ * counters (SPI bytes, pixels, address windows, ...), which are deterministic and are what
+ * the regression check in tools/bench_compare.py compares against bench/baseline.json.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+class Bench
+{
+public:
+    Bench(int argc, char **argv);
+
+    /**
+     * @brief Time @p body, which must perform exactly @p iterations operations when called
+     *        with that count.
+     *
+     * The body is first run once with a small count to warm caches. In --quick mode the
+     * iteration count is divided by 20.
+     */
+    template <typename Body>
+    void run(const std::string &name, uint64_t iterations, Body body)
+    {
+        if (!selected(name))
+        {
+            return;
+        }
+        if (_quick)
+        {
+            iterations = iterations / 20 > 0 ? iterations / 20 : 1;
+        }
+        body(iterations < 16 ? iterations : 16);
+
+        auto start = std::chrono::steady_clock::now();
+        body(iterations);
+        auto end = std::chrono::steady_clock::now();
+
+        double ns = std::chrono::duration<double, std::nano>(end - start).count();
+        record(name, iterations, ns / iterations);
+    }
+
+    /**
+     * @brief Attach a deterministic counter to a benchmark, measured per operation.
+     */
+    void counter(const std::string &name, const std::string &key, double value);
+
+    /**
+     * @brief Print the results table and write the JSON file if --json was given.
+     * @return Process exit code
+     */
+    int finish();
+
+    bool selected(const std::string &name) const;
+
+private:
+    struct Result
+    {
+        std::string name;
+        uint64_t iterations;
+        double nsPerOp;
+        std::map<std::string, double> counters;
+    };
+
+    void record(const std::string &name, uint64_t iterations, double nsPerOp);
+    Result &find(const std::string &name);
+
+    std::vector<Result> _results;
+    std::string _jsonPath;
+    std::string _filter;
+    bool _quick;
+};
+
+/* Heap allocations (malloc, calloc, realloc) made by library and shim code so far */
+uint64_t heapAllocations();
+
+/* One per source file in bench/ */
+void benchScheduler(Bench &bench);
+void benchESP32(Bench &bench);
+void benchSD(Bench &bench);
+void benchLog(Bench &bench);
+void benchLCD(Bench &bench);
+void benchTime(Bench &bench);
+void benchFormat(Bench &bench);
+void benchTelemetry(Bench &bench);
+void benchSPI(Bench &bench);
+
+#endif // BENCH_H
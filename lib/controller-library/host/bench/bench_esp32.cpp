@@ -0,0 +1,81 @@
+/**
+ * bench_esp32.cpp
+ *
+ * FEHESP32::handleMessage() for each frame type the driver sees regularly, and a mix.
+ */
+
+#include <Arduino.h>
+#include "FEHESP32.h"
+#include "HostHardware.h"
+#include "Bench.h"
+
+#define FRAME_LEN 48
+
+static uint32_t s_rcsBytes;
+
+static void rcsCallback(const uint8_t *data, uint8_t len)
+{
+    s_rcsBytes += len + data[0];
+}
+
+struct Frame
+{
+    const char *name;
+    uint8_t data[FRAME_LEN];
+};
+
+static Frame makeFrame(const char *name, uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    Frame f = {name, {0xAA, 0x55, cmd, len}};
+    memcpy(&f.data[4], payload, len);
+    return f;
+}
+
+void benchESP32(Bench &bench)
+{
+    static const uint8_t ack[] = {CMD_PING};
+    static const uint8_t pong[] = {1, 2, 3, PARTITION_OTA_0};
+    static const uint8_t debug[] = "wifi: sta connected, rssi -52";
+    static const uint8_t rcs[] = {3, 1, 0, 120, 0x10, 0x27, 0, 0, 0, 1, 2, 3, 4, 5, 6, 7};
+    static const uint8_t progress[] = {0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00};
+
+    const Frame frames[] = {
+        makeFrame("ack", RSP_ACK, ack, sizeof(ack)),
+        makeFrame("pong", RSP_PONG, pong, sizeof(pong)),
+        makeFrame("debug", NOTIFY_DEBUG, debug, sizeof(debug) - 1),
+        makeFrame("rcs_data", NOTIFY_RCS_DATA, rcs, sizeof(rcs)),
+        makeFrame("flash_progress", NOTIFY_FLASH_PROGRESS, progress, sizeof(progress)),
+        makeFrame("wifi_connected", NOTIFY_WIFI_CONNECTED, NULL, 0),
+    };
+
+    FEHESP32::setRCSCallback(rcsCallback);
+
+    for (const Frame &f : frames)
+    {
+        std::string name = std::string("esp32/handle_message/") + f.name;
+        bench.run(name, 2000000, [&f](uint64_t n) {
+            while (n--)
+            {
+                FEHESP32::handleMessage(f.data, FRAME_LEN);
+            }
+            HostHardware::clearSerial();
+        });
+
+        HostHardware::clearSerial();
+        FEHESP32::handleMessage(f.data, FRAME_LEN);
+        bench.counter(name, "serial_bytes", HostHardware::serialOutput().size());
+    }
+
+    /* The steady state with RCS running: mostly data, some acks, the odd debug line */
+    static const uint8_t MIX[] = {3, 3, 3, 0, 3, 3, 3, 0, 3, 3, 3, 2, 3, 3, 1, 0};
+    bench.run("esp32/handle_message/mix", 2000000, [&frames](uint64_t n) {
+        uint8_t i = 0;
+        while (n--)
+        {
+            FEHESP32::handleMessage(frames[MIX[i++ & 0x0F]].data, FRAME_LEN);
+        }
+        HostHardware::clearSerial();
+    });
+
+    FEHESP32::setRCSCallback(NULL);
+}
@@ -0,0 +1,91 @@
+/**
+ * bench_format.cpp
+ *
+ * Building a line of LCD text: String concatenation against LCD.WriteLinef() and
+ * FixedString, per line and for a frame like the one Exploration2.cpp redraws every
+ * 100 ms. allocs_per_op counts heap allocations; it should be 0 for everything but String.
+ */
+
+#include <FEH.h>
+#include "FEHInternal.h"
+#include "Bench.h"
+
+#include <stdio.h>
+#include <functional>
+
+static const float VALUES[] = {1.234f, 3.5f, 0.0625f, 4.875f};
+
+static void allocationCounter(Bench &bench, const std::string &name, const std::function<void(int)> &op)
+{
+    uint64_t before = heapAllocations();
+    for (int i = 0; i < 100; i++)
+    {
+        op(i);
+    }
+    bench.counter(name, "allocs_per_op", (heapAllocations() - before) / 100.0);
+}
+
+static void benchLine(Bench &bench, const std::string &name, const std::function<void(int)> &op)
+{
+    bench.run(name, 200000, [&op](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+        {
+            op((int)i);
+            if ((i & 31) == 31)
+            {
+                LCD.SetTextCursor(0, 0);
+            }
+        }
+    });
+    LCD.SetTextCursor(0, 0);
+    allocationCounter(bench, name, op);
+}
+
+void benchFormat(Bench &bench)
+{
+    ILI9341.begin();
+    LCD.Clear();
+    LCD.SetFontSize(1);
+    LCD.SetFontColor(WHITE);
+
+    benchLine(bench, "format/line/string", [](int i) {
+        LCD.WriteLine(("Left Optosensor Value:" + String(VALUES[i & 3])).c_str());
+    });
+    benchLine(bench, "format/line/writelinef", [](int i) {
+        LCD.WriteLinef("Left Optosensor Value:%.2f", VALUES[i & 3]);
+    });
+    benchLine(bench, "format/line/fixed_string", [](int i) {
+        FixedString<40> line("Left Optosensor Value:");
+        line += VALUES[i & 3];
+        LCD.WriteLine(line);
+    });
+
+    /* The four status lines of Exploration2.cpp's "looking for line" frame */
+    benchLine(bench, "format/frame/string", [](int i) {
+        LCD.WriteLine("Something is going wrong. Looking for line...");
+        LCD.WriteLine(("Left Optosensor Value:" + String(VALUES[i & 3])).c_str());
+        LCD.WriteLine(("Middle Optosensor Value:" + String(VALUES[(i + 1) & 3])).c_str());
+        LCD.WriteLine(("Right Optosensor Value:" + String(VALUES[(i + 2) & 3])).c_str());
+    });
+    benchLine(bench, "format/frame/writelinef", [](int i) {
+        LCD.WriteLine("Something is going wrong. Looking for line...");
+        LCD.WriteLinef("Left Optosensor Value:%.2f", VALUES[i & 3]);
+        LCD.WriteLinef("Middle Optosensor Value:%.2f", VALUES[(i + 1) & 3]);
+        LCD.WriteLinef("Right Optosensor Value:%.2f", VALUES[(i + 2) & 3]);
+    });
+
+    /* Formatting alone, against the C library */
+    char buf[64];
+    bench.run("format/text/format_text", 1000000, [&buf](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+        {
+            FormatText(buf, sizeof(buf), "x=%.2f y=%.2f n=%d", VALUES[i & 3], -VALUES[(i + 1) & 3], (int)i);
+        }
+    });
+    bench.run("format/text/snprintf", 1000000, [&buf](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+        {
+            snprintf(buf, sizeof(buf), "x=%.2f y=%.2f n=%d", VALUES[i & 3], -VALUES[(i + 1) & 3], (int)i);
+        }
+    });
+}
@@ -0,0 +1,111 @@
+/**
+ * bench_lcd.cpp
+ *
+ * FEHLCD glyph and primitive paths, and FEHIcon::Icon::ChangeLabelFloat() composed in a
+ * tile and drawn directly, against the ILI9341 framebuffer backend. Counters are the
+ * display traffic of a single call.
+ */
+
+#include <FEH.h>
+#include "FEHInternal.h"
+#include "Bench.h"
+
+#include <functional>
+
+/* Defined in FEHInternal.cpp; draws the startup screen with its logo */
+void initSplashScreen();
+
+/* Run @p op once from a known screen state and record what it sent to the display */
+static void displayCounters(Bench &bench, const std::string &name, const std::function<void()> &op)
+{
+    ILI9341.clearHostStats();
+    op();
+    const Adafruit_ILI9341::HostStats &s = ILI9341.hostStats();
+    bench.counter(name, "spi_bytes", s.spiBytes);
+    bench.counter(name, "addr_windows", s.addrWindows);
+    bench.counter(name, "pixels", s.pixels);
+    bench.counter(name, "transactions", s.transactions);
+}
+
+static void benchOp(Bench &bench, const std::string &name, uint64_t iterations, const std::function<void()> &op)
+{
+    bench.run(name, iterations, [&op](uint64_t n) {
+        while (n--)
+        {
+            op();
+        }
+    });
+    displayCounters(bench, name, op);
+}
+
+void benchLCD(Bench &bench)
+{
+    ILI9341.begin();
+    LCD.SetOrientation(FEHLCD::South);
+    LCD.Clear();
+
+    for (int size = 1; size <= 3; size++)
+    {
+        char name[64];
+
+        snprintf(name, sizeof(name), "lcd/write_at/size%d", size);
+        benchOp(bench, name, 20000, [size]() {
+            LCD.SetFontSize(size);
+            LCD.SetFontColor(WHITE);
+            LCD.WriteAt("Speed: 12.5", 10, 40);
+        });
+
+        snprintf(name, sizeof(name), "lcd/write_at_opaque/size%d", size);
+        benchOp(bench, name, 20000, [size]() {
+            LCD.SetFontSize(size);
+            LCD.SetFontColor(WHITE, BLACK);
+            LCD.WriteAt("Speed: 12.5", 10, 40);
+        });
+    }
+    LCD.SetFontSize(1);
+    LCD.SetFontColor(WHITE);
+
+    benchOp(bench, "lcd/draw_pixel", 2000000, []() { LCD.DrawPixel(100, 100); });
+    benchOp(bench, "lcd/fill_rectangle/40x30", 100000, []() { LCD.FillRectangle(20, 20, 40, 30); });
+    benchOp(bench, "lcd/draw_line/diagonal", 200000, []() { LCD.DrawLine(10, 10, 200, 120); });
+    benchOp(bench, "lcd/draw_line/shallow", 200000, []() { LCD.DrawLine(10, 100, 300, 130); });
+    benchOp(bench, "lcd/draw_line/horizontal", 200000, []() { LCD.DrawLine(10, 60, 200, 60); });
+    benchOp(bench, "lcd/draw_rectangle/100x60", 200000, []() { LCD.DrawRectangle(50, 50, 100, 60); });
+    benchOp(bench, "lcd/draw_circle/r40", 100000, []() { LCD.DrawCircle(160, 120, 40); });
+    benchOp(bench, "lcd/fill_circle/r40", 50000, []() { LCD.FillCircle(160, 120, 40); });
+
+    /* The same shapes through the Adafruit GFX routines FEHLCD used to call */
+    benchOp(bench, "lcd/draw_line/diagonal/gfx", 200000, []() { ILI9341.drawLine(10, 10, 200, 120, WHITE); });
+    benchOp(bench, "lcd/draw_line/shallow/gfx", 200000, []() { ILI9341.drawLine(10, 100, 300, 130, WHITE); });
+    benchOp(bench, "lcd/draw_rectangle/100x60/gfx", 200000, []() { ILI9341.drawRect(50, 50, 100, 60, WHITE); });
+    benchOp(bench, "lcd/fill_circle/r40/gfx", 50000, []() { ILI9341.fillCircle(160, 120, 40, WHITE); });
+    benchOp(bench, "lcd/clear", 2000, []() { LCD.Clear(); });
+    benchOp(bench, "lcd/splash_screen", 2000, []() { initSplashScreen(); });
+
+    /* Alternates between labels of the same and of different lengths */
+    FEHIcon::Icon icon;
+    char label[20] = "0.000";
+    icon.SetProperties(label, 100, 100, 80, 30, WHITE, WHITE);
+    icon.Draw();
+    static const float VALUES[] = {1.25f, 3.5f, 12.125f, 7.75f};
+    bench.run("icon/change_label_float", 20000, [&icon](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+        {
+            icon.ChangeLabelFloat(VALUES[i & 3]);
+        }
+    });
+    icon.ChangeLabelFloat(VALUES[3]);
+    displayCounters(bench, "icon/change_label_float", [&icon]() { icon.ChangeLabelFloat(VALUES[2]); });
+
+    /* Erasing and drawing straight to the display, as before LcdTile */
+    _lcdSetCompositing(false);
+    bench.run("icon/change_label_float/direct", 20000, [&icon](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+        {
+            icon.ChangeLabelFloat(VALUES[i & 3]);
+        }
+    });
+    icon.ChangeLabelFloat(VALUES[3]);
+    displayCounters(bench, "icon/change_label_float/direct", [&icon]() { icon.ChangeLabelFloat(VALUES[2]); });
+    _lcdSetCompositing(true);
+}
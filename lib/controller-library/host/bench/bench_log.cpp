@@ -0,0 +1,47 @@
+/**
+ * bench_log.cpp
+ *
+ * FEHLog::printf() formatting and dispatch to Serial.
+ */
+
+#include <FEHLog.h>
+#include "HostHardware.h"
+#include "Bench.h"
+
+void benchLog(Bench &bench)
+{
+    FEHLog::enableSerial();
+
+    bench.run("log/printf/string", 500000, [](uint64_t n) {
+        while (n--)
+        {
+            FEHLog::printf("state: %s\n", "drive");
+        }
+        HostHardware::clearSerial();
+    });
+
+    bench.run("log/printf/ints", 500000, [](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+        {
+            FEHLog::printf("t=%lu left=%d right=%d\n", (unsigned long)i, (int)(i & 0x3FF), -(int)(i & 0x1FF));
+        }
+        HostHardware::clearSerial();
+    });
+
+    bench.run("log/printf/floats", 500000, [](uint64_t n) {
+        float heading = 12.5f;
+        while (n--)
+        {
+            FEHLog::printf("x=%.2f y=%.2f h=%.1f\n", 3.25f, -7.75f, heading);
+            heading += 0.5f;
+        }
+        HostHardware::clearSerial();
+    });
+
+    HostHardware::clearSerial();
+    FEHLog::printf("t=%lu left=%d right=%d\n", 123456UL, 512, -256);
+    bench.counter("log/printf/ints", "serial_bytes", HostHardware::serialOutput().size());
+    HostHardware::clearSerial();
+
+    FEHLog::disableSerial();
+}
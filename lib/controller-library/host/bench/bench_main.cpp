@@ -0,0 +1,32 @@
+/**
+ * bench_main.cpp
+ *
+ * Host micro-benchmarks for the library's hot paths. See ../README.md.
+ */
+
+#include <Arduino.h>
+#include "HostHardware.h"
+#include "Bench.h"
+
+/* The library expects the program to provide these, as a sketch would */
+void setup() {}
+void loop() {}
+
+int main(int argc, char **argv)
+{
+    Bench bench(argc, argv);
+
+    HostHardware::reset();
+
+    benchScheduler(bench);
+    benchESP32(bench);
+    benchSD(bench);
+    benchLog(bench);
+    benchLCD(bench);
+    benchTime(bench);
+    benchFormat(bench);
+    benchTelemetry(bench);
+    benchSPI(bench);
+
+    return bench.finish();
+}
@@ -0,0 +1,98 @@
+/**
+ * bench_scheduler.cpp
+ *
+ * scheduleEvent()/cancelEvents() and the Timer 4 dispatch ISR at queue depths 0-7.
+ */
+
+#include <Arduino.h>
+#include "scheduler.h"
+#include "Bench.h"
+
+extern "C" void TIMER4_COMPA_vect(void);
+
+#define MAX_DEPTH 7
+#define FILLER_TICKS 60000
+
+static volatile uint32_t s_fired;
+
+static void target() { s_fired++; }
+
+/* Distinct callbacks so cancelEvents(target) has to skip every filler */
+template <int N>
+static void filler() {}
+
+static void (*const FILLERS[MAX_DEPTH])() = {filler<0>, filler<1>, filler<2>, filler<3>,
+                                             filler<4>, filler<5>, filler<6>};
+
+static void fill(int depth)
+{
+    for (int i = 0; i < depth; i++)
+    {
+        scheduleEvent(FILLERS[i], FILLER_TICKS + i);
+    }
+}
+
+static void drain(int depth)
+{
+    for (int i = 0; i < depth; i++)
+    {
+        cancelEvents(FILLERS[i]);
+    }
+    cancelEvents(target);
+}
+
+void benchScheduler(Bench &bench)
+{
+    char name[64];
+
+    for (int depth = 0; depth <= MAX_DEPTH; depth++)
+    {
+        fill(depth);
+        snprintf(name, sizeof(name), "scheduler/schedule_cancel/depth%d", depth);
+        bench.run(name, 2000000, [](uint64_t n) {
+            while (n--)
+            {
+                scheduleEvent(target, 1000);
+                cancelEvents(target);
+            }
+        });
+        drain(depth);
+    }
+
+    /*
+     * Each dispatch subtracts one tick from the fillers, so they are refreshed well
+     * before they could fall due.
+     */
+    for (int depth = 0; depth <= MAX_DEPTH; depth++)
+    {
+        fill(depth);
+        s_fired = 0;
+        snprintf(name, sizeof(name), "scheduler/dispatch/depth%d", depth);
+        bench.run(name, 2000000, [depth](uint64_t n) {
+            uint32_t sinceRefill = 0;
+            while (n--)
+            {
+                scheduleEvent(target, 1);
+                TIMER4_COMPA_vect();
+                if (++sinceRefill == FILLER_TICKS / 2)
+                {
+                    drain(depth);
+                    fill(depth);
+                    sinceRefill = 0;
+                }
+            }
+        });
+        drain(depth);
+
+        /* Every iteration must have dispatched exactly the target event */
+        s_fired = 0;
+        fill(depth);
+        for (int i = 0; i < 100; i++)
+        {
+            scheduleEvent(target, 1);
+            TIMER4_COMPA_vect();
+        }
+        drain(depth);
+        bench.counter(name, "fired_per_op", s_fired / 100.0);
+    }
+}
@@ -0,0 +1,74 @@
+/**
+ * bench_sd.cpp
+ *
+ * FEHSD::FScanf() on typical log and course-data lines. my_vsscanf() is private, so it is
+ * timed through FScanf() reading an in-memory file; the per-character file reads are part
+ * of the real cost anyway.
+ */
+
+#include <FEH.h>
+#include "HostHardware.h"
+#include "Bench.h"
+
+#define LINES 256
+
+struct ScanCase
+{
+    const char *name;
+    const char *line;
+};
+
+static std::string repeatLine(const char *line)
+{
+    std::string contents;
+    for (int i = 0; i < LINES; i++)
+    {
+        contents += line;
+        contents += '\n';
+    }
+    return contents;
+}
+
+void benchSD(Bench &bench)
+{
+    const ScanCase cases[] = {
+        {"ints", "12 -340 5600"},
+        {"floats", "12.500 -3.250 0.125"},
+        {"mixed", "waypoint 3 17.25 -4.50"},
+    };
+
+    for (const ScanCase &c : cases)
+    {
+        HostSdVolume::put("bench.txt", repeatLine(c.line));
+        FEHFile *file = SD.FOpen("bench.txt", "r");
+
+        std::string name = std::string("sd/fscanf/") + c.name;
+        bench.run(name, 200000, [&c, file](uint64_t n) {
+            int a, b, d;
+            float x, y, z;
+            char word[16];
+            for (uint64_t i = 0; i < n; i++)
+            {
+                if (i % LINES == 0)
+                {
+                    SD.FSeek(file, 0, SEEK_SET);
+                }
+                switch (c.name[0])
+                {
+                case 'i':
+                    SD.FScanf(file, "%d %d %d", &a, &b, &d);
+                    break;
+                case 'f':
+                    SD.FScanf(file, "%f %f %f", &x, &y, &z);
+                    break;
+                default:
+                    SD.FScanf(file, "%s %d %f %f", word, &a, &x, &y);
+                    break;
+                }
+            }
+        });
+
+        SD.FClose(file);
+    }
+    HostSdVolume::clear();
+}
@@ -0,0 +1,119 @@
+/**
+ * bench_spi.cpp
+ *
+ * SPI block transfers from private_include/spibus.h against a SPI.transfer() loop with a
+ * fresh SPISettings per frame, for an ESP32 frame (48 bytes, full duplex) and a 4 KB
+ * transmit-only block as the display takes pixels. Host times only show the software
+ * overhead; bytes per second on the controller come from test/test_spi.
+ */
+
+#include <Arduino.h>
+#include <SPI.h>
+#include "HostHardware.h"
+#include "spibus.h"
+#include "Bench.h"
+
+#define FRAME_LEN 48
+#define BLOCK_LEN 4096
+#define BENCH_CS_PIN 40
+
+/* Echoes the previous byte, as a shift register would */
+class LoopbackDevice : public HostSpiDevice
+{
+public:
+    uint8_t transfer(uint8_t out) override
+    {
+        uint8_t in = _last;
+        _last = out;
+        return in;
+    }
+
+private:
+    uint8_t _last = 0;
+};
+
+static const SpiBusSettings BENCH_SPI = spiBusSettings(1000000, SPI_MODE0);
+
+static void spiCounters(Bench &bench, const std::string &name, void (*op)())
+{
+    HostHardware::clearSpiStats();
+    op();
+    bench.counter(name, "spi_bytes", HostHardware::spiStats().bytes);
+}
+
+static uint8_t s_tx[BLOCK_LEN];
+static uint8_t s_rx[BLOCK_LEN];
+
+static void framePerByte()
+{
+    SPI.beginTransaction(SPISettings(1000000, MSBFIRST, SPI_MODE0));
+    digitalWrite(BENCH_CS_PIN, LOW);
+    for (uint8_t i = 0; i < FRAME_LEN; i++)
+    {
+        s_rx[i] = SPI.transfer(s_tx[i]);
+    }
+    digitalWrite(BENCH_CS_PIN, HIGH);
+    SPI.endTransaction();
+}
+
+static void frameBlock()
+{
+    spiBusBegin(BENCH_SPI);
+    digitalWrite(BENCH_CS_PIN, LOW);
+    spiBusTransfer(s_tx, s_rx, FRAME_LEN);
+    digitalWrite(BENCH_CS_PIN, HIGH);
+}
+
+static void blockPerByte()
+{
+    for (uint16_t i = 0; i < BLOCK_LEN; i++)
+    {
+        SPI.transfer(s_tx[i]);
+    }
+}
+
+static void blockWrite()
+{
+    spiBusWrite(s_tx, BLOCK_LEN);
+}
+
+void benchSPI(Bench &bench)
+{
+    static LoopbackDevice device;
+
+    HostHardware::reset();
+    HostHardware::attachSpiDevice(BENCH_CS_PIN, &device);
+    pinMode(BENCH_CS_PIN, OUTPUT);
+    digitalWrite(BENCH_CS_PIN, HIGH);
+    SPI.begin();
+    for (int i = 0; i < BLOCK_LEN; i++)
+    {
+        s_tx[i] = (uint8_t)(i * 7);
+    }
+
+    const struct
+    {
+        const char *name;
+        uint64_t iterations;
+        void (*op)();
+    } cases[] = {
+        {"spi/frame_48/per_byte", 200000, framePerByte},
+        {"spi/frame_48/block", 200000, frameBlock},
+        {"spi/block_4k/per_byte", 5000, blockPerByte},
+        {"spi/block_4k/write", 5000, blockWrite},
+    };
+
+    for (const auto &c : cases)
+    {
+        void (*op)() = c.op;
+        bench.run(c.name, c.iterations, [op](uint64_t n) {
+            while (n--)
+            {
+                op();
+            }
+        });
+        spiCounters(bench, c.name, op);
+    }
+
+    HostHardware::reset();
+}
@@ -0,0 +1,99 @@
+/**
+ * bench_telemetry.cpp
+ *
+ * FEHTelemetry packet encoding, and how long a burst of FEHLog lines holds up the caller
+ * with Serial paced at its baud rate: plain text at 115200 through the default 64-byte
+ * ring against framed text at 2 Mbaud through a 512-byte ring. blocked_us_per_line is
+ * virtual time spent waiting for room in the TX ring.
+ */
+
+#include <FEH.h>
+#include "HostHardware.h"
+#include "Bench.h"
+
+#define LOG_BURST_LINES 10
+
+static void logBurst()
+{
+    for (int i = 0; i < LOG_BURST_LINES; i++)
+    {
+        FEHLog::printf("t=%lu left=%d right=%d heading=%.1f\n", millis(), 100 + i, 200 - i, 45.0f);
+    }
+    HostHardware::advanceMicros(100000);
+}
+
+/* Blocked time and drops per line over a few bursts, 100 ms apart */
+static void burstCounters(Bench &bench, const std::string &name)
+{
+    HostHardware::clearSerialStats();
+    FEHTelemetry::resetStats();
+    for (int i = 0; i < 5; i++)
+    {
+        logBurst();
+    }
+    double lines = 5.0 * LOG_BURST_LINES;
+    bench.counter(name, "blocked_us_per_line", HostHardware::serialStats().blockedMicros / lines);
+    bench.counter(name, "dropped_per_line", FEHTelemetry::stats().dropped / lines);
+}
+
+void benchTelemetry(Bench &bench)
+{
+    struct
+    {
+        uint32_t time;
+        float left, right;
+        int16_t encoders[4];
+        float heading;
+        uint8_t state;
+        uint8_t spare[7];
+    } record = {};
+
+    HostHardware::reset();
+    FEHTelemetry::begin();
+    bench.run("telemetry/send/record_32", 1000000, [&record](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+        {
+            record.time = (uint32_t)i;
+            FEHTelemetry::send(1, record);
+            if ((i & 1023) == 1023)
+            {
+                HostHardware::clearSerial();
+            }
+        }
+    });
+    FEHTelemetry::resetStats();
+    FEHTelemetry::send(1, record);
+    bench.counter("telemetry/send/record_32", "frame_bytes", FEHTelemetry::stats().bytes);
+    FEHTelemetry::end();
+
+    /* A burst of log lines, as printed by a state machine on each transition */
+    FEHLog::enableSerial();
+
+    HostHardware::reset();
+    HostHardware::setSerialPacing(true, 64);
+    Serial.begin(115200);
+    bench.run("telemetry/log_burst/serial_115200", 2000, [](uint64_t n) {
+        for (uint64_t i = 0; i < n; i += LOG_BURST_LINES)
+        {
+            logBurst();
+            HostHardware::clearSerial();
+        }
+    });
+    burstCounters(bench, "telemetry/log_burst/serial_115200");
+
+    HostHardware::reset();
+    HostHardware::setSerialPacing(true, 512);
+    FEHTelemetry::begin(2000000);
+    bench.run("telemetry/log_burst/telemetry_2m", 2000, [](uint64_t n) {
+        for (uint64_t i = 0; i < n; i += LOG_BURST_LINES)
+        {
+            logBurst();
+            HostHardware::clearSerial();
+        }
+    });
+    burstCounters(bench, "telemetry/log_burst/telemetry_2m");
+    FEHTelemetry::end();
+
+    FEHLog::disableSerial();
+    HostHardware::reset();
+}
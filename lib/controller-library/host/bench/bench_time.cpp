@@ -0,0 +1,100 @@
+/**
+ * bench_time.cpp
+ *
+ * Clock reads: micros() against TimeNowMicros() and the helpers built on it. The cycle
+ * cost on the controller is measured by test/test_time under the simavr harness.
+ * Also Sleep(): how closely it keeps time and whether it services every ESP32 poll.
+ */
+
+#include <Arduino.h>
+#include <FEHTime.h>
+#include <FEHUtility.h>
+#include "HostHardware.h"
+#include "Bench.h"
+
+static volatile uint64_t s_sink;
+
+extern volatile bool g_esp32PollPending;
+
+/* Stands in for the scheduler's eventESP32Poll, which flags a poll every 50 ms */
+static uint64_t s_lastPollFlag;
+
+static void flagPolls(uint64_t now)
+{
+    if (now - s_lastPollFlag >= 50000)
+    {
+        s_lastPollFlag += 50000;
+        g_esp32PollPending = true;
+    }
+}
+
+void benchTime(Bench &bench)
+{
+    bench.run("time/micros", 5000000, [](uint64_t n) {
+        uint64_t sum = 0;
+        while (n--)
+        {
+            sum += micros();
+        }
+        s_sink = sum;
+    });
+
+    bench.run("time/now_micros", 5000000, [](uint64_t n) {
+        uint64_t sum = 0;
+        while (n--)
+        {
+            sum += TimeNowMicros();
+        }
+        s_sink = sum;
+    });
+
+    bench.run("time/deadline_expired", 5000000, [](uint64_t n) {
+        Deadline timeout = Deadline::InMillis(1000);
+        uint64_t expired = 0;
+        while (n--)
+        {
+            expired += timeout.Expired();
+        }
+        s_sink = expired;
+    });
+
+    bench.run("time/rate_limiter_ready", 5000000, [](uint64_t n) {
+        RateLimiter limiter(10);
+        uint64_t ready = 0;
+        while (n--)
+        {
+            ready += limiter.Ready();
+        }
+        s_sink = ready;
+    });
+
+    /* The 64-bit clock follows micros() to its 4 us resolution, including past its wrap */
+    uint64_t worst = 0;
+    for (int i = 0; i < 1000; i++)
+    {
+        HostHardware::advanceMicros(997);
+        uint64_t now = TimeNowMicros();
+        uint64_t diff = HostHardware::nowMicros() - now;
+        worst = diff > worst ? diff : worst;
+    }
+    HostHardware::advanceMicros(0x100000000ULL - HostHardware::nowMicros() % 0x100000000ULL + 5);
+    bench.counter("time/now_micros", "lag_us_max", worst);
+    bench.counter("time/now_micros", "wrap_errors", TimeNowMicros() <= 0xFFFFFFFFULL);
+
+    bench.run("time/sleep_1ms", 20000, [](uint64_t n) {
+        while (n--)
+        {
+            Sleep(1);
+        }
+    });
+
+    /* A 2 s Sleep() must service all 40 polls flagged during it and end on time */
+    s_lastPollFlag = HostHardware::nowMicros() - 25000;
+    HostHardware::setTickHook(flagPolls);
+    ResetSleepStats();
+    Sleep(2.0);
+    HostHardware::setTickHook(nullptr);
+    SleepStatistics stats = SleepStats();
+    bench.counter("time/sleep_1ms", "late_us", stats.sleptMicros - 2000000);
+    bench.counter("time/sleep_1ms", "missed_polls", 40.0 - stats.serviceRuns);
+}
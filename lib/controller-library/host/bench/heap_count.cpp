@@ -0,0 +1,49 @@
+/**
+ * heap_count.cpp
+ *
+ * Counts heap allocations made by the library and the shims. feh_bench is linked with
+ * --wrap for malloc/calloc/realloc/free, so calls from the static library land here;
+ * allocations inside the C++ runtime (the benchmark's own std::string and maps) do not.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+static uint64_t s_allocations;
+
+extern "C"
+{
+    void *__real_malloc(size_t size);
+    void *__real_calloc(size_t count, size_t size);
+    void *__real_realloc(void *ptr, size_t size);
+    void __real_free(void *ptr);
+
+    void *__wrap_malloc(size_t size)
+    {
+        s_allocations++;
+        return __real_malloc(size);
+    }
+
+    void *__wrap_calloc(size_t count, size_t size)
+    {
+        s_allocations++;
+        return __real_calloc(count, size);
+    }
+
+    /* A realloc that grows a block can move it, so it counts as an allocation */
+    void *__wrap_realloc(void *ptr, size_t size)
+    {
+        s_allocations++;
+        return __real_realloc(ptr, size);
+    }
+
+    void __wrap_free(void *ptr)
+    {
+        __real_free(ptr);
+    }
+}
+
+uint64_t heapAllocations()
+{
+    return s_allocations;
+}
@@ -0,0 +1,300 @@
+/**
+ * HostReplay.cpp
+ *
+ * Parses the format described in private_include/recorder.h into one queue of runs per
+ * channel plus a time-ordered list of ESP32 frames.
+ */
+
+#include "HostReplay.h"
+#include "HostHardware.h"
+#include "recorder.h"
+#include "FEHESP32.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+struct Run
+{
+    int32_t value;
+    uint32_t count;
+    uint64_t start;
+    uint64_t duration;
+};
+
+struct Channel
+{
+    std::vector<Run> runs;
+    size_t run = 0;   // Run being replayed
+    uint32_t used = 0; // Reads already taken from it
+};
+
+struct Frame
+{
+    uint64_t time;
+    std::vector<uint8_t> bytes;
+};
+
+static std::map<uint16_t, Channel> s_channels;
+static std::vector<Frame> s_frames;
+static size_t s_nextFrame;
+static HostReplay::Stats s_stats;
+static void (*s_finished)() = nullptr;
+static bool s_finishedCalled;
+
+class Reader
+{
+public:
+    Reader(const std::string &data, size_t pos) : _data(data), _pos(pos), _ok(true) {}
+
+    bool ok() const { return _ok; }
+    bool atEnd() const { return _pos >= _data.size(); }
+
+    uint8_t byte()
+    {
+        if (_pos >= _data.size())
+        {
+            _ok = false;
+            return 0;
+        }
+        return (uint8_t)_data[_pos++];
+    }
+
+    uint32_t varint()
+    {
+        uint32_t value = 0;
+        for (int shift = 0; shift < 35 && _ok; shift += 7)
+        {
+            uint8_t b = byte();
+            value |= (uint32_t)(b & 0x7F) << shift;
+            if (!(b & 0x80))
+            {
+                return value;
+            }
+        }
+        _ok = false;
+        return 0;
+    }
+
+    int32_t zigzag()
+    {
+        uint32_t v = varint();
+        return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+    }
+
+private:
+    const std::string &_data;
+    size_t _pos;
+    bool _ok;
+};
+
+static uint16_t keyOf(uint8_t type, uint8_t id)
+{
+    return (uint16_t)type << 8 | id;
+}
+
+bool HostReplay::load(const std::string &data)
+{
+    s_channels.clear();
+    s_frames.clear();
+    s_nextFrame = 0;
+    s_stats = Stats();
+    s_finishedCalled = false;
+
+    if (data.size() < 9 || data.compare(0, 4, RECORDER_MAGIC) != 0)
+    {
+        fprintf(stderr, "replay: not an FEHRecorder recording\n");
+        return false;
+    }
+    if ((uint8_t)data[4] != RECORDER_VERSION)
+    {
+        fprintf(stderr, "replay: recording version %d, expected %d\n", data[4], RECORDER_VERSION);
+        return false;
+    }
+
+    uint32_t start = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        start |= (uint32_t)(uint8_t)data[5 + i] << (8 * i);
+    }
+
+    std::map<uint16_t, int32_t> lastValue;
+    Reader in(data, 9);
+    uint64_t time = start;
+    s_stats.startMicros = s_stats.endMicros = start;
+
+    while (!in.atEnd() && in.ok())
+    {
+        uint8_t head = in.byte();
+        uint8_t type = head >> 4;
+        uint8_t id = in.byte();
+        time += in.zigzag();
+
+        if (type == RECORD_ESP32)
+        {
+            Frame f;
+            f.time = time;
+            uint32_t len = in.varint();
+            if (len > 255)
+            {
+                break;
+            }
+            f.bytes.resize(len);
+            for (uint8_t &b : f.bytes)
+            {
+                b = in.byte();
+            }
+            if (!in.ok())
+            {
+                break;
+            }
+            s_frames.push_back(f);
+            s_stats.endMicros = std::max(s_stats.endMicros, time);
+            continue;
+        }
+
+        uint16_t key = keyOf(type, id);
+        int32_t v = in.zigzag();
+        Run r;
+        r.value = (head & RECORD_FLAG_ABSOLUTE) ? v : lastValue[key] + v;
+        r.count = 1;
+        r.start = time;
+        r.duration = 0;
+        if (head & RECORD_FLAG_RUN)
+        {
+            r.count = in.varint() + 1;
+            r.duration = in.varint();
+        }
+        if (!in.ok())
+        {
+            break;
+        }
+        lastValue[key] = r.value;
+        s_channels[key].runs.push_back(r);
+        s_stats.remaining += r.count;
+        s_stats.endMicros = std::max(s_stats.endMicros, r.start + r.duration);
+    }
+
+    if (!in.ok())
+    {
+        /* A recording cut off by a reset ends mid-record; keep what was complete */
+        fprintf(stderr, "replay: recording is truncated\n");
+    }
+
+    std::stable_sort(s_frames.begin(), s_frames.end(),
+                     [](const Frame &a, const Frame &b) { return a.time < b.time; });
+    s_stats.remaining += s_frames.size();
+    return true;
+}
+
+bool HostReplay::loadFile(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == nullptr)
+    {
+        perror(path);
+        return false;
+    }
+    std::string data;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+    {
+        data.append(buf, n);
+    }
+    fclose(f);
+    return load(data);
+}
+
+static void checkFinished()
+{
+    if (s_stats.remaining == 0 && !s_finishedCalled)
+    {
+        s_finishedCalled = true;
+        if (s_finished)
+        {
+            s_finished();
+        }
+    }
+}
+
+static void advanceTo(uint64_t time)
+{
+    uint64_t now = HostHardware::nowMicros();
+    if (time > now)
+    {
+        HostHardware::advanceMicros(time - now);
+    }
+}
+
+static int32_t replayRead(uint8_t type, uint8_t id, int32_t live)
+{
+    auto it = s_channels.find(keyOf(type, id));
+    if (it == s_channels.end() || it->second.run >= it->second.runs.size())
+    {
+        s_stats.missing++;
+        return live;
+    }
+
+    Channel &c = it->second;
+    const Run &r = c.runs[c.run];
+    /*
+     * Only the first and last read of a run have known times; reads in between leave the
+     * clock alone, since spreading them evenly would run it ahead of other channels.
+     */
+    uint64_t time = c.used == 0 ? r.start : r.start + r.duration;
+    bool timed = c.used == 0 || c.used + 1 == r.count;
+    int32_t value = r.value;
+    if (++c.used == r.count)
+    {
+        c.run++;
+        c.used = 0;
+    }
+    s_stats.reads++;
+    s_stats.remaining--;
+
+    /* Interrupts that fire while the clock moves can read inputs too, so state is updated first */
+    if (timed)
+    {
+        advanceTo(time);
+    }
+    checkFinished();
+    return value;
+}
+
+static void deliverFrames(uint64_t now)
+{
+    while (s_nextFrame < s_frames.size() && s_frames[s_nextFrame].time <= now)
+    {
+        const Frame &f = s_frames[s_nextFrame++];
+        FEHESP32::handleMessage(f.bytes.data(), (uint8_t)f.bytes.size());
+        s_stats.frames++;
+        s_stats.remaining--;
+    }
+    checkFinished();
+}
+
+void HostReplay::start()
+{
+    advanceTo(s_stats.startMicros);
+    HostHardware::setTickHook(deliverFrames);
+    _recorderReplay(replayRead);
+}
+
+void HostReplay::stop()
+{
+    _recorderReplay(nullptr);
+    HostHardware::setTickHook(nullptr);
+}
+
+void HostReplay::setFinishedHandler(void (*handler)())
+{
+    s_finished = handler;
+}
+
+HostReplay::Stats HostReplay::stats()
+{
+    return s_stats;
+}
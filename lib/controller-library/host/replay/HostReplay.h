@@ -0,0 +1,48 @@
+/**
+ * HostReplay.h
+ *
+ * Replays an FEHRecorder recording into the host build. Each library read returns the
+ * value recorded for that read, the virtual clock is moved to the time of the read, and
+ * ESP32 frames are delivered to FEHESP32::handleMessage() when the clock reaches them.
+ * Code that reads its inputs in the same order as on the robot therefore sees the same
+ * run, and can be profiled or stepped in a debugger.
+ */
+
+#ifndef HOST_REPLAY_H
+#define HOST_REPLAY_H
+
+#include <stdint.h>
+#include <string>
+
+namespace HostReplay
+{
+    /// Parse a recording from a file on the PC. @return false with a message on stderr if invalid
+    bool loadFile(const char *path);
+
+    /// Parse a recording held in memory, e.g. from HostSdVolume::get()
+    bool load(const std::string &data);
+
+    /**
+     * @brief Start replaying: moves the clock to the start of the recording and takes over the
+     *        library's reads and HostHardware's tick hook.
+     */
+    void start();
+
+    /// Give reads back to the simulated hardware
+    void stop();
+
+    /// Called once when every recorded read and frame has been replayed
+    void setFinishedHandler(void (*handler)());
+
+    struct Stats
+    {
+        uint64_t reads;    ///< Reads answered from the recording
+        uint64_t missing;  ///< Reads of a channel whose recording had run out
+        uint64_t frames;   ///< ESP32 frames delivered
+        uint64_t remaining; ///< Recorded reads and frames not replayed yet
+        uint64_t startMicros, endMicros; ///< Recorded time span
+    };
+    Stats stats();
+}
+
+#endif // HOST_REPLAY_H
@@ -0,0 +1,60 @@
+/**
+ * replay_main.cpp
+ *
+ * main() for replay programs built with feh_add_replay(): replays a recording into the
+ * student's ERCMain() and reports how far it got. See host/README.md.
+ */
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include "HostHardware.h"
+#include "HostReplay.h"
+
+void ERCMain(void);
+
+static std::chrono::steady_clock::time_point s_wallStart;
+
+static void report(const char *how)
+{
+    HostReplay::Stats s = HostReplay::stats();
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - s_wallStart).count();
+    double simulated = (HostHardware::nowMicros() - s.startMicros) / 1e6;
+
+    fprintf(stderr,
+            "replay: %s after %.3f s of robot time in %.3f s (%.0fx)\n"
+            "replay: %llu reads, %llu frames, %llu reads past the recording, %llu not replayed\n",
+            how, simulated, wall, wall > 0 ? simulated / wall : 0.0, (unsigned long long)s.reads,
+            (unsigned long long)s.frames, (unsigned long long)s.missing, (unsigned long long)s.remaining);
+}
+
+static void finished()
+{
+    report("recording finished");
+    exit(0);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s recording.rec [--echo]\n", argv[0]);
+        return 2;
+    }
+    HostHardware::setSerialEcho(argc > 2 && !strcmp(argv[2], "--echo"));
+
+    if (!HostReplay::loadFile(argv[1]))
+    {
+        return 2;
+    }
+
+    s_wallStart = std::chrono::steady_clock::now();
+    HostReplay::setFinishedHandler(finished);
+    HostReplay::start();
+    sei();
+    ERCMain();
+
+    report("ERCMain() returned");
+    return 0;
+}
@@ -0,0 +1,130 @@
+/**
+ * test_replay.cpp
+ *
+ * Records a short run against changing simulated inputs, replays the recording with the
+ * inputs held still, and checks that the program sees exactly the same run.
+ */
+
+#include <FEH.h>
+#include <SdFat.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "HostHardware.h"
+#include "HostReplay.h"
+#include "FEHESP32.h"
+#include "ApplicationProtocol.h"
+
+#define RECORDING "RUN.REC"
+#define ITERATIONS 300
+
+static int s_rcsFrames;
+static int s_rcsLast;
+
+static void rcsCallback(const uint8_t *data, uint8_t len)
+{
+    s_rcsFrames++;
+    s_rcsLast = data[3];
+}
+
+/* Inputs while recording: every input changes on its own schedule */
+static void recordingInputs(uint64_t now)
+{
+    uint64_t ms = now / 1000;
+    HostHardware::setAnalog(0, (ms * 37) % 1024);
+    HostHardware::setPin(A1, (ms / 7) % 2);
+    HostHardware::setPin(A8, (ms / 3) % 2);
+    HostHardware::setTouch(ms % 200 < 40, (int16_t)(ms % 320), (int16_t)(ms % 240));
+
+    /* The hook can run several times per ms; send each frame once */
+    static uint64_t lastFrameMs = 0;
+    if (ms % 100 == 50 && ms != lastFrameMs)
+    {
+        lastFrameMs = ms;
+        uint8_t frame[] = {0xAA, 0x55, NOTIFY_RCS_DATA, 5, 1, 0, 0, (uint8_t)(ms / 100), 0};
+        FEHESP32::handleMessage(frame, sizeof(frame));
+    }
+}
+
+static std::vector<std::string> runProgram()
+{
+    AnalogInputPin light(FEHIO::Pin0);
+    DigitalInputPin bump(FEHIO::Pin1);
+    DigitalEncoder encoder(FEHIO::Pin8);
+    encoder.ResetCounts();
+    s_rcsFrames = 0;
+    s_rcsLast = 0;
+    FEHESP32::setRCSCallback(rcsCallback);
+
+    std::vector<std::string> trace;
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        int x = -1, y = -1;
+        char line[160];
+        float volts = light.Value();
+        int pressed = 0;
+        for (int j = 0; j < 5; j++)
+        {
+            pressed += bump.Value();
+        }
+        bool touched = LCD.Touch(&x, &y);
+        snprintf(line, sizeof(line), "%lu %.4f %d %d %d %d %d %.3f %d %d", micros(), volts, pressed,
+                 encoder.Counts(), touched, x, y, TimeNow(), s_rcsFrames, s_rcsLast);
+        trace.push_back(line);
+        Sleep(i % 4 + 1);
+    }
+    return trace;
+}
+
+int main()
+{
+    sei();
+    HostHardware::advanceMicros(1234567);
+    HostHardware::setTickHook(recordingInputs);
+    if (!FEHRecorder::start(RECORDING))
+    {
+        fprintf(stderr, "could not start recording\n");
+        return 1;
+    }
+    std::vector<std::string> recorded = runProgram();
+    FEHRecorder::stop();
+    HostHardware::setTickHook(nullptr);
+
+    std::string recording = HostSdVolume::get(RECORDING);
+    printf("recorded %d iterations in %zu bytes, %lu dropped\n", ITERATIONS, recording.size(),
+           FEHRecorder::droppedRecords());
+
+    HostHardware::reset();
+    sei();
+    if (!HostReplay::load(recording))
+    {
+        return 1;
+    }
+    HostReplay::start();
+    std::vector<std::string> replayed = runProgram();
+    HostReplay::stop();
+
+    HostReplay::Stats s = HostReplay::stats();
+    printf("replayed %llu reads, %llu frames, %llu missing, %llu left\n", (unsigned long long)s.reads,
+           (unsigned long long)s.frames, (unsigned long long)s.missing, (unsigned long long)s.remaining);
+
+    int failures = 0;
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        if (recorded[i] != replayed[i])
+        {
+            if (failures++ < 5)
+            {
+                printf("iteration %d differs:\n  recorded: %s\n  replayed: %s\n", i, recorded[i].c_str(),
+                       replayed[i].c_str());
+            }
+        }
+    }
+    if (s.missing != 0 || s.remaining != 0 || FEHRecorder::droppedRecords() != 0)
+    {
+        failures++;
+    }
+
+    printf("%s\n", failures ? "FAIL" : "OK");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,750 @@
+/**
+ * RobotSim.cpp
+ *
+ * The model is stepped from HostHardware's tick hook in slices of at most 1 ms:
+ *
+ *  - Each drive motor is a first-order system: wheel speed approaches the free speed for
+ *    its applied voltage (PWM duty times bus voltage) with the configured time constant.
+ *    Motor current follows from the same DC motor line and sags the bus voltage through
+ *    the battery's internal resistance.
+ *  - The robot is a circle. A step that would overlap a wall is not taken, and the wheels
+ *    lose their common (forward) speed, so the robot can still turn in place against it.
+ *  - Encoders follow wheel angle, bump switches close within 0.1 in of a wall, and
+ *    optosensors read the line map under them.
+ */
+
+#include "RobotSim.h"
+#include "HostHardware.h"
+#include "recorder.h"
+
+#include <Arduino.h>
+#include <Encoder.h>
+#include <FEHDefines.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <random>
+#include <string>
+#include <vector>
+#include <map>
+
+#define STEP_US 1000
+#define TRACE_US 10000
+#define BUMP_TRAVEL 0.1
+#define ADC_VREF 5.0
+#define BATTERY_DIVIDER 3.0
+
+struct Point
+{
+    double x, y;
+};
+
+struct Wall
+{
+    Point a, b;
+};
+
+struct Sensor
+{
+    uint8_t fehPin;
+    Point at; // Robot frame
+    bool level;
+};
+
+struct Wheel
+{
+    int motor = -1;
+    int sign = 1;
+    uint8_t encoderPins[2] = {0xFF, 0xFF}; // FEH pins; second one only for quadrature
+    double speed = 0;                      // rad/s
+    double angle = 0;                      // rad, signed
+    double travel = 0;                     // rad, unsigned, for single channel encoders
+    int32_t counted = 0;                   // Counts already sent to the encoder
+    bool level = true;
+};
+
+struct Config
+{
+    double arenaWidth = 72, arenaHeight = 72;
+    Point start = {12, 12};
+    double startHeading = 90;
+    double robotRadius = 4.5;
+    double wheelBase = 7.5;
+    double wheelDiameter = 2.5;
+    double wheelFreeRpm = 160;
+    double motorTimeConstant = 0.05;
+    double motorStallCurrent = 1.8;
+    double batteryVoltage = 11.7;
+    double batteryResistance = 0.15;
+    double countsPerRev = 318;
+    std::vector<Sensor> bumps;
+    std::vector<Sensor> optos;
+    std::vector<Wall> walls;
+    std::string lineMap;
+    double mapPixelsPerInch = 4;
+    double floorVoltage = 0.4;
+    double lineVoltage = 2.8;
+    double optoNoise = 0.0;
+    Point finish = {0, 0};
+    double finishRadius = 0; // 0: no finish
+    unsigned seed = 1;
+};
+
+static Config s_cfg;
+static Wheel s_wheels[2] = {{0, 1}, {1, -1}}; // Left, right: motor port and mounting sign
+
+/* Line map: darkness 0 (floor) to 1 (line), row 0 at the top */
+static std::vector<float> s_map;
+static int s_mapWidth, s_mapHeight;
+
+static Point s_pos;
+static double s_heading; // rad
+static double s_busVoltage;
+static uint64_t s_lastMicros, s_startMicros, s_nextTrace;
+static double s_timeLimit = 0;
+static void (*s_endHandler)(const char *) = nullptr;
+static bool s_ended;
+static FILE *s_trace;
+static std::mt19937 s_rng;
+static RobotSim::Stats s_stats;
+
+static std::map<std::string, double> s_params;
+static std::map<std::string, double> s_paramsUsed;
+static std::string s_paramsJson;
+
+//=============================================================================
+// CONFIGURATION
+//=============================================================================
+
+static bool parseNumbers(const char *text, double *out, int n)
+{
+    char *end;
+    for (int i = 0; i < n; i++)
+    {
+        out[i] = strtod(text, &end);
+        if (end == text)
+        {
+            return false;
+        }
+        text = end;
+    }
+    while (isspace((unsigned char)*text))
+    {
+        text++;
+    }
+    return *text == '\0';
+}
+
+static bool parseEncoder(const char *text, Wheel &w)
+{
+    double pins[2];
+    if (parseNumbers(text, pins, 2))
+    {
+        w.encoderPins[0] = (uint8_t)pins[0];
+        w.encoderPins[1] = (uint8_t)pins[1];
+        return pins[0] <= 15 && pins[1] <= 15;
+    }
+    if (parseNumbers(text, pins, 1))
+    {
+        w.encoderPins[0] = (uint8_t)pins[0];
+        w.encoderPins[1] = 0xFF;
+        return pins[0] >= 8 && pins[0] <= 14;
+    }
+    return false;
+}
+
+bool RobotSim::setOption(const char *key, const char *value)
+{
+    struct Scalar
+    {
+        const char *key;
+        double *value;
+    };
+    const Scalar scalars[] = {
+        {"arena_width", &s_cfg.arenaWidth},
+        {"arena_height", &s_cfg.arenaHeight},
+        {"start_x", &s_cfg.start.x},
+        {"start_y", &s_cfg.start.y},
+        {"start_heading", &s_cfg.startHeading},
+        {"robot_radius", &s_cfg.robotRadius},
+        {"wheel_base", &s_cfg.wheelBase},
+        {"wheel_diameter", &s_cfg.wheelDiameter},
+        {"wheel_free_rpm", &s_cfg.wheelFreeRpm},
+        {"motor_time_constant", &s_cfg.motorTimeConstant},
+        {"motor_stall_current", &s_cfg.motorStallCurrent},
+        {"battery_voltage", &s_cfg.batteryVoltage},
+        {"battery_resistance", &s_cfg.batteryResistance},
+        {"encoder_counts_per_rev", &s_cfg.countsPerRev},
+        {"map_pixels_per_inch", &s_cfg.mapPixelsPerInch},
+        {"floor_voltage", &s_cfg.floorVoltage},
+        {"line_voltage", &s_cfg.lineVoltage},
+        {"opto_noise", &s_cfg.optoNoise},
+    };
+
+    for (const Scalar &s : scalars)
+    {
+        if (!strcmp(key, s.key))
+        {
+            return parseNumbers(value, s.value, 1);
+        }
+    }
+
+    double v[4];
+    if (!strcmp(key, "left_motor") || !strcmp(key, "right_motor"))
+    {
+        Wheel &w = s_wheels[key[0] == 'r'];
+        /* "<port> [sign]": sign -1 for a motor mounted mirrored */
+        if (parseNumbers(value, v, 2))
+        {
+            w.sign = v[1] < 0 ? -1 : 1;
+        }
+        else if (!parseNumbers(value, v, 1))
+        {
+            return false;
+        }
+        w.motor = (int)v[0];
+        return w.motor >= 0 && w.motor <= 3;
+    }
+    if (!strcmp(key, "left_encoder") || !strcmp(key, "right_encoder"))
+    {
+        return parseEncoder(value, s_wheels[key[0] == 'r']);
+    }
+    if (!strcmp(key, "bump") || !strcmp(key, "opto"))
+    {
+        if (!parseNumbers(value, v, 3) || v[0] < 0 || v[0] > 15)
+        {
+            return false;
+        }
+        Sensor s = {(uint8_t)v[0], {v[1], v[2]}, true};
+        (key[0] == 'b' ? s_cfg.bumps : s_cfg.optos).push_back(s);
+        return true;
+    }
+    if (!strcmp(key, "wall"))
+    {
+        if (!parseNumbers(value, v, 4))
+        {
+            return false;
+        }
+        s_cfg.walls.push_back({{v[0], v[1]}, {v[2], v[3]}});
+        return true;
+    }
+    if (!strcmp(key, "finish"))
+    {
+        if (!parseNumbers(value, v, 3))
+        {
+            return false;
+        }
+        s_cfg.finish = {v[0], v[1]};
+        s_cfg.finishRadius = v[2];
+        return true;
+    }
+    if (!strcmp(key, "seed"))
+    {
+        if (!parseNumbers(value, v, 1))
+        {
+            return false;
+        }
+        s_cfg.seed = (unsigned)v[0];
+        return true;
+    }
+    if (!strcmp(key, "line_map"))
+    {
+        s_cfg.lineMap = value;
+        return true;
+    }
+    return false;
+}
+
+bool RobotSim::loadConfig(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (f == nullptr)
+    {
+        perror(path);
+        return false;
+    }
+
+    std::string dir = path;
+    size_t slash = dir.find_last_of('/');
+    dir = slash == std::string::npos ? "" : dir.substr(0, slash + 1);
+
+    char line[256];
+    int lineNumber = 0;
+    bool ok = true;
+    while (fgets(line, sizeof(line), f))
+    {
+        lineNumber++;
+        char *comment = strpbrk(line, "#;");
+        if (comment)
+        {
+            *comment = '\0';
+        }
+        char *eq = strchr(line, '=');
+        char key[64];
+        if (eq == nullptr)
+        {
+            if (sscanf(line, " %63s", key) == 1)
+            {
+                fprintf(stderr, "%s:%d: expected key = value\n", path, lineNumber);
+                ok = false;
+            }
+            continue;
+        }
+        *eq = '\0';
+        char *value = eq + 1;
+        while (isspace((unsigned char)*value))
+        {
+            value++;
+        }
+        value[strcspn(value, "\r\n")] = '\0';
+        if (sscanf(line, " %63s", key) != 1)
+        {
+            fprintf(stderr, "%s:%d: missing key\n", path, lineNumber);
+            ok = false;
+            continue;
+        }
+
+        /* Relative map paths are relative to the configuration file */
+        std::string v = value;
+        if (!strcmp(key, "line_map") && !v.empty() && v[0] != '/')
+        {
+            v = dir + v;
+        }
+        if (!setOption(key, v.c_str()))
+        {
+            fprintf(stderr, "%s:%d: bad value for '%s'\n", path, lineNumber, key);
+            ok = false;
+        }
+    }
+    fclose(f);
+    return ok;
+}
+
+static bool loadLineMap(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == nullptr)
+    {
+        perror(path);
+        return false;
+    }
+
+    /* Binary (P5) or ASCII (P2) PGM, as written by most image tools */
+    char magic[3] = {0};
+    int fields[3];
+    bool ok = fread(magic, 1, 2, f) == 2 && magic[0] == 'P' && (magic[1] == '2' || magic[1] == '5');
+    for (int i = 0; ok && i < 3; i++)
+    {
+        int c;
+        while ((c = fgetc(f)) == '#' || isspace(c))
+        {
+            if (c == '#')
+            {
+                while ((c = fgetc(f)) != '\n' && c != EOF)
+                {
+                }
+            }
+        }
+        ungetc(c, f);
+        ok = fscanf(f, "%d", &fields[i]) == 1;
+    }
+    if (!ok || fields[0] <= 0 || fields[1] <= 0 || fields[2] <= 0 || fields[2] > 65535)
+    {
+        fprintf(stderr, "%s: not a PGM image\n", path);
+        fclose(f);
+        return false;
+    }
+    fgetc(f); // Single whitespace before binary data
+
+    s_mapWidth = fields[0];
+    s_mapHeight = fields[1];
+    double maxval = fields[2];
+    s_map.resize((size_t)s_mapWidth * s_mapHeight);
+    for (float &px : s_map)
+    {
+        int value = 0;
+        if (magic[1] == '2')
+        {
+            ok = fscanf(f, "%d", &value) == 1;
+        }
+        else
+        {
+            value = fgetc(f);
+            if (maxval > 255)
+            {
+                value = (value << 8) | fgetc(f);
+            }
+            ok = !feof(f);
+        }
+        if (!ok)
+        {
+            fprintf(stderr, "%s: image data is truncated\n", path);
+            fclose(f);
+            return false;
+        }
+        /* Dark pixels are line */
+        px = (float)(1.0 - value / maxval);
+    }
+    fclose(f);
+    return true;
+}
+
+//=============================================================================
+// MODEL
+//=============================================================================
+
+static double freeSpeed12V()
+{
+    return s_cfg.wheelFreeRpm * 2 * M_PI / 60;
+}
+
+static Point toWorld(Point robot)
+{
+    double c = cos(s_heading), s = sin(s_heading);
+    return {s_pos.x + robot.x * c - robot.y * s, s_pos.y + robot.x * s + robot.y * c};
+}
+
+static double distanceToSegment(Point p, const Wall &w)
+{
+    double dx = w.b.x - w.a.x, dy = w.b.y - w.a.y;
+    double len2 = dx * dx + dy * dy;
+    double t = len2 > 0 ? ((p.x - w.a.x) * dx + (p.y - w.a.y) * dy) / len2 : 0;
+    t = t < 0 ? 0 : (t > 1 ? 1 : t);
+    double ex = w.a.x + t * dx - p.x, ey = w.a.y + t * dy - p.y;
+    return sqrt(ex * ex + ey * ey);
+}
+
+static double distanceToWalls(Point p)
+{
+    /* Arena edges; negative outside */
+    double d = fmin(fmin(p.x, s_cfg.arenaWidth - p.x), fmin(p.y, s_cfg.arenaHeight - p.y));
+    for (const Wall &w : s_cfg.walls)
+    {
+        d = fmin(d, distanceToSegment(p, w));
+    }
+    return d;
+}
+
+static double darknessAt(Point p)
+{
+    if (s_map.empty())
+    {
+        return 0;
+    }
+    int px = (int)floor(p.x * s_cfg.mapPixelsPerInch);
+    int py = s_mapHeight - 1 - (int)floor(p.y * s_cfg.mapPixelsPerInch);
+    if (px < 0 || py < 0 || px >= s_mapWidth || py >= s_mapHeight)
+    {
+        return 0;
+    }
+    return s_map[(size_t)py * s_mapWidth + px];
+}
+
+static volatile uint16_t *const MOTOR_OCR[] = {&OCR3C, &OCR5B, &OCR5C, &OCR5A};
+
+/* Voltage applied to a wheel's motor, positive driving the robot forward */
+static double wheelVoltage(const Wheel &w)
+{
+    if (w.motor < 0 || !digitalRead(MOTOR_nSLEEP_PIN))
+    {
+        return 0;
+    }
+    double duty = (*MOTOR_OCR[w.motor] & 0xFF) / 255.0;
+    /* FEHMotor drives the direction pin high for negative percentages */
+    bool reverse = digitalRead(pgm_read_byte(MOTOR_DIRECTION_PINS + w.motor));
+    return duty * s_busVoltage * (reverse ? -1 : 1) * w.sign;
+}
+
+static void updateEncoder(Wheel &w, double dAngle)
+{
+    w.angle += dAngle;
+    w.travel += fabs(dAngle);
+    if (w.encoderPins[0] > 15)
+    {
+        return;
+    }
+
+    uint8_t pinA = pgm_read_byte(FEHIOPIN_TO_ARDUINOPIN + w.encoderPins[0]);
+    if (w.encoderPins[1] <= 15)
+    {
+        int32_t counts = (int32_t)floor(w.angle * s_cfg.countsPerRev / (2 * M_PI));
+        Encoder *e = Encoder::find(pinA);
+        if (e)
+        {
+            e->step(counts - w.counted);
+        }
+        w.counted = counts;
+        return;
+    }
+
+    /* Single channel: one pin change per count, in either direction */
+    int32_t counts = (int32_t)floor(w.travel * s_cfg.countsPerRev / (2 * M_PI));
+    while (w.counted < counts)
+    {
+        w.level = !w.level;
+        HostHardware::setPin(pinA, w.level);
+        w.counted++;
+    }
+}
+
+static void updateSensors()
+{
+    for (Sensor &b : s_cfg.bumps)
+    {
+        bool pressed = distanceToWalls(toWorld(b.at)) < BUMP_TRAVEL;
+        /* Switches pull the input low when closed */
+        if (b.level == pressed)
+        {
+            b.level = !pressed;
+            HostHardware::setPin(pgm_read_byte(FEHIOPIN_TO_ARDUINOPIN + b.fehPin), b.level);
+        }
+    }
+
+    std::normal_distribution<double> noise(0, s_cfg.optoNoise > 0 ? s_cfg.optoNoise : 1);
+    for (const Sensor &o : s_cfg.optos)
+    {
+        double v = s_cfg.floorVoltage + (s_cfg.lineVoltage - s_cfg.floorVoltage) * darknessAt(toWorld(o.at));
+        if (s_cfg.optoNoise > 0)
+        {
+            v += noise(s_rng);
+        }
+        v = fmin(fmax(v, 0), ADC_VREF);
+        uint8_t pin = pgm_read_byte(FEHIOPIN_TO_ARDUINOPIN + o.fehPin);
+        if (pin >= A0)
+        {
+            HostHardware::setAnalog(pin - A0, (uint16_t)lround(v / ADC_VREF * 1023));
+        }
+    }
+
+    double battery = fmin(s_busVoltage / BATTERY_DIVIDER, ADC_VREF);
+    HostHardware::setAnalog(BATTERY_PIN - A0, (uint16_t)lround(battery / ADC_VREF * 1023));
+}
+
+static void step(double dt)
+{
+    double wFree = freeSpeed12V();
+    double follow = 1 - exp(-dt / s_cfg.motorTimeConstant);
+    double current = 0;
+
+    for (Wheel &w : s_wheels)
+    {
+        double v = wheelVoltage(w);
+        w.speed += (v / 12 * wFree - w.speed) * follow;
+        /* Stall current at 12 V, falling linearly to zero at free speed; drawn for the PWM duty */
+        double duty = s_busVoltage > 0 ? fabs(v) / s_busVoltage : 0;
+        current += fabs(s_cfg.motorStallCurrent * (v / 12 - w.speed / wFree)) * duty;
+    }
+    s_busVoltage = s_cfg.batteryVoltage - s_cfg.batteryResistance * current;
+    s_stats.minBusVoltage = fmin(s_stats.minBusVoltage, s_busVoltage);
+
+    double r = s_cfg.wheelDiameter / 2;
+    double vLeft = s_wheels[0].speed * r, vRight = s_wheels[1].speed * r;
+    double forward = (vLeft + vRight) / 2 * dt;
+    double turn = (vRight - vLeft) / s_cfg.wheelBase * dt;
+
+    double mid = s_heading + turn / 2;
+    Point next = {s_pos.x + forward * cos(mid), s_pos.y + forward * sin(mid)};
+    if (forward != 0 && distanceToWalls(next) < s_cfg.robotRadius && distanceToWalls(next) < distanceToWalls(s_pos))
+    {
+        /* Blocked: the wheels stall except for turning in place */
+        double common = (s_wheels[0].speed + s_wheels[1].speed) / 2;
+        s_wheels[0].speed -= common;
+        s_wheels[1].speed -= common;
+        vLeft -= common * r;
+        vRight -= common * r;
+        s_stats.wallSeconds += dt;
+    }
+    else
+    {
+        s_pos = next;
+        s_stats.distance += fabs(forward);
+    }
+    s_heading += turn;
+
+    updateEncoder(s_wheels[0], vLeft / r * dt);
+    updateEncoder(s_wheels[1], vRight / r * dt);
+    updateSensors();
+}
+
+static void end(const char *reason)
+{
+    if (s_ended)
+    {
+        return;
+    }
+    s_ended = true;
+    if (s_trace)
+    {
+        fflush(s_trace);
+    }
+    if (s_endHandler)
+    {
+        s_endHandler(reason);
+    }
+}
+
+static void tick(uint64_t now)
+{
+    while (s_lastMicros < now)
+    {
+        uint64_t dt = now - s_lastMicros < STEP_US ? now - s_lastMicros : STEP_US;
+        step(dt / 1e6);
+        s_lastMicros += dt;
+
+        if (s_trace && s_lastMicros >= s_nextTrace)
+        {
+            fprintf(s_trace, "%.3f,%.3f,%.3f,%.2f,%.3f,%.3f,%.3f\n", (s_lastMicros - s_startMicros) / 1e6, s_pos.x,
+                    s_pos.y, s_heading * 180 / M_PI, s_wheels[0].speed * s_cfg.wheelDiameter / 2,
+                    s_wheels[1].speed * s_cfg.wheelDiameter / 2, s_busVoltage);
+            s_nextTrace += TRACE_US;
+        }
+    }
+
+    s_stats.seconds = (now - s_startMicros) / 1e6;
+    if (s_cfg.finishRadius > 0 && s_stats.lapSeconds < 0)
+    {
+        double dx = s_pos.x - s_cfg.finish.x, dy = s_pos.y - s_cfg.finish.y;
+        if (dx * dx + dy * dy <= s_cfg.finishRadius * s_cfg.finishRadius)
+        {
+            s_stats.lapSeconds = s_stats.seconds;
+            end("finish");
+        }
+    }
+    if (s_timeLimit > 0 && s_stats.seconds >= s_timeLimit)
+    {
+        end("time_limit");
+    }
+}
+
+/* Virtual time each library read costs, roughly as on the controller */
+static int32_t timedRead(uint8_t type, uint8_t id, int32_t live)
+{
+    static const uint16_t COST_US[] = {
+        0,   // unused
+        4,   // RECORD_DIGITAL
+        112, // RECORD_ANALOG: one conversion at the Arduino ADC clock
+        4,   // RECORD_ENCODER
+        4,   // RECORD_TOUCH: the background poll's I2C time is emulated by the TWI model
+        4,   // RECORD_TOUCHED
+        4,   // RECORD_EVENT
+        4,   // RECORD_TIME
+        0,   // RECORD_ESP32
+    };
+    if (type < sizeof(COST_US) / sizeof(COST_US[0]))
+    {
+        HostHardware::advanceMicros(COST_US[type]);
+    }
+    return live;
+}
+
+//=============================================================================
+// CONTROL
+//=============================================================================
+
+bool RobotSim::start()
+{
+    if (!s_cfg.lineMap.empty() && !loadLineMap(s_cfg.lineMap.c_str()))
+    {
+        return false;
+    }
+
+    s_pos = s_cfg.start;
+    s_heading = s_cfg.startHeading * M_PI / 180;
+    s_busVoltage = s_cfg.batteryVoltage;
+    s_rng.seed(s_cfg.seed);
+    s_stats = Stats();
+    s_stats.lapSeconds = -1;
+    s_stats.minBusVoltage = s_busVoltage;
+    s_ended = false;
+    for (Wheel &w : s_wheels)
+    {
+        w.speed = w.angle = w.travel = 0;
+        w.counted = 0;
+        w.level = true;
+        if (w.encoderPins[0] <= 15)
+        {
+            HostHardware::setPin(pgm_read_byte(FEHIOPIN_TO_ARDUINOPIN + w.encoderPins[0]), true);
+        }
+    }
+    for (Sensor &b : s_cfg.bumps)
+    {
+        b.level = true;
+        HostHardware::setPin(pgm_read_byte(FEHIOPIN_TO_ARDUINOPIN + b.fehPin), true);
+    }
+    updateSensors();
+
+    s_startMicros = s_lastMicros = s_nextTrace = HostHardware::nowMicros();
+    HostHardware::setTickHook(tick);
+    _recorderReplay(timedRead);
+    return true;
+}
+
+void RobotSim::stop()
+{
+    _recorderReplay(nullptr);
+    HostHardware::setTickHook(nullptr);
+    if (s_trace)
+    {
+        fclose(s_trace);
+        s_trace = nullptr;
+    }
+}
+
+void RobotSim::setTimeLimit(double seconds)
+{
+    s_timeLimit = seconds;
+}
+
+void RobotSim::setEndHandler(void (*handler)(const char *reason))
+{
+    s_endHandler = handler;
+}
+
+bool RobotSim::traceTo(const char *path)
+{
+    s_trace = fopen(path, "w");
+    if (s_trace == nullptr)
+    {
+        perror(path);
+        return false;
+    }
+    fprintf(s_trace, "t,x,y,heading_deg,left_speed,right_speed,bus_voltage\n");
+    return true;
+}
+
+RobotSim::Pose RobotSim::pose()
+{
+    return {s_pos.x, s_pos.y, s_heading * 180 / M_PI};
+}
+
+RobotSim::Stats RobotSim::stats()
+{
+    return s_stats;
+}
+
+double RobotSim::param(const char *name, double fallback)
+{
+    auto it = s_params.find(name);
+    double value = it == s_params.end() ? fallback : it->second;
+    s_paramsUsed[name] = value;
+    return value;
+}
+
+void RobotSim::setParam(const char *name, double value)
+{
+    s_params[name] = value;
+}
+
+const char *RobotSim::paramsJson()
+{
+    s_paramsJson = "{";
+    for (auto &p : s_paramsUsed)
+    {
+        char item[96];
+        snprintf(item, sizeof(item), "%s\"%s\": %g", s_paramsJson.size() > 1 ? ", " : "", p.first.c_str(), p.second);
+        s_paramsJson += item;
+    }
+    s_paramsJson += "}";
+    return s_paramsJson.c_str();
+}
@@ -0,0 +1,73 @@
+/**
+ * RobotSim.h
+ *
+ * Differential-drive robot model for the host build. It reads what the library drives
+ * (motor PWM registers and direction pins) and writes what the library reads (encoder
+ * edges, bump switch levels, optosensor and battery voltages), so unmodified ERCMain()
+ * code runs against it in virtual time, much faster than real time.
+ *
+ * Units are inches, seconds, volts and degrees. Robot-frame points have x forward and
+ * y to the left of the robot's center. See host/README.md for the configuration keys.
+ */
+
+#ifndef ROBOT_SIM_H
+#define ROBOT_SIM_H
+
+#include <stdint.h>
+
+namespace RobotSim
+{
+    /// Read a configuration file of "key = value" lines. @return false with a message on stderr
+    bool loadConfig(const char *path);
+
+    /// Set one configuration key, e.g. from the command line. @return false if unknown or invalid
+    bool setOption(const char *key, const char *value);
+
+    /**
+     * @brief Place the robot at its start pose and take over HostHardware's tick hook.
+     *
+     * Every library input read also costs virtual time from here on (about as long as it
+     * takes on the controller), so loops that poll sensors without sleeping still advance.
+     */
+    bool start();
+
+    void stop();
+
+    /// Stop the run (calling the end handler) once this much robot time has passed
+    void setTimeLimit(double seconds);
+
+    /// Called once when the time limit or the finish circle is reached
+    void setEndHandler(void (*handler)(const char *reason));
+
+    /// Append the pose every 10 ms to a CSV file
+    bool traceTo(const char *path);
+
+    struct Pose
+    {
+        double x, y;       ///< Inches from the bottom left corner of the arena
+        double headingDeg; ///< Counterclockwise from +x
+    };
+    Pose pose();
+
+    struct Stats
+    {
+        double seconds;          ///< Robot time since start()
+        double lapSeconds;       ///< Time the finish circle was first entered, or -1
+        double distance;         ///< Inches traveled by the robot center
+        double wallSeconds;      ///< Time spent pushing against a wall
+        double minBusVoltage;    ///< Lowest motor supply voltage under load
+    };
+    Stats stats();
+
+    /**
+     * @brief Tunable value for sweeps: @p fallback unless set with setParam() or --param.
+     *
+     * Student code can use it under #ifdef FEH_ROBOTSIM, e.g. `kp = RobotSim::param("kp", kp);`.
+     */
+    double param(const char *name, double fallback);
+    void setParam(const char *name, double value);
+    /// Parameters read by param() so far, as a JSON object
+    const char *paramsJson();
+}
+
+#endif // ROBOT_SIM_H
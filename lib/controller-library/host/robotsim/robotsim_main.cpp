@@ -0,0 +1,129 @@
+/**
+ * robotsim_main.cpp
+ *
+ * main() for programs built with feh_add_robotsim(): runs the student's ERCMain() against
+ * the robot model and prints a JSON summary of the run. See host/README.md.
+ */
+
+#include <FEH.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include "HostHardware.h"
+#include "RobotSim.h"
+
+void ERCMain(void);
+
+static std::chrono::steady_clock::time_point s_wallStart;
+static FILE *s_out = stdout;
+
+static void report(const char *reason)
+{
+    RobotSim::Stats s = RobotSim::stats();
+    RobotSim::Pose p = RobotSim::pose();
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - s_wallStart).count();
+
+    fprintf(s_out,
+            "{\"reason\": \"%s\", \"seconds\": %.3f, \"lap_seconds\": %.3f, \"x\": %.2f, \"y\": %.2f, "
+            "\"heading_deg\": %.1f, \"distance\": %.2f, \"wall_seconds\": %.3f, \"min_bus_voltage\": %.2f, "
+            "\"wall_clock_seconds\": %.3f, \"speedup\": %.1f, \"params\": %s}\n",
+            reason, s.seconds, s.lapSeconds, p.x, p.y, p.headingDeg, s.distance, s.wallSeconds, s.minBusVoltage,
+            wall, wall > 0 ? s.seconds / wall : 0.0, RobotSim::paramsJson());
+    fflush(s_out);
+}
+
+static void ended(const char *reason)
+{
+    report(reason);
+    exit(0);
+}
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s [--config robot.cfg] [--set key=value]... [--param name=value]...\n"
+            "       [--seconds 60] [--trace pose.csv] [--json result.json] [--echo]\n",
+            program);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = 60;
+    bool echo = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *a = argv[i];
+        const char *v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!strcmp(a, "--echo"))
+        {
+            echo = true;
+            continue;
+        }
+        if (v == nullptr)
+        {
+            usage(argv[0]);
+        }
+        i++;
+
+        if (!strcmp(a, "--config"))
+        {
+            if (!RobotSim::loadConfig(v))
+                return 2;
+        }
+        else if (!strcmp(a, "--set") || !strcmp(a, "--param"))
+        {
+            const char *eq = strchr(v, '=');
+            if (eq == nullptr)
+                usage(argv[0]);
+            std::string key(v, eq - v);
+            if (a[2] == 'p')
+            {
+                RobotSim::setParam(key.c_str(), atof(eq + 1));
+            }
+            else if (!RobotSim::setOption(key.c_str(), eq + 1))
+            {
+                fprintf(stderr, "bad option '%s'\n", v);
+                return 2;
+            }
+        }
+        else if (!strcmp(a, "--seconds"))
+            seconds = atof(v);
+        else if (!strcmp(a, "--trace"))
+        {
+            if (!RobotSim::traceTo(v))
+                return 2;
+        }
+        else if (!strcmp(a, "--json"))
+        {
+            s_out = fopen(v, "w");
+            if (s_out == nullptr)
+            {
+                perror(v);
+                return 2;
+            }
+        }
+        else
+            usage(argv[0]);
+    }
+
+    HostHardware::setSerialEcho(echo);
+    sei();
+    /* The parts of the library's setup() that the model depends on */
+    FEHMotor::SetAllSleep(false);
+
+    RobotSim::setTimeLimit(seconds);
+    RobotSim::setEndHandler(ended);
+    if (!RobotSim::start())
+    {
+        return 2;
+    }
+
+    s_wallStart = std::chrono::steady_clock::now();
+    ERCMain();
+    report("returned");
+    return 0;
+}
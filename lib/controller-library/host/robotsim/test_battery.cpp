@@ -0,0 +1,144 @@
+/**
+ * test_battery.cpp
+ *
+ * Speed consistency across battery states: the same timed drive (1 s at 80% on 9 V
+ * motors) from a charged pack down to LOW_BATTERY_THRESHOLD, with the robot model's bus
+ * sagging under load, once with the fixed 12 V motor scaling and once with
+ * FEHMotor::SetBatteryCompensation(). Compensation turned on while the scheduler queue
+ * is full must still follow the battery once the queue drains.
+ */
+
+#include <FEH.h>
+#include <stdio.h>
+#include <math.h>
+#include "HostHardware.h"
+#include "RobotSim.h"
+#include "scheduler.h"
+#include "../tests/check.h"
+
+static const double BATTERIES[] = {12.6, 11.7, 11.0, 10.0};
+#define BATTERY_COUNT (sizeof(BATTERIES) / sizeof(BATTERIES[0]))
+
+struct Drive
+{
+    double inches;
+    double effectiveVolts;
+};
+
+static Drive drive(double battery, bool compensate)
+{
+    char value[16];
+    snprintf(value, sizeof(value), "%.2f", battery);
+    RobotSim::setOption("battery_voltage", value);
+    RobotSim::start();
+
+    FEHMotor left(FEHMotor::Motor0, 9.0), right(FEHMotor::Motor1, 9.0);
+    FEHMotor::SetBatteryCompensation(compensate);
+    double startX = RobotSim::pose().x;
+    left.SetPercent(80);
+    right.SetPercent(-80);
+    Sleep(1000);
+
+    Drive d = {RobotSim::pose().x - startX, left.EffectiveVolts()};
+    left.Stop();
+    right.Stop();
+    FEHMotor::SetBatteryCompensation(false);
+    Sleep(500);
+    RobotSim::stop();
+    return d;
+}
+
+static void idle()
+{
+}
+
+/* The same drive with compensation turned on into a full scheduler queue, and the pack
+   dropping from @p from to @p to volts 100 ms in */
+static double refusedDrive(double from, double to)
+{
+    char value[16];
+    snprintf(value, sizeof(value), "%.2f", from);
+    RobotSim::setOption("battery_voltage", value);
+    RobotSim::start();
+
+    FEHMotor left(FEHMotor::Motor0, 9.0), right(FEHMotor::Motor1, 9.0);
+    while (schedulerHasRoom())
+    {
+        scheduleEvent(idle, schedulerMsToTicks(10));
+    }
+    FEHMotor::SetBatteryCompensation(true);
+    double startX = RobotSim::pose().x;
+    left.SetPercent(80);
+    right.SetPercent(-80);
+    Sleep(100);
+    snprintf(value, sizeof(value), "%.2f", to);
+    RobotSim::setOption("battery_voltage", value);
+    Sleep(900);
+
+    double inches = RobotSim::pose().x - startX;
+    left.Stop();
+    right.Stop();
+    FEHMotor::SetBatteryCompensation(false);
+    Sleep(500);
+    RobotSim::stop();
+    return inches;
+}
+
+/* (max - min) / mean of the distances */
+static double spread(const Drive *d)
+{
+    double lo = d[0].inches, hi = d[0].inches, sum = 0;
+    for (size_t i = 0; i < BATTERY_COUNT; i++)
+    {
+        lo = fmin(lo, d[i].inches);
+        hi = fmax(hi, d[i].inches);
+        sum += d[i].inches;
+    }
+    return (hi - lo) / (sum / BATTERY_COUNT);
+}
+
+int main()
+{
+    const char *options[][2] = {
+        {"arena_width", "200"}, {"arena_height", "48"},
+        {"start_x", "12"}, {"start_y", "24"}, {"start_heading", "0"},
+        {"wheel_diameter", "2.5"}, {"wheel_base", "7.5"}, {"wheel_free_rpm", "120"},
+        {"left_motor", "0 1"}, {"right_motor", "1 -1"},
+    };
+    for (auto &o : options)
+    {
+        if (!RobotSim::setOption(o[0], o[1]))
+        {
+            printf("bad option %s\n", o[0]);
+            return 1;
+        }
+    }
+
+    sei();
+    FEHMotor::SetAllSleep(false);
+
+    Drive fixed[BATTERY_COUNT], compensated[BATTERY_COUNT];
+    printf("battery   fixed in  volts   compensated in  volts\n");
+    for (size_t i = 0; i < BATTERY_COUNT; i++)
+    {
+        fixed[i] = drive(BATTERIES[i], false);
+        compensated[i] = drive(BATTERIES[i], true);
+        printf("%5.1f V  %8.2f  %5.2f  %14.2f  %5.2f\n", BATTERIES[i], fixed[i].inches, fixed[i].effectiveVolts,
+               compensated[i].inches, compensated[i].effectiveVolts);
+    }
+
+    check(spread(fixed) > 0.15, "fixed scaling distance spread", spread(fixed));
+    check(spread(compensated) < 0.03, "compensated distance spread", spread(compensated));
+    for (size_t i = 0; i < BATTERY_COUNT; i++)
+    {
+        char what[48];
+        snprintf(what, sizeof(what), "compensated volts at %.1f V", BATTERIES[i]);
+        check(fabs(compensated[i].effectiveVolts - 7.2) < 0.15, what, compensated[i].effectiveVolts);
+    }
+
+    double refused = refusedDrive(BATTERIES[0], BATTERIES[BATTERY_COUNT - 1]);
+    double expected = compensated[BATTERY_COUNT - 1].inches;
+    check(fabs(refused - expected) < 0.03 * expected, "queue full at start, distance / 10 V", refused / expected);
+
+    return checkResult("battery");
+}
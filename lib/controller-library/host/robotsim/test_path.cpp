@@ -0,0 +1,117 @@
+/**
+ * test_path.cpp
+ *
+ * FEHPath on the robot model: a course of a line, an arc, a square corner and a finish
+ * turn driven from odometry alone, with a single channel encoder on one wheel and a
+ * quadrature encoder on the other. Checks where the robot ends up against the model's
+ * true pose, that the end point repeats from a charged pack to a low one, and compares
+ * the time with driving the same distance at a fixed 35%.
+ */
+
+#include <FEH.h>
+#include <stdio.h>
+#include <math.h>
+#include "HostHardware.h"
+#include "RobotSim.h"
+#include "../tests/check.h"
+
+/* 120 rpm on a 2.5 in wheel, with 9 V motors held at 9 V by battery compensation */
+#define TOP_SPEED (120 / 60.0 * M_PI * 2.5 * 9 / 12)
+
+struct Lap
+{
+    bool finished;
+    double seconds;
+    double length;
+    RobotSim::Pose truth;
+    FEHPath::Pose odometry;
+};
+
+static Lap lap(double battery)
+{
+    char value[16];
+    snprintf(value, sizeof(value), "%.2f", battery);
+    RobotSim::setOption("battery_voltage", value);
+    RobotSim::start();
+
+    FEHMotor left(FEHMotor::Motor0, 9.0), right(FEHMotor::Motor1, 9.0);
+    FEHMotor::SetBatteryCompensation(true);
+    DigitalEncoder leftEncoder(FEHIO::Pin8);
+    DigitalQuadratureEncoder rightEncoder(FEHIO::Pin10, FEHIO::Pin11);
+
+    FEHPath path(left, right, leftEncoder, rightEncoder, 2.5, 7.5, 318, TOP_SPEED);
+    path.SetMotorReversed(false, true);
+    path.SetPose(12, 24, 0);
+
+    path.Clear();
+    path.LineTo(48, 24);
+    path.Arc(12, 90);     // To (60, 36) facing +y
+    path.LineTo(60, 60);
+    path.LineTo(30, 60);  // Square corner
+    path.SetFinishHeading(-90);
+
+    Lap l;
+    l.length = 36 + M_PI * 12 / 2 + 24 + 30;
+    Stopwatch time;
+    l.finished = path.Follow(20);
+    l.seconds = time.ElapsedSeconds();
+    Sleep(300);
+    l.truth = RobotSim::pose();
+    l.odometry = path.GetPose();
+
+    FEHMotor::SetBatteryCompensation(false);
+    RobotSim::stop();
+    return l;
+}
+
+int main()
+{
+    const char *options[][2] = {
+        {"arena_width", "96"}, {"arena_height", "96"},
+        {"start_x", "12"}, {"start_y", "24"}, {"start_heading", "0"},
+        {"wheel_diameter", "2.5"}, {"wheel_base", "7.5"}, {"wheel_free_rpm", "120"},
+        {"left_motor", "0 1"}, {"right_motor", "1 -1"},
+        {"left_encoder", "8"}, {"right_encoder", "10 11"}, {"encoder_counts_per_rev", "318"},
+    };
+    for (auto &o : options)
+    {
+        if (!RobotSim::setOption(o[0], o[1]))
+        {
+            printf("bad option %s\n", o[0]);
+            return 1;
+        }
+    }
+
+    sei();
+    FEHMotor::SetAllSleep(false);
+
+    Lap charged = lap(12.6);
+    Lap low = lap(10.5);
+    printf("battery  seconds   true x      y  heading   odometry x      y  heading\n");
+    for (const Lap *l : {&charged, &low})
+    {
+        printf("%5.1f V  %7.2f  %7.2f %6.2f  %7.1f   %10.2f %6.2f  %7.1f\n", l == &charged ? 12.6 : 10.5,
+               l->seconds, l->truth.x, l->truth.y, l->truth.headingDeg, l->odometry.x, l->odometry.y,
+               l->odometry.headingDeg);
+    }
+
+    check(charged.finished, "path completed", charged.seconds);
+    double error = hypot(charged.truth.x - 30, charged.truth.y - 60);
+    check(error < 1.0, "end point error, in", error);
+    double headingError = fabs(remainder(charged.truth.headingDeg + 90, 360));
+    check(headingError < 3, "finish heading error, deg", headingError);
+    double odometryError = hypot(charged.truth.x - charged.odometry.x, charged.truth.y - charged.odometry.y);
+    check(odometryError < 0.5, "odometry drift, in", odometryError);
+
+    check(low.finished, "path completed on a low battery", low.seconds);
+    double repeat = hypot(charged.truth.x - low.truth.x, charged.truth.y - low.truth.y);
+    check(repeat < 0.5, "end point change 12.6 V to 10.5 V, in", repeat);
+
+    // The same distance at a fixed 35%, not counting stops to turn at each corner
+    double fixed = charged.length / (0.35 * TOP_SPEED);
+    printf("%.1f in course: %.2f s following the path, %.2f s at a fixed 35%%\n", charged.length, charged.seconds,
+           fixed);
+    check(charged.seconds < 0.6 * fixed, "path time / fixed 35% time", charged.seconds / fixed);
+
+    return checkResult("path");
+}
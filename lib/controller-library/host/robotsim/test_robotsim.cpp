@@ -0,0 +1,107 @@
+/**
+ * test_robotsim.cpp
+ *
+ * Drives the robot model through the library: straight line distance and encoder counts,
+ * an optosensor crossing a line from a map image, and a bump switch against the arena wall.
+ */
+
+#include <FEH.h>
+#include <stdio.h>
+#include <math.h>
+#include "HostHardware.h"
+#include "RobotSim.h"
+#include "../tests/check.h"
+
+#define MAP_PATH "robotsim_test_map.pgm"
+#define PPI 4
+
+/* 48 x 48 in floor with a 1 in dark line along x = 30 */
+static void writeMap()
+{
+    FILE *f = fopen(MAP_PATH, "wb");
+    fprintf(f, "P5\n%d %d\n255\n", 48 * PPI, 48 * PPI);
+    for (int y = 0; y < 48 * PPI; y++)
+    {
+        for (int x = 0; x < 48 * PPI; x++)
+        {
+            fputc(fabs((x + 0.5) / PPI - 30) < 0.5 ? 0 : 255, f);
+        }
+    }
+    fclose(f);
+}
+
+int main()
+{
+    writeMap();
+
+    const char *options[][2] = {
+        {"arena_width", "48"}, {"arena_height", "48"},
+        {"start_x", "12"}, {"start_y", "24"}, {"start_heading", "0"},
+        {"wheel_diameter", "2.5"}, {"wheel_base", "7.5"}, {"wheel_free_rpm", "120"},
+        {"left_motor", "0 1"}, {"right_motor", "1 -1"},
+        {"left_encoder", "8"}, {"right_encoder", "10 11"}, {"encoder_counts_per_rev", "318"},
+        {"bump", "1 4.5 0"}, {"opto", "0 2 0"},
+        {"line_map", MAP_PATH}, {"floor_voltage", "0.4"}, {"line_voltage", "2.8"},
+    };
+    for (auto &o : options)
+    {
+        if (!RobotSim::setOption(o[0], o[1]))
+        {
+            printf("bad option %s\n", o[0]);
+            return 1;
+        }
+    }
+
+    sei();
+    FEHMotor::SetAllSleep(false);
+    if (!RobotSim::start())
+    {
+        return 1;
+    }
+
+    FEHMotor left(FEHMotor::Motor0, 12), right(FEHMotor::Motor1, 12);
+    DigitalEncoder leftEncoder(FEHIO::Pin8);
+    DigitalQuadratureEncoder rightEncoder(FEHIO::Pin10, FEHIO::Pin11);
+    DigitalInputPin bump(FEHIO::Pin1);
+    AnalogInputPin opto(FEHIO::Pin0);
+
+    /* One second at 50%: 0.5 * 11.7 V / 12 V * 2 rev/s, less the spin-up lag */
+    left.SetPercent(50);
+    right.SetPercent(-50);
+    Sleep(1000);
+    RobotSim::Pose p = RobotSim::pose();
+    double inchesPerCount = M_PI * 2.5 / 318;
+    check(p.x > 12 + 7.0 && p.x < 12 + 7.8, "x after 1 s at 50%", p.x);
+    check(fabs(p.y - 24) < 0.01 && fabs(p.headingDeg) < 0.01, "drift", fabs(p.y - 24) + fabs(p.headingDeg));
+    check(fabs(leftEncoder.Counts() * inchesPerCount - (p.x - 12)) < 0.1, "digital encoder inches",
+          leftEncoder.Counts() * inchesPerCount);
+    check(fabs(rightEncoder.Counts() * inchesPerCount - (p.x - 12)) < 0.1, "quadrature encoder inches",
+          rightEncoder.Counts() * inchesPerCount);
+    check(opto.Value() < 0.5, "optosensor on floor", opto.Value());
+
+    /* Poll without sleeping: reads cost virtual time, so this terminates */
+    while (opto.Value() < 1.6 && TimeNow() < 30)
+    {
+    }
+    check(fabs(RobotSim::pose().x + 2 - 30) < 0.6, "optosensor x when line seen", RobotSim::pose().x + 2);
+
+    while (bump.Value() && TimeNow() < 30)
+    {
+    }
+    check(fabs(RobotSim::pose().x - (48 - 4.5)) < 0.2, "x when bump switch closed", RobotSim::pose().x);
+
+    /* The switch closes 0.1 in before the robot's edge meets the wall */
+    Sleep(500);
+    check(fabs(RobotSim::pose().x - (48 - 4.5)) < 0.01, "x after pushing the wall", RobotSim::pose().x);
+    check(RobotSim::stats().wallSeconds > 0.45, "seconds against the wall", RobotSim::stats().wallSeconds);
+    check(RobotSim::stats().minBusVoltage < 11.7, "bus voltage sag", RobotSim::stats().minBusVoltage);
+
+    /* Turning in place (clockwise, right wheel backward) still works against the wall */
+    right.SetPercent(50);
+    Sleep(500);
+    check(RobotSim::pose().headingDeg < -45, "heading after turning in place", RobotSim::pose().headingDeg);
+
+    RobotSim::stop();
+    remove(MAP_PATH);
+    return checkResult("robotsim");
+}
@@ -0,0 +1,315 @@
+/**
+ * Adafruit_ILI9341.cpp (host shim)
+ *
+ * Clipping follows Adafruit_SPITFT.cpp (BSD license, Adafruit Industries).
+ */
+
+#include <Adafruit_ILI9341.h>
+
+/* Defined with the other HostHardware state in Arduino.cpp */
+void hostSelectLcd(HostSpiDevice *device);
+void hostSpiElapse(uint64_t bytes);
+
+/* CASET + 4 bytes, PASET + 4 bytes, RAMWR */
+#define ADDR_WINDOW_BYTES 11
+/* MADCTL + 1 byte */
+#define ROTATION_BYTES 2
+
+Adafruit_ILI9341::Adafruit_ILI9341(int8_t, int8_t, int8_t)
+    : Adafruit_GFX(ILI9341_TFTWIDTH, ILI9341_TFTHEIGHT)
+{
+    memset(_fb, 0, sizeof(_fb));
+    _stats = {0, 0, 0, 0};
+    _winX = _winY = _curX = _curY = 0;
+    _winW = _winH = 1;
+}
+
+void Adafruit_ILI9341::begin(uint32_t)
+{
+    memset(_fb, 0, sizeof(_fb));
+    _width = WIDTH;
+    _height = HEIGHT;
+    rotation = 0;
+}
+
+void Adafruit_ILI9341::setRotation(uint8_t m)
+{
+    Adafruit_GFX::setRotation(m);
+    _stats.spiBytes += ROTATION_BYTES;
+}
+
+uint32_t Adafruit_ILI9341::panelIndex(int16_t x, int16_t y) const
+{
+    int16_t px, py;
+    switch (rotation)
+    {
+    case 1:
+        px = WIDTH - 1 - y;
+        py = x;
+        break;
+    case 2:
+        px = WIDTH - 1 - x;
+        py = HEIGHT - 1 - y;
+        break;
+    case 3:
+        px = y;
+        py = HEIGHT - 1 - x;
+        break;
+    default:
+        px = x;
+        py = y;
+        break;
+    }
+    return (uint32_t)py * WIDTH + px;
+}
+
+void Adafruit_ILI9341::streamPixel(uint16_t color)
+{
+    _fb[panelIndex(_curX, _curY)] = color;
+    if (++_curX >= _winX + _winW)
+    {
+        _curX = _winX;
+        if (++_curY >= _winY + _winH)
+        {
+            _curY = _winY;
+        }
+    }
+}
+
+void Adafruit_ILI9341::startWrite(void)
+{
+    _stats.transactions++;
+    // The library's SPI_BEGIN_TRANSACTION: 24 MHz requested, F_CPU / 2 granted
+    SPCR = _BV(SPE) | _BV(MSTR);
+    SPSR = _BV(SPI2X);
+    hostSelectLcd(&_pixelData);
+}
+
+void Adafruit_ILI9341::endWrite(void)
+{
+    hostSelectLcd(NULL);
+}
+
+uint8_t Adafruit_ILI9341::PixelData::transfer(uint8_t out)
+{
+    _panel._stats.spiBytes++;
+    if (!_haveHigh)
+    {
+        _high = out;
+        _haveHigh = true;
+        return 0;
+    }
+    _haveHigh = false;
+    _panel._stats.pixels++;
+    _panel.streamPixel(_high << 8 | out);
+    return 0;
+}
+
+void Adafruit_ILI9341::setAddrWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+    _winX = _curX = x;
+    _winY = _curY = y;
+    _winW = w;
+    _winH = h;
+    _pixelData._haveHigh = false;
+    _stats.addrWindows++;
+    _stats.spiBytes += ADDR_WINDOW_BYTES;
+    hostSpiElapse(ADDR_WINDOW_BYTES);
+}
+
+void Adafruit_ILI9341::writePixels(const uint16_t *colors, uint32_t len)
+{
+    _stats.pixels += len;
+    _stats.spiBytes += 2 * (uint64_t)len;
+    hostSpiElapse(2 * (uint64_t)len);
+    while (len--)
+    {
+        streamPixel(*colors++);
+    }
+}
+
+void Adafruit_ILI9341::writeColor(uint16_t color, uint32_t len)
+{
+    _stats.pixels += len;
+    _stats.spiBytes += 2 * (uint64_t)len;
+    hostSpiElapse(2 * (uint64_t)len);
+    while (len--)
+    {
+        streamPixel(color);
+    }
+}
+
+void Adafruit_ILI9341::writePixel(int16_t x, int16_t y, uint16_t color)
+{
+    if ((x >= 0) && (x < _width) && (y >= 0) && (y < _height))
+    {
+        setAddrWindow(x, y, 1, 1);
+        writeColor(color, 1);
+    }
+}
+
+void Adafruit_ILI9341::drawPixel(int16_t x, int16_t y, uint16_t color)
+{
+    if ((x >= 0) && (x < _width) && (y >= 0) && (y < _height))
+    {
+        startWrite();
+        setAddrWindow(x, y, 1, 1);
+        writeColor(color, 1);
+        endWrite();
+    }
+}
+
+void Adafruit_ILI9341::writeFillRectPreclipped(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    setAddrWindow(x, y, w, h);
+    writeColor(color, (uint32_t)w * h);
+}
+
+void Adafruit_ILI9341::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    if (w && h)
+    {
+        if (w < 0)
+        {
+            x += w + 1;
+            w = -w;
+        }
+        if (x < _width)
+        {
+            if (h < 0)
+            {
+                y += h + 1;
+                h = -h;
+            }
+            if (y < _height)
+            {
+                int16_t x2 = x + w - 1;
+                if (x2 >= 0)
+                {
+                    int16_t y2 = y + h - 1;
+                    if (y2 >= 0)
+                    {
+                        if (x < 0)
+                        {
+                            x = 0;
+                            w = x2 + 1;
+                        }
+                        if (y < 0)
+                        {
+                            y = 0;
+                            h = y2 + 1;
+                        }
+                        if (x2 >= _width)
+                        {
+                            w = _width - x;
+                        }
+                        if (y2 >= _height)
+                        {
+                            h = _height - y;
+                        }
+                        writeFillRectPreclipped(x, y, w, h, color);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void Adafruit_ILI9341::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    startWrite();
+    writeFillRect(x, y, w, h, color);
+    endWrite();
+}
+
+void Adafruit_ILI9341::writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+    if ((y >= 0) && (y < _height) && w)
+    {
+        if (w < 0)
+        {
+            x += w + 1;
+            w = -w;
+        }
+        if (x < _width)
+        {
+            int16_t x2 = x + w - 1;
+            if (x2 >= 0)
+            {
+                if (x < 0)
+                {
+                    x = 0;
+                    w = x2 + 1;
+                }
+                if (x2 >= _width)
+                {
+                    w = _width - x;
+                }
+                writeFillRectPreclipped(x, y, w, 1, color);
+            }
+        }
+    }
+}
+
+void Adafruit_ILI9341::writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+    if ((x >= 0) && (x < _width) && h)
+    {
+        if (h < 0)
+        {
+            y += h + 1;
+            h = -h;
+        }
+        if (y < _height)
+        {
+            int16_t y2 = y + h - 1;
+            if (y2 >= 0)
+            {
+                if (y < 0)
+                {
+                    y = 0;
+                    h = y2 + 1;
+                }
+                if (y2 >= _height)
+                {
+                    h = _height - y;
+                }
+                writeFillRectPreclipped(x, y, 1, h, color);
+            }
+        }
+    }
+}
+
+void Adafruit_ILI9341::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+    startWrite();
+    writeFastHLine(x, y, w, color);
+    endWrite();
+}
+
+void Adafruit_ILI9341::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+    startWrite();
+    writeFastVLine(x, y, h, color);
+    endWrite();
+}
+
+uint16_t Adafruit_ILI9341::hostPixel(int16_t x, int16_t y) const
+{
+    if ((x < 0) || (x >= _width) || (y < 0) || (y >= _height))
+    {
+        return 0;
+    }
+    return _fb[panelIndex(x, y)];
+}
+
+uint32_t Adafruit_ILI9341::hostChecksum() const
+{
+    uint32_t hash = 2166136261u;
+    for (uint32_t i = 0; i < (uint32_t)WIDTH * HEIGHT; i++)
+    {
+        hash = (hash ^ (_fb[i] & 0xFF)) * 16777619u;
+        hash = (hash ^ (_fb[i] >> 8)) * 16777619u;
+    }
+    return hash;
+}
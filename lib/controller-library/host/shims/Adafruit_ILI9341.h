@@ -0,0 +1,106 @@
+/**
+ * Adafruit_ILI9341.h (host shim)
+ *
+ * The panel is a 240x320 RGB565 framebuffer. Drawing goes through the same
+ * Adafruit_SPITFT paths as on the robot (clipping, address windows, pixel streams), and
+ * every one of them is counted as the SPI bytes it would clock out, so the host can
+ * measure display traffic without the hardware. Between startWrite() and endWrite() the
+ * panel also takes pixel data written straight to the SPI port after setAddrWindow(), as
+ * the library's blitters send it.
+ */
+
+#ifndef HOST_ADAFRUIT_ILI9341_H
+#define HOST_ADAFRUIT_ILI9341_H
+
+#include <Adafruit_GFX.h>
+#include <SPI.h>
+#include "HostHardware.h"
+
+#define ILI9341_TFTWIDTH 240
+#define ILI9341_TFTHEIGHT 320
+
+#define ILI9341_BLACK 0x0000
+#define ILI9341_NAVY 0x000F
+#define ILI9341_DARKGREEN 0x03E0
+#define ILI9341_MAROON 0x7800
+#define ILI9341_BLUE 0x001F
+#define ILI9341_GREEN 0x07E0
+#define ILI9341_RED 0xF800
+#define ILI9341_YELLOW 0xFFE0
+#define ILI9341_WHITE 0xFFFF
+
+class Adafruit_ILI9341 : public Adafruit_GFX
+{
+public:
+    Adafruit_ILI9341(int8_t cs, int8_t dc, int8_t rst = -1);
+
+    void begin(uint32_t freq = 0);
+    void setRotation(uint8_t r) override;
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+    void startWrite(void) override;
+    void endWrite(void) override;
+    void writePixel(int16_t x, int16_t y, uint16_t color) override;
+    void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+    void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+    void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+
+    void setAddrWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+    void writePixels(const uint16_t *colors, uint32_t len);
+    void writeColor(uint16_t color, uint32_t len);
+    void writeFillRectPreclipped(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+
+    static uint16_t color565(uint8_t r, uint8_t g, uint8_t b)
+    {
+        return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+    }
+
+    /* Host only */
+
+    struct HostStats
+    {
+        uint64_t spiBytes;     ///< Command and data bytes the SPI bus would carry
+        uint64_t addrWindows;  ///< setAddrWindow() calls (11 bytes each)
+        uint64_t pixels;       ///< Pixels streamed (2 bytes each)
+        uint64_t transactions; ///< startWrite()/endWrite() pairs
+    };
+    const HostStats &hostStats() const { return _stats; }
+    void clearHostStats() { _stats = {0, 0, 0, 0}; }
+
+    /// Color at logical (rotated) coordinates
+    uint16_t hostPixel(int16_t x, int16_t y) const;
+    /// FNV-1a hash of the whole panel, to check that two drawing paths agree
+    uint32_t hostChecksum() const;
+    /// Raw panel memory, 240 columns by 320 rows
+    const uint16_t *hostFramebuffer() const { return _fb; }
+
+private:
+    uint32_t panelIndex(int16_t x, int16_t y) const;
+    void streamPixel(uint16_t color);
+
+    /* RGB565 pixels, high byte first, from SPI transfers while the panel is selected */
+    class PixelData : public HostSpiDevice
+    {
+    public:
+        explicit PixelData(Adafruit_ILI9341 &panel) : _panel(panel) {}
+        uint8_t transfer(uint8_t out) override;
+        bool _haveHigh = false;
+        uint8_t _high = 0;
+
+    private:
+        Adafruit_ILI9341 &_panel;
+    };
+    PixelData _pixelData{*this};
+
+    uint16_t _fb[ILI9341_TFTWIDTH * ILI9341_TFTHEIGHT];
+    HostStats _stats;
+
+    /* Current address window in logical coordinates, and the write position in it */
+    int16_t _winX, _winY, _winW, _winH;
+    int16_t _curX, _curY;
+};
+
+#endif // HOST_ADAFRUIT_ILI9341_H
@@ -0,0 +1,1337 @@
+/**
+ * Arduino.cpp (host shim)
+ *
+ * Registers, pin I/O, the virtual clock with Timer 1/4 emulation, Serial, and the rest of
+ * the Arduino core functions the library uses.
+ */
+
+#include <Arduino.h>
+#include <avr/wdt.h>
+#include <avr/sleep.h>
+#include <avr/eeprom.h>
+#include "HostHardware.h"
+
+#include <util/twi.h>
+
+#include <map>
+#include <vector>
+
+//=============================================================================
+// REGISTERS
+//=============================================================================
+
+#define HOST_DEFINE_REG8(name) volatile uint8_t name;
+#define HOST_DEFINE_REG16(name) volatile uint16_t name;
+HOST_REG8_LIST(HOST_DEFINE_REG8)
+HOST_REG16_LIST(HOST_DEFINE_REG16)
+#undef HOST_DEFINE_REG8
+#undef HOST_DEFINE_REG16
+
+HostAdcsraRegister ADCSRA;
+HostTwcrRegister TWCR;
+HostTifrRegister TIFR1, TIFR4;
+HostSpdrRegister SPDR;
+
+/* Same name and type as the AVR core's wiring.c, which keeps it global */
+volatile unsigned long timer0_overflow_count = 0;
+
+/* Interrupt vectors the emulation can raise. Weak so the shims link without the library. */
+extern "C" void TIMER1_COMPA_vect(void) __attribute__((weak));
+extern "C" void TIMER1_COMPB_vect(void) __attribute__((weak));
+extern "C" void TIMER4_COMPA_vect(void) __attribute__((weak));
+extern "C" void PCINT2_vect(void) __attribute__((weak));
+extern "C" void TWI_vect(void) __attribute__((weak));
+
+//=============================================================================
+// PIN MAPPING (Mega 2560 variant)
+//=============================================================================
+
+/* Port letter and bit of each digital pin, from variants/mega/pins_arduino.h */
+static const char PIN_PORT_BITS[NUM_DIGITAL_PINS][3] = {
+    "E0", "E1", "E4", "E5", "G5", "E3", "H3", "H4", "H5", "H6", "B4", "B5", "B6", "B7",
+    "J1", "J0", "H1", "H0", "D3", "D2", "D1", "D0", "A0", "A1", "A2", "A3", "A4", "A5",
+    "A6", "A7", "C7", "C6", "C5", "C4", "C3", "C2", "C1", "C0", "D7", "G2", "G1", "G0",
+    "L7", "L6", "L5", "L4", "L3", "L2", "L1", "L0", "B3", "B2", "B1", "B0", "F0", "F1",
+    "F2", "F3", "F4", "F5", "F6", "F7", "K0", "K1", "K2", "K3", "K4", "K5", "K6", "K7"};
+
+uint8_t digitalPinToPort(uint8_t pin)
+{
+    if (pin >= NUM_DIGITAL_PINS)
+    {
+        return NOT_A_PORT;
+    }
+    char letter = PIN_PORT_BITS[pin][0];
+    /* PA = 1 ... PH = 8, there is no port I, PJ = 10 ... PL = 12 */
+    return (letter < 'I') ? (letter - 'A' + PA) : (letter - 'J' + PJ);
+}
+
+uint8_t digitalPinToBitMask(uint8_t pin)
+{
+    if (pin >= NUM_DIGITAL_PINS)
+    {
+        return 0;
+    }
+    return 1 << (PIN_PORT_BITS[pin][1] - '0');
+}
+
+static volatile uint8_t *const PORT_INPUT[] = {
+    NULL, &PINA, &PINB, &PINC, &PIND, &PINE, &PINF, &PING, &PINH, NULL, &PINJ, &PINK, &PINL};
+static volatile uint8_t *const PORT_OUTPUT[] = {
+    NULL, &PORTA, &PORTB, &PORTC, &PORTD, &PORTE, &PORTF, &PORTG, &PORTH, NULL, &PORTJ, &PORTK, &PORTL};
+static volatile uint8_t *const PORT_MODE[] = {
+    NULL, &DDRA, &DDRB, &DDRC, &DDRD, &DDRE, &DDRF, &DDRG, &DDRH, NULL, &DDRJ, &DDRK, &DDRL};
+
+volatile uint8_t *portInputRegister(uint8_t port) { return port <= PL ? PORT_INPUT[port] : NULL; }
+volatile uint8_t *portOutputRegister(uint8_t port) { return port <= PL ? PORT_OUTPUT[port] : NULL; }
+volatile uint8_t *portModeRegister(uint8_t port) { return port <= PL ? PORT_MODE[port] : NULL; }
+
+//=============================================================================
+// HOST STATE
+//=============================================================================
+
+static uint64_t s_nowMicros = 0;
+static bool s_inAdvance = false;
+static void (*s_tickHook)(uint64_t) = NULL;
+
+static uint16_t s_analog[NUM_ANALOG_INPUTS];
+static uint16_t (*s_analogProvider)(uint8_t) = NULL;
+static uint8_t s_pinMode[NUM_DIGITAL_PINS];
+
+static std::string s_serialOut;
+static std::string s_serialIn;
+static bool s_serialEcho = false;
+
+/* Serial pacing: the time the last queued byte finishes shifting out, in nanoseconds */
+static bool s_serialPaced = false;
+static size_t s_serialTxSize = SERIAL_TX_BUFFER_SIZE;
+static uint64_t s_serialBusyUntilNs = 0;
+static HostHardware::SerialStats s_serialStats;
+
+static std::map<uint8_t, HostSpiDevice *> s_spiDevices;
+static std::map<uint8_t, HostI2cDevice *> s_i2cDevices;
+static HostHardware::SpiStats s_spiStats;
+/* The display while its driver has chip select low, see hostSelectLcd() */
+static HostSpiDevice *s_lcdDevice;
+/* SPI timing: nanoseconds of bus time not yet added to the clock */
+static bool s_spiTimed = false;
+static uint64_t s_spiPendingNs = 0;
+
+/* TWI bus model, see the TWI section */
+static void twiReset();
+static void serviceTwi();
+static bool twiDue(uint64_t *dueMicros);
+
+/* The FT6206 touch panel on the shield, answering at its address unless a test attaches
+   its own device there. Touches come from HostHardware::setTouch(). */
+class HostTouchPanel : public HostI2cDevice
+{
+public:
+    void receive(const uint8_t *data, size_t len) override
+    {
+        if (len > 0)
+        {
+            _reg = data[0];
+        }
+    }
+
+    void request(uint8_t *data, size_t len) override
+    {
+        uint8_t regs[256] = {0};
+        /* The panel is mounted rotated from the landscape display, see FEHLCD::Touch() */
+        bool touched;
+        int16_t x, y;
+        HostHardware::touchState(&touched, &x, &y);
+        uint16_t panelX = touched ? y : 0;
+        uint16_t panelY = touched ? 320 - x : 0;
+        regs[0x02] = touched ? 1 : 0;
+        regs[0x03] = panelX >> 8;
+        regs[0x04] = panelX & 0xFF;
+        regs[0x05] = panelY >> 8;
+        regs[0x06] = panelY & 0xFF;
+        regs[0xA3] = 0x06; // Chip ID: FT6206
+        regs[0xA8] = 0x11; // Vendor ID: FocalTech
+        for (size_t i = 0; i < len; i++)
+        {
+            data[i] = regs[(uint8_t)(_reg + i)];
+        }
+    }
+
+private:
+    uint8_t _reg = 0;
+};
+
+/* A read asks the device for this many bytes at SLA+R and hands them out one by one */
+#define HOST_TWI_READ_AHEAD 32
+
+enum HostTwiMode
+{
+    TWI_IDLE,     // No START sent
+    TWI_ADDRESS,  // START sent, next byte is SLA+R/W
+    TWI_TRANSMIT, // Writing to a device
+    TWI_RECEIVE,  // Reading from a device
+};
+
+#define HOST_FT6206_ADDRESS 0x38
+
+static HostTouchPanel s_touchPanel;
+static HostHardware::I2cStats s_i2cStats;
+static bool s_twiStuck = false;
+
+static HostTwiMode s_twiMode = TWI_IDLE;
+static HostI2cDevice *s_twiDevice = NULL;
+static std::vector<uint8_t> s_twiWrite; // Bytes written since SLA+W, given to the device at STOP
+static uint8_t s_twiRead[HOST_TWI_READ_AHEAD];
+static uint8_t s_twiReadIndex = 0;
+
+static bool s_twiBusy = false; // An operation is on the bus
+static uint64_t s_twiDueNs = 0;
+static uint8_t s_twiStatus = 0;
+static uint8_t s_twiData = 0;
+
+static bool s_touched = false;
+static int16_t s_touchX = 0;
+static int16_t s_touchY = 0;
+
+static bool s_watchdogArmed = false;
+
+static uint8_t s_eeprom[E2END + 1];
+static struct HostEepromInit
+{
+    HostEepromInit() { memset(s_eeprom, 0xFF, sizeof(s_eeprom)); }
+} s_eepromInit;
+
+/* Emulated 16-bit timer, with compare B where the library uses it */
+struct HostTimer16
+{
+    volatile uint8_t *tccrA;
+    volatile uint8_t *tccrB;
+    volatile uint16_t *tcnt;
+    volatile uint16_t *ocrA;
+    volatile uint16_t *ocrB;
+    volatile uint8_t *timsk;
+    HostTifrRegister *tifr;
+    void (*isrA)(void);
+    void (*isrB)(void);
+    uint32_t residualCycles;
+};
+
+static HostTimer16 s_timers[] = {
+    {&TCCR1A, &TCCR1B, &TCNT1, &OCR1A, &OCR1B, &TIMSK1, &TIFR1, TIMER1_COMPA_vect, TIMER1_COMPB_vect, 0},
+    {&TCCR4A, &TCCR4B, &TCNT4, &OCR4A, NULL, &TIMSK4, &TIFR4, TIMER4_COMPA_vect, NULL, 0},
+};
+
+/* OCFnA/OCIEnA and OCFnB/OCIEnB */
+#define HOST_COMPARE_A (1 << 1)
+#define HOST_COMPARE_B (1 << 2)
+
+/* Timers 0-5 share the clock select encoding */
+static const uint16_t PRESCALERS[8] = {0, 1, 8, 64, 256, 1024, 0, 0};
+
+static bool interruptsEnabled() { return SREG & (1 << SREG_I); }
+
+/* Run an interrupt vector the way the hardware does: with the I bit cleared */
+static void dispatchIsr(void (*isr)(void))
+{
+    if (isr == NULL)
+    {
+        return;
+    }
+    uint8_t sreg = SREG;
+    cli();
+    isr();
+    SREG = sreg | (1 << SREG_I);
+}
+
+/* Run a timer's pending, enabled compare interrupts, A first as its vector comes first,
+ * including any that become pending while they run */
+static void dispatchTimer(HostTimer16 &t)
+{
+    while (interruptsEnabled())
+    {
+        if ((*t.tifr & HOST_COMPARE_A) && (*t.timsk & HOST_COMPARE_A))
+        {
+            t.tifr->_value &= ~HOST_COMPARE_A;
+            dispatchIsr(t.isrA);
+        }
+        else if ((*t.tifr & HOST_COMPARE_B) && (*t.timsk & HOST_COMPARE_B))
+        {
+            t.tifr->_value &= ~HOST_COMPARE_B;
+            dispatchIsr(t.isrB);
+        }
+        else
+        {
+            break;
+        }
+    }
+}
+
+static void dispatchPending()
+{
+    if (!interruptsEnabled())
+    {
+        return;
+    }
+    for (HostTimer16 &t : s_timers)
+    {
+        dispatchTimer(t);
+    }
+    if ((TWCR & _BV(TWINT)) && (TWCR & _BV(TWIE)))
+    {
+        dispatchIsr(TWI_vect);
+    }
+}
+
+/* Ticks from the count to a compare value, a full cycle if they are equal */
+static uint32_t ticksToCompare(uint16_t tcnt, uint16_t ocr, uint32_t top)
+{
+    uint32_t ticks = (uint16_t)(ocr - tcnt);
+    return ticks == 0 ? top + 1 : ticks;
+}
+
+/* Count a timer on by some CPU cycles, raising its compare matches. Without @p dispatch
+ * (time passing inside an ISR) matches only set their flags, as on the hardware. */
+static void runTimer(HostTimer16 &t, uint64_t cycles, bool dispatch)
+{
+    uint16_t prescaler = PRESCALERS[*t.tccrB & 0x07];
+    if (prescaler == 0)
+    {
+        t.residualCycles = 0;
+        return;
+    }
+
+    uint64_t total = cycles + t.residualCycles;
+    uint64_t ticks = total / prescaler;
+    t.residualCycles = total % prescaler;
+
+    while (ticks > 0)
+    {
+        /* WGMn2 in TCCRnB with WGMn3 clear is CTC with OCRnA as TOP */
+        bool ctc = (*t.tccrB & ((1 << 3) | (1 << 4))) == (1 << 3);
+        uint32_t top = ctc ? *t.ocrA : 0xFFFF;
+
+        uint32_t toA = ticksToCompare(*t.tcnt, *t.ocrA, top);
+        uint32_t toB = t.ocrB ? ticksToCompare(*t.tcnt, *t.ocrB, top) : UINT32_MAX;
+        uint32_t toMatch = toA < toB ? toA : toB;
+
+        if (ticks < toMatch)
+        {
+            *t.tcnt = (uint16_t)((*t.tcnt + ticks) % (top + 1));
+            break;
+        }
+
+        ticks -= toMatch;
+        *t.tcnt = toA == toMatch ? *t.ocrA : *t.ocrB;
+        t.tifr->_value |= (toA == toMatch ? HOST_COMPARE_A : 0) | (toB == toMatch ? HOST_COMPARE_B : 0);
+        if (dispatch)
+        {
+            dispatchTimer(t);
+        }
+
+        /* The ISR may have stopped or reprogrammed the timer */
+        if (PRESCALERS[*t.tccrB & 0x07] != prescaler)
+        {
+            break;
+        }
+    }
+}
+
+static void setPinRegisterBit(uint8_t pin, volatile uint8_t *(*reg)(uint8_t), bool level)
+{
+    volatile uint8_t *r = reg(digitalPinToPort(pin));
+    if (r == NULL)
+    {
+        return;
+    }
+    if (level)
+    {
+        *r |= digitalPinToBitMask(pin);
+    }
+    else
+    {
+        *r &= ~digitalPinToBitMask(pin);
+    }
+}
+
+//=============================================================================
+// HOST HARDWARE API
+//=============================================================================
+
+void HostHardware::reset()
+{
+#define HOST_RESET_REG(name) name = 0;
+    HOST_REG8_LIST(HOST_RESET_REG)
+    HOST_REG16_LIST(HOST_RESET_REG)
+#undef HOST_RESET_REG
+    ADCSRA = 0;
+    TIFR1._value = TIFR4._value = 0;
+
+    /* Unconnected inputs read high, interrupts on as after init() */
+    PINA = PINB = PINC = PIND = PINE = PINF = PING = PINH = PINJ = PINK = PINL = 0xFF;
+    SREG = (1 << SREG_I);
+
+    s_nowMicros = 0;
+    timer0_overflow_count = 0;
+    s_tickHook = NULL;
+    for (HostTimer16 &t : s_timers)
+    {
+        t.residualCycles = 0;
+    }
+
+    /* Mid-scale on every channel except the battery divider, which reads 12 V */
+    for (uint8_t i = 0; i < NUM_ANALOG_INPUTS; i++)
+    {
+        s_analog[i] = 512;
+    }
+    s_analog[15] = 818;
+    s_analogProvider = NULL;
+    memset(s_pinMode, INPUT, sizeof(s_pinMode));
+
+    s_serialOut.clear();
+    s_serialIn.clear();
+    s_serialPaced = false;
+    s_serialTxSize = SERIAL_TX_BUFFER_SIZE;
+    s_serialBusyUntilNs = 0;
+    s_serialStats = {0, 0};
+
+    s_spiDevices.clear();
+    s_i2cDevices.clear();
+    s_spiStats = {0, 0};
+    s_lcdDevice = NULL;
+    s_spiTimed = false;
+    s_spiPendingNs = 0;
+    TWCR = 0;
+    twiReset();
+
+    s_touched = false;
+    s_watchdogArmed = false;
+}
+
+uint64_t HostHardware::nowMicros()
+{
+    return s_nowMicros;
+}
+
+/* Timer 0: clk/64, overflow every 256 ticks (1024 us) */
+static void syncTimer0()
+{
+    uint64_t timer0Ticks = s_nowMicros * (F_CPU / 1000000UL) / 64;
+    timer0_overflow_count = (unsigned long)(timer0Ticks / 256);
+    TCNT0 = (uint8_t)timer0Ticks;
+}
+
+void HostHardware::advanceMicros(uint64_t us)
+{
+    /* delay() from inside an ISR or tick hook moves the clock and timers without
+     * running further interrupts; matches are left pending */
+    if (s_inAdvance)
+    {
+        s_nowMicros += us;
+        syncTimer0();
+        serviceTwi();
+        for (HostTimer16 &t : s_timers)
+        {
+            runTimer(t, us * (F_CPU / 1000000UL), false);
+        }
+        return;
+    }
+
+    s_inAdvance = true;
+    dispatchPending();
+
+    /* Step in 1 ms slices so the tick hook sees a reasonably fine-grained clock */
+    while (us > 0)
+    {
+        uint64_t step = us > 1000 ? 1000 : us;
+
+        /* Stop at the end of a TWI operation so the next one starts on time */
+        uint64_t due;
+        if (twiDue(&due) && due > s_nowMicros && due - s_nowMicros < step)
+        {
+            step = due - s_nowMicros;
+        }
+        us -= step;
+        s_nowMicros += step;
+
+        syncTimer0();
+        serviceTwi();
+
+        for (HostTimer16 &t : s_timers)
+        {
+            runTimer(t, step * (F_CPU / 1000000UL), true);
+        }
+
+        if (s_tickHook)
+        {
+            s_tickHook(s_nowMicros);
+        }
+    }
+
+    s_inAdvance = false;
+}
+
+void _hostSleepCpu(void)
+{
+    HostHardware::advanceMicros(1024 - s_nowMicros % 1024);
+}
+
+void HostHardware::setTickHook(void (*hook)(uint64_t))
+{
+    s_tickHook = hook;
+}
+
+void HostHardware::setPin(uint8_t arduinoPin, bool level)
+{
+    uint8_t port = digitalPinToPort(arduinoPin);
+    volatile uint8_t *pin = portInputRegister(port);
+    if (pin == NULL)
+    {
+        return;
+    }
+
+    uint8_t mask = digitalPinToBitMask(arduinoPin);
+    bool old = *pin & mask;
+    setPinRegisterBit(arduinoPin, portInputRegister, level);
+
+    /* Port K is PCINT16-23 */
+    if (port == PK && old != level && (PCMSK2 & mask) && (PCICR & (1 << PCIE2)))
+    {
+        if (interruptsEnabled())
+        {
+            dispatchIsr(PCINT2_vect);
+        }
+        else
+        {
+            PCIFR |= (1 << PCIF2);
+        }
+    }
+}
+
+void HostHardware::setAnalog(uint8_t channel, uint16_t value)
+{
+    if (channel < NUM_ANALOG_INPUTS)
+    {
+        s_analog[channel] = value & 0x3FF;
+    }
+}
+
+void HostHardware::setAnalogProvider(uint16_t (*provider)(uint8_t))
+{
+    s_analogProvider = provider;
+}
+
+uint16_t HostHardware::analogValue(uint8_t channel)
+{
+    channel &= 0x0F;
+    if (s_analogProvider)
+    {
+        return s_analogProvider(channel) & 0x3FF;
+    }
+    return s_analog[channel];
+}
+
+uint8_t HostHardware::pinModeOf(uint8_t arduinoPin)
+{
+    return arduinoPin < NUM_DIGITAL_PINS ? s_pinMode[arduinoPin] : INPUT;
+}
+
+const std::string &HostHardware::serialOutput()
+{
+    return s_serialOut;
+}
+
+void HostHardware::clearSerial()
+{
+    s_serialOut.clear();
+}
+
+void HostHardware::setSerialEcho(bool echo)
+{
+    s_serialEcho = echo;
+}
+
+void HostHardware::serialInject(const uint8_t *data, size_t len)
+{
+    s_serialIn.append((const char *)data, len);
+}
+
+void HostHardware::setSerialPacing(bool paced, size_t txBufferSize)
+{
+    s_serialPaced = paced;
+    s_serialTxSize = txBufferSize > 1 ? txBufferSize : 2;
+    s_serialBusyUntilNs = s_nowMicros * 1000;
+}
+
+HostHardware::SerialStats HostHardware::serialStats()
+{
+    return s_serialStats;
+}
+
+void HostHardware::clearSerialStats()
+{
+    s_serialStats = {0, 0};
+}
+
+void HostHardware::attachSpiDevice(uint8_t csPin, HostSpiDevice *device)
+{
+    if (device)
+    {
+        s_spiDevices[csPin] = device;
+    }
+    else
+    {
+        s_spiDevices.erase(csPin);
+    }
+}
+
+HostSpiDevice *HostHardware::selectedSpiDevice()
+{
+    if (s_lcdDevice)
+    {
+        return s_lcdDevice;
+    }
+    for (auto &entry : s_spiDevices)
+    {
+        volatile uint8_t *port = portOutputRegister(digitalPinToPort(entry.first));
+        if (port && !(*port & digitalPinToBitMask(entry.first)))
+        {
+            return entry.second;
+        }
+    }
+    return NULL;
+}
+
+void HostHardware::attachI2cDevice(uint8_t address, HostI2cDevice *device)
+{
+    if (device)
+    {
+        s_i2cDevices[address] = device;
+    }
+    else
+    {
+        s_i2cDevices.erase(address);
+    }
+}
+
+HostI2cDevice *HostHardware::i2cDevice(uint8_t address)
+{
+    auto it = s_i2cDevices.find(address);
+    if (it != s_i2cDevices.end())
+    {
+        return it->second;
+    }
+    return address == HOST_FT6206_ADDRESS ? &s_touchPanel : NULL;
+}
+
+HostHardware::SpiStats HostHardware::spiStats()
+{
+    return s_spiStats;
+}
+
+void HostHardware::clearSpiStats()
+{
+    s_spiStats = {0, 0};
+}
+
+void hostCountSpi(uint64_t bytes, uint64_t transactions)
+{
+    s_spiStats.bytes += bytes;
+    s_spiStats.transactions += transactions;
+}
+
+HostHardware::I2cStats HostHardware::i2cStats()
+{
+    return s_i2cStats;
+}
+
+void HostHardware::clearI2cStats()
+{
+    s_i2cStats = {0, 0};
+}
+
+void HostHardware::setI2cStuck(bool stuck)
+{
+    s_twiStuck = stuck;
+    setPin(SDA, !stuck);
+}
+
+void HostHardware::setTouch(bool touched, int16_t x, int16_t y)
+{
+    s_touched = touched;
+    s_touchX = x;
+    s_touchY = y;
+}
+
+void HostHardware::touchState(bool *touched, int16_t *x, int16_t *y)
+{
+    *touched = s_touched;
+    *x = s_touchX;
+    *y = s_touchY;
+}
+
+uint8_t *HostHardware::eeprom()
+{
+    return s_eeprom;
+}
+
+bool HostHardware::watchdogArmed()
+{
+    return s_watchdogArmed;
+}
+
+/* Registers start in their power-on state even before a tool calls reset() */
+static struct HostInit
+{
+    HostInit() { HostHardware::reset(); }
+} s_hostInit;
+
+//=============================================================================
+// ARDUINO CORE
+//=============================================================================
+
+HostAdcsraRegister &HostAdcsraRegister::operator=(uint8_t value)
+{
+    _value = value;
+    if ((value & (1 << ADSC)) && (value & (1 << ADEN)))
+    {
+        uint8_t channel = (ADMUX & 0x07) | ((ADCSRB & (1 << MUX5)) ? 0x08 : 0x00);
+        ADC = HostHardware::analogValue(channel);
+        _value = (_value & ~(1 << ADSC)) | (1 << ADIF);
+    }
+    return *this;
+}
+
+void init(void) {}
+void initVariant(void) {}
+void yield(void) {}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    if (pin >= NUM_DIGITAL_PINS)
+    {
+        return;
+    }
+    s_pinMode[pin] = mode;
+    setPinRegisterBit(pin, portModeRegister, mode == OUTPUT);
+    if (mode != OUTPUT)
+    {
+        setPinRegisterBit(pin, portOutputRegister, mode == INPUT_PULLUP);
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+    if (pin >= NUM_DIGITAL_PINS)
+    {
+        return;
+    }
+
+    volatile uint8_t *port = portOutputRegister(digitalPinToPort(pin));
+    bool old = *port & digitalPinToBitMask(pin);
+    setPinRegisterBit(pin, portOutputRegister, val);
+
+    /* Outputs read back what they drive */
+    if (s_pinMode[pin] == OUTPUT)
+    {
+        setPinRegisterBit(pin, portInputRegister, val);
+    }
+
+    auto device = s_spiDevices.find(pin);
+    if (device != s_spiDevices.end() && old != (bool)val)
+    {
+        if (val)
+        {
+            device->second->deselect();
+        }
+        else
+        {
+            device->second->select();
+        }
+    }
+}
+
+int digitalRead(uint8_t pin)
+{
+    if (pin >= NUM_DIGITAL_PINS)
+    {
+        return LOW;
+    }
+    return (*portInputRegister(digitalPinToPort(pin)) & digitalPinToBitMask(pin)) ? HIGH : LOW;
+}
+
+int analogRead(uint8_t pin)
+{
+    if (pin >= A0)
+    {
+        pin -= A0;
+    }
+    ADCSRB = (ADCSRB & ~(1 << MUX5)) | (((pin >> 3) & 0x01) << MUX5);
+    ADMUX = (1 << REFS0) | (pin & 0x07);
+    ADC = HostHardware::analogValue(pin);
+    return ADC;
+}
+
+void analogReference(uint8_t) {}
+
+void analogWrite(uint8_t pin, int val)
+{
+    pinMode(pin, OUTPUT);
+    digitalWrite(pin, val >= 128);
+}
+
+unsigned long millis(void)
+{
+    return (unsigned long)(s_nowMicros / 1000);
+}
+
+unsigned long micros(void)
+{
+    return (unsigned long)s_nowMicros;
+}
+
+void delay(unsigned long ms)
+{
+    HostHardware::advanceMicros((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    HostHardware::advanceMicros(us);
+}
+
+void attachInterrupt(uint8_t, void (*)(void), int) {}
+void detachInterrupt(uint8_t) {}
+
+long random(long howbig)
+{
+    if (howbig == 0)
+    {
+        return 0;
+    }
+    return ::random() % howbig;
+}
+
+long random(long howsmall, long howbig)
+{
+    if (howsmall >= howbig)
+    {
+        return howsmall;
+    }
+    return random(howbig - howsmall) + howsmall;
+}
+
+void randomSeed(unsigned long seed)
+{
+    if (seed != 0)
+    {
+        srandom(seed);
+    }
+}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max)
+{
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+void wdt_enable(uint8_t)
+{
+    s_watchdogArmed = true;
+}
+
+void wdt_disable(void)
+{
+    s_watchdogArmed = false;
+}
+
+uint8_t eeprom_read_byte(const uint8_t *address)
+{
+    return s_eeprom[(uintptr_t)address & E2END];
+}
+
+void eeprom_write_byte(uint8_t *address, uint8_t value)
+{
+    s_eeprom[(uintptr_t)address & E2END] = value;
+}
+
+void eeprom_update_byte(uint8_t *address, uint8_t value)
+{
+    eeprom_write_byte(address, value);
+}
+
+void eeprom_read_block(void *dst, const void *src, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        ((uint8_t *)dst)[i] = eeprom_read_byte((const uint8_t *)src + i);
+    }
+}
+
+void eeprom_write_block(const void *src, void *dst, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        eeprom_write_byte((uint8_t *)dst + i, ((const uint8_t *)src)[i]);
+    }
+}
+
+void eeprom_update_block(const void *src, void *dst, size_t n)
+{
+    eeprom_write_block(src, dst, n);
+}
+
+//=============================================================================
+// TWI
+//=============================================================================
+
+static void twiReset()
+{
+    s_twiMode = TWI_IDLE;
+    s_twiDevice = NULL;
+    s_twiWrite.clear();
+    s_twiBusy = false;
+    s_i2cStats = {0, 0};
+    s_twiStuck = false;
+}
+
+/* Deliver what was written to the device when the write ends */
+static void twiEndWrite()
+{
+    if (s_twiMode == TWI_TRANSMIT && s_twiDevice)
+    {
+        s_twiDevice->receive(s_twiWrite.data(), s_twiWrite.size());
+    }
+    s_twiWrite.clear();
+}
+
+/* Start an operation of @p bits SCL periods that ends with @p status */
+static void twiSchedule(uint8_t bits, uint8_t status, uint8_t data = 0)
+{
+    uint32_t prescaler = 1u << (2 * (TWSR & 0x03));
+    uint64_t sclNs = (16 + 2ULL * TWBR * prescaler) * 1000000000ULL / F_CPU;
+    s_twiBusy = true;
+    s_twiDueNs = s_nowMicros * 1000 + bits * sclNs;
+    s_twiStatus = status;
+    s_twiData = data;
+}
+
+static bool twiDue(uint64_t *dueMicros)
+{
+    if (!s_twiBusy || s_twiStuck)
+    {
+        return false;
+    }
+    *dueMicros = (s_twiDueNs + 999) / 1000;
+    return true;
+}
+
+static void serviceTwi()
+{
+    uint64_t due;
+    if (!twiDue(&due) || s_nowMicros < due)
+    {
+        return;
+    }
+    s_twiBusy = false;
+    TWSR = (TWSR & 0x03) | s_twiStatus;
+    if (s_twiStatus == TW_MR_DATA_ACK || s_twiStatus == TW_MR_DATA_NACK)
+    {
+        TWDR = s_twiData;
+    }
+    TWCR._value |= _BV(TWINT);
+    if ((TWCR & _BV(TWIE)) && interruptsEnabled())
+    {
+        dispatchIsr(TWI_vect);
+    }
+}
+
+HostTwcrRegister &HostTwcrRegister::operator=(uint8_t value)
+{
+    _value = value;
+    if (!(value & _BV(TWEN)))
+    {
+        /* Disabling the port releases the bus; a stuck device lets go of SDA */
+        s_twiMode = TWI_IDLE;
+        s_twiBusy = false;
+        s_twiWrite.clear();
+        if (s_twiStuck)
+        {
+            HostHardware::setI2cStuck(false);
+        }
+        return *this;
+    }
+    if (!(value & _BV(TWINT)))
+    {
+        return *this;
+    }
+
+    /* Writing TWINT as one clears it and starts the operation */
+    _value &= ~_BV(TWINT);
+
+    if (value & _BV(TWSTO))
+    {
+        twiEndWrite();
+        s_twiMode = TWI_IDLE;
+        s_twiDevice = NULL;
+        _value &= ~_BV(TWSTO);
+        return *this;
+    }
+
+    if (value & _BV(TWSTA))
+    {
+        twiEndWrite();
+        bool repeated = s_twiMode != TWI_IDLE;
+        s_twiMode = TWI_ADDRESS;
+        s_i2cStats.transactions += repeated ? 0 : 1;
+        twiSchedule(1, repeated ? TW_REP_START : TW_START);
+        return *this;
+    }
+
+    s_i2cStats.bytes++;
+    switch (s_twiMode)
+    {
+    case TWI_ADDRESS:
+    {
+        bool read = TWDR & TW_READ;
+        s_twiDevice = HostHardware::i2cDevice(TWDR >> 1);
+        if (s_twiDevice && read)
+        {
+            s_twiDevice->request(s_twiRead, sizeof(s_twiRead));
+            s_twiReadIndex = 0;
+        }
+        s_twiMode = read ? TWI_RECEIVE : TWI_TRANSMIT;
+        if (read)
+            twiSchedule(9, s_twiDevice ? TW_MR_SLA_ACK : TW_MR_SLA_NACK);
+        else
+            twiSchedule(9, s_twiDevice ? TW_MT_SLA_ACK : TW_MT_SLA_NACK);
+        break;
+    }
+    case TWI_TRANSMIT:
+        s_twiWrite.push_back((uint8_t)TWDR);
+        twiSchedule(9, TW_MT_DATA_ACK);
+        break;
+    case TWI_RECEIVE:
+    {
+        uint8_t data = s_twiReadIndex < sizeof(s_twiRead) ? s_twiRead[s_twiReadIndex++] : 0xFF;
+        twiSchedule(9, (value & _BV(TWEA)) ? TW_MR_DATA_ACK : TW_MR_DATA_NACK, data);
+        break;
+    }
+    default:
+        /* A byte without START: the hardware reports a bus error */
+        twiSchedule(1, TW_BUS_ERROR);
+        break;
+    }
+    return *this;
+}
+
+//=============================================================================
+// SPI
+//=============================================================================
+
+void HostHardware::setSpiTiming(bool timed)
+{
+    s_spiTimed = timed;
+    s_spiPendingNs = 0;
+}
+
+/* Advance the clock by @p bytes at the SCK rate in SPCR/SPSR: the SPR bits divide F_CPU
+   by 4 to 128 and SPI2X halves the divider */
+void hostSpiElapse(uint64_t bytes)
+{
+    if (!s_spiTimed)
+    {
+        return;
+    }
+    uint8_t shift = 2 + 2 * (SPCR & 0x03) - (SPSR & _BV(SPI2X) ? 1 : 0);
+    if ((SPCR & 0x03) == 0x03)
+    {
+        shift = SPSR & _BV(SPI2X) ? 6 : 7; // /64 and /128 share SPR = 3
+    }
+    s_spiPendingNs += bytes * 8 * 1000000000ULL / (F_CPU >> shift);
+    if (s_spiPendingNs >= 1000)
+    {
+        uint64_t us = s_spiPendingNs / 1000;
+        s_spiPendingNs %= 1000;
+        HostHardware::advanceMicros(us);
+    }
+}
+
+HostSpdrRegister &HostSpdrRegister::operator=(uint8_t value)
+{
+    HostSpiDevice *device = HostHardware::selectedSpiDevice();
+    _received = device ? device->transfer(value) : 0xFF;
+    s_spiStats.bytes++;
+    SPSR |= _BV(SPIF);
+    hostSpiElapse(1);
+    return *this;
+}
+
+HostSpdrRegister::operator uint8_t()
+{
+    SPSR &= ~_BV(SPIF);
+    return _received;
+}
+
+/* The ILI9341 shim takes pixel data written straight to SPDR between startWrite() and
+   endWrite(), as the panel does while its chip select is low */
+void hostSelectLcd(HostSpiDevice *device)
+{
+    s_lcdDevice = device;
+}
+
+//=============================================================================
+// SERIAL
+//=============================================================================
+
+HardwareSerial Serial;
+
+/* Keep the capture bounded for long simulations */
+#define HOST_SERIAL_CAPTURE_LIMIT (1u << 20)
+
+void HardwareSerial::begin(unsigned long baud, uint8_t)
+{
+    flush();
+    _baud = baud;
+}
+
+/* 10 bit times per byte: start, 8 data, stop */
+static uint64_t serialByteNs(unsigned long baud)
+{
+    return (10ULL * 1000000000ULL + baud - 1) / baud;
+}
+
+/* Bytes still to go out: the one in the shift register plus those in the ring */
+static size_t serialQueued(unsigned long baud)
+{
+    uint64_t nowNs = s_nowMicros * 1000;
+    if (s_serialBusyUntilNs <= nowNs)
+    {
+        return 0;
+    }
+    uint64_t byteNs = serialByteNs(baud);
+    return (size_t)((s_serialBusyUntilNs - nowNs + byteNs - 1) / byteNs);
+}
+
+static bool serialPaced(unsigned long baud)
+{
+    return s_serialPaced && baud != 0;
+}
+
+int HardwareSerial::available(void)
+{
+    return (int)s_serialIn.size();
+}
+
+int HardwareSerial::peek(void)
+{
+    return s_serialIn.empty() ? -1 : (uint8_t)s_serialIn[0];
+}
+
+int HardwareSerial::read(void)
+{
+    if (s_serialIn.empty())
+    {
+        return -1;
+    }
+    uint8_t c = s_serialIn[0];
+    s_serialIn.erase(0, 1);
+    return c;
+}
+
+int HardwareSerial::availableForWrite(void)
+{
+    if (!serialPaced(_baud))
+    {
+        return (int)s_serialTxSize - 1;
+    }
+    /* The ring holds one byte less than its size; the shift register holds one more */
+    size_t queued = serialQueued(_baud);
+    size_t inRing = queued > 0 ? queued - 1 : 0;
+    return (int)(s_serialTxSize - 1 - inRing);
+}
+
+void HardwareSerial::flush(void)
+{
+    if (serialPaced(_baud))
+    {
+        while (serialQueued(_baud) > 0)
+        {
+            HostHardware::advanceMicros(1);
+        }
+    }
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+    if (s_serialOut.size() + size > HOST_SERIAL_CAPTURE_LIMIT)
+    {
+        s_serialOut.clear();
+    }
+    if (serialPaced(_baud))
+    {
+        uint64_t byteNs = serialByteNs(_baud);
+        for (size_t i = 0; i < size; i++)
+        {
+            /* Busy-wait for room, as HardwareSerial::write() does */
+            uint64_t start = s_nowMicros;
+            while (serialQueued(_baud) >= s_serialTxSize)
+            {
+                HostHardware::advanceMicros(1);
+            }
+            s_serialStats.blockedMicros += s_nowMicros - start;
+
+            uint64_t nowNs = s_nowMicros * 1000;
+            if (s_serialBusyUntilNs < nowNs)
+            {
+                s_serialBusyUntilNs = nowNs;
+            }
+            s_serialBusyUntilNs += byteNs;
+        }
+    }
+    s_serialStats.bytes += size;
+    s_serialOut.append((const char *)buffer, size);
+    if (s_serialEcho)
+    {
+        fwrite(buffer, 1, size, stdout);
+    }
+    return size;
+}
+
+//=============================================================================
+// PRINT
+//=============================================================================
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (size--)
+    {
+        if (write(*buffer++))
+            n++;
+        else
+            break;
+    }
+    return n;
+}
+
+size_t Print::print(const __FlashStringHelper *ifsh) { return print(reinterpret_cast<const char *>(ifsh)); }
+size_t Print::print(const String &s) { return write(s.c_str(), s.length()); }
+size_t Print::print(const char str[]) { return write(str); }
+size_t Print::print(char c) { return write((uint8_t)c); }
+size_t Print::print(unsigned char b, int base) { return print((unsigned long)b, base); }
+size_t Print::print(int n, int base) { return print((long)n, base); }
+size_t Print::print(unsigned int n, int base) { return print((unsigned long)n, base); }
+
+size_t Print::print(long n, int base)
+{
+    if (base == 0)
+    {
+        return write((uint8_t)n);
+    }
+    else if (base == 10)
+    {
+        if (n < 0)
+        {
+            int t = print('-');
+            n = -n;
+            return printNumber(n, 10) + t;
+        }
+        return printNumber(n, 10);
+    }
+    else
+    {
+        /* The AVR core prints negative numbers in other bases as 32-bit two's complement */
+        return printNumber((uint32_t)n, base);
+    }
+}
+
+size_t Print::print(unsigned long n, int base)
+{
+    if (base == 0)
+        return write((uint8_t)n);
+    else
+        return printNumber(n, base);
+}
+
+size_t Print::print(double n, int digits) { return printFloat(n, digits); }
+
+size_t Print::println(void) { return write("\r\n"); }
+size_t Print::println(const __FlashStringHelper *ifsh) { return print(ifsh) + println(); }
+size_t Print::println(const String &s) { return print(s) + println(); }
+size_t Print::println(const char c[]) { return print(c) + println(); }
+size_t Print::println(char c) { return print(c) + println(); }
+size_t Print::println(unsigned char b, int base) { return print(b, base) + println(); }
+size_t Print::println(int num, int base) { return print(num, base) + println(); }
+size_t Print::println(unsigned int num, int base) { return print(num, base) + println(); }
+size_t Print::println(long num, int base) { return print(num, base) + println(); }
+size_t Print::println(unsigned long num, int base) { return print(num, base) + println(); }
+size_t Print::println(double num, int digits) { return print(num, digits) + println(); }
+
+size_t Print::printNumber(unsigned long n, uint8_t base)
+{
+    char buf[8 * sizeof(long) + 1];
+    char *str = &buf[sizeof(buf) - 1];
+
+    *str = '\0';
+
+    if (base < 2)
+        base = 10;
+
+    do
+    {
+        char c = n % base;
+        n /= base;
+
+        *--str = c < 10 ? c + '0' : c + 'A' - 10;
+    } while (n);
+
+    return write(str);
+}
+
+size_t Print::printFloat(double number, uint8_t digits)
+{
+    size_t n = 0;
+
+    if (isnan(number))
+        return print("nan");
+    if (isinf(number))
+        return print("inf");
+    if (number > 4294967040.0)
+        return print("ovf");
+    if (number < -4294967040.0)
+        return print("ovf");
+
+    if (number < 0.0)
+    {
+        n += print('-');
+        number = -number;
+    }
+
+    double rounding = 0.5;
+    for (uint8_t i = 0; i < digits; ++i)
+        rounding /= 10.0;
+
+    number += rounding;
+
+    unsigned long int_part = (unsigned long)number;
+    double remainder = number - (double)int_part;
+    n += print(int_part);
+
+    if (digits > 0)
+    {
+        n += print('.');
+    }
+
+    while (digits-- > 0)
+    {
+        remainder *= 10.0;
+        unsigned int toPrint = (unsigned int)(remainder);
+        n += print(toPrint);
+        remainder -= toPrint;
+    }
+
+    return n;
+}
@@ -0,0 +1,223 @@
+/**
+ * Arduino.h (host shim)
+ *
+ * Just enough of the Arduino AVR core for the controller library to build and run on a PC.
+ * Pin numbering, ports and bit masks follow the Mega 2560 variant. Time is virtual: it only
+ * advances through delay()/delayMicroseconds() or HostHardware::advanceMicros(), which also
+ * run the emulated timers (see HostHardware.h).
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <ctype.h>
+#include <type_traits>
+
+#include <avr/pgmspace.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#include "Print.h"
+
+/* avr-libc has strlcpy(); older glibc does not */
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+static inline size_t strlcpy(char *dst, const char *src, size_t size)
+{
+    size_t len = strlen(src);
+    if (size > 0)
+    {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#endif
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+#ifndef ARDUINO
+#define ARDUINO 10819
+#endif
+#ifndef ARDUINO_ARCH_AVR
+#define ARDUINO_ARCH_AVR
+#endif
+#define ARDUINO_AVR_MEGA2560
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef unsigned int word;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+/*
+ * The AVR core defines min()/max() as macros, which would break the standard C++ headers
+ * the host tools include after this one. Templates behave the same for the library's uses;
+ * they return by value, since a conditional of two lvalues of one type is itself an lvalue.
+ */
+template <typename T, typename U>
+static inline auto min(T a, U b) -> typename std::decay<decltype(a < b ? a : b)>::type { return (b < a) ? b : a; }
+template <typename T, typename U>
+static inline auto max(T a, U b) -> typename std::decay<decltype(a < b ? a : b)>::type { return (a < b) ? b : a; }
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define radians(deg) ((deg) * DEG_TO_RAD)
+#define degrees(rad) ((rad) * RAD_TO_DEG)
+#define sq(x) ((x) * (x))
+
+#define clockCyclesPerMicrosecond() (F_CPU / 1000000L)
+#define clockCyclesToMicroseconds(a) ((a) / clockCyclesPerMicrosecond())
+#define microsecondsToClockCycles(a) ((a) * clockCyclesPerMicrosecond())
+
+#define lowByte(w) ((uint8_t)((w) & 0xff))
+#define highByte(w) ((uint8_t)((w) >> 8))
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define bitToggle(value, bit) ((value) ^= (1UL << (bit)))
+#define bitWrite(value, bit, bitvalue) ((bitvalue) ? bitSet(value, bit) : bitClear(value, bit))
+#define bit(b) (1UL << (b))
+
+#define interrupts() sei()
+#define noInterrupts() cli()
+
+/* Mega 2560 analog pins */
+#define NUM_DIGITAL_PINS 70
+#define NUM_ANALOG_INPUTS 16
+static const uint8_t A0 = 54;
+static const uint8_t A1 = 55;
+static const uint8_t A2 = 56;
+static const uint8_t A3 = 57;
+static const uint8_t A4 = 58;
+static const uint8_t A5 = 59;
+static const uint8_t A6 = 60;
+static const uint8_t A7 = 61;
+static const uint8_t A8 = 62;
+static const uint8_t A9 = 63;
+static const uint8_t A10 = 64;
+static const uint8_t A11 = 65;
+static const uint8_t A12 = 66;
+static const uint8_t A13 = 67;
+static const uint8_t A14 = 68;
+static const uint8_t A15 = 69;
+static const uint8_t SS = 53;
+static const uint8_t MOSI = 51;
+static const uint8_t MISO = 50;
+static const uint8_t SCK = 52;
+static const uint8_t SDA = 20;
+static const uint8_t SCL = 21;
+static const uint8_t LED_BUILTIN = 13;
+
+/* Port numbers, as in the AVR core */
+#define NOT_A_PIN 0
+#define NOT_A_PORT 0
+#define PA 1
+#define PB 2
+#define PC 3
+#define PD 4
+#define PE 5
+#define PF 6
+#define PG 7
+#define PH 8
+#define PJ 10
+#define PK 11
+#define PL 12
+
+uint8_t digitalPinToPort(uint8_t pin);
+uint8_t digitalPinToBitMask(uint8_t pin);
+volatile uint8_t *portInputRegister(uint8_t port);
+volatile uint8_t *portOutputRegister(uint8_t port);
+volatile uint8_t *portModeRegister(uint8_t port);
+#define analogInputToDigitalPin(p) (((p) < 16) ? (p) + 54 : -1)
+#define digitalPinToInterrupt(p) (-1)
+
+void init(void);
+void initVariant(void);
+void yield(void);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogReference(uint8_t mode);
+void analogWrite(uint8_t pin, int val);
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void attachInterrupt(uint8_t interruptNum, void (*userFunc)(void), int mode);
+void detachInterrupt(uint8_t interruptNum);
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+long map(long value, long fromLow, long fromHigh, long toLow, long toHigh);
+
+void setup(void);
+void loop(void);
+
+/**
+ * Serial port. Output is kept in memory (see HostHardware::serialOutput()) and optionally
+ * echoed to stdout; input is whatever HostHardware::serialInject() queued.
+ */
+/* Ring sizes as in the core's HardwareSerial.h; only the TX size is modelled, by pacing */
+#if !defined(SERIAL_TX_BUFFER_SIZE)
+#define SERIAL_TX_BUFFER_SIZE 64
+#endif
+#if !defined(SERIAL_RX_BUFFER_SIZE)
+#define SERIAL_RX_BUFFER_SIZE 64
+#endif
+
+class HardwareSerial : public Print
+{
+public:
+    void begin(unsigned long baud) { begin(baud, 0x06); }
+    void begin(unsigned long baud, uint8_t config);
+    void end() {}
+    int available(void);
+    int peek(void);
+    int read(void);
+    int availableForWrite(void) override;
+    void flush(void) override;
+    size_t write(uint8_t) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+    operator bool() { return true; }
+
+    unsigned long baud() const { return _baud; }
+
+private:
+    unsigned long _baud = 0;
+};
+
+extern HardwareSerial Serial;
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,75 @@
+/**
+ * Encoder.h (host shim)
+ *
+ * PJRC's Encoder decodes quadrature from pin interrupts. The host keeps the same interface;
+ * tools find an encoder by its first pin with find() and move the count with step().
+ */
+
+#ifndef HOST_ENCODER_H
+#define HOST_ENCODER_H
+
+#include <Arduino.h>
+
+class Encoder
+{
+public:
+    Encoder(uint8_t pin1, uint8_t pin2) : pin1(pin1), pin2(pin2), position(0)
+    {
+        pinMode(pin1, INPUT_PULLUP);
+        pinMode(pin2, INPUT_PULLUP);
+        next = first();
+        first() = this;
+    }
+
+    ~Encoder()
+    {
+        for (Encoder **e = &first(); *e; e = &(*e)->next)
+        {
+            if (*e == this)
+            {
+                *e = next;
+                break;
+            }
+        }
+    }
+
+    int32_t read() { return position; }
+    int32_t readAndReset()
+    {
+        int32_t ret = position;
+        position = 0;
+        return ret;
+    }
+    void write(int32_t p) { position = p; }
+
+    /// Host only: add quadrature counts as if the shaft moved
+    void step(int32_t counts) { position += counts; }
+
+    /// Host only: the most recently created encoder on @p pin1, or nullptr
+    static Encoder *find(uint8_t pin1)
+    {
+        for (Encoder *e = first(); e; e = e->next)
+        {
+            if (e->pin1 == pin1)
+            {
+                return e;
+            }
+        }
+        return nullptr;
+    }
+
+    const uint8_t pin1;
+    const uint8_t pin2;
+
+private:
+    volatile int32_t position;
+    Encoder *next;
+
+    static Encoder *&first()
+    {
+        static Encoder *head = nullptr;
+        return head;
+    }
+};
+
+#endif // HOST_ENCODER_H
@@ -0,0 +1,171 @@
+/**
+ * HostHardware.h
+ *
+ * Control surface for the host build: the virtual clock, timer emulation, pin and ADC
+ * inputs, captured Serial output, and the SPI/I2C device hooks that stand in for the
+ * shield's peripherals. Only host tools include this; library code never does.
+ */
+
+#ifndef HOST_HARDWARE_H
+#define HOST_HARDWARE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <Arduino.h>
+
+/**
+ * @brief A peripheral on the SPI bus, selected by a chip select pin going low.
+ */
+class HostSpiDevice
+{
+public:
+    virtual ~HostSpiDevice() {}
+    virtual void select() {}
+    virtual void deselect() {}
+    virtual uint8_t transfer(uint8_t out) = 0;
+};
+
+/**
+ * @brief A peripheral on the I2C bus at a 7-bit address.
+ */
+class HostI2cDevice
+{
+public:
+    virtual ~HostI2cDevice() {}
+    /// Master wrote @p len bytes in one transmission
+    virtual void receive(const uint8_t *data, size_t len) = 0;
+    /// Master reads @p len bytes; fill @p data
+    virtual void request(uint8_t *data, size_t len) = 0;
+};
+
+namespace HostHardware
+{
+    /**
+     * @brief Put registers, pins, clock, timers and devices back to their power-on state.
+     */
+    void reset();
+
+    /* Virtual clock */
+
+    /// Microseconds since reset, 64-bit so it never wraps in a test
+    uint64_t nowMicros();
+
+    /**
+     * @brief Advance the virtual clock, running emulated timer interrupts that fall due.
+     *
+     * Timer 4 (scheduler, CTC on OCR4A) and Timer 1 (servos and FEHPeriodic, normal mode
+     * with OCR1A and OCR1B) are emulated. Interrupts only fire while the I bit in SREG is
+     * set; time advanced from inside an ISR counts the timers on and leaves their matches
+     * pending until the next advance.
+     */
+    void advanceMicros(uint64_t us);
+
+    /**
+     * @brief Called after every clock advance with the new time, e.g. to step a simulation.
+     */
+    void setTickHook(void (*hook)(uint64_t nowMicros));
+
+    /* Pins */
+
+    /// Drive an input pin (Arduino pin number) from outside; updates the PINx register
+    void setPin(uint8_t arduinoPin, bool level);
+
+    /// Set the 10-bit ADC value returned for an ADC channel (0-15)
+    void setAnalog(uint8_t channel, uint16_t value);
+
+    /// Optional callback that supplies ADC values instead of setAnalog()
+    void setAnalogProvider(uint16_t (*provider)(uint8_t channel));
+
+    /// Current mode of a pin as last set by pinMode() (INPUT, OUTPUT or INPUT_PULLUP)
+    uint8_t pinModeOf(uint8_t arduinoPin);
+
+    /* Serial */
+
+    /// Everything written to Serial since the last clearSerial()
+    const std::string &serialOutput();
+    void clearSerial();
+    void setSerialEcho(bool echo);
+    void serialInject(const uint8_t *data, size_t len);
+
+    /**
+     * @brief Drain Serial output at its baud rate through a TX ring of @p txBufferSize bytes.
+     *
+     * Off by default, so output is free. When on and Serial.begin() has been called, a
+     * write to a full ring advances the clock until a byte has gone out, as the AVR core's
+     * busy-wait does, and availableForWrite() reports the free space in the ring.
+     */
+    void setSerialPacing(bool paced, size_t txBufferSize = SERIAL_TX_BUFFER_SIZE);
+
+    struct SerialStats
+    {
+        uint64_t bytes;         ///< Bytes written to Serial
+        uint64_t blockedMicros; ///< Time writers spent waiting for room in the TX ring
+    };
+    SerialStats serialStats();
+    void clearSerialStats();
+
+    /* SPI / I2C devices */
+
+    /// Attach a device selected by @p csPin. Pass nullptr to detach.
+    void attachSpiDevice(uint8_t csPin, HostSpiDevice *device);
+
+    /**
+     * @brief Attach a device at a 7-bit I2C address. Pass nullptr to detach.
+     *
+     * Devices are reached through Wire and through the TWI registers, which are timed at
+     * the SCL rate set in TWBR. The touch panel answers at 0x38 unless replaced.
+     */
+    void attachI2cDevice(uint8_t address, HostI2cDevice *device);
+
+    struct I2cStats
+    {
+        uint64_t transactions; ///< STARTs on the TWI bus (repeated STARTs not counted)
+        uint64_t bytes;        ///< Address and data bytes on the TWI bus
+    };
+    I2cStats i2cStats();
+    void clearI2cStats();
+
+    /// A device holds SDA low: TWI operations never complete until the port is disabled
+    void setI2cStuck(bool stuck);
+
+    struct SpiStats
+    {
+        uint64_t bytes;        ///< Bytes written to SPDR, by SPI.transfer() or directly
+        uint64_t transactions; ///< SPI.beginTransaction() calls
+    };
+    SpiStats spiStats();
+    void clearSpiStats();
+
+    /**
+     * @brief Time bytes on the SPI bus at the SCK rate set in SPCR/SPSR.
+     *
+     * Off by default, so transfers are free. When on, each byte written to SPDR, and each
+     * byte the ILI9341 model streams, advances the clock by eight SCK periods.
+     */
+    void setSpiTiming(bool timed);
+
+    /* Touchscreen */
+
+    /// Touch at landscape screen coordinates, as FEHLCD::Touch() reports them. The touch
+    /// panel model reports it from its registers.
+    void setTouch(bool touched, int16_t x = 0, int16_t y = 0);
+
+    /* EEPROM */
+
+    /// The E2END + 1 bytes behind avr/eeprom.h, erased (0xFF) at start and kept by reset()
+    uint8_t *eeprom();
+
+    /* Watchdog */
+
+    /// True once wdt_enable() was called, i.e. the library asked for a reset
+    bool watchdogArmed();
+
+    /* Hooks used by the shims themselves */
+    HostSpiDevice *selectedSpiDevice();
+    HostI2cDevice *i2cDevice(uint8_t address);
+    uint16_t analogValue(uint8_t channel);
+    void touchState(bool *touched, int16_t *x, int16_t *y);
+}
+
+#endif // HOST_HARDWARE_H
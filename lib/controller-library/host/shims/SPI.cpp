@@ -0,0 +1,71 @@
+/**
+ * SPI.cpp (host shim)
+ */
+
+#include <SPI.h>
+#include "HostHardware.h"
+
+SPIClass SPI;
+
+static uint32_t s_clock = 4000000;
+
+/* Defined with the other HostHardware state in Arduino.cpp */
+void hostCountSpi(uint64_t bytes, uint64_t transactions);
+
+void SPIClass::begin()
+{
+    pinMode(SS, OUTPUT);
+    pinMode(SCK, OUTPUT);
+    pinMode(MOSI, OUTPUT);
+    SPCR |= (1 << MSTR) | (1 << SPE);
+}
+
+void SPIClass::beginTransaction(SPISettings settings)
+{
+    s_clock = settings.clock;
+
+    // The slowest divider from /2 up that keeps SCK at or below the clock, as on the AVR
+    uint8_t div = 0;
+    while (div < 6 && settings.clock < (F_CPU >> (div + 1)))
+    {
+        div++;
+    }
+    if (div == 6)
+    {
+        div = 7;
+    }
+    SPCR = (SPCR & ~0x0F) | (settings.dataMode & 0x0C) | (((div ^ 1) >> 1) & 0x03);
+    SPSR = (div ^ 1) & 0x01;
+    hostCountSpi(0, 1);
+}
+
+uint8_t SPIClass::transfer(uint8_t data)
+{
+    // As the AVR core does it; SPDR routes the byte to the selected device
+    SPDR = data;
+    while (!(SPSR & _BV(SPIF)))
+    {
+    }
+    return SPDR;
+}
+
+uint16_t SPIClass::transfer16(uint16_t data)
+{
+    uint16_t high = transfer(data >> 8);
+    return (high << 8) | transfer(data & 0xFF);
+}
+
+void SPIClass::transfer(void *buf, size_t count)
+{
+    uint8_t *p = (uint8_t *)buf;
+    while (count--)
+    {
+        *p = transfer(*p);
+        p++;
+    }
+}
+
+uint32_t SPIClass::clock()
+{
+    return s_clock;
+}
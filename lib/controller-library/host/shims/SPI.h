@@ -0,0 +1,62 @@
+/**
+ * SPI.h (host shim)
+ *
+ * Routes each transfer to the HostSpiDevice whose chip select pin is low, and counts bytes
+ * and transactions for the benchmarks.
+ */
+
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#include <Arduino.h>
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0C
+
+#define SPI_CLOCK_DIV4 0x00
+#define SPI_CLOCK_DIV16 0x01
+#define SPI_CLOCK_DIV64 0x02
+#define SPI_CLOCK_DIV128 0x03
+#define SPI_CLOCK_DIV2 0x04
+#define SPI_CLOCK_DIV8 0x05
+#define SPI_CLOCK_DIV32 0x06
+
+class SPISettings
+{
+public:
+    SPISettings() : clock(4000000), bitOrder(MSBFIRST), dataMode(SPI_MODE0) {}
+    SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode)
+        : clock(clock), bitOrder(bitOrder), dataMode(dataMode)
+    {
+    }
+
+    uint32_t clock;
+    uint8_t bitOrder;
+    uint8_t dataMode;
+};
+
+class SPIClass
+{
+public:
+    static void begin();
+    static void end() {}
+    static void beginTransaction(SPISettings settings);
+    static void endTransaction() {}
+    static uint8_t transfer(uint8_t data);
+    static uint16_t transfer16(uint16_t data);
+    static void transfer(void *buf, size_t count);
+    static void usingInterrupt(uint8_t) {}
+    static void notUsingInterrupt(uint8_t) {}
+    static void setBitOrder(uint8_t) {}
+    static void setDataMode(uint8_t) {}
+    static void setClockDivider(uint8_t) {}
+
+    /// Clock of the current transaction, for tools that model bus time
+    static uint32_t clock();
+};
+
+extern SPIClass SPI;
+
+#endif // HOST_SPI_H
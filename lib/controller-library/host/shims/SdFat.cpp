@@ -0,0 +1,167 @@
+/**
+ * SdFat.cpp (host shim)
+ */
+
+#include <SdFat.h>
+
+#include <map>
+
+static std::map<std::string, std::string> &volume()
+{
+    static std::map<std::string, std::string> files;
+    return files;
+}
+
+void HostSdVolume::put(const char *path, const std::string &contents)
+{
+    volume()[path] = contents;
+}
+
+std::string HostSdVolume::get(const char *path)
+{
+    auto it = volume().find(path);
+    return it == volume().end() ? std::string() : it->second;
+}
+
+void HostSdVolume::clear()
+{
+    volume().clear();
+}
+
+bool SdFile::open(const char *path, oflag_t oflag)
+{
+    if (isOpen())
+    {
+        return false;
+    }
+
+    auto it = volume().find(path);
+    if (it == volume().end())
+    {
+        if (!(oflag & O_CREAT))
+        {
+            return false;
+        }
+        it = volume().emplace(path, std::string()).first;
+    }
+    else if ((oflag & O_CREAT) && (oflag & O_EXCL))
+    {
+        return false;
+    }
+
+    if (oflag & O_TRUNC)
+    {
+        it->second.clear();
+    }
+
+    _file = &it->second;
+    _flags = oflag;
+    _pos = 0;
+    return true;
+}
+
+bool SdFile::close()
+{
+    _file = nullptr;
+    return true;
+}
+
+bool SdFile::isReadable() const
+{
+    return isOpen() && (_flags & O_ACCMODE) != O_WRONLY;
+}
+
+bool SdFile::isWritable() const
+{
+    return isOpen() && (_flags & O_ACCMODE) != O_RDONLY;
+}
+
+int SdFile::available()
+{
+    uint64_t n = available64();
+    return n > 0x7FFF ? 0x7FFF : (int)n;
+}
+
+uint64_t SdFile::available64()
+{
+    return isReadable() && _pos < _file->size() ? _file->size() - _pos : 0;
+}
+
+int SdFile::read()
+{
+    if (!available64())
+    {
+        return -1;
+    }
+    return (uint8_t)(*_file)[_pos++];
+}
+
+int SdFile::read(void *buf, size_t count)
+{
+    if (!isReadable())
+    {
+        return -1;
+    }
+    size_t n = (size_t)available64();
+    if (n > count)
+    {
+        n = count;
+    }
+    memcpy(buf, _file->data() + _pos, n);
+    _pos += n;
+    return (int)n;
+}
+
+int SdFile::peek()
+{
+    return available64() ? (uint8_t)(*_file)[_pos] : -1;
+}
+
+size_t SdFile::write(uint8_t b)
+{
+    return write(&b, 1);
+}
+
+size_t SdFile::write(const uint8_t *buf, size_t size)
+{
+    if (!isWritable())
+    {
+        return 0;
+    }
+    if (_flags & O_APPEND)
+    {
+        _pos = _file->size();
+    }
+    if (_pos + size > _file->size())
+    {
+        _file->resize(_pos + size);
+    }
+    memcpy(&(*_file)[_pos], buf, size);
+    _pos += size;
+    return size;
+}
+
+bool SdFile::seekSet(uint64_t pos)
+{
+    if (!isOpen() || pos > _file->size())
+    {
+        return false;
+    }
+    _pos = pos;
+    return true;
+}
+
+uint64_t SdFile::fileSize() const
+{
+    return isOpen() ? _file->size() : 0;
+}
+
+bool SdFat::exists(const char *path)
+{
+    return volume().count(path) != 0;
+}
+
+bool SdFat::remove(const char *path)
+{
+    return volume().erase(path) != 0;
+}
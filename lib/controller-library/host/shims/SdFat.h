@@ -0,0 +1,90 @@
+/**
+ * SdFat.h (host shim)
+ *
+ * An in-memory file system with the subset of the SdFat API the library uses. Every
+ * SdFat instance shares one volume, which host tools can preload or inspect through
+ * HostSdVolume.
+ */
+
+#ifndef HOST_SDFAT_H
+#define HOST_SDFAT_H
+
+#include <Arduino.h>
+#include <string>
+
+typedef int oflag_t;
+
+#ifndef O_RDONLY
+#define O_RDONLY 0x00
+#endif
+#ifndef O_WRONLY
+#define O_WRONLY 0x01
+#endif
+#ifndef O_RDWR
+#define O_RDWR 0x02
+#endif
+#ifndef O_APPEND
+#define O_APPEND 0x08
+#endif
+#ifndef O_CREAT
+#define O_CREAT 0x10
+#endif
+#ifndef O_TRUNC
+#define O_TRUNC 0x20
+#endif
+#ifndef O_EXCL
+#define O_EXCL 0x40
+#endif
+#define O_ACCMODE (O_RDONLY | O_WRONLY | O_RDWR)
+#define O_READ O_RDONLY
+#define O_WRITE O_WRONLY
+
+namespace HostSdVolume
+{
+    /// Create or replace a file
+    void put(const char *path, const std::string &contents);
+    /// Contents of a file, empty if it does not exist
+    std::string get(const char *path);
+    /// Remove every file
+    void clear();
+}
+
+class SdFile : public Print
+{
+public:
+    bool open(const char *path, oflag_t oflag = O_RDONLY);
+    bool close();
+    bool isOpen() const { return _file != nullptr; }
+    bool isReadable() const;
+    bool isWritable() const;
+
+    int available();
+    uint64_t available64();
+    int read();
+    int read(void *buf, size_t count);
+    int peek();
+
+    size_t write(uint8_t b) override;
+    size_t write(const uint8_t *buf, size_t size) override;
+    using Print::write;
+
+    bool seekSet(uint64_t pos);
+    uint64_t curPosition() const { return _pos; }
+    uint64_t fileSize() const;
+    bool sync() { return isOpen(); }
+
+private:
+    std::string *_file = nullptr;
+    uint64_t _pos = 0;
+    oflag_t _flags = 0;
+};
+
+class SdFat
+{
+public:
+    bool begin(uint8_t csPin = SS) { return true; }
+    bool exists(const char *path);
+    bool remove(const char *path);
+};
+
+#endif // HOST_SDFAT_H
@@ -0,0 +1,318 @@
+/**
+ * WString.cpp (host shim)
+ *
+ * Follows the AVR core's WString.cpp: every growth reallocs the buffer to the exact new
+ * length, and numbers are converted in a stack buffer and then copied in.
+ */
+
+#include "WString.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+static void numberToText(char *buf, size_t size, unsigned long value, unsigned char base, bool negative)
+{
+    char digits[8 * sizeof(unsigned long) + 1];
+    char *p = digits + sizeof(digits);
+    *--p = '\0';
+    do
+    {
+        unsigned d = value % base;
+        *--p = d < 10 ? '0' + d : 'a' + d - 10;
+        value /= base;
+    } while (value);
+    snprintf(buf, size, "%s%s", negative ? "-" : "", p);
+}
+
+String::String(const char *cstr)
+{
+    init();
+    if (cstr)
+        copy(cstr, strlen(cstr));
+}
+
+String::String(const String &value)
+{
+    init();
+    *this = value;
+}
+
+String::String(String &&rval)
+{
+    init();
+    move(rval);
+}
+
+String::String(char c)
+{
+    init();
+    char buf[2] = {c, 0};
+    *this = buf;
+}
+
+String::String(unsigned char value, unsigned char base) : String((unsigned long)value, base) {}
+String::String(unsigned int value, unsigned char base) : String((unsigned long)value, base) {}
+String::String(int value, unsigned char base) : String((long)value, base) {}
+
+String::String(long value, unsigned char base)
+{
+    init();
+    char buf[2 + 8 * sizeof(long)];
+    if (base == 10 && value < 0)
+        numberToText(buf, sizeof(buf), 0UL - (unsigned long)value, base, true);
+    else
+        numberToText(buf, sizeof(buf), (unsigned long)value, base, false);
+    *this = buf;
+}
+
+String::String(unsigned long value, unsigned char base)
+{
+    init();
+    char buf[1 + 8 * sizeof(unsigned long)];
+    numberToText(buf, sizeof(buf), value, base, false);
+    *this = buf;
+}
+
+String::String(float value, unsigned char decimalPlaces) : String((double)value, decimalPlaces) {}
+
+String::String(double value, unsigned char decimalPlaces)
+{
+    init();
+    char buf[33];
+    snprintf(buf, sizeof(buf), "%*.*f", decimalPlaces + 2, decimalPlaces, value);
+    *this = buf;
+}
+
+String::~String()
+{
+    free(buffer);
+}
+
+void String::init()
+{
+    buffer = NULL;
+    capacity = 0;
+    len = 0;
+}
+
+void String::invalidate()
+{
+    free(buffer);
+    buffer = NULL;
+    capacity = len = 0;
+}
+
+unsigned char String::reserve(unsigned int size)
+{
+    if (buffer && capacity >= size)
+        return 1;
+    if (changeBuffer(size))
+    {
+        if (len == 0)
+            buffer[0] = 0;
+        return 1;
+    }
+    return 0;
+}
+
+unsigned char String::changeBuffer(unsigned int maxStrLen)
+{
+    char *newbuffer = (char *)realloc(buffer, maxStrLen + 1);
+    if (newbuffer)
+    {
+        buffer = newbuffer;
+        capacity = maxStrLen;
+        return 1;
+    }
+    return 0;
+}
+
+String &String::copy(const char *cstr, unsigned int length)
+{
+    if (!reserve(length))
+    {
+        invalidate();
+        return *this;
+    }
+    len = length;
+    memcpy(buffer, cstr, length);
+    buffer[len] = 0;
+    return *this;
+}
+
+void String::move(String &rhs)
+{
+    free(buffer);
+    buffer = rhs.buffer;
+    capacity = rhs.capacity;
+    len = rhs.len;
+    rhs.buffer = NULL;
+    rhs.capacity = 0;
+    rhs.len = 0;
+}
+
+String &String::operator=(const String &rhs)
+{
+    if (this == &rhs)
+        return *this;
+    if (rhs.buffer)
+        copy(rhs.buffer, rhs.len);
+    else
+        invalidate();
+    return *this;
+}
+
+String &String::operator=(String &&rval)
+{
+    if (this != &rval)
+        move(rval);
+    return *this;
+}
+
+String &String::operator=(const char *cstr)
+{
+    if (cstr)
+        copy(cstr, strlen(cstr));
+    else
+        invalidate();
+    return *this;
+}
+
+unsigned char String::concat(const String &s)
+{
+    return concat(s.buffer, s.len);
+}
+
+unsigned char String::concat(const char *cstr, unsigned int length)
+{
+    unsigned int newlen = len + length;
+    if (!cstr)
+        return 0;
+    if (length == 0)
+        return 1;
+    if (!reserve(newlen))
+        return 0;
+    memmove(buffer + len, cstr, length);
+    len = newlen;
+    buffer[len] = 0;
+    return 1;
+}
+
+unsigned char String::concat(const char *cstr)
+{
+    if (!cstr)
+        return 0;
+    return concat(cstr, strlen(cstr));
+}
+
+unsigned char String::concat(char c)
+{
+    return concat(&c, 1);
+}
+
+unsigned char String::concat(int num) { return concat(String(num)); }
+unsigned char String::concat(unsigned int num) { return concat(String(num)); }
+unsigned char String::concat(long num) { return concat(String(num)); }
+unsigned char String::concat(unsigned long num) { return concat(String(num)); }
+unsigned char String::concat(float num) { return concat(String(num)); }
+unsigned char String::concat(double num) { return concat(String(num)); }
+
+#define SUM_OPERATOR(type, value)                                          \
+    StringSumHelper &operator+(const StringSumHelper &lhs, type value)     \
+    {                                                                      \
+        StringSumHelper &a = const_cast<StringSumHelper &>(lhs);           \
+        if (!a.concat(value))                                              \
+            a.invalidate();                                                \
+        return a;                                                          \
+    }
+
+SUM_OPERATOR(const String &, rhs)
+SUM_OPERATOR(const char *, cstr)
+SUM_OPERATOR(char, c)
+SUM_OPERATOR(int, num)
+SUM_OPERATOR(unsigned int, num)
+SUM_OPERATOR(long, num)
+SUM_OPERATOR(unsigned long, num)
+SUM_OPERATOR(float, num)
+SUM_OPERATOR(double, num)
+
+#undef SUM_OPERATOR
+
+unsigned char String::equals(const String &s2) const
+{
+    return len == s2.len && equals(s2.buffer);
+}
+
+unsigned char String::equals(const char *cstr) const
+{
+    if (len == 0)
+        return cstr == NULL || *cstr == 0;
+    if (cstr == NULL)
+        return buffer[0] == 0;
+    return strcmp(buffer, cstr) == 0;
+}
+
+char String::charAt(unsigned int index) const
+{
+    return operator[](index);
+}
+
+char String::operator[](unsigned int index) const
+{
+    if (index >= len || !buffer)
+        return 0;
+    return buffer[index];
+}
+
+int String::indexOf(char ch, unsigned int fromIndex) const
+{
+    if (fromIndex >= len)
+        return -1;
+    const char *temp = strchr(buffer + fromIndex, ch);
+    return temp ? temp - buffer : -1;
+}
+
+String String::substring(unsigned int left, unsigned int right) const
+{
+    if (left > right)
+    {
+        unsigned int temp = right;
+        right = left;
+        left = temp;
+    }
+    String out;
+    if (left >= len)
+        return out;
+    if (right > len)
+        right = len;
+    out.copy(buffer + left, right - left);
+    return out;
+}
+
+void String::trim()
+{
+    if (!buffer || len == 0)
+        return;
+    char *begin = buffer;
+    while (isspace((unsigned char)*begin))
+        begin++;
+    char *end = buffer + len - 1;
+    while (isspace((unsigned char)*end) && end >= begin)
+        end--;
+    len = end + 1 - begin;
+    if (begin > buffer)
+        memmove(buffer, begin, len);
+    buffer[len] = 0;
+}
+
+long String::toInt() const
+{
+    return buffer ? atol(buffer) : 0;
+}
+
+float String::toFloat() const
+{
+    return buffer ? (float)atof(buffer) : 0;
+}
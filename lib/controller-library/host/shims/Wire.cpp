@@ -0,0 +1,81 @@
+/**
+ * Wire.cpp (host shim)
+ */
+
+#include <Wire.h>
+#include "HostHardware.h"
+
+TwoWire Wire;
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+    _address = address;
+    _txLength = 0;
+}
+
+uint8_t TwoWire::endTransmission(bool)
+{
+    HostI2cDevice *device = HostHardware::i2cDevice(_address);
+    if (device == NULL)
+    {
+        /* Same code as the AVR core: address NACK */
+        return 2;
+    }
+    device->receive(_txBuffer, _txLength);
+    _txLength = 0;
+    return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, bool)
+{
+    if (quantity > WIRE_BUFFER_LENGTH)
+    {
+        quantity = WIRE_BUFFER_LENGTH;
+    }
+    _rxIndex = 0;
+    _rxLength = 0;
+
+    HostI2cDevice *device = HostHardware::i2cDevice(address);
+    if (device == NULL)
+    {
+        return 0;
+    }
+    device->request(_rxBuffer, quantity);
+    _rxLength = quantity;
+    return quantity;
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+    if (_txLength >= WIRE_BUFFER_LENGTH)
+    {
+        return 0;
+    }
+    _txBuffer[_txLength++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t quantity)
+{
+    size_t n = 0;
+    while (n < quantity && write(data[n]))
+    {
+        n++;
+    }
+    return n;
+}
+
+int TwoWire::available()
+{
+    return _rxLength - _rxIndex;
+}
+
+int TwoWire::read()
+{
+    return _rxIndex < _rxLength ? _rxBuffer[_rxIndex++] : -1;
+}
+
+int TwoWire::peek()
+{
+    return _rxIndex < _rxLength ? _rxBuffer[_rxIndex] : -1;
+}
@@ -0,0 +1,44 @@
+/**
+ * Wire.h (host shim)
+ *
+ * Transmissions go to the HostI2cDevice attached at the address; a missing device NACKs.
+ */
+
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include <Arduino.h>
+
+#define WIRE_BUFFER_LENGTH 32
+
+class TwoWire : public Print
+{
+public:
+    void begin() {}
+    void end() {}
+    void setClock(uint32_t) {}
+
+    void beginTransmission(uint8_t address);
+    uint8_t endTransmission(bool sendStop = true);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, bool sendStop = true);
+
+    size_t write(uint8_t data) override;
+    size_t write(const uint8_t *data, size_t quantity) override;
+    using Print::write;
+
+    int available();
+    int read();
+    int peek();
+
+private:
+    uint8_t _address = 0;
+    uint8_t _txBuffer[WIRE_BUFFER_LENGTH];
+    uint8_t _txLength = 0;
+    uint8_t _rxBuffer[WIRE_BUFFER_LENGTH];
+    uint8_t _rxIndex = 0;
+    uint8_t _rxLength = 0;
+};
+
+extern TwoWire Wire;
+
+#endif // HOST_WIRE_H
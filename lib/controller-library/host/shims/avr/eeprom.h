@@ -0,0 +1,23 @@
+/**
+ * avr/eeprom.h (host shim)
+ *
+ * The ATmega2560's 4 KB EEPROM as an array in HostHardware (see HostHardware::eeprom()).
+ * It keeps its contents across HostHardware::reset(), as the real one does across resets.
+ */
+
+#ifndef HOST_AVR_EEPROM_H
+#define HOST_AVR_EEPROM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define E2END 0x0FFF
+
+uint8_t eeprom_read_byte(const uint8_t *address);
+void eeprom_write_byte(uint8_t *address, uint8_t value);
+void eeprom_update_byte(uint8_t *address, uint8_t value);
+void eeprom_read_block(void *dst, const void *src, size_t n);
+void eeprom_write_block(const void *src, void *dst, size_t n);
+void eeprom_update_block(const void *src, void *dst, size_t n);
+
+#endif // HOST_AVR_EEPROM_H
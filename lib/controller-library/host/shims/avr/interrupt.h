@@ -0,0 +1,36 @@
+/**
+ * avr/interrupt.h (host shim)
+ *
+ * ISR(vector) defines an ordinary extern "C" function named after the vector, so host
+ * code (the timer emulation in HostHardware, or a test) can call it directly.
+ * cli()/sei() only track the I bit in SREG; there is no preemption on the host.
+ */
+
+#ifndef HOST_AVR_INTERRUPT_H
+#define HOST_AVR_INTERRUPT_H
+
+#include <avr/io.h>
+
+#define ISR_BLOCK
+#define ISR_NOBLOCK
+#define ISR_NAKED
+#define ISR_ALIASOF(v)
+
+#ifdef __cplusplus
+#define HOST_ISR_LINKAGE extern "C"
+#else
+#define HOST_ISR_LINKAGE
+#endif
+
+#define ISR(vector, ...)                 \
+    HOST_ISR_LINKAGE void vector(void);  \
+    HOST_ISR_LINKAGE void vector(void)
+#define SIGNAL(vector) ISR(vector)
+#define EMPTY_INTERRUPT(vector) \
+    ISR(vector) {}
+
+static inline void sei(void) { SREG |= (1 << SREG_I); }
+static inline void cli(void) { SREG &= ~(1 << SREG_I); }
+#define reti()
+
+#endif // HOST_AVR_INTERRUPT_H
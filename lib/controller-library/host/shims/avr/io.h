@@ -0,0 +1,269 @@
+/**
+ * avr/io.h (host shim)
+ *
+ * ATmega2560 I/O registers as plain host variables, so library code that does direct
+ * register access compiles and runs unchanged on a PC. Bit numbers match the datasheet.
+ *
+ * Registers whose hardware behaviour the library depends on (e.g. ADCSRA's ADSC bit
+ * clearing itself when a conversion finishes) are small proxy objects instead.
+ */
+
+#ifndef HOST_AVR_IO_H
+#define HOST_AVR_IO_H
+
+#include <stdint.h>
+
+#define __AVR_ATmega2560__ 1
+
+#ifndef _BV
+#define _BV(bit) (1 << (bit))
+#endif
+
+// clang-format off
+
+/* 8-bit registers */
+#define HOST_REG8_LIST(X) \
+    X(PINA) X(DDRA) X(PORTA) X(PINB) X(DDRB) X(PORTB) X(PINC) X(DDRC) X(PORTC) \
+    X(PIND) X(DDRD) X(PORTD) X(PINE) X(DDRE) X(PORTE) X(PINF) X(DDRF) X(PORTF) \
+    X(PING) X(DDRG) X(PORTG) X(PINH) X(DDRH) X(PORTH) X(PINJ) X(DDRJ) X(PORTJ) \
+    X(PINK) X(DDRK) X(PORTK) X(PINL) X(DDRL) X(PORTL) \
+    X(SREG) X(MCUSR) X(SMCR) X(WDTCSR) X(GPIOR0) X(GPIOR1) \
+    X(EICRA) X(EICRB) X(EIMSK) X(EIFR) X(PCICR) X(PCIFR) X(PCMSK0) X(PCMSK1) X(PCMSK2) \
+    X(TCCR0A) X(TCCR0B) X(TCNT0) X(OCR0A) X(OCR0B) X(TIMSK0) X(TIFR0) \
+    X(TCCR1A) X(TCCR1B) X(TCCR1C) X(TIMSK1) \
+    X(TCCR2A) X(TCCR2B) X(TCNT2) X(OCR2A) X(OCR2B) X(TIMSK2) X(TIFR2) \
+    X(TCCR3A) X(TCCR3B) X(TCCR3C) X(TIMSK3) X(TIFR3) \
+    X(TCCR4A) X(TCCR4B) X(TCCR4C) X(TIMSK4) \
+    X(TCCR5A) X(TCCR5B) X(TCCR5C) X(TIMSK5) X(TIFR5) \
+    X(ADCSRB) X(ADMUX) X(DIDR0) X(DIDR2) \
+    X(SPCR) X(SPSR) \
+    X(TWBR) X(TWSR) X(TWAR) X(TWDR) X(TWAMR) \
+    X(UCSR0A) X(UCSR0B) X(UCSR0C) X(UDR0) X(UBRR0H) X(UBRR0L)
+
+/* 16-bit registers */
+#define HOST_REG16_LIST(X) \
+    X(TCNT1) X(OCR1A) X(OCR1B) X(OCR1C) X(ICR1) \
+    X(TCNT3) X(OCR3A) X(OCR3B) X(OCR3C) X(ICR3) \
+    X(TCNT4) X(OCR4A) X(OCR4B) X(OCR4C) X(ICR4) \
+    X(TCNT5) X(OCR5A) X(OCR5B) X(OCR5C) X(ICR5) \
+    X(ADC) X(UBRR0)
+
+// clang-format on
+
+#define HOST_DECLARE_REG8(name) extern volatile uint8_t name;
+#define HOST_DECLARE_REG16(name) extern volatile uint16_t name;
+HOST_REG8_LIST(HOST_DECLARE_REG8)
+HOST_REG16_LIST(HOST_DECLARE_REG16)
+#undef HOST_DECLARE_REG8
+#undef HOST_DECLARE_REG16
+
+#define ADCW ADC
+#define ADCL (*(volatile uint8_t *)&ADC)
+
+/**
+ * ADCSRA starts a conversion when ADSC is written, and the hardware clears ADSC
+ * when the result is in ADC. On the host the conversion completes immediately.
+ */
+class HostAdcsraRegister
+{
+public:
+    operator uint8_t() const { return _value; }
+    HostAdcsraRegister &operator=(uint8_t value);
+    HostAdcsraRegister &operator|=(uint8_t value) { return *this = _value | value; }
+    HostAdcsraRegister &operator&=(uint8_t value) { return *this = _value & value; }
+
+private:
+    uint8_t _value = 0;
+};
+extern HostAdcsraRegister ADCSRA;
+
+/**
+ * TWCR starts a bus operation (START, STOP, or sending or receiving a byte) when TWINT is
+ * written as one, and the hardware sets TWINT when the operation is done. On the host the
+ * operation completes after its time on the bus, when the virtual clock reaches it; see
+ * HostHardware::advanceMicros().
+ */
+class HostTwcrRegister
+{
+public:
+    operator uint8_t() const { return _value; }
+    HostTwcrRegister &operator=(uint8_t value);
+    HostTwcrRegister &operator|=(uint8_t value) { return *this = _value | value; }
+    HostTwcrRegister &operator&=(uint8_t value) { return *this = _value & value; }
+
+    /* Set by the bus model */
+    uint8_t _value = 0;
+};
+extern HostTwcrRegister TWCR;
+
+/**
+ * Writing SPDR clocks a byte out to the device whose chip select is low and sets SPIF in
+ * SPSR when the byte clocked in is ready; reading SPDR returns that byte and clears SPIF.
+ * On the host the byte completes immediately, after its time on the bus if
+ * HostHardware::setSpiTiming() is on.
+ */
+class HostSpdrRegister
+{
+public:
+    operator uint8_t();
+    HostSpdrRegister &operator=(uint8_t value);
+
+private:
+    uint8_t _received = 0;
+};
+extern HostSpdrRegister SPDR;
+
+/**
+ * Interrupt flags of the emulated timers (1 and 4): the timer model sets a flag on a
+ * compare match, and writing a one to a flag clears it, as the scheduler does to drop a
+ * stale match before it reprograms Timer 4.
+ */
+class HostTifrRegister
+{
+public:
+    operator uint8_t() const { return _value; }
+    HostTifrRegister &operator=(uint8_t value)
+    {
+        _value &= ~value;
+        return *this;
+    }
+    HostTifrRegister &operator|=(uint8_t value) { return *this = _value | value; }
+    HostTifrRegister &operator&=(uint8_t value) { return *this = _value & value; }
+
+    /* Set by the timer model */
+    uint8_t _value = 0;
+};
+extern HostTifrRegister TIFR1, TIFR4;
+
+/* Port bits */
+#define HOST_PORT_BITS(p) \
+    enum { p##0 = 0, p##1, p##2, p##3, p##4, p##5, p##6, p##7 };
+HOST_PORT_BITS(PA) HOST_PORT_BITS(PB) HOST_PORT_BITS(PC) HOST_PORT_BITS(PD) HOST_PORT_BITS(PE)
+HOST_PORT_BITS(PF) HOST_PORT_BITS(PG) HOST_PORT_BITS(PH) HOST_PORT_BITS(PJ) HOST_PORT_BITS(PK)
+HOST_PORT_BITS(PL)
+#undef HOST_PORT_BITS
+
+/* SREG */
+#define SREG_I 7
+
+/* MCUSR */
+#define JTRF 4
+#define WDRF 3
+#define BORF 2
+#define EXTRF 1
+#define PORF 0
+
+/* SMCR */
+#define SM2 3
+#define SM1 2
+#define SM0 1
+#define SE 0
+
+/* PCICR / PCIFR */
+#define PCIE2 2
+#define PCIE1 1
+#define PCIE0 0
+#define PCIF2 2
+#define PCIF1 1
+#define PCIF0 0
+
+/* 8-bit timers 0 and 2 */
+#define COM0A1 7
+#define COM0A0 6
+#define COM0B1 5
+#define COM0B0 4
+#define WGM01 1
+#define WGM00 0
+#define FOC0A 7
+#define FOC0B 6
+#define WGM02 3
+#define CS02 2
+#define CS01 1
+#define CS00 0
+#define OCIE0B 2
+#define OCIE0A 1
+#define TOIE0 0
+#define OCF0B 2
+#define OCF0A 1
+#define TOV0 0
+
+#define COM2A1 7
+#define COM2A0 6
+#define COM2B1 5
+#define COM2B0 4
+#define WGM21 1
+#define WGM20 0
+#define FOC2A 7
+#define FOC2B 6
+#define WGM22 3
+#define CS22 2
+#define CS21 1
+#define CS20 0
+#define OCIE2B 2
+#define OCIE2A 1
+#define TOIE2 0
+#define OCF2B 2
+#define OCF2A 1
+#define TOV2 0
+
+/* 16-bit timers 1, 3, 4 and 5 */
+#define HOST_TIMER16_BITS(n)                                                       \
+    enum                                                                           \
+    {                                                                              \
+        COM##n##A1 = 7, COM##n##A0 = 6, COM##n##B1 = 5, COM##n##B0 = 4,            \
+        COM##n##C1 = 3, COM##n##C0 = 2, WGM##n##1 = 1, WGM##n##0 = 0,              \
+        ICNC##n = 7, ICES##n = 6, WGM##n##3 = 4, WGM##n##2 = 3,                    \
+        CS##n##2 = 2, CS##n##1 = 1, CS##n##0 = 0,                                  \
+        ICIE##n = 5, OCIE##n##C = 3, OCIE##n##B = 2, OCIE##n##A = 1, TOIE##n = 0,  \
+        ICF##n = 5, OCF##n##C = 3, OCF##n##B = 2, OCF##n##A = 1, TOV##n = 0        \
+    };
+HOST_TIMER16_BITS(1) HOST_TIMER16_BITS(3) HOST_TIMER16_BITS(4) HOST_TIMER16_BITS(5)
+#undef HOST_TIMER16_BITS
+
+/* ADC */
+#define ADEN 7
+#define ADSC 6
+#define ADATE 5
+#define ADIF 4
+#define ADIE 3
+#define ADPS2 2
+#define ADPS1 1
+#define ADPS0 0
+#define ACME 6
+#define MUX5 3
+#define REFS1 7
+#define REFS0 6
+#define ADLAR 5
+
+/* SPI */
+#define SPIE 7
+#define SPE 6
+#define DORD 5
+#define MSTR 4
+#define CPOL 3
+#define CPHA 2
+#define SPR1 1
+#define SPR0 0
+#define SPIF 7
+#define WCOL 6
+#define SPI2X 0
+
+/* TWI */
+#define TWINT 7
+#define TWEA 6
+#define TWSTA 5
+#define TWSTO 4
+#define TWWC 3
+#define TWEN 2
+#define TWIE 0
+#define TWPS1 1
+#define TWPS0 0
+
+/* Watchdog */
+#define WDIF 7
+#define WDIE 6
+#define WDP3 5
+#define WDCE 4
+#define WDE 3
+
+#endif // HOST_AVR_IO_H
@@ -0,0 +1,34 @@
+/**
+ * avr/sleep.h (host shim)
+ *
+ * sleep_cpu() moves the virtual clock to the next Timer 0 overflow, the interrupt that
+ * wakes an idle AVR at the latest, running the emulated timers on the way.
+ */
+
+#ifndef HOST_AVR_SLEEP_H
+#define HOST_AVR_SLEEP_H
+
+#include <avr/io.h>
+
+#define SLEEP_MODE_IDLE 0
+#define SLEEP_MODE_ADC (1 << SM0)
+#define SLEEP_MODE_PWR_DOWN (1 << SM1)
+#define SLEEP_MODE_PWR_SAVE ((1 << SM0) | (1 << SM1))
+#define SLEEP_MODE_STANDBY ((1 << SM1) | (1 << SM2))
+#define SLEEP_MODE_EXT_STANDBY ((1 << SM0) | (1 << SM1) | (1 << SM2))
+
+#define set_sleep_mode(mode) (SMCR = (SMCR & ~((1 << SM0) | (1 << SM1) | (1 << SM2))) | (mode))
+#define sleep_enable() (SMCR |= (1 << SE))
+#define sleep_disable() (SMCR &= ~(1 << SE))
+void _hostSleepCpu(void);
+
+#define sleep_cpu() _hostSleepCpu()
+#define sleep_mode() \
+    do               \
+    {                \
+        sleep_enable(); \
+        sleep_cpu();    \
+        sleep_disable(); \
+    } while (0)
+
+#endif // HOST_AVR_SLEEP_H
@@ -0,0 +1,37 @@
+/**
+ * util/atomic.h (host shim)
+ *
+ * Same shape as avr-libc's ATOMIC_BLOCK: the I bit is cleared for the body of the block
+ * and restored (or forced on) afterwards, including on break/return.
+ */
+
+#ifndef HOST_UTIL_ATOMIC_H
+#define HOST_UTIL_ATOMIC_H
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+static inline uint8_t __host_iCliRetVal(void)
+{
+    cli();
+    return 1;
+}
+
+static inline void __host_iRestore(const uint8_t *sreg) { SREG = *sreg; }
+static inline void __host_iSeiParam(const uint8_t *) { sei(); }
+static inline void __host_iNop(const uint8_t *) {}
+
+#define ATOMIC_RESTORESTATE                                                  \
+    uint8_t sreg_save __attribute__((__cleanup__(__host_iRestore))) = SREG
+#define ATOMIC_FORCEON                                                       \
+    uint8_t sreg_save __attribute__((__cleanup__(__host_iSeiParam))) = 0
+#define NONATOMIC_RESTORESTATE ATOMIC_RESTORESTATE
+#define NONATOMIC_FORCEOFF                                                   \
+    uint8_t sreg_save __attribute__((__cleanup__(__host_iRestore))) = SREG
+
+#define ATOMIC_BLOCK(type) \
+    for (type, __ToDo = __host_iCliRetVal(); __ToDo; __ToDo = 0)
+#define NONATOMIC_BLOCK(type) \
+    for (type, __ToDo = (sei(), (uint8_t)1); __ToDo; __ToDo = 0)
+
+#endif // HOST_UTIL_ATOMIC_H
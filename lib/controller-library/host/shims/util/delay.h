@@ -0,0 +1,15 @@
+/**
+ * util/delay.h (host shim)
+ *
+ * Busy-wait delays advance the virtual clock like delay()/delayMicroseconds().
+ */
+
+#ifndef HOST_UTIL_DELAY_H
+#define HOST_UTIL_DELAY_H
+
+void delayMicroseconds(unsigned int us);
+
+#define _delay_us(us) delayMicroseconds((unsigned int)(us))
+#define _delay_ms(ms) delayMicroseconds((unsigned int)((ms) * 1000))
+
+#endif // HOST_UTIL_DELAY_H
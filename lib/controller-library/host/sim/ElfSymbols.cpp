@@ -0,0 +1,138 @@
+/**
+ * ElfSymbols.cpp
+ */
+
+#include "ElfSymbols.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <cxxabi.h>
+
+#define SHT_SYMTAB 2
+#define STT_FUNC 2
+
+static uint16_t rd16(const std::vector<uint8_t> &b, size_t off)
+{
+    return b[off] | (b[off + 1] << 8);
+}
+
+static uint32_t rd32(const std::vector<uint8_t> &b, size_t off)
+{
+    return b[off] | (b[off + 1] << 8) | (b[off + 2] << 16) | ((uint32_t)b[off + 3] << 24);
+}
+
+static std::string demangle(const char *name)
+{
+    int status = 0;
+    char *d = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+    if (status != 0 || d == nullptr)
+    {
+        return name;
+    }
+    std::string s(d);
+    free(d);
+    return s;
+}
+
+bool ElfSymbols::load(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == nullptr)
+    {
+        return false;
+    }
+    std::vector<uint8_t> b;
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+    {
+        b.insert(b.end(), chunk, chunk + n);
+    }
+    fclose(f);
+
+    /* ELF magic, ELFCLASS32, ELFDATA2LSB */
+    if (b.size() < 52 || memcmp(b.data(), "\x7f" "ELF", 4) != 0 || b[4] != 1 || b[5] != 1)
+    {
+        return false;
+    }
+
+    uint32_t shoff = rd32(b, 0x20);
+    uint16_t shentsize = rd16(b, 0x2E);
+    uint16_t shnum = rd16(b, 0x30);
+    if (shoff + (uint64_t)shentsize * shnum > b.size())
+    {
+        return false;
+    }
+
+    for (uint16_t i = 0; i < shnum; i++)
+    {
+        size_t sh = shoff + (size_t)i * shentsize;
+        if (rd32(b, sh + 4) != SHT_SYMTAB)
+        {
+            continue;
+        }
+        uint32_t symOff = rd32(b, sh + 16);
+        uint32_t symSize = rd32(b, sh + 20);
+        uint32_t link = rd32(b, sh + 24);
+        uint32_t entSize = rd32(b, sh + 36);
+        size_t strSh = shoff + (size_t)link * shentsize;
+        uint32_t strOff = rd32(b, strSh + 16);
+        uint32_t strSize = rd32(b, strSh + 20);
+        if (entSize < 16 || symOff + (uint64_t)symSize > b.size() || strOff + (uint64_t)strSize > b.size())
+        {
+            return false;
+        }
+
+        for (uint32_t s = symOff; s + entSize <= symOff + symSize; s += entSize)
+        {
+            uint32_t nameOff = rd32(b, s);
+            uint32_t value = rd32(b, s + 4);
+            uint32_t size = rd32(b, s + 8);
+            uint8_t info = b[s + 12];
+            if (nameOff >= strSize)
+            {
+                continue;
+            }
+            const char *name = (const char *)&b[strOff + nameOff];
+            _raw.push_back({name, value});
+            if ((info & 0x0F) == STT_FUNC)
+            {
+                _symbols.push_back({value, size, demangle(name)});
+            }
+        }
+    }
+
+    std::sort(_symbols.begin(), _symbols.end(),
+              [](const ElfSymbol &a, const ElfSymbol &b) { return a.address < b.address; });
+    return true;
+}
+
+const ElfSymbol *ElfSymbols::find(uint32_t pc) const
+{
+    auto it = std::upper_bound(_symbols.begin(), _symbols.end(), pc,
+                               [](uint32_t v, const ElfSymbol &s) { return v < s.address; });
+    if (it == _symbols.begin())
+    {
+        return nullptr;
+    }
+    --it;
+    if (pc >= it->address + (it->size ? it->size : 2))
+    {
+        return nullptr;
+    }
+    return &*it;
+}
+
+int64_t ElfSymbols::address(const char *rawName) const
+{
+    for (const auto &r : _raw)
+    {
+        if (r.first == rawName)
+        {
+            return r.second;
+        }
+    }
+    return -1;
+}
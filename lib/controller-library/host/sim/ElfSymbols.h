@@ -0,0 +1,42 @@
+/**
+ * ElfSymbols.h
+ *
+ * Function symbols of an AVR ELF file, for attributing simulated cycles to functions.
+ * A small reader of its own so the harness does not depend on which simavr version
+ * exposes symbols.
+ */
+
+#ifndef ELF_SYMBOLS_H
+#define ELF_SYMBOLS_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+struct ElfSymbol
+{
+    uint32_t address; ///< Byte address in flash
+    uint32_t size;    ///< Bytes
+    std::string name; ///< Demangled
+};
+
+class ElfSymbols
+{
+public:
+    /// @return false if the file is not a readable 32-bit little-endian ELF
+    bool load(const char *path);
+
+    /// Function containing the flash byte address @p pc, or nullptr
+    const ElfSymbol *find(uint32_t pc) const;
+
+    /// Address of a symbol by its raw (mangled) name, or -1
+    int64_t address(const char *rawName) const;
+
+    const std::vector<ElfSymbol> &all() const { return _symbols; }
+
+private:
+    std::vector<ElfSymbol> _symbols; ///< Sorted by address
+    std::vector<std::pair<std::string, uint32_t>> _raw;
+};
+
+#endif // ELF_SYMBOLS_H
@@ -0,0 +1,650 @@
+/**
+ * feh_avrsim.cpp
+ *
+ * Runs a Mega 2560 firmware image (e.g. a PlatformIO Unity test) in simavr, cycle-accurately
+ * and without hardware, and reports:
+ *
+ *  - UART0 output, passed through so PlatformIO's test runner can parse Unity results,
+ *  - pin waveforms (frequency, duty, pulse width) checked against expectations the firmware
+ *    prints as "AVRSIM EXPECT <port><bit> <metric> <value> <tolerance>" lines,
+ *  - cycles spent in each interrupt vector per invocation,
+ *  - cycles between GPIOR0 region markers (see private_include/avrsim.h),
+ *  - optionally a flat per-function cycle profile, timer registers and a VCD trace.
+ *
+ * Waveform expectations are reported as extra Unity test cases, and the Unity summary is
+ * rewritten to include them, so a failed expectation fails `pio test`.
+ */
+
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_io.h>
+#include <simavr/avr_ioport.h>
+#include <simavr/avr_uart.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ElfSymbols.h"
+
+#define F_CPU 16000000UL
+#define CYCLES_PER_US (F_CPU / 1000000UL)
+
+/* Flash byte size of the ATmega2560 vector table: 57 vectors, 4-byte JMP each */
+#define VECTOR_TABLE_BYTES (57 * 4)
+#define OPCODE_RETI 0x9518
+
+/* Data-space address of GPIOR0, used for region markers */
+#define GPIOR0_ADDR 0x3E
+
+static const char *const VECTOR_NAMES[57] = {
+    "RESET", "INT0", "INT1", "INT2", "INT3", "INT4", "INT5", "INT6", "INT7", "PCINT0",
+    "PCINT1", "PCINT2", "WDT", "TIMER2_COMPA", "TIMER2_COMPB", "TIMER2_OVF", "TIMER1_CAPT",
+    "TIMER1_COMPA", "TIMER1_COMPB", "TIMER1_COMPC", "TIMER1_OVF", "TIMER0_COMPA",
+    "TIMER0_COMPB", "TIMER0_OVF", "SPI_STC", "USART0_RX", "USART0_UDRE", "USART0_TX",
+    "ANALOG_COMP", "ADC", "EE_READY", "TIMER3_CAPT", "TIMER3_COMPA", "TIMER3_COMPB",
+    "TIMER3_COMPC", "TIMER3_OVF", "USART1_RX", "USART1_UDRE", "USART1_TX", "TWI",
+    "SPM_READY", "TIMER4_CAPT", "TIMER4_COMPA", "TIMER4_COMPB", "TIMER4_COMPC", "TIMER4_OVF",
+    "TIMER5_CAPT", "TIMER5_COMPA", "TIMER5_COMPB", "TIMER5_COMPC", "TIMER5_OVF", "USART2_RX",
+    "USART2_UDRE", "USART2_TX", "USART3_RX", "USART3_UDRE", "USART3_TX"};
+
+/* Timer registers worth checking after a run, by data-space address */
+static const struct
+{
+    const char *name;
+    uint16_t addr;
+    bool wide;
+} REGISTERS[] = {
+    {"TCCR1A", 0x80, false}, {"TCCR1B", 0x81, false}, {"OCR1A", 0x88, true}, {"TIMSK1", 0x6F, false},
+    {"TCCR2A", 0xB0, false}, {"TCCR2B", 0xB1, false}, {"OCR2A", 0xB3, false}, {"TIMSK2", 0x70, false},
+    {"TCCR3A", 0x90, false}, {"TCCR3B", 0x91, false}, {"OCR3C", 0x9C, true},
+    {"TCCR4A", 0xA0, false}, {"TCCR4B", 0xA1, false}, {"OCR4A", 0xA8, true}, {"TIMSK4", 0x72, false},
+    {"TCCR5A", 0x120, false}, {"TCCR5B", 0x121, false}, {"OCR5A", 0x128, true}, {"OCR5B", 0x12A, true},
+    {"OCR5C", 0x12C, true},
+};
+
+struct Stats
+{
+    uint64_t count = 0;
+    uint64_t total = 0;
+    uint64_t min = UINT64_MAX;
+    uint64_t max = 0;
+
+    void add(uint64_t v)
+    {
+        count++;
+        total += v;
+        min = std::min(min, v);
+        max = std::max(max, v);
+    }
+};
+
+struct Pin
+{
+    std::string name; // e.g. "G5"
+    bool level = false;
+    uint64_t windowStart = 0;
+    uint64_t lastEdge = 0;
+    uint64_t highCycles = 0;
+    uint64_t firstRise = 0;
+    uint64_t lastRise = 0;
+    uint64_t rises = 0;
+    Stats pulses; // high time of complete pulses
+    std::vector<std::pair<uint64_t, bool>> edges; // only kept for --vcd
+};
+
+struct Expectation
+{
+    std::string pin;
+    std::string metric;
+    double value;
+    double tolerance;
+};
+
+struct Options
+{
+    const char *elf = nullptr;
+    const char *json = nullptr;
+    const char *vcd = nullptr;
+    uint64_t maxMs = 600000;
+    uint64_t afterMs = 200;
+    int profile = 0;
+    std::vector<std::string> trace;
+};
+
+/* Simulation state shared with the simavr callbacks */
+static avr_t *s_avr;
+static Options s_opt;
+static std::map<std::string, Pin> s_pins;
+static std::vector<Expectation> s_expectations;
+static std::string s_line;
+static std::vector<std::string> s_heldSummary;
+static int s_unityTests = -1, s_unityFailures = 0, s_unityIgnored = 0;
+static bool s_unityDone = false;
+static std::map<int, Stats> s_regions;
+static std::map<int, std::string> s_regionNames;
+static int s_activeRegion = 0;
+static uint64_t s_regionStart = 0;
+
+//=============================================================================
+// PINS
+//=============================================================================
+
+static void pinChanged(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+    Pin *p = (Pin *)param;
+    bool level = value & 1;
+    if (level == p->level)
+    {
+        return;
+    }
+    uint64_t now = s_avr->cycle;
+    if (p->level)
+    {
+        p->highCycles += now - p->lastEdge;
+        if (p->rises > 0)
+        {
+            p->pulses.add(now - p->lastRise);
+        }
+    }
+    else
+    {
+        if (p->rises == 0)
+        {
+            p->firstRise = now;
+        }
+        p->lastRise = now;
+        p->rises++;
+    }
+    p->level = level;
+    p->lastEdge = now;
+    if (s_opt.vcd)
+    {
+        p->edges.push_back({now, level});
+    }
+}
+
+/* Start measuring a pin from now */
+static void resetWindow(Pin &p)
+{
+    p.windowStart = p.lastEdge = s_avr->cycle;
+    p.highCycles = 0;
+    p.rises = 0;
+    p.pulses = Stats();
+}
+
+static Pin *tracePin(const std::string &name)
+{
+    auto it = s_pins.find(name);
+    if (it != s_pins.end())
+    {
+        return &it->second;
+    }
+    if (name.size() != 2 || name[0] < 'A' || name[0] > 'L' || name[1] < '0' || name[1] > '7')
+    {
+        fprintf(stderr, "avrsim: bad pin '%s', expected <port><bit> like G5\n", name.c_str());
+        return nullptr;
+    }
+    Pin &p = s_pins[name];
+    p.name = name;
+    avr_irq_t *irq = avr_io_getirq(s_avr, AVR_IOCTL_IOPORT_GETIRQ(name[0]), name[1] - '0');
+    if (irq == nullptr)
+    {
+        fprintf(stderr, "avrsim: no port %c on this MCU\n", name[0]);
+        s_pins.erase(name);
+        return nullptr;
+    }
+    p.level = irq->value & 1;
+    resetWindow(p);
+    avr_irq_register_notify(irq, pinChanged, &p);
+    return &p;
+}
+
+static double measure(const Pin &p, const std::string &metric)
+{
+    uint64_t now = s_avr->cycle;
+    if (metric == "duty_pct")
+    {
+        uint64_t high = p.highCycles + (p.level ? now - p.lastEdge : 0);
+        uint64_t window = now - p.windowStart;
+        return window ? 100.0 * high / window : NAN;
+    }
+    if (metric == "freq_hz" || metric == "period_us")
+    {
+        if (p.rises < 2)
+        {
+            return metric == "freq_hz" ? 0.0 : NAN;
+        }
+        double period = (double)(p.lastRise - p.firstRise) / (p.rises - 1);
+        return metric == "freq_hz" ? F_CPU / period : period / CYCLES_PER_US;
+    }
+    if (metric == "high_us")
+    {
+        return p.pulses.count ? (double)p.pulses.total / p.pulses.count / CYCLES_PER_US : NAN;
+    }
+    return NAN;
+}
+
+//=============================================================================
+// UART0: Unity output and AVRSIM directives
+//=============================================================================
+
+static void emit(const std::string &line)
+{
+    fputs(line.c_str(), stdout);
+    fputc('\n', stdout);
+    fflush(stdout);
+}
+
+static void directive(const char *args)
+{
+    char pin[8], metric[16];
+    double value, tol;
+    int id;
+    char name[64];
+
+    if (sscanf(args, "EXPECT %7s %15s %lf %lf", pin, metric, &value, &tol) == 4)
+    {
+        if (tracePin(pin))
+        {
+            s_expectations.push_back({pin, metric, value, tol});
+        }
+    }
+    else if (strncmp(args, "MARK", 4) == 0)
+    {
+        for (auto &p : s_pins)
+        {
+            resetWindow(p.second);
+        }
+    }
+    else if (sscanf(args, "REGION %d %63s", &id, name) == 2)
+    {
+        s_regionNames[id] = name;
+    }
+    else
+    {
+        fprintf(stderr, "avrsim: unknown directive '%s'\n", args);
+    }
+}
+
+static void uartLine(const std::string &line)
+{
+    int tests, failures, ignored;
+
+    if (line.compare(0, 7, "AVRSIM ") == 0)
+    {
+        directive(line.c_str() + 7);
+    }
+    else if (sscanf(line.c_str(), "%d Tests %d Failures %d Ignored", &tests, &failures, &ignored) == 3)
+    {
+        /* Held back so waveform results can be added to it */
+        s_unityTests = tests;
+        s_unityFailures = failures;
+        s_unityIgnored = ignored;
+    }
+    else if (s_unityTests >= 0 && !s_unityDone && (line == "OK" || line == "FAIL"))
+    {
+        s_unityDone = true;
+    }
+    else if (!s_unityDone)
+    {
+        emit(line);
+    }
+}
+
+static void uartByte(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+    char c = (char)value;
+    if (c == '\n')
+    {
+        uartLine(s_line);
+        s_line.clear();
+    }
+    else if (c != '\r')
+    {
+        s_line += c;
+    }
+}
+
+//=============================================================================
+// REGION MARKERS
+//=============================================================================
+
+static void gpior0Write(struct avr_t *avr, avr_io_addr_t addr, uint8_t v, void *param)
+{
+    avr->data[addr] = v;
+    if (s_activeRegion)
+    {
+        s_regions[s_activeRegion].add(avr->cycle - s_regionStart);
+    }
+    s_activeRegion = v;
+    s_regionStart = avr->cycle;
+}
+
+//=============================================================================
+// REPORTING
+//=============================================================================
+
+static void writeVcd(const char *path)
+{
+    FILE *f = fopen(path, "w");
+    if (f == nullptr)
+    {
+        perror(path);
+        return;
+    }
+    fprintf(f, "$timescale 62500 ps $end\n$scope module avr $end\n");
+    char id = '!';
+    std::map<std::string, char> ids;
+    for (auto &p : s_pins)
+    {
+        ids[p.first] = id;
+        fprintf(f, "$var wire 1 %c P%s $end\n", id++, p.first.c_str());
+    }
+    fprintf(f, "$upscope $end\n$enddefinitions $end\n");
+
+    std::vector<std::pair<uint64_t, std::pair<char, bool>>> all;
+    for (auto &p : s_pins)
+    {
+        for (auto &e : p.second.edges)
+        {
+            all.push_back({e.first, {ids[p.first], e.second}});
+        }
+    }
+    std::stable_sort(all.begin(), all.end(),
+                     [](const decltype(all)::value_type &a, const decltype(all)::value_type &b) {
+                         return a.first < b.first;
+                     });
+    for (auto &e : all)
+    {
+        fprintf(f, "#%llu\n%d%c\n", (unsigned long long)e.first, e.second.second, e.second.first);
+    }
+    fclose(f);
+}
+
+static void printStats(FILE *f, const Stats &s)
+{
+    fprintf(f, "\"count\": %llu, \"min\": %llu, \"max\": %llu, \"avg\": %.1f",
+            (unsigned long long)s.count, (unsigned long long)(s.count ? s.min : 0),
+            (unsigned long long)s.max, s.count ? (double)s.total / s.count : 0.0);
+}
+
+int main(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char *a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(a, "--json") && hasValue)
+            s_opt.json = argv[++i];
+        else if (!strcmp(a, "--vcd") && hasValue)
+            s_opt.vcd = argv[++i];
+        else if (!strcmp(a, "--max-ms") && hasValue)
+            s_opt.maxMs = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(a, "--after-ms") && hasValue)
+            s_opt.afterMs = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(a, "--profile") && hasValue)
+            s_opt.profile = atoi(argv[++i]);
+        else if (!strcmp(a, "--trace") && hasValue)
+            s_opt.trace.push_back(argv[++i]);
+        else if (a[0] != '-' && s_opt.elf == nullptr)
+            s_opt.elf = a;
+        else
+        {
+            fprintf(stderr,
+                    "usage: %s firmware.elf [--json FILE] [--vcd FILE] [--trace G5]...\n"
+                    "       [--max-ms N] [--after-ms N] [--profile TOP_N]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (s_opt.elf == nullptr)
+    {
+        fprintf(stderr, "avrsim: no firmware given\n");
+        return 2;
+    }
+
+    ElfSymbols symbols;
+    if (!symbols.load(s_opt.elf))
+    {
+        fprintf(stderr, "avrsim: cannot read symbols from %s\n", s_opt.elf);
+        return 2;
+    }
+
+    elf_firmware_t firmware;
+    memset(&firmware, 0, sizeof(firmware));
+    if (elf_read_firmware(s_opt.elf, &firmware) != 0)
+    {
+        fprintf(stderr, "avrsim: cannot load %s\n", s_opt.elf);
+        return 2;
+    }
+    firmware.frequency = F_CPU;
+
+    s_avr = avr_make_mcu_by_name("atmega2560");
+    if (s_avr == nullptr)
+    {
+        fprintf(stderr, "avrsim: simavr has no atmega2560 core\n");
+        return 2;
+    }
+    avr_init(s_avr);
+    avr_load_firmware(s_avr, &firmware);
+    s_avr->frequency = F_CPU;
+    s_avr->log = LOG_WARNING;
+
+    /* UART0 goes through uartByte() only */
+    uint32_t uartFlags = 0;
+    avr_ioctl(s_avr, AVR_IOCTL_UART_GET_FLAGS('0'), &uartFlags);
+    uartFlags &= ~AVR_UART_FLAG_STDIO;
+    avr_ioctl(s_avr, AVR_IOCTL_UART_SET_FLAGS('0'), &uartFlags);
+    avr_irq_register_notify(avr_io_getirq(s_avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT), uartByte, nullptr);
+
+    avr_register_io_write(s_avr, GPIOR0_ADDR, gpior0Write, nullptr);
+
+    for (const std::string &t : s_opt.trace)
+    {
+        tracePin(t);
+    }
+
+    /* ISR entry addresses: __vector_N */
+    std::map<uint32_t, int> isrEntry;
+    for (int v = 1; v < 57; v++)
+    {
+        char name[16];
+        snprintf(name, sizeof(name), "__vector_%d", v);
+        int64_t addr = symbols.address(name);
+        if (addr >= 0)
+        {
+            isrEntry[(uint32_t)addr] = v;
+        }
+    }
+
+    std::map<int, Stats> isrStats;
+    std::vector<std::pair<int, uint64_t>> isrStack;
+    std::map<const ElfSymbol *, uint64_t> profile;
+
+    const uint64_t maxCycles = s_opt.maxMs * (F_CPU / 1000);
+    uint64_t stopAt = UINT64_MAX;
+    const char *exitReason = "timeout";
+
+    for (;;)
+    {
+        uint32_t pc = s_avr->pc;
+        uint64_t before = s_avr->cycle;
+        int state = avr_run(s_avr);
+
+        if (state == cpu_Done || state == cpu_Crashed)
+        {
+            exitReason = state == cpu_Done ? "done" : "crashed";
+            break;
+        }
+
+        if (s_opt.profile)
+        {
+            profile[symbols.find(pc)] += s_avr->cycle - before;
+        }
+
+        if (state == cpu_Running && !isrStack.empty() && pc + 1 < s_avr->flashend &&
+            (s_avr->flash[pc] | (s_avr->flash[pc + 1] << 8)) == OPCODE_RETI)
+        {
+            isrStats[isrStack.back().first].add(s_avr->cycle - isrStack.back().second);
+            isrStack.pop_back();
+        }
+
+        /* Arrived at an ISR through its vector table JMP */
+        if (pc < VECTOR_TABLE_BYTES)
+        {
+            auto it = isrEntry.find(s_avr->pc);
+            if (it != isrEntry.end())
+            {
+                isrStack.push_back({it->second, s_avr->cycle});
+            }
+        }
+
+        if (s_unityDone && stopAt == UINT64_MAX)
+        {
+            stopAt = s_avr->cycle + s_opt.afterMs * (F_CPU / 1000);
+        }
+        if (s_avr->cycle >= stopAt)
+        {
+            exitReason = "unity";
+            break;
+        }
+        if (s_avr->cycle >= maxCycles)
+        {
+            break;
+        }
+    }
+
+    if (!s_line.empty())
+    {
+        uartLine(s_line);
+    }
+
+    /* Waveform expectations, reported as Unity test cases */
+    int passed = 0;
+    std::vector<double> measured;
+    for (const Expectation &e : s_expectations)
+    {
+        double m = measure(s_pins[e.pin], e.metric);
+        measured.push_back(m);
+        bool ok = !isnan(m) && fabs(m - e.value) <= e.tolerance;
+        passed += ok;
+        char line[160];
+        if (ok)
+        {
+            snprintf(line, sizeof(line), "avrsim:0:waveform_%s_%s:PASS", e.pin.c_str(), e.metric.c_str());
+        }
+        else
+        {
+            snprintf(line, sizeof(line), "avrsim:0:waveform_%s_%s:FAIL: Expected %g +/- %g Was %g",
+                     e.pin.c_str(), e.metric.c_str(), e.value, e.tolerance, m);
+        }
+        emit(line);
+    }
+
+    int failures = (int)s_expectations.size() - passed;
+    if (s_unityTests >= 0)
+    {
+        int tests = s_unityTests + (int)s_expectations.size();
+        failures += s_unityFailures;
+        emit("");
+        emit("-----------------------");
+        emit(std::to_string(tests) + " Tests " + std::to_string(failures) + " Failures " +
+             std::to_string(s_unityIgnored) + " Ignored ");
+        emit(failures ? "FAIL" : "OK");
+    }
+    else
+    {
+        fprintf(stderr, "avrsim: no Unity summary before %s\n", exitReason);
+        failures++;
+    }
+
+    if (s_opt.vcd)
+    {
+        writeVcd(s_opt.vcd);
+    }
+
+    if (s_opt.json)
+    {
+        FILE *f = fopen(s_opt.json, "w");
+        if (f == nullptr)
+        {
+            perror(s_opt.json);
+            return 2;
+        }
+        fprintf(f, "{\n  \"elf\": \"%s\",\n  \"exit\": \"%s\",\n  \"cycles\": %llu,\n", s_opt.elf, exitReason,
+                (unsigned long long)s_avr->cycle);
+        fprintf(f, "  \"unity\": {\"tests\": %d, \"failures\": %d, \"ignored\": %d},\n", s_unityTests,
+                s_unityFailures, s_unityIgnored);
+
+        fprintf(f, "  \"isrs\": [");
+        size_t n = 0;
+        for (auto &s : isrStats)
+        {
+            fprintf(f, "%s\n    {\"vector\": %d, \"name\": \"%s\", ", n++ ? "," : "", s.first, VECTOR_NAMES[s.first]);
+            printStats(f, s.second);
+            fprintf(f, "}");
+        }
+        fprintf(f, "\n  ],\n  \"regions\": [");
+        n = 0;
+        for (auto &r : s_regions)
+        {
+            fprintf(f, "%s\n    {\"id\": %d, \"name\": \"%s\", ", n++ ? "," : "", r.first,
+                    s_regionNames.count(r.first) ? s_regionNames[r.first].c_str() : "");
+            printStats(f, r.second);
+            fprintf(f, "}");
+        }
+        fprintf(f, "\n  ],\n  \"waveforms\": [");
+        n = 0;
+        for (auto &p : s_pins)
+        {
+            fprintf(f, "%s\n    {\"pin\": \"%s\", \"freq_hz\": %.3f, \"duty_pct\": %.3f, \"high_us\": %.3f}",
+                    n++ ? "," : "", p.first.c_str(), measure(p.second, "freq_hz"), measure(p.second, "duty_pct"),
+                    measure(p.second, "high_us"));
+        }
+        fprintf(f, "\n  ],\n  \"expectations\": [");
+        for (size_t i = 0; i < s_expectations.size(); i++)
+        {
+            const Expectation &e = s_expectations[i];
+            fprintf(f, "%s\n    {\"pin\": \"%s\", \"metric\": \"%s\", \"expected\": %g, \"tolerance\": %g, \"measured\": %g}",
+                    i ? "," : "", e.pin.c_str(), e.metric.c_str(), e.value, e.tolerance, measured[i]);
+        }
+        fprintf(f, "\n  ],\n  \"registers\": {");
+        for (size_t i = 0; i < sizeof(REGISTERS) / sizeof(REGISTERS[0]); i++)
+        {
+            uint16_t v = s_avr->data[REGISTERS[i].addr];
+            if (REGISTERS[i].wide)
+            {
+                v |= s_avr->data[REGISTERS[i].addr + 1] << 8;
+            }
+            fprintf(f, "%s\"%s\": %u", i ? ", " : "", REGISTERS[i].name, v);
+        }
+        fprintf(f, "},\n  \"profile\": [");
+        std::vector<std::pair<uint64_t, const ElfSymbol *>> top;
+        for (auto &p : profile)
+        {
+            top.push_back({p.second, p.first});
+        }
+        std::sort(top.rbegin(), top.rend());
+        for (int i = 0; i < (int)top.size() && i < s_opt.profile; i++)
+        {
+            std::string name = top[i].second ? top[i].second->name : "?";
+            for (char &c : name)
+            {
+                if (c == '"' || c == '\\')
+                    c = '\'';
+            }
+            fprintf(f, "%s\n    {\"function\": \"%s\", \"cycles\": %llu}", i ? "," : "", name.c_str(),
+                    (unsigned long long)top[i].first);
+        }
+        fprintf(f, "\n  ]\n}\n");
+        fclose(f);
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,44 @@
+/**
+ * check.h
+ *
+ * Checks shared by the host tests. Each test is its own program, so the failure count is
+ * per program; main() ends with return checkResult("name").
+ */
+
+#ifndef HOST_TESTS_CHECK_H
+#define HOST_TESTS_CHECK_H
+
+#include <stdio.h>
+
+static int s_failures;
+
+/* Print @p what if @p ok is false */
+static inline void check(bool ok, const char *what)
+{
+    if (!ok)
+    {
+        printf("FAIL %s\n", what);
+        s_failures++;
+    }
+}
+
+/* Print @p what with the measured @p value as a row of a table, pass or fail */
+static inline void check(bool ok, const char *what, double value)
+{
+    printf("%-40s %10.3f  %s\n", what, value, ok ? "ok" : "FAIL");
+    s_failures += !ok;
+}
+
+/* Print the result of test @p name and return the exit code of the program */
+static inline int checkResult(const char *name)
+{
+    if (s_failures == 0)
+    {
+        printf("%s: all checks passed\n", name);
+        return 0;
+    }
+    printf("%s: %d failures\n", name, s_failures);
+    return 1;
+}
+
+#endif // HOST_TESTS_CHECK_H
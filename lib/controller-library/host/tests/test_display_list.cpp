@@ -0,0 +1,127 @@
+/**
+ * test_display_list.cpp
+ *
+ * Runs a debug screen through LCD.SetOutput(): streamed alongside the display, and
+ * streamed alone, where it must not touch the display yet leave the text cursor where
+ * drawing would. With file arguments the stream and the final screen are saved there for
+ * tools/lcd_view.py to redraw and compare pixel for pixel.
+ */
+
+#include <FEH.h>
+#include "HostHardware.h"
+#include "FEHInternal.h"
+#include "displaylist.h"
+#include "check.h"
+#include <stdio.h>
+#include <string>
+
+/* One update of a debug screen that uses every FEHLCD draw call */
+static void drawScreen(int frame)
+{
+    LCD.Clear(NAVY);
+    LCD.SetFontColor(WHITE);
+    LCD.SetFontSize(2);
+    LCD.WriteAt("Speed:", 10, 10);
+    LCD.WriteAt(12.5f + frame, 100, 10);
+    LCD.SetFontSize(1);
+    LCD.SetTextCursor(10, 40);
+    LCD.Printf("frame %d", frame);
+    LCD.WriteLine(" of many");
+    LCD.Write(frame % 2 == 0);
+    LCD.SetFontColor(YELLOW, RED);
+    LCD.WriteLine("  opaque text that runs past the right edge and wraps");
+
+    LCD.SetFontColor(GREEN);
+    LCD.DrawRectangle(10, 80, 100, 60);
+    LCD.FillRectangle(20 + frame, 90, 30, -20);
+    LCD.DrawLine(10, 150, 200, 190 - frame);
+    LCD.DrawHorizontalLine(200, 10, 230);
+    LCD.DrawVerticalLine(230, 80, 300);
+    LCD.DrawPixel(5, 5);
+    LCD.SetFontColor(ORANGE);
+    LCD.DrawCircle(160, 250, 30);
+    LCD.FillCircle(60, 260, 20 + frame);
+    LCD.DrawRectangle(-10, 290, 50, 50);
+
+    char label[20] = "0.000";
+    FEHIcon::Icon icon;
+    LCD.SetFontSize(2);
+    icon.SetProperties(label, 120, 90, 80, 30, WHITE, RED);
+    icon.Draw();
+    icon.ChangeLabelFloat(1.25f * frame);
+}
+
+static bool save(const char *path, const void *data, size_t len)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f)
+    {
+        return false;
+    }
+    bool ok = fwrite(data, 1, len, f) == len;
+    return fclose(f) == 0 && ok;
+}
+
+int main(int argc, char **argv)
+{
+    HostHardware::reset();
+    ILI9341.begin();
+    FEHTelemetry::begin();
+    HostHardware::clearSerial();
+
+    // Screen only: nothing is sent
+    drawScreen(0);
+    check(HostHardware::serialOutput().empty(), "nothing streamed with output on the screen");
+
+    // Streamed alongside the display
+    LCD.SetOutput(FEHLCD::ScreenAndStream);
+    ILI9341.clearHostStats();
+    drawScreen(1);
+    _serviceDeferredWork();
+    uint64_t panelBytes = ILI9341.hostStats().spiBytes;
+    std::string stream = HostHardware::serialOutput();
+    int16_t cursorX = ILI9341.getCursorX(), cursorY = ILI9341.getCursorY();
+
+    if (argc > 2)
+    {
+        std::string panel;
+        for (int16_t y = 0; y < ILI9341.height(); y++)
+        {
+            for (int16_t x = 0; x < ILI9341.width(); x++)
+            {
+                uint16_t p = ILI9341.hostPixel(x, y);
+                panel += (char)(p & 0xFF);
+                panel += (char)(p >> 8);
+            }
+        }
+        check(save(argv[1], stream.data(), stream.size()) && save(argv[2], panel.data(), panel.size()),
+              "stream and screen saved");
+    }
+
+    // Streamed alone
+    HostHardware::clearSerial();
+    LCD.SetOutput(FEHLCD::Stream);
+    uint32_t before = ILI9341.hostChecksum();
+    ILI9341.clearHostStats();
+    drawScreen(1);
+    check(ILI9341.hostStats().spiBytes == 0, "streaming alone sends nothing to the display");
+    check(ILI9341.hostChecksum() == before, "streaming alone leaves the screen as it was");
+    check(ILI9341.getCursorX() == cursorX && ILI9341.getCursorY() == cursorY, "text cursor moves as when drawing");
+
+    // The icon's label is the last text: held back until deferred work runs
+    size_t held = HostHardware::serialOutput().size();
+    _serviceDeferredWork();
+    check(HostHardware::serialOutput().size() > held, "pending text sent by deferred work");
+    size_t streamBytes = HostHardware::serialOutput().size();
+
+    printf("one update: %llu bytes to the display, %zu bytes streamed\n", (unsigned long long)panelBytes,
+           streamBytes);
+    check(streamBytes * 50 < panelBytes, "stream is under 2% of the display traffic");
+
+    LCD.SetOutput(FEHLCD::Screen);
+    HostHardware::clearSerial();
+    LCD.FillRectangle(0, 0, 10, 10);
+    check(HostHardware::serialOutput().empty(), "back on the screen, nothing streamed");
+
+    return checkResult("display list");
+}
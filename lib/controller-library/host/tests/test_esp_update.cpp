@@ -0,0 +1,325 @@
+/**
+ * test_esp_update.cpp
+ *
+ * A Mega application update through the ESP32, end to end against a stand-in ESP32: the
+ * library asks for the download and stages the update in EEPROM, then the bootloader's
+ * receiver (bootloaders/stk500v2/espboot.c, compiled here with flash and SPI hooks) pulls
+ * the image. Checks a full update fits in 10 s of bus and flash time, that an unchanged
+ * image rewrites only the reset vector page, that a lost link leaves no runnable
+ * application and resumes on the next run, that the bootloader starts nothing until it
+ * does, and that a corrupt frame or image never commits.
+ */
+
+#include <FEH.h>
+#include "HostHardware.h"
+#include "FEHESP32.h"
+#include "espboot.h"
+#include "check.h"
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+#include <deque>
+#include <stdio.h>
+#include <vector>
+
+#define ESP32_CS_PIN 40
+#define FLASH_BYTES (AVR_UPDATE_MAX_PAGES * AVR_UPDATE_PAGE_SIZE)
+// ATmega2560 page erase plus page write
+#define PAGE_WRITE_US 9000
+
+static uint16_t crcPage(const uint8_t *data, uint16_t crc = 0xFFFF)
+{
+    for (int i = 0; i < AVR_UPDATE_PAGE_SIZE; i++)
+    {
+        crc = _crc16_update(crc, data[i]);
+    }
+    return crc;
+}
+
+/**
+ * The ESP32 side: answers CMD_AVR_DOWNLOAD by "downloading" image, and CMD_AVR_READ_PAGE
+ * with the page, each answer in the frame after its request as the SPI slave does.
+ */
+class StandInEsp32 : public HostSpiDevice
+{
+public:
+    std::vector<uint8_t> image;  ///< What the next download fetches, padded to whole pages
+    int answerPages = -1;        ///< Pages to serve before going silent, -1 for no limit
+    int corruptPage = -1;        ///< Page whose first serving arrives with a flipped bit
+
+    void select() override
+    {
+        _in.clear();
+        _out.clear();
+        if (!_queue.empty())
+        {
+            _out.swap(_queue.front());
+            _queue.pop_front();
+        }
+    }
+
+    uint8_t transfer(uint8_t byte) override
+    {
+        uint8_t out = _in.size() < _out.size() ? _out[_in.size()] : 0;
+        _in.push_back(byte);
+        return out;
+    }
+
+    void deselect() override
+    {
+        if (_in.size() < 4 || _in[0] != 0xAA || _in[1] != 0x55)
+        {
+            return;
+        }
+        if (_in[2] == CMD_AVR_DOWNLOAD)
+        {
+            download();
+        }
+        else if (_in[2] == CMD_AVR_READ_PAGE && _in.size() == AVR_UPDATE_FRAME_SIZE)
+        {
+            servePage(_in[4] | (_in[5] << 8));
+        }
+    }
+
+private:
+    std::vector<uint8_t> _in, _out;
+    std::deque<std::vector<uint8_t>> _queue;
+    std::vector<uint8_t> _downloaded;
+
+    void queue(uint8_t cmd, const std::vector<uint8_t> &data)
+    {
+        std::vector<uint8_t> frame = {0xAA, 0x55, cmd, (uint8_t)data.size()};
+        frame.insert(frame.end(), data.begin(), data.end());
+        _queue.push_back(frame);
+    }
+
+    void download()
+    {
+        _downloaded = image;
+        uint16_t pages = _downloaded.size() / AVR_UPDATE_PAGE_SIZE;
+        uint16_t crc = 0xFFFF;
+        for (uint16_t page = 0; page < pages; page++)
+        {
+            crc = crcPage(&_downloaded[page * AVR_UPDATE_PAGE_SIZE], crc);
+        }
+        uint32_t bytes = _downloaded.size();
+        queue(RSP_ACK, {CMD_AVR_DOWNLOAD});
+        queue(NOTIFY_FLASH_PROGRESS, {0, 0, 0, 0, (uint8_t)bytes, (uint8_t)(bytes >> 8), (uint8_t)(bytes >> 16), 0});
+        queue(NOTIFY_AVR_IMAGE_READY, {(uint8_t)pages, (uint8_t)(pages >> 8), (uint8_t)crc, (uint8_t)(crc >> 8),
+                                       (uint8_t)bytes, (uint8_t)(bytes >> 8), (uint8_t)(bytes >> 16), 0});
+    }
+
+    void servePage(uint16_t page)
+    {
+        if (answerPages == 0 || (page + 1) * AVR_UPDATE_PAGE_SIZE > _downloaded.size())
+        {
+            return;
+        }
+        if (answerPages > 0)
+        {
+            answerPages--;
+        }
+        const uint8_t *data = &_downloaded[page * AVR_UPDATE_PAGE_SIZE];
+        uint16_t crc = crcPage(data);
+        std::vector<uint8_t> frame = {0xAA, 0x55, RSP_AVR_PAGE, 0, (uint8_t)page, (uint8_t)(page >> 8)};
+        frame.insert(frame.end(), data, data + AVR_UPDATE_PAGE_SIZE);
+        frame.push_back((uint8_t)crc);
+        frame.push_back((uint8_t)(crc >> 8));
+        if (page == corruptPage)
+        {
+            frame[100] ^= 0x10;
+            corruptPage = -1;
+        }
+        _queue.push_back(frame);
+    }
+};
+
+static StandInEsp32 s_esp32;
+
+/* The bootloader's flash and its costs */
+static uint8_t s_flash[FLASH_BYTES];
+static uint32_t s_pageWrites;
+static uint64_t s_spiBytes;
+static uint32_t s_idles;
+static bool s_spiTaken;
+
+extern "C" {
+
+void espbootSpiBegin(void)
+{
+    s_spiTaken = true;
+}
+
+void espbootSpiEnd(void)
+{
+    s_spiTaken = false;
+}
+
+void espbootSpiFrame(uint8_t *frame, uint16_t len)
+{
+    check(s_spiTaken, "frames only between espbootSpiBegin() and espbootSpiEnd()");
+    s_esp32.select();
+    for (uint16_t i = 0; i < len; i++)
+    {
+        frame[i] = s_esp32.transfer(frame[i]);
+    }
+    s_esp32.deselect();
+    s_spiBytes += len;
+}
+
+void espbootIdle(void)
+{
+    s_idles++;
+}
+
+uint8_t espbootFlashByte(uint32_t address)
+{
+    return s_flash[address];
+}
+
+void espbootFlashWrite(uint32_t address, const uint8_t *page)
+{
+    memcpy(&s_flash[address], page, AVR_UPDATE_PAGE_SIZE);
+    s_pageWrites++;
+}
+
+uint8_t espbootEepromRead(uint16_t address)
+{
+    return eeprom_read_byte((const uint8_t *)(uintptr_t)address);
+}
+
+void espbootEepromWrite(uint16_t address, uint8_t value)
+{
+    eeprom_write_byte((uint8_t *)(uintptr_t)address, value);
+}
+}
+
+static std::vector<uint8_t> makeImage(size_t bytes, uint32_t seed)
+{
+    std::vector<uint8_t> image(bytes);
+    for (size_t i = 0; i < bytes; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        image[i] = seed >> 16;
+    }
+    image.resize((bytes + AVR_UPDATE_PAGE_SIZE - 1) / AVR_UPDATE_PAGE_SIZE * AVR_UPDATE_PAGE_SIZE, 0xFF);
+    return image;
+}
+
+static bool flashHolds(const std::vector<uint8_t> &image)
+{
+    return memcmp(s_flash, image.data(), image.size()) == 0;
+}
+
+static bool markerSet()
+{
+    return HostHardware::eeprom()[AVR_UPDATE_MARKER_ADDRESS] == AVR_UPDATE_MAGIC;
+}
+
+/* The library's side: download through the stand-in and stage the update */
+static bool download(const std::vector<uint8_t> &image)
+{
+    s_esp32.image = image;
+    if (!FEHESP32::downloadApplication("http://10.0.0.2/app.bin"))
+    {
+        return false;
+    }
+    for (int i = 0; i < 5 && !FEHESP32::isApplicationReady(); i++)
+    {
+        FEHESP32::poll();
+    }
+    return FEHESP32::isApplicationReady() && FEHESP32::stageApplication();
+}
+
+/* Bus and flash time of the last bootloader run */
+static double lastSeconds()
+{
+    return s_spiBytes * 8.0 / AVR_UPDATE_SPI_CLOCK_HZ + s_pageWrites * PAGE_WRITE_US * 1e-6;
+}
+
+/* One bootloader run; returns espbootRun()'s result */
+static uint8_t boot(const char *what)
+{
+    s_pageWrites = 0;
+    s_spiBytes = 0;
+    s_idles = 0;
+    espbootSpiBegin();
+    uint8_t result = espbootRun();
+    espbootSpiEnd();
+    printf("%-24s result %u, %4lu pages written, %7llu SPI bytes, %.2f s\n", what, result,
+           (unsigned long)s_pageWrites, (unsigned long long)s_spiBytes, lastSeconds());
+    return result;
+}
+
+int main()
+{
+    HostHardware::reset();
+    HostHardware::attachSpiDevice(ESP32_CS_PIN, &s_esp32);
+    FEHESP32::init();
+
+    // The running application
+    std::vector<uint8_t> old = makeImage(FLASH_BYTES, 1);
+    memcpy(s_flash, old.data(), old.size());
+
+    check(boot("nothing staged") == ESPBOOT_NOT_PENDING && s_spiBytes == 0, "no marker, no update");
+
+    // Largest application there is room for, every page different
+    std::vector<uint8_t> full = makeImage(FLASH_BYTES - 100, 2);
+    check(download(full), "library downloads and stages the update");
+    check(FEHESP32::getFlashProgress() == 1.0f, "download progress reaches 100%");
+    const uint8_t *marker = HostHardware::eeprom() + AVR_UPDATE_MARKER_ADDRESS;
+    check(marker[0] == AVR_UPDATE_MAGIC && (marker[1] | (marker[2] << 8)) == AVR_UPDATE_MAX_PAGES,
+          "marker holds the page count");
+    check(boot("full image") == ESPBOOT_DONE && flashHolds(full), "full image written");
+    check(s_pageWrites == AVR_UPDATE_MAX_PAGES + 1, "every page written once, page 0 erased first");
+    check(lastSeconds() < 10.0, "full update in under 10 s");
+    check(!markerSet(), "marker cleared on commit");
+    check(boot("after commit") == ESPBOOT_NOT_PENDING, "committed update does not run again");
+
+    // The same image again: only the reset vector page is erased and rewritten
+    check(download(full), "same image staged");
+    check(boot("unchanged image") == ESPBOOT_DONE && s_pageWrites == 2, "unchanged pages skipped");
+
+    // A smaller build that changed a little: the link drops partway
+    std::vector<uint8_t> edited = makeImage(100 * 1024, 2);
+    edited[5000] ^= 0xFF;
+    edited[60000] ^= 0xFF;
+    check(download(edited), "edited image staged");
+    s_esp32.answerPages = 150;
+    check(boot("link lost") == ESPBOOT_NO_ANSWER, "lost link reported");
+    check(s_idles == ESPBOOT_RETRIES + 1, "gives up after ESPBOOT_RETRIES silent frames");
+    bool blank = true;
+    for (int i = 0; i < AVR_UPDATE_PAGE_SIZE; i++)
+    {
+        blank &= s_flash[i] == 0xFF;
+    }
+    check(blank, "no reset vector until the update commits");
+    check(markerSet(), "marker kept for the next run");
+
+    // installApplication() resets through the watchdog, which would jump straight to the
+    // application; pages 1 on still hold the old one and part of the new
+    s_spiBytes = 0;
+    check(!espbootStart(_BV(WDRF)) && s_spiBytes > 0, "watchdog reset retries and starts nothing");
+    s_spiBytes = 0;
+    check(!espbootStart(_BV(EXTRF)) && s_spiBytes == 0, "reset button waits for avrdude, starts nothing");
+    check(!espbootStart(0), "wait timeout retries and starts nothing");
+
+    s_esp32.answerPages = -1;
+    s_esp32.corruptPage = 300;
+    check(boot("resumed, one bad frame") == ESPBOOT_DONE && flashHolds(edited), "update resumes after the link returns");
+    check(s_pageWrites == 2, "resume writes only what is left");
+    s_spiBytes = 0;
+    check(espbootStart(_BV(WDRF)) && s_spiBytes == 0, "committed application started after the reset");
+
+    // The ESP32 serves a different image from the one announced: never committed
+    check(download(edited), "image staged");
+    HostHardware::eeprom()[AVR_UPDATE_MARKER_ADDRESS + 3] ^= 1;
+    check(boot("wrong image CRC") == ESPBOOT_BAD_IMAGE && markerSet(), "wrong image not committed");
+    check(s_flash[0] == 0xFF && s_flash[1] == 0xFF, "wrong image leaves no reset vector");
+    check(!espbootStart(_BV(WDRF)) && markerSet(), "wrong image is never started");
+
+    // A marker written over is not an update, but an erased page 0 is still no application
+    HostHardware::eeprom()[AVR_UPDATE_MARKER_ADDRESS + 5] ^= 1;
+    check(!espbootPending() && !espbootStart(_BV(WDRF)), "blank reset vector not started");
+
+    return checkResult("esp update");
+}
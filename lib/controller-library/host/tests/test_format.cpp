@@ -0,0 +1,84 @@
+/**
+ * test_format.cpp
+ *
+ * Checks FormatText() and FormatText_P() against the C library's snprintf() for the
+ * conversions they support, %S, and FixedString's truncation.
+ */
+
+#include <FEHFormat.h>
+#include <avr/pgmspace.h>
+#include <stdio.h>
+#include <string.h>
+#include "check.h"
+
+#define CHECK_FORMAT(fmt, ...)                                                         \
+    do                                                                                 \
+    {                                                                                  \
+        char expected[64], actual[64], flash[64];                                      \
+        int expectedLen = snprintf(expected, sizeof(expected), fmt, __VA_ARGS__);      \
+        int actualLen = FormatText(actual, sizeof(actual), fmt, __VA_ARGS__);          \
+        int flashLen = FormatText_P(flash, sizeof(flash), PSTR(fmt), __VA_ARGS__);     \
+        if (strcmp(expected, actual) != 0 || expectedLen != actualLen)                 \
+        {                                                                              \
+            printf("FAIL %-12s expected \"%s\" (%d), got \"%s\" (%d)\n", fmt, expected, \
+                   expectedLen, actual, actualLen);                                    \
+            s_failures++;                                                              \
+        }                                                                              \
+        if (strcmp(actual, flash) != 0 || actualLen != flashLen)                       \
+        {                                                                              \
+            printf("FAIL %-12s FormatText_P gave \"%s\" (%d)\n", fmt, flash, flashLen);  \
+            s_failures++;                                                              \
+        }                                                                              \
+    } while (0)
+
+int main()
+{
+    CHECK_FORMAT("%d", 0);
+    CHECK_FORMAT("%d", -12345);
+    CHECK_FORMAT("%i|%5d|%-5d|%05d", 42, 42, 42, -42);
+    CHECK_FORMAT("%+d % d %+d", 7, 7, -7);
+    CHECK_FORMAT("%.3d|%.0d|%8.3d", 5, 0, -5);
+    CHECK_FORMAT("%ld %lu", -2147483647L, 4294967295UL);
+    CHECK_FORMAT("%u %x %X %08lx", 65535u, 0xbeefu, 0xbeefu, 0x1234abcdUL);
+    CHECK_FORMAT("%*d|%-*d|%*d", 6, 1, 6, 2, -6, 3);
+    CHECK_FORMAT("%c%c%3c|%-3c|", 'a', 'b', 'c', 'd');
+    CHECK_FORMAT("%s|%8s|%-8s|%.3s|%*.*s", "text", "text", "text", "text", 6, 2, "text");
+    CHECK_FORMAT("%f", 3.14159);
+    CHECK_FORMAT("%.2f|%.0f|%.1f", 2.718, 2.718, -0.04);
+    CHECK_FORMAT("%8.3f|%-8.3f|%08.3f|%+.2f", 1.5, 1.5, -1.5, 1.5);
+    CHECK_FORMAT("%.2f %.2f %.2f", 0.999, 9.999, 99.999);
+    CHECK_FORMAT("%.4f %.6f", 1234567.8901, 0.000123);
+    CHECK_FORMAT("%.*f", 3, 12.3456);
+    CHECK_FORMAT("%5.1f|%5.1f", 1.0 / 0.0, -1.0 / 0.0);
+    CHECK_FORMAT("100%% %s", "done");
+    CHECK_FORMAT("%hd %hu", (short)-3, (unsigned short)3);
+
+    char small[8];
+    int n = FormatText(small, sizeof(small), "%s=%d", "value", 12345);
+    check(n == 11 && strcmp(small, "value=1") == 0, "FormatText truncates and returns the full length");
+    check(FormatText(nullptr, 0, "%d", 123) == 3, "FormatText with size 0");
+    FormatText(small, sizeof(small), "%f", 5e9);
+    check(strcmp(small, "ovf") == 0, "floats beyond 32 bits print ovf");
+
+    static const char name[] PROGMEM = "flash";
+    char text[32];
+    n = FormatText(text, sizeof(text), "[%S|%8S|%-7S|%.2S]", name, name, name, name);
+    check(n == 27 && strcmp(text, "[flash|   flash|flash  |fl]") == 0, "%S prints strings from program memory");
+    FormatText_P(text, sizeof(text), PSTR("%s %S"), (const char *)nullptr, (const char *)nullptr);
+    check(strcmp(text, "(null) (null)") == 0, "%s and %S print (null)");
+
+    FixedString<12> s("x=");
+    s += 1.25;
+    s += ' ';
+    s += -7;
+    check(strcmp(s, "x=1.25 -7") == 0 && s.length() == 9 && !s.truncated(), "FixedString appends");
+    s.append(3.14159, 3);
+    check(strcmp(s.c_str(), "x=1.25 -73.1") == 0 && s.length() == 12 && s.truncated(),
+          "FixedString truncates at capacity");
+    s += "more";
+    check(s.length() == 12 && s.truncated(), "FixedString stays full");
+    s.printf("%u%%", 50u);
+    check(strcmp(s, "50%") == 0 && s.length() == 3 && !s.truncated(), "FixedString printf replaces");
+
+    return checkResult("format");
+}
@@ -0,0 +1,192 @@
+/**
+ * test_i2c.cpp
+ *
+ * Runs FEHI2C against the emulated TWI port: queued transactions complete in order from
+ * the interrupt while the caller carries on, fast mode takes a quarter of the bus time,
+ * a missing device NACKs, and a device holding SDA low is failed and clocked free by
+ * the health check. Touch() is then read both synchronously and from the 10 ms poll.
+ */
+
+#include <FEH.h>
+#include "HostHardware.h"
+#include "FEHInternal.h"
+#include "check.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define SENSOR_ADDRESS 0x68
+#define MISSING_ADDRESS 0x50
+
+/* A register file: a write sets the register pointer, then stores any further bytes */
+class RegisterDevice : public HostI2cDevice
+{
+public:
+    uint8_t registers[64];
+    uint8_t pointer = 0;
+    std::vector<std::vector<uint8_t>> writes;
+
+    RegisterDevice()
+    {
+        for (int i = 0; i < 64; i++)
+        {
+            registers[i] = (uint8_t)(0xA0 + i);
+        }
+    }
+
+    void receive(const uint8_t *data, size_t len) override
+    {
+        writes.emplace_back(data, data + len);
+        if (len > 0)
+        {
+            pointer = data[0] & 63;
+        }
+        for (size_t i = 1; i < len; i++)
+        {
+            registers[pointer++ & 63] = data[i];
+        }
+    }
+
+    void request(uint8_t *data, size_t len) override
+    {
+        for (size_t i = 0; i < len; i++)
+        {
+            data[i] = registers[(pointer + i) & 63];
+        }
+    }
+};
+
+static std::vector<int> s_completed;
+
+static void recordCompletion(FEHI2CTransaction *t)
+{
+    s_completed.push_back((int)(intptr_t)t->context);
+}
+
+static void testQueue(RegisterDevice &sensor)
+{
+    HostHardware::reset();
+    HostHardware::attachI2cDevice(SENSOR_ADDRESS, &sensor);
+    FEHI2C::begin();
+    s_completed.clear();
+
+    uint8_t regA = 0x00, regB = 0x10, dataA[6], dataB[2];
+    uint8_t write[2] = {0x20, 0x5A};
+    FEHI2CTransaction a(SENSOR_ADDRESS, &regA, 1, dataA, sizeof(dataA), I2C_FAST, recordCompletion, (void *)1);
+    FEHI2CTransaction b(SENSOR_ADDRESS, write, 2, nullptr, 0, I2C_FAST, recordCompletion, (void *)2);
+    FEHI2CTransaction c(SENSOR_ADDRESS, &regB, 1, dataB, sizeof(dataB), I2C_FAST, recordCompletion, (void *)3);
+
+    uint64_t start = HostHardware::nowMicros();
+    check(FEHI2C::submit(a) && FEHI2C::submit(b) && FEHI2C::submit(c), "three transactions queue");
+    check(!FEHI2C::submit(a), "a pending transaction cannot be queued twice");
+    check(HostHardware::nowMicros() == start, "submit() does not wait for the bus");
+    check(a.status == I2C_PENDING && c.status == I2C_PENDING, "transactions pending after submit()");
+
+    HostHardware::advanceMicros(2000);
+    check(a.done() && b.done() && c.done(), "queue drains from the interrupt");
+    check(a.status == I2C_OK && b.status == I2C_OK && c.status == I2C_OK, "all complete with I2C_OK");
+    check(s_completed == std::vector<int>({1, 2, 3}), "callbacks run in submission order");
+    check(dataA[0] == 0xA0 && dataA[5] == 0xA5, "register read returns the device's bytes");
+    check(sensor.registers[0x20] == 0x5A, "register write reaches the device");
+    check(dataB[0] == 0xB0 && dataB[1] == 0xB1, "second read after the write");
+
+    uint8_t value = 0;
+    check(FEHI2C::readRegisters(SENSOR_ADDRESS, 0x20, &value, 1) == I2C_OK && value == 0x5A,
+          "synchronous readRegisters()");
+    check(FEHI2C::writeRegister(MISSING_ADDRESS, 0x00, 1) == I2C_NACK_ADDRESS, "missing device NACKs");
+    check(FEHI2C::readRegisters(SENSOR_ADDRESS, 0x01, &value, 1) == I2C_OK && value == 0xA1,
+          "bus works after a NACK");
+}
+
+/* Virtual time for a 7-byte register read, as the touch panel needs */
+static uint64_t readTime(FEHI2CSpeed speed)
+{
+    uint8_t data[7];
+    uint64_t start = HostHardware::nowMicros();
+    FEHI2C::readRegisters(SENSOR_ADDRESS, 0x00, data, sizeof(data), speed);
+    return HostHardware::nowMicros() - start;
+}
+
+static void testSpeed(RegisterDevice &sensor)
+{
+    HostHardware::reset();
+    HostHardware::attachI2cDevice(SENSOR_ADDRESS, &sensor);
+    FEHI2C::begin();
+
+    uint64_t standard = readTime(I2C_STANDARD);
+    uint64_t fast = readTime(I2C_FAST);
+    printf("7-byte read: %llu us at 100 kHz, %llu us at 400 kHz\n", (unsigned long long)standard,
+           (unsigned long long)fast);
+    // 10 bytes of 9 bits on the wire: 900 us and 225 us, plus interrupt latency
+    check(standard >= 900 && standard < 1100, "100 kHz read takes about 900 us");
+    check(fast >= 225 && fast < 350, "400 kHz read takes about 225 us");
+}
+
+static void testStuckBus(RegisterDevice &sensor)
+{
+    HostHardware::reset();
+    HostHardware::attachI2cDevice(SENSOR_ADDRESS, &sensor);
+    FEHI2C::begin();
+    s_completed.clear();
+
+    uint8_t reg = 0x00, data[4];
+    FEHI2CTransaction t(SENSOR_ADDRESS, &reg, 1, data, sizeof(data), I2C_FAST, recordCompletion, (void *)7);
+    unsigned long recoveries = FEHI2C::recoveries();
+
+    HostHardware::setI2cStuck(true);
+    FEHI2C::submit(t);
+    HostHardware::advanceMicros(100000);
+    check(!FEHI2C::checkStalled(), "first health check only notes the progress so far");
+    HostHardware::advanceMicros(100000);
+    check(t.status == I2C_PENDING, "stuck transaction stays pending");
+    check(FEHI2C::checkStalled(), "second health check sees no progress");
+    check(t.status == I2C_TIMEOUT && s_completed == std::vector<int>({7}), "stalled transaction fails with a callback");
+    check(FEHI2C::recoveries() == recoveries + 1, "bus recovered once");
+    check(!FEHI2C::checkStalled(), "idle bus is not stalled");
+
+    HostHardware::setI2cStuck(true);
+    check(FEHI2C::readRegisters(SENSOR_ADDRESS, 0x00, data, 1) == I2C_TIMEOUT, "wait() times out on a stuck bus");
+    check(FEHI2C::recoveries() == recoveries + 2, "timeout recovers the bus");
+    check(FEHI2C::readRegisters(SENSOR_ADDRESS, 0x02, data, 1) == I2C_OK && data[0] == 0xA2,
+          "bus works after recovery");
+}
+
+static void testTouch()
+{
+    HostHardware::reset();
+    FEHI2C::begin();
+
+    int x = 0, y = 0;
+    HostHardware::setTouch(true, 120, 80);
+    check(LCD.Touch(&x, &y) && x == 120 && y == 80, "synchronous touch read");
+    HostHardware::setTouch(false);
+    check(!LCD.Touch(&x, &y), "no touch");
+
+    // From here on Touch() reads the sample polled in the background
+    check(_touchBegin(128), "touch panel identifies as an FT6206");
+    HostHardware::setTouch(true, 200, 40);
+    HostHardware::advanceMicros(20000);
+
+    HostHardware::clearI2cStats();
+    uint64_t start = HostHardware::nowMicros();
+    bool touched = LCD.Touch(&x, &y);
+    check(HostHardware::nowMicros() == start, "polled Touch() does not wait for the bus");
+    check(HostHardware::i2cStats().transactions == 0, "polled Touch() does not use the bus");
+    check(touched && x == 200 && y == 40, "polled touch point");
+
+    HostHardware::setTouch(false);
+    HostHardware::advanceMicros(20000);
+    check(!LCD.Touch(&x, &y), "polled release");
+    check(HostHardware::i2cStats().transactions >= 2, "panel polled every 10 ms");
+}
+
+int main()
+{
+    RegisterDevice sensor;
+    testQueue(sensor);
+    testSpeed(sensor);
+    testStuckBus(sensor);
+    testTouch();
+
+    return checkResult("i2c");
+}
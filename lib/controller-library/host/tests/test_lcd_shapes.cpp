@@ -0,0 +1,118 @@
+/**
+ * test_lcd_shapes.cpp
+ *
+ * Checks that the span-based FEHLCD shapes (FillCircle, DrawLine, DrawRectangle) light
+ * exactly the pixels of the Adafruit GFX routines they replace, including shapes clipped
+ * by the screen edge, and that they never need more address windows to do it.
+ */
+
+#include <FEH.h>
+#include "HostHardware.h"
+#include "FEHInternal.h"
+#include "check.h"
+#include <functional>
+#include <stdio.h>
+#include <stdlib.h>
+
+static uint64_t s_gfxWindows, s_spanWindows;
+
+/* Draw with each path on a black screen and compare the panels */
+static void compare(const char *what, const std::function<void()> &gfx, const std::function<void()> &span)
+{
+    ILI9341.fillScreen(BLACK);
+    ILI9341.clearHostStats();
+    gfx();
+    uint32_t expected = ILI9341.hostChecksum();
+    uint64_t gfxWindows = ILI9341.hostStats().addrWindows;
+
+    ILI9341.fillScreen(BLACK);
+    ILI9341.clearHostStats();
+    span();
+    uint64_t spanWindows = ILI9341.hostStats().addrWindows;
+
+    s_gfxWindows += gfxWindows;
+    s_spanWindows += spanWindows;
+    if (ILI9341.hostChecksum() != expected)
+    {
+        printf("FAIL %s: pixels differ\n", what);
+        s_failures++;
+    }
+    if (spanWindows > gfxWindows)
+    {
+        printf("FAIL %s: %llu address windows, GFX needs %llu\n", what, (unsigned long long)spanWindows,
+               (unsigned long long)gfxWindows);
+        s_failures++;
+    }
+}
+
+static void testCircles()
+{
+    char what[48];
+    for (int r = 0; r <= 100; r++)
+    {
+        snprintf(what, sizeof(what), "FillCircle r=%d", r);
+        compare(what, [r]() { ILI9341.fillCircle(160, 120, r, WHITE); },
+                [r]() { LCD.FillCircle(160, 120, r); });
+    }
+    // Clipped by the corners and edges
+    compare("FillCircle top left", []() { ILI9341.fillCircle(5, 8, 40, WHITE); },
+            []() { LCD.FillCircle(5, 8, 40); });
+    compare("FillCircle bottom right", []() { ILI9341.fillCircle(315, 236, 33, WHITE); },
+            []() { LCD.FillCircle(315, 236, 33); });
+    compare("FillCircle off screen", []() { ILI9341.fillCircle(-50, 120, 20, WHITE); },
+            []() { LCD.FillCircle(-50, 120, 20); });
+}
+
+static void testLines()
+{
+    char what[64];
+    srand(64);
+    for (int i = 0; i < 500; i++)
+    {
+        // Some endpoints off screen
+        int x0 = rand() % 360 - 20, y0 = rand() % 280 - 20;
+        int x1 = rand() % 360 - 20, y1 = rand() % 280 - 20;
+        snprintf(what, sizeof(what), "DrawLine (%d,%d)-(%d,%d)", x0, y0, x1, y1);
+        compare(what, [=]() { ILI9341.drawLine(x0, y0, x1, y1, WHITE); },
+                [=]() { LCD.DrawLine(x0, y0, x1, y1); });
+    }
+    compare("DrawLine diagonal", []() { ILI9341.drawLine(10, 10, 200, 200, WHITE); },
+            []() { LCD.DrawLine(10, 10, 200, 200); });
+    compare("DrawLine shallow", []() { ILI9341.drawLine(10, 100, 300, 110, WHITE); },
+            []() { LCD.DrawLine(10, 100, 300, 110); });
+}
+
+static void testRectangles()
+{
+    char what[64];
+    const int sizes[] = {1, 2, 3, 10, 100};
+    for (int w : sizes)
+    {
+        for (int h : sizes)
+        {
+            snprintf(what, sizeof(what), "DrawRectangle %dx%d", w, h);
+            compare(what, [=]() { ILI9341.drawRect(50, 50, w, h, WHITE); },
+                    [=]() { LCD.DrawRectangle(50, 50, w, h); });
+        }
+    }
+    compare("DrawRectangle clipped", []() { ILI9341.drawRect(-10, 200, 100, 100, WHITE); },
+            []() { LCD.DrawRectangle(-10, 200, 100, 100); });
+}
+
+int main()
+{
+    HostHardware::reset();
+    ILI9341.begin();
+    LCD.SetOrientation(FEHLCD::East);
+    LCD.SetFontColor(WHITE);
+
+    testCircles();
+    testLines();
+    testRectangles();
+
+    printf("address windows: %llu with GFX, %llu with spans\n", (unsigned long long)s_gfxWindows,
+           (unsigned long long)s_spanWindows);
+    check(s_spanWindows * 2 < s_gfxWindows, "spans need less than half the address windows");
+
+    return checkResult("lcd shapes");
+}
@@ -0,0 +1,173 @@
+/**
+ * test_lcd_tile.cpp
+ *
+ * Checks the off-screen tile from private_include/lcdtile.h: shapes and text composed in
+ * it, in one band or many and clipped by the screen edge, land on the panel exactly as
+ * drawn directly, in one address window per band. FEHIcon label changes composed in a
+ * tile must leave the same screen as the erase-and-redraw path they replace.
+ */
+
+#include <FEH.h>
+#include "HostHardware.h"
+#include "FEHInternal.h"
+#include "lcdtile.h"
+#include "check.h"
+#include <functional>
+#include <stdio.h>
+
+static const uint16_t PALETTE[] = {BLUE, WHITE, RED, GREEN};
+
+/* Draw @p scene into a tile over the rectangle, and directly over the same rectangle
+   filled with the background, and compare the rectangle; nothing outside it may change */
+static void compare(const char *what, int16_t x, int16_t y, int16_t w, int16_t h,
+                    const std::function<void(Adafruit_GFX &)> &scene, uint64_t bands)
+{
+    ILI9341.fillScreen(BLACK);
+    ILI9341.fillRect(x, y, w, h, PALETTE[0]);
+    scene(ILI9341);
+    static uint16_t expected[320 * 240];
+    for (int16_t row = 0; row < ILI9341.height(); row++)
+    {
+        for (int16_t col = 0; col < ILI9341.width(); col++)
+        {
+            expected[row * ILI9341.width() + col] = ILI9341.hostPixel(col, row);
+        }
+    }
+
+    ILI9341.fillScreen(BLACK);
+    ILI9341.clearHostStats();
+    LcdTile tile(x, y, w, h, PALETTE, 4);
+    while (tile.nextBand())
+    {
+        scene(tile);
+    }
+    const Adafruit_ILI9341::HostStats &stats = ILI9341.hostStats();
+
+    bool inside = true, outside = true;
+    for (int16_t row = 0; row < ILI9341.height(); row++)
+    {
+        for (int16_t col = 0; col < ILI9341.width(); col++)
+        {
+            uint16_t pixel = ILI9341.hostPixel(col, row);
+            if (col >= x && col < x + w && row >= y && row < y + h)
+            {
+                inside &= pixel == expected[row * ILI9341.width() + col];
+            }
+            else
+            {
+                outside &= pixel == BLACK;
+            }
+        }
+    }
+
+    char line[96];
+    snprintf(line, sizeof(line), "%s: pixels match direct drawing", what);
+    check(inside, line);
+    snprintf(line, sizeof(line), "%s: nothing drawn outside the tile", what);
+    check(outside, line);
+    snprintf(line, sizeof(line), "%s: one address window per band", what);
+    check(stats.addrWindows == bands && stats.transactions == bands, line);
+}
+
+static void scene(Adafruit_GFX &gfx)
+{
+    gfx.fillCircle(60, 50, 30, RED);
+    gfx.drawRect(10, 10, 100, 80, WHITE);
+    gfx.drawLine(0, 0, 200, 120, GREEN);
+    gfx.setTextWrap(false);
+    gfx.setTextSize(2);
+    gfx.setTextColor(WHITE, RED);
+    gfx.setCursor(20, 60);
+    gfx.print("12.125");
+}
+
+static void testTile()
+{
+    // 64x32 fits one band; 200x100 takes 10 rows per band
+    compare("small tile", 5, 40, 64, 32, scene, 1);
+    compare("banded tile", 0, 0, 200, 100, scene, 10);
+    // Clipped to the 140 columns and 70 rows left on the 240x320 screen
+    compare("clipped tile", 100, 250, 200, 100, [](Adafruit_GFX &gfx) {
+        gfx.fillCircle(170, 290, 40, GREEN);
+        gfx.drawFastHLine(0, 300, 240, WHITE);
+    }, 5);
+
+    // A color outside the palette draws as the background
+    ILI9341.fillScreen(BLACK);
+    LcdTile tile(0, 0, 10, 10, PALETTE, 4);
+    while (tile.nextBand())
+    {
+        tile.fillRect(0, 0, 10, 10, YELLOW);
+    }
+    check(ILI9341.hostPixel(5, 5) == PALETTE[0], "unknown color draws as the background");
+
+    LcdTile offScreen(-50, 10, 20, 20, PALETTE, 4);
+    ILI9341.clearHostStats();
+    check(!offScreen.nextBand(), "tile entirely off screen has no bands");
+    check(ILI9341.hostStats().spiBytes == 0, "tile entirely off screen sends nothing");
+}
+
+/* Run the same label changes with and without compositing and compare the panels */
+static void testIcon()
+{
+    static const float VALUES[] = {1.25f, 3.5f, 12.125f, 7.75f, -0.5f, 3.5f};
+    char label[20] = "0.000";
+    uint64_t windows[2] = {0, 0}, bytes[2] = {0, 0};
+    uint32_t checksum[2];
+
+    for (int composited = 0; composited < 2; composited++)
+    {
+        _lcdSetCompositing(composited);
+        ILI9341.fillScreen(BLACK);
+        LCD.SetFontSize(2);
+        FEHIcon::Icon icon;
+        icon.SetProperties(label, 100, 100, 80, 30, WHITE, RED);
+        icon.Draw();
+
+        ILI9341.clearHostStats();
+        for (float value : VALUES)
+        {
+            icon.ChangeLabelFloat(value);
+        }
+        icon.ChangeLabelInt(42);
+        icon.ChangeLabelString("GO");
+        windows[composited] = ILI9341.hostStats().addrWindows;
+        bytes[composited] = ILI9341.hostStats().spiBytes;
+        checksum[composited] = ILI9341.hostChecksum();
+    }
+    _lcdSetCompositing(true);
+
+    printf("icon label changes: %llu bytes in %llu windows direct, %llu bytes in %llu windows composited\n",
+           (unsigned long long)bytes[0], (unsigned long long)windows[0], (unsigned long long)bytes[1],
+           (unsigned long long)windows[1]);
+    check(checksum[0] == checksum[1], "composited labels match the direct path");
+    // 80x30 is two bands of the 2048-pixel tile
+    check(windows[1] == 2 * 8, "one window per band of each composited label change");
+    check(bytes[1] < bytes[0], "composited labels send fewer bytes");
+
+    // A selected icon keeps its rings through a label change
+    ILI9341.fillScreen(BLACK);
+    FEHIcon::Icon icon;
+    icon.SetProperties(label, 100, 100, 80, 30, WHITE, RED);
+    icon.Draw();
+    icon.Select();
+    icon.ChangeLabelString("GO");
+    uint32_t composed = ILI9341.hostChecksum();
+
+    ILI9341.fillScreen(BLACK);
+    icon.Draw();
+    icon.Select();
+    check(ILI9341.hostChecksum() == composed, "selected icon keeps its rings");
+}
+
+int main()
+{
+    HostHardware::reset();
+    ILI9341.begin();
+    LCD.SetOrientation(FEHLCD::East);
+
+    testTile();
+    testIcon();
+
+    return checkResult("lcd tile");
+}
@@ -0,0 +1,90 @@
+/**
+ * test_log.cpp
+ *
+ * The FEH_LOG_* macros: levels above FEH_LOG_LEVEL compiled out, runtime levels per
+ * module, arguments not evaluated when a message is not sent, the line format, and a
+ * library trace point (the scheduler's full queue warning).
+ */
+
+#define FEH_LOG_LEVEL FEH_LOG_LEVEL_DEBUG
+
+#include <FEH.h>
+#include "HostHardware.h"
+#include "scheduler.h"
+#include "check.h"
+#include <stdio.h>
+#include <string.h>
+
+static int s_evaluated;
+
+static int evaluate(int value)
+{
+    s_evaluated++;
+    return value;
+}
+
+static bool logged(const char *text)
+{
+    return HostHardware::serialOutput().find(text) != std::string::npos;
+}
+
+static void noop()
+{
+}
+
+int main()
+{
+    HostHardware::reset();
+    Serial.begin(SERIAL_CONSOLE_BAUD);
+
+    // Nowhere to send: nothing is formatted or evaluated
+    FEH_LOG_ERROR(APP, "dropped %d", evaluate(1));
+    check(s_evaluated == 0 && HostHardware::serialOutput().empty(), "no output while logging is off");
+
+    FEHLog::enableSerial();
+    FEH_LOG_INFO(APP, "speed %d%%", evaluate(35));
+    check(s_evaluated == 1, "enabled level evaluates its arguments");
+    char line[32];
+    snprintf(line, sizeof(line), "%lu I app: speed 35%%\r\n", (unsigned long)millis());
+    check(HostHardware::serialOutput() == line, "line format");
+    HostHardware::clearSerial();
+
+    FEH_LOG_DEBUG(APP, "debug %d", evaluate(2));
+    check(s_evaluated == 2 && logged(" D app: debug 2"), "DEBUG compiled in");
+    FEH_LOG_TRACE(APP, "trace %d", evaluate(3));
+    check(s_evaluated == 2 && !logged("trace"), "TRACE compiled out");
+
+    // Runtime levels
+    FEHLog::setLevel(FEH_LOG_APP, FEH_LOG_LEVEL_WARN);
+    check(FEHLog::level(FEH_LOG_APP) == FEH_LOG_LEVEL_WARN, "level set");
+    FEH_LOG_INFO(APP, "info %d", evaluate(4));
+    check(s_evaluated == 2 && !logged("info"), "INFO filtered at WARN");
+    FEH_LOG_WARN(APP, "warn %d", evaluate(5));
+    check(s_evaluated == 3 && logged(" W app: warn 5"), "WARN passes at WARN");
+    check(FEHLog::level(FEH_LOG_SD) == FEH_LOG_LEVEL_TRACE, "other modules unchanged");
+
+    // A library module: the scheduler warns when its queue is full
+    HostHardware::clearSerial();
+    for (int i = 0; i < 8; i++)
+    {
+        scheduleEvent(noop, schedulerMsToTicks(1000));
+    }
+    check(!scheduleEvent(noop, schedulerMsToTicks(1000)), "ninth event refused");
+    check(!scheduleEvent(noop, schedulerMsToTicks(1000)), "tenth event refused");
+    check(HostHardware::serialOutput().empty(), "scheduler warning deferred");
+    check(schedulerService() && logged(" W scheduler: queue full, 2 events dropped"), "scheduler warning");
+    HostHardware::clearSerial();
+    check(!schedulerService() && HostHardware::serialOutput().empty(), "warning reported once");
+    FEHLog::setLevel(FEH_LOG_SCHEDULER, FEH_LOG_LEVEL_ERROR);
+    scheduleEvent(noop, schedulerMsToTicks(1000));
+    schedulerService();
+    check(HostHardware::serialOutput().empty(), "scheduler warning filtered at ERROR");
+    cancelEvents(noop);
+
+    FEHLog::setLevel(FEH_LOG_LEVEL_NONE);
+    FEH_LOG_ERROR(APP, "error %d", evaluate(6));
+    check(s_evaluated == 3 && !logged("error"), "all modules off");
+
+    FEHLog::disableSerial();
+    return checkResult("log");
+}
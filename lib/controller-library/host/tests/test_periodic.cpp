@@ -0,0 +1,158 @@
+/**
+ * test_periodic.cpp
+ *
+ * FEHPeriodic on the emulated Timer 1, sharing it with a servo. A 2 kHz callback samples
+ * the servo's pin to check its frames still come every 20 ms; a 1 kHz and a 500 Hz
+ * callback share releases so the second starts late by the first's run. Then overruns
+ * (a run longer than the period skips releases), a callback stopped for running over its
+ * budget, and the rate, budget and load checks of attach(). Last, a callback's reads
+ * while FEHRecorder is on are left for the main thread to write to the SD card.
+ */
+
+#include <FEH.h>
+#include "HostHardware.h"
+#include "spibus.h"
+#include "check.h"
+#include <stdio.h>
+
+/* Servo0 is pin 12, PB6 */
+static bool s_servoHigh;
+static int s_servoFrames;
+static uint64_t s_firstRise, s_lastRise;
+
+static void sampleServo()
+{
+    bool high = PORTB & _BV(6);
+    if (high && !s_servoHigh)
+    {
+        s_lastRise = HostHardware::nowMicros();
+        s_firstRise = s_servoFrames++ ? s_firstRise : s_lastRise;
+    }
+    s_servoHigh = high;
+}
+
+static void fast()
+{
+    delayMicroseconds(100);
+}
+
+static void slow()
+{
+    delayMicroseconds(50);
+}
+
+static int s_calls;
+
+/* Every tenth run takes 1.5 periods */
+static void sometimesLong()
+{
+    delayMicroseconds(++s_calls % 10 == 0 ? 1500 : 100);
+}
+
+static void hog()
+{
+    delayMicroseconds(300);
+}
+
+static void idle()
+{
+}
+
+/* TimeNow() is a recorded input that changes every millisecond */
+static void readClock()
+{
+    TimeNow();
+}
+
+static void print(const char *name, void (*callback)())
+{
+    FEHPeriodic::Stats s;
+    FEHPeriodic::stats(callback, &s);
+    printf("%-14s runs %5lu  overruns %3lu  over budget %3u  max latency %4u us  max run %4u us%s\n", name, s.runs,
+           s.overruns, s.overBudget, s.maxLatencyMicros, s.maxRunMicros, s.stopped ? "  stopped" : "");
+}
+
+int main()
+{
+    HostHardware::reset();
+    FEHPeriodic::Stats s;
+
+    // Rates, budgets and load
+    check(!FEHPeriodic::attach(idle, 50), "rate below PERIODIC_MIN_HZ refused");
+    check(!FEHPeriodic::attach(idle, 3000), "rate above PERIODIC_MAX_HZ refused");
+    check(!FEHPeriodic::attach(idle, 1000, 1000), "budget of a whole period refused");
+    check(!FEHPeriodic::attach(idle, 2000, 300), "60% load refused");
+    check(!FEHPeriodic::stats(idle, &s), "no stats for a callback not attached");
+
+    // A servo running frames on OCR1A while three callbacks run on OCR1B
+    FEHServo servo(FEHServo::Servo0);
+    servo.SetDegree(90);
+    check(FEHPeriodic::attach(sampleServo, 2000, 50), "2 kHz sampler attached");
+    check(FEHPeriodic::attach(fast, 1000, 150), "1 kHz attached");
+    check(FEHPeriodic::attach(slow, 500, 100), "500 Hz attached");
+    check(!FEHPeriodic::attach(hog, 1000, 300), "attach past PERIODIC_MAX_LOAD_PERCENT refused");
+    check(FEHPeriodic::attach(idle, 100, 10), "fourth callback attached");
+    check(!FEHPeriodic::attach(hog, 100, 100), "fifth callback refused");
+    FEHPeriodic::detach(idle);
+
+    Sleep(1000);
+    print("servo sampler", sampleServo);
+    print("1 kHz", fast);
+    print("500 Hz", slow);
+
+    FEHPeriodic::stats(fast, &s);
+    check(s.runs >= 999 && s.runs <= 1000, "1 kHz runs 1000 times a second");
+    check(s.overruns == 0 && s.overBudget == 0, "1 kHz within its budget");
+    check(s.maxRunMicros >= 100 && s.maxRunMicros <= 101, "1 kHz run time measured");
+    FEHPeriodic::stats(slow, &s);
+    check(s.runs >= 499 && s.runs <= 500, "500 Hz runs 500 times a second");
+    check(s.maxLatencyMicros >= 100 && s.maxLatencyMicros <= 201, "500 Hz waits for the 1 kHz run");
+
+    double frame = (double)(s_lastRise - s_firstRise) / (s_servoFrames - 1);
+    printf("servo frames %d, period %.1f us\n", s_servoFrames, frame);
+    check(s_servoFrames >= 49 && s_servoFrames <= 51, "servo frames every 20 ms");
+    check(frame > 19900 && frame < 20100, "servo frame period");
+
+    FEHPeriodic::detach(sampleServo);
+    FEHPeriodic::detach(fast);
+    FEHPeriodic::detach(slow);
+    servo.Off();
+
+    // Overruns: each 1.5 ms run skips the release that came while it ran
+    check(FEHPeriodic::attach(sometimesLong, 1000, 400), "overrunning callback attached");
+    Sleep(100);
+    print("overrunning", sometimesLong);
+    FEHPeriodic::stats(sometimesLong, &s);
+    check(s.overruns >= 9 && s.overruns <= 10, "overruns counted");
+    check(s.runs + s.overruns >= 99 && s.runs + s.overruns <= 100, "skipped releases keep the rate");
+    check(s.overBudget == s.overruns && !s.stopped, "occasional long runs are not stopped");
+    FEHPeriodic::resetStats();
+    FEHPeriodic::stats(sometimesLong, &s);
+    check(s.runs == 0 && s.overruns == 0 && s.maxRunMicros == 0, "stats reset");
+    FEHPeriodic::detach(sometimesLong);
+
+    // Over budget on every run: stopped after PERIODIC_MAX_OVER_BUDGET runs
+    check(FEHPeriodic::attach(hog, 200, 200), "hog attached");
+    Sleep(100);
+    print("hog", hog);
+    FEHPeriodic::stats(hog, &s);
+    check(s.stopped && s.runs == PERIODIC_MAX_OVER_BUDGET, "over budget callback stopped");
+    check(FEHPeriodic::attach(hog, 200, 400), "stopped callback reattached with a larger budget");
+    Sleep(100);
+    FEHPeriodic::stats(hog, &s);
+    check(!s.stopped && s.runs >= 19 && s.overBudget == 0, "reattached callback runs");
+    FEHPeriodic::detach(hog);
+
+    // Recording: the callback asks for the bus and the main thread flushes in Sleep()
+    check(FEHRecorder::start("PERIODIC.REC"), "recording started");
+    spiBusResetStats();
+    check(FEHPeriodic::attach(readClock, 1000, 100), "recorded callback attached");
+    Sleep(200);
+    FEHPeriodic::stats(readClock, &s);
+    check(spiBusStats().requests[SPI_BUS_SD] > 0, "flush requested from the callback");
+    check(!s.stopped && s.overBudget == 0, "recorded callback within its budget");
+    FEHPeriodic::detach(readClock);
+    FEHRecorder::stop();
+
+    return checkResult("periodic");
+}
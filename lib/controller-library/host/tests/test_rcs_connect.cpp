@@ -0,0 +1,263 @@
+/**
+ * test_rcs_connect.cpp
+ *
+ * Connects to the RCS through the region menu against a stand-in ESP32 that takes its
+ * time joining the network, with touches replayed into the menu. "overlap" (the default)
+ * picks a region while the WiFi join is underway and checks that only the RCS connect is
+ * left to wait for afterwards. "background" starts the join as startup would with
+ * RCS_CONNECT_AT_BOOT, retries a failed join, returns from the menu at once and finishes
+ * the connection from Sleep() alone. "late" picks a region just before a background join
+ * times out and checks the join still gets its full time.
+ */
+
+#include <FEH.h>
+#include "HostHardware.h"
+#include "FEHInternal.h"
+#include "FEHESP32.h"
+#include "recorder.h"
+#include "scheduler.h"
+#include "check.h"
+#include <deque>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define ESP32_CS_PIN 40
+#define POLL_TICKS 781 // As eventESP32Poll(), ~50 ms
+#define MS 1000ULL
+
+/**
+ * The ESP32 side: joins the network @c joinMs after CMD_WIFI_CONNECT (or fails the
+ * first @c failJoins attempts) and acknowledges CMD_RCS_CONNECT. Each answer goes out in
+ * the first frame after it is due, as the SPI slave queues them.
+ */
+class StandInEsp32 : public HostSpiDevice
+{
+public:
+    uint64_t joinMs = 4000;
+    int failJoins = 0;
+    int wifiConnects = 0;
+    int rcsConnects = 0;
+    char rcsRegion = 0;
+    std::string rcsKey;
+
+    void select() override
+    {
+        _in.clear();
+        _out.clear();
+        if (!_queue.empty() && _queue.front().due <= HostHardware::nowMicros())
+        {
+            _out.swap(_queue.front().frame);
+            _queue.pop_front();
+        }
+    }
+
+    uint8_t transfer(uint8_t byte) override
+    {
+        uint8_t out = _in.size() < _out.size() ? _out[_in.size()] : 0;
+        _in.push_back(byte);
+        return out;
+    }
+
+    void deselect() override
+    {
+        if (_in.size() < 4 || _in[0] != 0xAA || _in[1] != 0x55)
+        {
+            return;
+        }
+        uint64_t now = HostHardware::nowMicros();
+        if (_in[2] == CMD_WIFI_CONNECT)
+        {
+            wifiConnects++;
+            queue(now, RSP_ACK, {CMD_WIFI_CONNECT});
+            if (failJoins > 0)
+            {
+                failJoins--;
+                queue(now + 2000 * MS, NOTIFY_WIFI_FAILED, {});
+            }
+            else
+            {
+                queue(now + joinMs * MS, NOTIFY_WIFI_CONNECTED, {});
+            }
+        }
+        else if (_in[2] == CMD_RCS_CONNECT)
+        {
+            rcsConnects++;
+            rcsRegion = _in[4];
+            rcsKey.assign((const char *)&_in[10], _in[9]);
+            queue(now + 100 * MS, RSP_ACK, {CMD_RCS_CONNECT});
+        }
+    }
+
+    void queue(uint64_t due, uint8_t cmd, const std::vector<uint8_t> &data)
+    {
+        Answer answer = {due, {0xAA, 0x55, cmd, (uint8_t)data.size()}};
+        answer.frame.insert(answer.frame.end(), data.begin(), data.end());
+        _queue.push_back(answer);
+    }
+
+private:
+    struct Answer
+    {
+        uint64_t due;
+        std::vector<uint8_t> frame;
+    };
+    std::vector<uint8_t> _in, _out;
+    std::deque<Answer> _queue;
+};
+
+static StandInEsp32 s_esp32;
+
+extern volatile bool g_esp32PollPending;
+
+/* The library's eventESP32Poll(), which the test cannot reach */
+static void eventPoll()
+{
+    g_esp32PollPending = true;
+    scheduleEvent(eventPoll, POLL_TICKS);
+}
+
+/*
+ * The team at the region menu: region C pressed at s_pickAt, Ok a second later. Each
+ * touch read takes a millisecond of the menu loop's time.
+ */
+static uint64_t s_pickAt;
+
+static int32_t touches(uint8_t type, uint8_t, int32_t live)
+{
+    if (type != RECORD_TOUCH)
+    {
+        return live;
+    }
+    HostHardware::advanceMicros(MS);
+    uint64_t t = HostHardware::nowMicros();
+    int x, y;
+    if (t >= s_pickAt && t < s_pickAt + 100 * MS)
+    {
+        x = 198, y = 90; // Region C
+    }
+    else if (t >= s_pickAt + 1000 * MS && t < s_pickAt + 1100 * MS)
+    {
+        x = 80, y = 120; // Ok
+    }
+    else
+    {
+        return -1;
+    }
+    // FEHLCD::Touch() turns the panel's point into screen coordinates
+    return ((int32_t)y << 12) | (LCD_WIDTH - x);
+}
+
+static void printTimes(const char *what)
+{
+    const FEHRCS::ConnectTimes &t = RCS.GetConnectTimes();
+    printf("%-10s WiFi +%lu ms, region +%lu ms, RCS sent +%lu ms, ready +%lu ms\n", what,
+           t.wifiConnected - t.started, t.regionChosen - t.started, t.rcsSent - t.started, t.ready - t.started);
+}
+
+/* Region picked at 5 s while a 4 s join runs: only the RCS connect is left after it */
+static void testOverlap()
+{
+    s_esp32.joinMs = 4000;
+    s_pickAt = HostHardware::nowMicros() + 5000 * MS;
+
+    RCS.InitializeTouchMenu("TEAM7");
+    printTimes("overlap");
+
+    const FEHRCS::ConnectTimes &t = RCS.GetConnectTimes();
+    check(RCS.IsReady(), "connected when the menu returns");
+    check(t.wifiConnected < t.regionChosen, "WiFi joined while the region was chosen");
+    check(t.ready - t.regionChosen < 500, "only the RCS connect waited for after the menu");
+    check(s_esp32.rcsConnects == 1 && s_esp32.rcsRegion == 'C' && s_esp32.rcsKey == "TEAM7",
+          "RCS connect carries the region and team key");
+    check(RCS.CurrentRegionLetter() == 'C', "chosen region kept");
+
+    // Data arrives through the callback registered by the background connect
+    s_esp32.queue(0, NOTIFY_RCS_DATA, {2, 1, 0, 90, 0});
+    Sleep(200);
+    check(RCS.GetLever() == 2 && RCS.Time() == 90, "RCS data handled");
+}
+
+/*
+ * Join started at boot fails once and takes 8 s the second time; the region is picked
+ * at 3 s. The menu returns at once and Sleep() alone finishes the connection.
+ */
+static void testBackground()
+{
+    s_esp32.failJoins = 1;
+    s_esp32.joinMs = 8000;
+    uint64_t start = HostHardware::nowMicros();
+    s_pickAt = start + 3000 * MS;
+
+    RCS.BeginConnect();
+    check(!RCS.WaitReady(100), "no waiting before a region is chosen");
+
+    RCS.InitializeTouchMenu("TEAM7", false);
+    check(!RCS.IsReady(), "menu returns before the connection is up");
+    check(HostHardware::nowMicros() - start < 5000 * MS, "menu returns once the region is chosen");
+
+    for (int i = 0; i < 200 && !RCS.IsReady(); i++)
+    {
+        Sleep(100);
+    }
+    printTimes("background");
+
+    const FEHRCS::ConnectTimes &t = RCS.GetConnectTimes();
+    check(RCS.IsReady(), "connection finished from Sleep()");
+    check(s_esp32.wifiConnects == 2, "failed join retried");
+    check(t.regionChosen < t.wifiConnected && t.rcsSent >= t.wifiConnected, "RCS connect sent once joined");
+    check(t.ready - t.started < 11000, "connect time is the join's, not the menu's plus the join's");
+    check(RCS.WaitReady(), "WaitReady() on a finished connection");
+}
+
+/*
+ * Region chosen 100 ms before the background join's time limit, on a join that takes
+ * 10.2 s: the limit counts from the choice, so the join finishes the connection.
+ */
+static void testLate()
+{
+    s_esp32.joinMs = 10200;
+    uint64_t start = HostHardware::nowMicros();
+    // Ok is taken about 1.1 s after the region is pressed
+    s_pickAt = start + (RCS_WIFI_TIMEOUT_MS - 1200) * MS;
+
+    RCS.BeginConnect();
+    RCS.InitializeTouchMenu("TEAM7", false);
+    for (int i = 0; i < 50 && !RCS.IsReady(); i++)
+    {
+        Sleep(100);
+    }
+    printTimes("late");
+
+    const FEHRCS::ConnectTimes &t = RCS.GetConnectTimes();
+    check(t.regionChosen - t.started < RCS_WIFI_TIMEOUT_MS, "region chosen before the join's time limit");
+    check(RCS.IsReady(), "connected after a choice just before the join's time limit");
+    check(s_esp32.wifiConnects == 1, "the join underway is kept");
+    check(t.wifiConnected - t.regionChosen < RCS_WIFI_TIMEOUT_MS, "joined within the limit from the choice");
+}
+
+int main(int argc, char **argv)
+{
+    HostHardware::reset();
+    HostHardware::attachSpiDevice(ESP32_CS_PIN, &s_esp32);
+    ILI9341.begin();
+    FEHESP32::init();
+    scheduleEvent(eventPoll, POLL_TICKS);
+    _recorderReplay(touches);
+
+    // RCS is one object for the program, so each scenario runs in its own process
+    if (argc > 1 && strcmp(argv[1], "background") == 0)
+    {
+        testBackground();
+    }
+    else if (argc > 1 && strcmp(argv[1], "late") == 0)
+    {
+        testLate();
+    }
+    else
+    {
+        testOverlap();
+    }
+
+    return checkResult("rcs connect");
+}
@@ -0,0 +1,148 @@
+/**
+ * test_spibus.cpp
+ *
+ * Runs the SPI bus arbiter from private_include/spibus.h: ownership nests for one device
+ * and is refused to another, and with the bus timed at its SCK rate, an ESP32 poll that
+ * falls due during full-screen clears goes out between the display's row bands instead
+ * of after the whole clear. An unbanded fill is measured alongside for comparison.
+ */
+
+#include <FEH.h>
+#include "HostHardware.h"
+#include "FEHInternal.h"
+#include "FEHESP32.h"
+#include "spibus.h"
+#include "scheduler.h"
+#include "check.h"
+#include <stdio.h>
+
+#define ESP32_CS_PIN 40
+#define POLL_TICKS 781 // As eventESP32Poll(), ~50 ms
+#define CLEARS 20
+
+/* An ESP32 with nothing queued: answers every poll with zeros */
+class IdleEsp32 : public HostSpiDevice
+{
+public:
+    uint8_t transfer(uint8_t) override
+    {
+        bytes++;
+        return 0;
+    }
+    uint64_t bytes = 0;
+};
+
+extern volatile bool g_esp32PollPending;
+
+static bool s_polling;
+
+/* The library's eventESP32Poll(), which the test cannot reach */
+static void eventPoll()
+{
+    if (!s_polling)
+    {
+        return;
+    }
+    g_esp32PollPending = true;
+    spiBusRequest(SPI_BUS_ESP32);
+    scheduleEvent(eventPoll, POLL_TICKS);
+}
+
+static void testOwnership()
+{
+    HostHardware::reset();
+    spiBusResetStats();
+
+    check(spiBusAcquire(SPI_BUS_LCD), "free bus is acquired");
+    check(spiBusAcquire(SPI_BUS_LCD), "acquisition nests for the owner");
+    check(!spiBusAcquire(SPI_BUS_ESP32), "bus refused to another device");
+    {
+        SpiBusOwner sd(SPI_BUS_SD);
+        check(!sd.owned(), "SpiBusOwner reports a refusal");
+    }
+    HostHardware::advanceMicros(500);
+    spiBusRelease(SPI_BUS_LCD);
+    check(!spiBusAcquire(SPI_BUS_SD), "bus held until the outermost release");
+    spiBusRelease(SPI_BUS_LCD);
+    {
+        SpiBusOwner sd(SPI_BUS_SD);
+        check(sd.owned(), "released bus is acquired by another device");
+    }
+
+    const SpiBusStatistics &stats = spiBusStats();
+    check(stats.conflicts == 3, "refusals counted as conflicts");
+    check(stats.transactions[SPI_BUS_LCD] == 1 && stats.transactions[SPI_BUS_SD] == 1,
+          "transactions count outermost acquisitions");
+    check(stats.busyMicros[SPI_BUS_LCD] == 500, "LCD bus time");
+
+    spiBusRequest(SPI_BUS_ESP32);
+    check(!spiBusYield(SPI_BUS_ESP32), "no yield to a request of equal priority");
+    HostHardware::advanceMicros(200);
+    {
+        SpiBusOwner esp32(SPI_BUS_ESP32);
+    }
+    check(spiBusStats().maxLatencyMicros[SPI_BUS_ESP32] == 200, "latency from request to acquisition");
+}
+
+static void testLatency(IdleEsp32 &esp32)
+{
+    HostHardware::reset();
+    HostHardware::attachSpiDevice(ESP32_CS_PIN, &esp32);
+    HostHardware::setSpiTiming(true);
+    ILI9341.begin();
+    LCD.SetOrientation(FEHLCD::East);
+    FEHESP32::init();
+    spiBusResetStats();
+
+    s_polling = true;
+    scheduleEvent(eventPoll, POLL_TICKS);
+
+    uint64_t start = HostHardware::nowMicros();
+    for (int i = 0; i < CLEARS; i++)
+    {
+        LCD.Clear(i & 1 ? WHITE : BLACK);
+    }
+    uint64_t elapsed = HostHardware::nowMicros() - start;
+
+    const SpiBusStatistics &stats = spiBusStats();
+    printf("%d clears in %llu us: LCD busy %lu us, ESP32 busy %lu us in %lu polls of %lu requested, "
+           "max poll latency %lu us, %lu preemptions\n",
+           CLEARS, (unsigned long long)elapsed, (unsigned long)stats.busyMicros[SPI_BUS_LCD],
+           (unsigned long)stats.busyMicros[SPI_BUS_ESP32], (unsigned long)stats.transactions[SPI_BUS_ESP32],
+           (unsigned long)stats.requests[SPI_BUS_ESP32], (unsigned long)stats.maxLatencyMicros[SPI_BUS_ESP32],
+           (unsigned long)stats.preemptions);
+
+    // 153.6 KB per clear at 8 MHz; polls of 48 bytes at 1 MHz every 50 ms
+    check(elapsed >= CLEARS * 153600ULL, "clears take their bus time");
+    check(stats.busyMicros[SPI_BUS_LCD] >= CLEARS * 153600UL, "LCD bus time covers the clears");
+    check(stats.requests[SPI_BUS_ESP32] >= elapsed / 50000 - 1, "poll requested every 50 ms");
+    check(stats.transactions[SPI_BUS_ESP32] >= stats.requests[SPI_BUS_ESP32] - 1, "every request served");
+    check(esp32.bytes == 48 * stats.transactions[SPI_BUS_ESP32], "each poll is one 48-byte frame");
+    check(stats.busyMicros[SPI_BUS_ESP32] >= 384 * stats.transactions[SPI_BUS_ESP32], "ESP32 bus time");
+    check(stats.preemptions >= stats.transactions[SPI_BUS_ESP32], "polls go out at preemption points");
+    check(stats.conflicts == 0, "no conflicts from the main thread");
+    // One band of LCD_BURST_PIXELS (4.1 ms) plus its address window
+    check(stats.maxLatencyMicros[SPI_BUS_ESP32] < 5000, "poll latency bounded by one band");
+
+    // The same clears as one transaction each: the poll waits for the whole fill
+    spiBusResetStats();
+    for (int i = 0; i < CLEARS; i++)
+    {
+        ILI9341.fillScreen(i & 1 ? WHITE : BLACK);
+        FEHESP32::servicePoll();
+    }
+    printf("unbanded: max poll latency %lu us\n", (unsigned long)spiBusStats().maxLatencyMicros[SPI_BUS_ESP32]);
+    check(spiBusStats().maxLatencyMicros[SPI_BUS_ESP32] > 100000, "unbanded fill holds the poll back");
+
+    s_polling = false;
+    HostHardware::advanceMicros(100000);
+}
+
+int main()
+{
+    IdleEsp32 esp32;
+    testOwnership();
+    testLatency(esp32);
+
+    return checkResult("spibus");
+}
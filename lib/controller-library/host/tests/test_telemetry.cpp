@@ -0,0 +1,197 @@
+/**
+ * test_telemetry.cpp
+ *
+ * Checks FEHTelemetry's framing by decoding its output, and that a 2 Mbaud stream with a
+ * 512-byte TX ring sustains more than 100 KB/s without the sender ever waiting. With a
+ * file argument the stream is also saved there for tools/telemetry_receive.py to verify.
+ */
+
+#include <FEH.h>
+#include "HostHardware.h"
+#include "check.h"
+#include <util/crc16.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+/* Records sent by the stream test; telemetry_receive.py --expect must match */
+#define STREAM_PACKETS 5000
+#define STREAM_PERIOD_US 200
+
+struct Packet
+{
+    uint8_t channel;
+    uint8_t sequence;
+    std::vector<uint8_t> payload;
+};
+
+/* Split the captured output at the delimiters and undo COBS; false on a bad frame */
+static bool decode(const std::string &stream, std::vector<Packet> &packets)
+{
+    size_t start = 0;
+    size_t end;
+    while ((end = stream.find('\0', start)) != std::string::npos)
+    {
+        std::vector<uint8_t> raw;
+        size_t i = start;
+        while (i < end)
+        {
+            uint8_t code = stream[i];
+            if (code == 0 || i + code > end)
+            {
+                return false;
+            }
+            raw.insert(raw.end(), stream.begin() + i + 1, stream.begin() + i + code);
+            i += code;
+            if (i < end)
+            {
+                raw.push_back(0);
+            }
+        }
+        start = end + 1;
+
+        if (raw.size() < 4)
+        {
+            return false;
+        }
+        uint16_t crc = 0xFFFF;
+        for (size_t k = 0; k < raw.size() - 2; k++)
+        {
+            crc = _crc_xmodem_update(crc, raw[k]);
+        }
+        if (crc != (raw[raw.size() - 2] | raw[raw.size() - 1] << 8))
+        {
+            return false;
+        }
+        packets.push_back({raw[0], raw[1], std::vector<uint8_t>(raw.begin() + 2, raw.end() - 2)});
+    }
+    return start == stream.size();
+}
+
+static void testFraming()
+{
+    HostHardware::reset();
+    check(!FEHTelemetry::send(1, "x", 1), "send before begin() is refused");
+
+    FEHTelemetry::begin();
+    HostHardware::clearSerial();
+
+    uint8_t zeros[16] = {0};
+    uint8_t ones[TELEMETRY_MAX_PAYLOAD];
+    memset(ones, 0xFF, sizeof(ones));
+    float pose[3] = {1.5f, -2.25f, 90.0f};
+
+    check(FEHTelemetry::send(1, zeros, 0), "empty payload");
+    check(FEHTelemetry::send(2, zeros, sizeof(zeros)), "all-zero payload");
+    check(FEHTelemetry::send(3, pose), "record payload");
+    check(!FEHTelemetry::send(4, ones, TELEMETRY_MAX_PAYLOAD + 1), "oversized payload is refused");
+    check(!FEHTelemetry::send(5, ones, TELEMETRY_MAX_PAYLOAD), "largest payload does not fit the 64-byte ring");
+    HostHardware::setSerialPacing(false, 512);
+    check(FEHTelemetry::send(5, ones, TELEMETRY_MAX_PAYLOAD), "largest payload fits a 512-byte ring");
+
+    std::vector<Packet> packets;
+    check(decode(HostHardware::serialOutput(), packets), "stream decodes");
+    check(packets.size() == 4, "four packets");
+    if (packets.size() == 4)
+    {
+        check(packets[0].channel == 1 && packets[0].payload.empty(), "empty payload round trip");
+        check(packets[1].payload == std::vector<uint8_t>(zeros, zeros + sizeof(zeros)), "zeros round trip");
+        check(packets[2].payload.size() == sizeof(pose) && memcmp(packets[2].payload.data(), pose, sizeof(pose)) == 0,
+              "record round trip");
+        check(packets[3].channel == 5 && packets[3].payload.size() == TELEMETRY_MAX_PAYLOAD, "largest round trip");
+        check(packets[3].sequence == 4, "sequence counts dropped packets too");
+    }
+    FEHTelemetry::end();
+}
+
+static void testSustainedStream(const char *capturePath)
+{
+    HostHardware::reset();
+    HostHardware::setSerialPacing(true, 512);
+    FEHTelemetry::begin(2000000);
+    HostHardware::clearSerial();
+    HostHardware::clearSerialStats();
+
+    struct
+    {
+        uint32_t time;
+        float left, right;
+        int16_t encoders[4];
+        float heading;
+        uint8_t state;
+        uint8_t spare[7];
+    } record = {};
+    static_assert(sizeof(record) == 32, "32-byte record");
+
+    uint64_t start = HostHardware::nowMicros();
+    for (int i = 0; i < STREAM_PACKETS; i++)
+    {
+        record.time = (uint32_t)HostHardware::nowMicros();
+        record.left = i * 0.01f;
+        record.encoders[i & 3] = (int16_t)i;
+        FEHTelemetry::send(1, record);
+        HostHardware::advanceMicros(STREAM_PERIOD_US);
+    }
+    double seconds = (HostHardware::nowMicros() - start) / 1e6;
+
+    TelemetryStatistics stats = FEHTelemetry::stats();
+    double rate = stats.bytes / seconds;
+    printf("stream: %lu packets, %lu dropped, %.1f KB/s, sender blocked %llu us\n", stats.packets, stats.dropped,
+           rate / 1000.0, (unsigned long long)HostHardware::serialStats().blockedMicros);
+    check(stats.dropped == 0, "no packets dropped at 2 Mbaud");
+    check(HostHardware::serialStats().blockedMicros == 0, "sender never waits");
+    check(rate > 100000.0, "more than 100 KB/s");
+
+    std::vector<Packet> packets;
+    check(decode(HostHardware::serialOutput(), packets) && packets.size() == STREAM_PACKETS, "stream decodes");
+
+    if (capturePath)
+    {
+        FILE *f = fopen(capturePath, "wb");
+        check(f != nullptr, "capture file opens");
+        if (f)
+        {
+            const std::string &out = HostHardware::serialOutput();
+            fwrite(out.data(), 1, out.size(), f);
+            fclose(f);
+        }
+    }
+    FEHTelemetry::end();
+}
+
+static void testLogNeverWaits()
+{
+    /* The default 64-byte ring at 115200: plain FEHLog output waits, framed output drops */
+    HostHardware::reset();
+    HostHardware::setSerialPacing(true, 64);
+    Serial.begin(115200);
+    FEHLog::enableSerial();
+
+    for (int i = 0; i < 10; i++)
+    {
+        FEHLog::printf("line %d: left=%d right=%d heading=%.1f\n", i, 100 + i, 200 - i, 45.0f);
+    }
+    check(HostHardware::serialStats().blockedMicros > 0, "plain Serial output waits for the ring");
+
+    FEHTelemetry::begin(115200);
+    HostHardware::clearSerialStats();
+    for (int i = 0; i < 10; i++)
+    {
+        FEHLog::printf("line %d: left=%d right=%d heading=%.1f\n", i, 100 + i, 200 - i, 45.0f);
+    }
+    check(HostHardware::serialStats().blockedMicros == 0, "telemetry output never waits");
+    check(FEHTelemetry::stats().dropped > 0, "full ring drops packets");
+
+    FEHTelemetry::end();
+    FEHLog::disableSerial();
+}
+
+int main(int argc, char **argv)
+{
+    testFraming();
+    testSustainedStream(argc > 1 ? argv[1] : nullptr);
+    testLogNeverWaits();
+
+    return checkResult("telemetry");
+}
@@ -0,0 +1,117 @@
+/**
+ * test_trace.cpp
+ *
+ * FEHTrace across emulated resets. A power-on over noise starts an empty trace; a run of
+ * marks, a scheduler event, an ESP32 frame and a kill wraps the ring; a watchdog reset then
+ * prints the last TRACE_ENTRIES events with the kill reason and saves them to the SD card;
+ * no reset flags are reported as unknown (the stock bootloader clears them), and a
+ * power-on ignores an intact ring.
+ */
+
+#include <FEH.h>
+#include "HostHardware.h"
+#include "SdFat.h"
+#include "../private_include/trace.h"
+#include "../private_include/scheduler.h"
+#include "../private_include/FEHESP32.h"
+#include "../private_include/ApplicationProtocol.h"
+#include "check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+static bool contains(const std::string &s, const char *text)
+{
+    return s.find(text) != std::string::npos;
+}
+
+static void tick()
+{
+}
+
+/* Reset the emulated chip with @p mcusr and @p gpior1 as the hardware and bootloader leave them */
+static std::string boot(uint8_t mcusr, uint8_t gpior1)
+{
+    HostHardware::reset();
+    MCUSR = mcusr;
+    GPIOR1 = gpior1;
+    HostHardware::clearSerial();
+    _traceBoot();
+    return HostHardware::serialOutput();
+}
+
+int main()
+{
+    // Power-on: RAM is noise
+    uint8_t *ram = (uint8_t *)&_traceRing;
+    for (size_t i = 0; i < sizeof(_traceRing); i++)
+    {
+        ram[i] = rand();
+    }
+    std::string out = boot(_BV(PORF), 0);
+    check(out.empty(), "nothing printed after a power-on");
+    check(!FEHTrace::recovered(), "no trace recovered after a power-on");
+    check(FEHTrace::resetCause() == _BV(PORF), "power-on reset cause");
+    check(MCUSR == 0 && GPIOR1 == 0, "reset flags cleared");
+    check(_traceRing.count == 1 && _traceRing.entries[0].type == TRACE_BOOT, "trace starts with the boot");
+
+    // A run that ends in a kill
+    Sleep(100);
+    FEHTrace::mark(1, 100);
+    scheduleEvent(tick, 16);
+    Sleep(5);
+    uint8_t pong[] = {0xAA, 0x55, RSP_PONG, 0};
+    FEHESP32::handleMessage(pong, sizeof(pong));
+    for (int i = 0; i < 40; i++)
+    {
+        FEHTrace::mark(7, i);
+    }
+    FEHTrace::print();
+    check(contains(HostHardware::serialOutput(), "Trace since boot (power-on), 32 events"), "print() of this run");
+    Sleep(1400);
+    _traceReason(F("I2C fault"));
+    _traceEvent(TRACE_KILL);
+
+    char dispatch[16];
+    snprintf(dispatch, sizeof(dispatch), "0x%04x", (uint16_t)(uintptr_t)tick);
+
+    // Watchdog reset, with the flags handed over by the bootloader
+    out = boot(0, _BV(WDRF));
+    printf("%s", out.c_str());
+    check(FEHTrace::recovered(), "trace recovered after a watchdog reset");
+    check(FEHTrace::resetCause() == _BV(WDRF), "watchdog reset cause");
+    check(contains(out, "Trace before reset (watchdog), 32 events, newest last:"), "header");
+    check(contains(out, "Last kill or fatal error: I2C fault"), "kill reason");
+    check(contains(out, "mark     7, 9\r\n") && !contains(out, "mark     7, 8\r\n"), "oldest events replaced");
+    check(contains(out, "mark     7, 39\r\n"), "newest mark");
+    check(contains(out, "    1.50") && contains(out, "s  kill"), "kill time");
+    check(out.rfind("kill") > out.rfind("mark"), "oldest first");
+
+    // Only the last 32 remain, so run the early events again into the new ring
+    scheduleEvent(tick, 16);
+    Sleep(5);
+    FEHESP32::handleMessage(pong, sizeof(pong));
+    HostHardware::clearSerial();
+    FEHTrace::print();
+    std::string run = HostHardware::serialOutput();
+    check(contains(run, "Trace since boot (watchdog), 3 events"), "ring restarted");
+    check(contains(run, "boot     watchdog"), "boot event");
+    check(contains(run, dispatch), "scheduler dispatch");
+    check(contains(run, "esp32 rx 0x82, 4 bytes"), "ESP32 frame");
+
+    check(FEHTrace::save("TRACE.TXT"), "saved to SD");
+    check(HostSdVolume::get("TRACE.TXT") == out, "saved trace matches the one printed at boot");
+
+    // A jump to 0 leaves no flags, and neither does any reset under the stock bootloader
+    FEHTrace::mark(3);
+    out = boot(0, 0);
+    check(contains(out, "Trace before reset (unknown, bootloader cleared MCUSR), 4 events"), "no reset flags");
+
+    // The reset button keeps RAM; a power-on does not trust it
+    boot(_BV(EXTRF), 0);
+    check(FEHTrace::recovered(), "trace recovered after the reset button");
+    out = boot(_BV(PORF), 0);
+    check(out.empty() && !FEHTrace::recovered() && !FEHTrace::save("TRACE.TXT"), "intact ring ignored at power-on");
+
+    return checkResult("trace");
+}
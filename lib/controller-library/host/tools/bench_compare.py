@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""Compare host benchmark results against a baseline.
+
+Counters (SPI bytes, pixels, ...) are deterministic, so any change is reported and an
+increase fails the check. Timings depend on the machine and are only compared when
+--time-tolerance is given, e.g. on a dedicated runner.
+
+    bench_compare.py BASELINE.json RESULTS.json [--time-tolerance 0.25] [--update]
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        return {b["name"]: b for b in json.load(f)["benchmarks"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("baseline")
+    parser.add_argument("results")
+    parser.add_argument("--time-tolerance", type=float, default=None,
+                        help="fail when ns/op grows by more than this fraction")
+    parser.add_argument("--update", action="store_true",
+                        help="overwrite the baseline with the results")
+    args = parser.parse_args()
+
+    if args.update:
+        with open(args.results) as f:
+            results = json.load(f)
+        for b in results["benchmarks"]:
+            b.pop("iterations", None)
+        with open(args.baseline, "w") as f:
+            json.dump(results, f, indent=2, sort_keys=True)
+            f.write("\n")
+        print("baseline updated: %s" % args.baseline)
+        return 0
+
+    baseline = load(args.baseline)
+    results = load(args.results)
+    failures = []
+
+    for name, base in sorted(baseline.items()):
+        if name not in results:
+            failures.append("%s: missing from results" % name)
+            continue
+        cur = results[name]
+
+        for key, old in sorted(base.get("counters", {}).items()):
+            new = cur.get("counters", {}).get(key)
+            if new is None:
+                failures.append("%s: counter %s missing" % (name, key))
+            elif new > old:
+                failures.append("%s: %s %g -> %g" % (name, key, old, new))
+            elif new < old:
+                print("improved  %s: %s %g -> %g" % (name, key, old, new))
+
+        if args.time_tolerance is not None and base.get("ns_per_op"):
+            old, new = base["ns_per_op"], cur["ns_per_op"]
+            if new > old * (1.0 + args.time_tolerance):
+                failures.append("%s: %.1f -> %.1f ns/op" % (name, old, new))
+
+    for name in sorted(set(results) - set(baseline)):
+        print("new       %s (run with --update to add it to the baseline)" % name)
+
+    for f in failures:
+        print("REGRESSION %s" % f)
+    if failures:
+        return 1
+    print("%d benchmarks checked, no regressions" % len(baseline))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
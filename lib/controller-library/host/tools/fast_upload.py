@@ -0,0 +1,390 @@
+#!/usr/bin/env python3
+"""Upload firmware through the stk500v2 bootloader, writing only the flash pages that changed.
+
+With the bootloader in lib/platformio_packages/ArduinoCore-avr/bootloaders/stk500v2 (rebuilt
+with `make mega2560` and burned with an ISP programmer), the upload switches to --baud after
+signing on, asks for the CRC-16 of every page the image covers (CMD_FEH_PAGE_CRC) and writes
+only the pages whose CRC differs, then checks the written pages the same way. A stock
+bootloader answers neither command: the upload then stays at 115200, writes every page and
+reads them back, as avrdude does.
+
+    fast_upload.py firmware.hex --port /dev/ttyACM0 [--baud 1000000] [--report times.jsonl]
+    fast_upload.py --self-test
+
+Each upload prints one line with the pages written and skipped and the time taken; --report
+also appends it, with the image's size and modification time, to a JSON-lines file so upload
+times can be compared build to build. --self-test runs the upload against a model of the
+bootloader (stock and fast) and reports the time each case would take on the wire.
+
+Reading a port needs pyserial (pip install pyserial).
+"""
+
+import argparse
+import json
+import os
+import random
+import struct
+import sys
+import time
+
+# command.h
+MESSAGE_START = 0x1B
+TOKEN = 0x0E
+CMD_SIGN_ON = 0x01
+CMD_LOAD_ADDRESS = 0x06
+CMD_ENTER_PROGMODE_ISP = 0x10
+CMD_LEAVE_PROGMODE_ISP = 0x11
+CMD_PROGRAM_FLASH_ISP = 0x13
+CMD_READ_FLASH_ISP = 0x14
+CMD_FEH_SET_BAUD = 0xF0
+CMD_FEH_PAGE_CRC = 0xF1
+STATUS_CMD_OK = 0x00
+STATUS_CMD_FAILED = 0xC0
+
+BOOT_BAUD = 115200
+F_CPU = 16000000
+PAGE_SIZE = 256
+# Flash below the bootloader on an ATmega2560
+FLASH_SIZE = 0x3E000
+# Most pages per CMD_FEH_PAGE_CRC
+CRC_PAGES = 128
+
+
+def crc16(data, crc=0xFFFF):
+    """avr-libc _crc16_update over data (CRC-16/MODBUS)."""
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+
+def read_hex(path):
+    """Return the flash image of an Intel HEX file, padded with 0xFF to whole pages."""
+    image = bytearray()
+    base = 0
+    with open(path) as f:
+        for number, line in enumerate(f, 1):
+            line = line.strip()
+            if not line:
+                continue
+            record = bytes.fromhex(line[1:]) if line[0] == ":" else b""
+            if len(record) < 5 or len(record) != record[0] + 5 or sum(record) & 0xFF:
+                raise ValueError("%s:%d: bad record" % (path, number))
+            count, address, kind = record[0], (record[1] << 8) | record[2], record[3]
+            data = record[4:4 + count]
+            if kind == 0:
+                start = base + address
+                if start + count > len(image):
+                    image += b"\xff" * (start + count - len(image))
+                image[start:start + count] = data
+            elif kind == 1:
+                break
+            elif kind == 2:
+                base = ((data[0] << 8) | data[1]) << 4
+            elif kind == 4:
+                base = ((data[0] << 8) | data[1]) << 16
+    if len(image) > FLASH_SIZE:
+        raise ValueError("%s: %d bytes does not fit below the bootloader" % (path, len(image)))
+    image += b"\xff" * (-len(image) % PAGE_SIZE)
+    return bytes(image)
+
+
+class Programmer:
+    """stk500v2 messages over a port with read(n), write(data) and a baudrate attribute."""
+
+    def __init__(self, port):
+        self.port = port
+        self.seq = 0
+
+    def command(self, body):
+        """Send one message and return the answer's body, or None if none came back."""
+        self.seq = (self.seq + 1) & 0xFF
+        message = bytes([MESSAGE_START, self.seq, len(body) >> 8, len(body) & 0xFF, TOKEN]) + bytes(body)
+        checksum = 0
+        for byte in message:
+            checksum ^= byte
+        self.port.write(message + bytes([checksum]))
+
+        header = self.port.read(5)
+        if len(header) < 5 or header[0] != MESSAGE_START or header[1] != self.seq or header[4] != TOKEN:
+            return None
+        length = (header[2] << 8) | header[3]
+        rest = self.port.read(length + 1)
+        if len(rest) < length + 1:
+            return None
+        checksum = 0
+        for byte in header + rest:
+            checksum ^= byte
+        if checksum or rest[0] != body[0]:
+            return None
+        return rest[:length]
+
+    def sign_on(self, attempts=1):
+        for _ in range(attempts):
+            answer = self.command([CMD_SIGN_ON])
+            if answer and answer[1] == STATUS_CMD_OK:
+                return True
+        return False
+
+    def set_baud(self, baud):
+        """Switch the bootloader and the port to baud; False if the bootloader cannot."""
+        answer = self.command([CMD_FEH_SET_BAUD] + list(struct.pack(">I", baud)))
+        if not answer or answer[1] != STATUS_CMD_OK:
+            return False
+        self.port.baudrate = baud
+        if not self.sign_on(3):
+            raise IOError("no answer at %d baud" % baud)
+        return True
+
+    def load_address(self, address):
+        answer = self.command([CMD_LOAD_ADDRESS] + list(struct.pack(">I", address >> 1)))
+        if not answer or answer[1] != STATUS_CMD_OK:
+            raise IOError("CMD_LOAD_ADDRESS failed")
+
+    def page_crcs(self, address, pages):
+        """CRC-16 of each page from address, or None if the bootloader has no CMD_FEH_PAGE_CRC."""
+        crcs = []
+        self.load_address(address)
+        while pages:
+            count = min(pages, CRC_PAGES)
+            answer = self.command([CMD_FEH_PAGE_CRC, count])
+            if not answer or answer[1] != STATUS_CMD_OK or len(answer) != 2 * count + 3:
+                return None
+            crcs += struct.unpack("<%dH" % count, answer[2:-1])
+            pages -= count
+        return crcs
+
+    def write_page(self, address, data):
+        self.load_address(address)
+        # Mode, delay and the ISP command bytes are ignored by the bootloader
+        answer = self.command([CMD_PROGRAM_FLASH_ISP, len(data) >> 8, len(data) & 0xFF,
+                               0xC1, 10, 0x40, 0x4C, 0x20, 0, 0] + list(data))
+        if not answer or answer[1] != STATUS_CMD_OK:
+            raise IOError("CMD_PROGRAM_FLASH_ISP failed at 0x%05X" % address)
+
+    def read_page(self, address):
+        self.load_address(address)
+        answer = self.command([CMD_READ_FLASH_ISP, PAGE_SIZE >> 8, PAGE_SIZE & 0xFF, 0x20])
+        if not answer or answer[1] != STATUS_CMD_OK:
+            raise IOError("CMD_READ_FLASH_ISP failed at 0x%05X" % address)
+        return bytes(answer[2:2 + PAGE_SIZE])
+
+
+def upload(port, image, baud, clock=time.monotonic):
+    """Program image through the bootloader on port and return a summary dict."""
+    start = clock()
+    prog = Programmer(port)
+    if not prog.sign_on(10):
+        raise IOError("no answer from the bootloader")
+    if baud != port.baudrate and not prog.set_baud(baud):
+        baud = port.baudrate
+    prog.command([CMD_ENTER_PROGMODE_ISP, 200, 100, 25, 32, 0, 0x53, 3, 0xAC, 0x53, 0, 0])
+
+    pages = [image[i:i + PAGE_SIZE] for i in range(0, len(image), PAGE_SIZE)]
+    wanted = [crc16(page) for page in pages]
+    flashed = prog.page_crcs(0, len(pages))
+    fast = flashed is not None
+    changed = [i for i in range(len(pages)) if not fast or flashed[i] != wanted[i]]
+
+    for i in changed:
+        prog.write_page(i * PAGE_SIZE, pages[i])
+
+    # Check what was written: by CRC where the bootloader can, otherwise byte for byte
+    bad = []
+    if fast:
+        for i in changed:
+            if prog.page_crcs(i * PAGE_SIZE, 1) != [wanted[i]]:
+                bad.append(i)
+    else:
+        bad = [i for i in changed if prog.read_page(i * PAGE_SIZE) != pages[i]]
+    prog.command([CMD_LEAVE_PROGMODE_ISP, 1, 1])
+    if bad:
+        raise IOError("verify failed at 0x%05X" % (bad[0] * PAGE_SIZE))
+
+    return {"bytes": len(image), "pages": len(pages), "written": len(changed),
+            "skipped": len(pages) - len(changed), "baud": baud, "page_crc": fast,
+            "seconds": round(clock() - start, 3)}
+
+
+def describe(result):
+    return ("%d of %d pages written, %d unchanged, in %.2f s at %d baud%s"
+            % (result["written"], result["pages"], result["skipped"], result["seconds"], result["baud"],
+               "" if result["page_crc"] else " (stock bootloader: every page written and read back)"))
+
+
+class SimulatedBootloader:
+    """stk500boot.c's message handling, as a port, counting the time each message takes.
+
+    fast=False models the stock bootloader, which fails both FEH commands. Time is the bytes
+    on the wire at the current baud plus 9 ms to erase and write a page and 20 cycles per
+    byte to CRC one, so reports are comparable with uploads to a real board.
+    """
+
+    PAGE_WRITE_SECONDS = 0.009
+    CRC_SECONDS_PER_BYTE = 20.0 / F_CPU
+
+    def __init__(self, fast, flash=None):
+        self.fast = fast
+        self.flash = bytearray(flash if flash is not None else b"\xff" * FLASH_SIZE)
+        self.baudrate = BOOT_BAUD
+        self.uart_baud = BOOT_BAUD
+        self.address = 0
+        self.answer = b""
+        self.seconds = 0.0
+        self.page_writes = 0
+
+    def clock(self):
+        return self.seconds
+
+    def wire(self, count):
+        # A byte sent at a rate the UART is not set to is garbage
+        self.seconds += count * 10.0 / self.uart_baud
+        return self.baudrate == self.uart_baud
+
+    def write(self, message):
+        if not self.wire(len(message)):
+            self.answer = b""
+            return
+        length = (message[2] << 8) | message[3]
+        body = message[5:5 + length]
+        checksum = 0
+        for byte in message:
+            checksum ^= byte
+        if message[0] != MESSAGE_START or message[4] != TOKEN or len(body) != length or checksum:
+            self.answer = b""
+            return
+
+        new_baud = None
+        cmd = body[0]
+        if cmd == CMD_LOAD_ADDRESS:
+            self.address = (struct.unpack(">I", body[1:5])[0] << 1) & 0xFFFFFFFF
+            reply = [STATUS_CMD_OK]
+        elif cmd == CMD_PROGRAM_FLASH_ISP:
+            size = (body[1] << 8) | body[2]
+            page = self.address - self.address % PAGE_SIZE
+            self.flash[page:page + PAGE_SIZE] = b"\xff" * PAGE_SIZE
+            self.flash[self.address:self.address + size] = body[10:10 + size]
+            self.address += size
+            self.seconds += self.PAGE_WRITE_SECONDS
+            self.page_writes += 1
+            reply = [STATUS_CMD_OK]
+        elif cmd == CMD_READ_FLASH_ISP:
+            size = (body[1] << 8) | body[2]
+            reply = [STATUS_CMD_OK] + list(self.flash[self.address:self.address + size]) + [STATUS_CMD_OK]
+            self.address += size
+        elif cmd == CMD_FEH_SET_BAUD and self.fast:
+            baud = struct.unpack(">I", body[1:5])[0]
+            select = (F_CPU // 4 // baud - 1) // 2 if 0 < baud <= F_CPU // 8 else 0x100
+            reply = [STATUS_CMD_OK] if select < 0x100 else [STATUS_CMD_FAILED]
+            if select < 0x100:
+                new_baud = F_CPU // (8 * (select + 1))
+        elif cmd == CMD_FEH_PAGE_CRC and self.fast and 0 < body[1] <= CRC_PAGES:
+            reply = [STATUS_CMD_OK]
+            for _ in range(body[1]):
+                crc = crc16(self.flash[self.address:self.address + PAGE_SIZE])
+                reply += [crc & 0xFF, crc >> 8]
+                self.address += PAGE_SIZE
+            reply.append(STATUS_CMD_OK)
+            self.seconds += body[1] * PAGE_SIZE * self.CRC_SECONDS_PER_BYTE
+        elif cmd in (CMD_SIGN_ON, CMD_ENTER_PROGMODE_ISP, CMD_LEAVE_PROGMODE_ISP):
+            reply = [STATUS_CMD_OK]
+        else:
+            reply = [STATUS_CMD_FAILED]
+
+        reply = bytes([cmd] + reply)
+        answer = bytes([MESSAGE_START, message[1], len(reply) >> 8, len(reply) & 0xFF, TOKEN]) + reply
+        checksum = 0
+        for byte in answer:
+            checksum ^= byte
+        self.answer = answer + bytes([checksum])
+        self.wire(len(self.answer))
+        if new_baud:
+            self.uart_baud = new_baud
+
+    def read(self, count):
+        data, self.answer = self.answer[:count], self.answer[count:]
+        return data
+
+
+def self_test():
+    failures = []
+
+    def check(ok, what):
+        if not ok:
+            failures.append(what)
+            print("FAIL " + what)
+
+    # A 200 KB library-plus-splash image, then the same build with one function changed
+    rng = random.Random(67)
+    image = bytes(rng.getrandbits(8) for _ in range(200 * 1024))
+    edited = bytearray(image)
+    edited[0x1234:0x1240] = b"\x00" * 12
+
+    def run(what, port, data, baud):
+        result = upload(port, data, baud, clock=port.clock)
+        check(port.flash[:len(data)] == data, what + ": flash holds the image")
+        print("%-28s %s" % (what + ":", describe(result)))
+        return result
+
+    stock = run("stock bootloader", SimulatedBootloader(False), image, 1000000)
+    check(stock["written"] == stock["pages"] and stock["baud"] == BOOT_BAUD,
+          "stock bootloader: every page at 115200")
+
+    board = SimulatedBootloader(True)
+    first = run("fast, blank flash", board, image, 1000000)
+    check(first["written"] == first["pages"] and first["baud"] == 1000000, "blank flash: every page at 1 Mbaud")
+    again = run("fast, one page changed", SimulatedBootloader(True, board.flash), bytes(edited), 1000000)
+    check(again["written"] == 1, "one changed page written")
+    same = run("fast, unchanged", SimulatedBootloader(True, board.flash), image, 500000)
+    check(same["written"] == 0 and same["baud"] == 500000, "unchanged image writes nothing")
+    check(again["seconds"] * 20 < stock["seconds"], "a one-page change uploads 20 times faster")
+
+    slow = run("fast, rate out of reach", SimulatedBootloader(True), image[:4096], 4000000)
+    check(slow["baud"] == BOOT_BAUD and slow["written"] == 16, "unreachable rate stays at 115200")
+
+    if failures:
+        return 1
+    print("fast upload: all checks passed")
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("hex", nargs="?", help="firmware.hex to upload")
+    parser.add_argument("--port", help="serial port of the controller")
+    parser.add_argument("--baud", type=int, default=1000000, help="rate to switch to after signing on")
+    parser.add_argument("--report", help="append the result to this JSON-lines file")
+    parser.add_argument("--self-test", action="store_true", help="upload to a model of the bootloader")
+    args = parser.parse_args()
+
+    if args.self_test:
+        return self_test()
+    if not args.hex or not args.port:
+        parser.error("a hex file and --port are needed")
+
+    import serial
+
+    image = read_hex(args.hex)
+    with serial.Serial(args.port, BOOT_BAUD, timeout=0.5) as port:
+        # Reset into the bootloader the way avrdude's wiring programmer does
+        port.dtr = False
+        port.rts = False
+        time.sleep(0.05)
+        port.dtr = True
+        port.rts = True
+        time.sleep(0.05)
+        port.reset_input_buffer()
+        result = upload(port, image, args.baud)
+
+    print(describe(result))
+    if args.report:
+        result.update({"image": os.path.abspath(args.hex), "built": int(os.path.getmtime(args.hex)),
+                       "uploaded": int(time.time())})
+        with open(args.report, "a") as f:
+            f.write(json.dumps(result, sort_keys=True) + "\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
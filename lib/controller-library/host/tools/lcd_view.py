@@ -0,0 +1,336 @@
+#!/usr/bin/env python3
+"""Draw the LCD display list a robot streams with LCD.SetOutput() into PNG images.
+
+Records arrive as FEHTelemetry packets on channel 255 (see private_include/displaylist.h
+for the format) and are drawn the way Adafruit_GFX draws them on the robot's screen.
+
+    lcd_view.py capture.bin --png screen.png [--frames frame]
+    lcd_view.py --port /dev/ttyACM0 --png screen.png [--seconds 30]
+
+--png writes the screen after the last record, and when reading a port, again after every
+clear, so an image viewer that reloads on change shows the screen live. --frames PREFIX
+writes the screen as it was just before each clear to PREFIX0000.png, PREFIX0001.png, ...
+Text on the telemetry text channel is printed as it arrives.
+
+--compare RAW checks the final screen against RGB565 pixels (little endian, row by row)
+and exits non-zero on any difference; --host-font draws text with the host build's
+synthetic glyphs instead of the robot's font, so the two can be compared exactly.
+
+Reading a port needs pyserial (pip install pyserial).
+"""
+
+import argparse
+import os
+import struct
+import sys
+import time
+import zlib
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from telemetry_receive import Decoder, TEXT_CHANNEL  # noqa: E402
+
+DISPLAY_CHANNEL = 255
+
+SCREEN, CLEAR, PIXEL, LINE, RECT, FILL_RECT, CIRCLE, FILL_CIRCLE, TEXT = range(1, 10)
+TEXT_HEADER = 11
+
+# Fields of each shape record before its color
+SHAPE_FIELDS = {CLEAR: 0, PIXEL: 2, LINE: 4, RECT: 4, FILL_RECT: 4, CIRCLE: 3, FILL_CIRCLE: 3}
+
+# Adafruit_GFX's classic 5x7 font, printable ASCII: 5 columns per glyph, bit 0 at the top
+FONT = bytes.fromhex(
+    "0000000000" "00005f0000" "0007000700" "147f147f14" "242a7f2a12" "2313086462" "3649552250" "0005030000"
+    "001c224100" "0041221c00" "082a1c2a08" "08083e0808" "0050300000" "0808080808" "0060600000" "2010080402"
+    "3e5149453e" "00427f4000" "4261514946" "2141454b31" "1814127f10" "2745454539" "3c4a494930" "0171090503"
+    "3649494936" "064949291e" "0036360000" "0056360000" "0008142241" "1414141414" "4122140800" "0201510906"
+    "324979413e" "7e1111117e" "7f49494936" "3e41414122" "7f4141221c" "7f49494941" "7f09090101" "3e41415132"
+    "7f0808087f" "00417f4100" "2040413f01" "7f08142241" "7f40404040" "7f0204027f" "7f0408107f" "3e4141413e"
+    "7f09090906" "3e4151215e" "7f09192946" "4649494931" "01017f0101" "3f4040403f" "1f2040201f" "7f2018207f"
+    "6314081463" "0304780403" "6151494543" "00007f4141" "0204081020" "41417f0000" "0402010204" "4040404040"
+    "0001020400" "2054545478" "7f48444438" "3844444420" "384444487f" "3854545418" "087e090102" "081454543c"
+    "7f08040478" "00447d4000" "2040443d00" "007f102844" "00417f4000" "7c04180478" "7c08040478" "3844444438"
+    "7c14141408" "081414187c" "7c08040408" "4854545420" "043f444020" "3c4040207c" "1c2040201c" "3c4030403c"
+    "4428102844" "0c5050503c" "4464544c44" "0008364100" "00007f0000" "0041360800" "08082a1c08")
+
+
+def font_column(c, i):
+    if 0x20 <= c < 0x7F:
+        return FONT[(c - 0x20) * 5 + i]
+    return 0
+
+
+def host_font_column(c, i):
+    """glyphColumn() of host/shims/Adafruit_GFX.cpp"""
+    if c == 0x20:
+        return 0
+    h = ((c * 2654435761) ^ (i * 40503)) & 0xFFFFFFFF
+    h ^= h >> 13
+    return h & 0x7F
+
+
+class Screen:
+    """The display as Adafruit_GFX draws on it, with clipping, in RGB565."""
+
+    def __init__(self, width=240, height=320, column=font_column):
+        self.column = column
+        self.resize(width, height)
+
+    def resize(self, width, height):
+        self.width, self.height = width, height
+        self.pixels = [0] * (width * height)
+
+    def fill_rect(self, x, y, w, h, color):
+        if w < 0:
+            x, w = x + w + 1, -w
+        if h < 0:
+            y, h = y + h + 1, -h
+        x0, y0 = max(x, 0), max(y, 0)
+        x1, y1 = min(x + w, self.width), min(y + h, self.height)
+        for row in range(y0, y1):
+            start = row * self.width
+            self.pixels[start + x0:start + x1] = [color] * max(0, x1 - x0)
+
+    def pixel(self, x, y, color):
+        if 0 <= x < self.width and 0 <= y < self.height:
+            self.pixels[y * self.width + x] = color
+
+    def line(self, x0, y0, x1, y1, color):
+        # Adafruit_GFX::writeLine()
+        steep = abs(y1 - y0) > abs(x1 - x0)
+        if steep:
+            x0, y0, x1, y1 = y0, x0, y1, x1
+        if x0 > x1:
+            x0, x1, y0, y1 = x1, x0, y1, y0
+        dx, dy = x1 - x0, abs(y1 - y0)
+        err = dx // 2
+        ystep = 1 if y0 < y1 else -1
+        while x0 <= x1:
+            if steep:
+                self.pixel(y0, x0, color)
+            else:
+                self.pixel(x0, y0, color)
+            err -= dy
+            if err < 0:
+                y0 += ystep
+                err += dx
+            x0 += 1
+
+    def rect(self, x, y, w, h, color):
+        # FEHLCD::DrawRectangle() normalizes before drawing the four sides
+        if w < 0:
+            x, w = x + w + 1, -w
+        if h < 0:
+            y, h = y + h + 1, -h
+        if w == 0 or h == 0:
+            return
+        self.fill_rect(x, y, w, 1, color)
+        self.fill_rect(x, y + h - 1, w, 1, color)
+        self.fill_rect(x, y, 1, h, color)
+        self.fill_rect(x + w - 1, y, 1, h, color)
+
+    def circle(self, x0, y0, r, color):
+        # Adafruit_GFX::drawCircle()
+        f, ddf_x, ddf_y, x, y = 1 - r, 1, -2 * r, 0, r
+        for px, py in ((x0, y0 + r), (x0, y0 - r), (x0 + r, y0), (x0 - r, y0)):
+            self.pixel(px, py, color)
+        while x < y:
+            if f >= 0:
+                y -= 1
+                ddf_y += 2
+                f += ddf_y
+            x += 1
+            ddf_x += 2
+            f += ddf_x
+            for dx, dy in ((x, y), (y, x)):
+                for sx in (1, -1):
+                    for sy in (1, -1):
+                        self.pixel(x0 + sx * dx, y0 + sy * dy, color)
+
+    def fill_circle(self, x0, y0, r, color):
+        # Adafruit_GFX::fillCircle() and fillCircleHelper() with both halves
+        if r < 0:
+            return
+        self.fill_rect(x0, y0 - r, 1, 2 * r + 1, color)
+        f, ddf_x, ddf_y, x, y = 1 - r, 1, -2 * r, 0, r
+        px, py = x, y
+        while x < y:
+            if f >= 0:
+                y -= 1
+                ddf_y += 2
+                f += ddf_y
+            x += 1
+            ddf_x += 2
+            f += ddf_x
+            if x < y + 1:
+                self.fill_rect(x0 + x, y0 - y, 1, 2 * y + 1, color)
+                self.fill_rect(x0 - x, y0 - y, 1, 2 * y + 1, color)
+            if y != py:
+                self.fill_rect(x0 + py, y0 - px, 1, 2 * px + 1, color)
+                self.fill_rect(x0 - py, y0 - px, 1, 2 * px + 1, color)
+                py = y
+            px = x
+
+    def char(self, x, y, c, color, bg, size):
+        # Adafruit_GFX::drawChar() for the classic font
+        if x >= self.width or y >= self.height or x + 6 * size - 1 < 0 or y + 8 * size - 1 < 0:
+            return
+        if c >= 176:
+            c += 1
+        for i in range(5):
+            line = self.column(c, i)
+            for j in range(8):
+                if line & 1:
+                    self.fill_rect(x + i * size, y + j * size, size, size, color)
+                elif bg != color:
+                    self.fill_rect(x + i * size, y + j * size, size, size, bg)
+                line >>= 1
+        if bg != color:
+            self.fill_rect(x + 5 * size, y, size, 8 * size, bg)
+
+    def text(self, x, y, color, bg, size, wrap, chars):
+        # Adafruit_GFX::write()
+        for c in chars:
+            if c == 0x0A:
+                x, y = 0, y + 8 * size
+            elif c != 0x0D:
+                if wrap and x + 6 * size > self.width:
+                    x, y = 0, y + 8 * size
+                self.char(x, y, c, color, bg, size)
+                x += 6 * size
+
+    def draw(self, record):
+        """Draw one record; returns its op, or None if it is malformed."""
+        if not record:
+            return None
+        op = record[0]
+        if op == SCREEN and len(record) == 5:
+            width, height = struct.unpack_from("<hh", record, 1)
+            if (width, height) != (self.width, self.height):
+                self.resize(width, height)
+        elif op in SHAPE_FIELDS and len(record) == 3 + 2 * SHAPE_FIELDS[op]:
+            fields = struct.unpack_from("<%dh" % SHAPE_FIELDS[op], record, 1)
+            color = struct.unpack_from("<H", record, len(record) - 2)[0]
+            if op == CLEAR:
+                self.fill_rect(0, 0, self.width, self.height, color)
+            elif op == PIXEL:
+                self.pixel(*fields, color)
+            elif op == LINE:
+                self.line(*fields, color)
+            elif op == RECT:
+                self.rect(*fields, color)
+            elif op == FILL_RECT:
+                self.fill_rect(*fields, color)
+            elif op == CIRCLE:
+                self.circle(*fields, color)
+            else:
+                self.fill_circle(*fields, color)
+        elif op == TEXT and len(record) >= TEXT_HEADER:
+            x, y, color, bg, size, wrap = struct.unpack_from("<hhHHBB", record, 1)
+            self.text(x, y, color, bg, size, wrap, record[TEXT_HEADER:])
+        else:
+            return None
+        return op
+
+    def png(self):
+        rows = bytearray()
+        for row in range(self.height):
+            rows.append(0)
+            for p in self.pixels[row * self.width:(row + 1) * self.width]:
+                r, g, b = p >> 11, (p >> 5) & 0x3F, p & 0x1F
+                rows += bytes(((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2)))
+
+        def chunk(kind, data):
+            body = kind + data
+            return struct.pack(">I", len(data)) + body + struct.pack(">I", zlib.crc32(body))
+
+        header = struct.pack(">IIBBBBB", self.width, self.height, 8, 2, 0, 0, 0)
+        return (b"\x89PNG\r\n\x1a\n" + chunk(b"IHDR", header) + chunk(b"IDAT", zlib.compress(bytes(rows), 6)) +
+                chunk(b"IEND", b""))
+
+
+def write_png(screen, path):
+    # Replace the file in one step, so a viewer never loads half an image
+    with open(path + ".tmp", "wb") as f:
+        f.write(screen.png())
+    os.replace(path + ".tmp", path)
+
+
+def open_source(args):
+    if args.port:
+        try:
+            import serial
+        except ImportError:
+            sys.exit("reading a port needs pyserial: pip install pyserial")
+        port = serial.Serial(args.port, args.baud, timeout=0.05)
+        return lambda: port.read(max(1, port.in_waiting)), True
+    stream = sys.stdin.buffer if args.input == "-" else open(args.input, "rb")
+    return lambda: stream.read(65536), False
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", nargs="?", default="-", help="capture file, or - for stdin (default)")
+    parser.add_argument("--port", help="serial port to read instead of a file")
+    parser.add_argument("--baud", type=int, default=2000000)
+    parser.add_argument("--seconds", type=float, help="stop reading a port after this long")
+    parser.add_argument("--png", help="write the screen to this file")
+    parser.add_argument("--frames", metavar="PREFIX", help="write the screen before each clear")
+    parser.add_argument("--compare", metavar="RAW", help="check the final screen against RGB565 pixels")
+    parser.add_argument("--host-font", action="store_true", help="draw text with the host build's glyphs")
+    parser.add_argument("--quiet", action="store_true", help="print only the summary")
+    args = parser.parse_args()
+
+    screen = Screen(column=host_font_column if args.host_font else font_column)
+    read, live = open_source(args)
+    decoder = Decoder(resync=live)
+    records = bad = frames = 0
+    record_bytes = 0
+
+    start = time.monotonic()
+    try:
+        while args.seconds is None or time.monotonic() - start < args.seconds:
+            data = read()
+            if not data:
+                if live:
+                    continue
+                break
+            for channel, _, payload in decoder.feed(data):
+                if channel == TEXT_CHANNEL:
+                    if not args.quiet:
+                        sys.stdout.write(payload.decode("ascii", "replace"))
+                    continue
+                if channel != DISPLAY_CHANNEL:
+                    continue
+                if payload[:1] == bytes((CLEAR,)):
+                    if args.frames and records:
+                        write_png(screen, "%s%04d.png" % (args.frames, frames))
+                    if live and args.png and records:
+                        write_png(screen, args.png)
+                    frames += 1
+                if screen.draw(payload) is None:
+                    bad += 1
+                records += 1
+                record_bytes += len(payload)
+    except KeyboardInterrupt:
+        pass
+
+    if args.png:
+        write_png(screen, args.png)
+    print("%d records (%d bytes) in %d frames, %d malformed; %s" %
+          (records, record_bytes, frames, bad, decoder.summary(time.monotonic() - start)), file=sys.stderr)
+
+    failed = bad or decoder.lost or decoder.crc_errors or decoder.framing_errors
+    if args.compare:
+        with open(args.compare, "rb") as f:
+            raw = f.read()
+        expected = list(struct.unpack("<%dH" % (len(raw) // 2), raw))
+        if expected != screen.pixels:
+            differ = sum(a != b for a, b in zip(expected, screen.pixels)) if len(expected) == len(screen.pixels) \
+                else len(screen.pixels)
+            print("%d of %d pixels differ from %s" % (differ, len(screen.pixels), args.compare), file=sys.stderr)
+            failed = True
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""Run a feh_add_robotsim() program over a grid of parameters and rank the runs.
+
+Each --param takes a comma-separated list of values; every combination is run once, in
+parallel, and the results are sorted by lap time (runs that did not finish last).
+
+    robotsim_sweep.py ./my_robot_sim --config robot.cfg --param kp=0.5,1,2 --param kd=0,0.1
+                      [--seconds 60] [-j 8] [--csv results.csv]
+
+Student code reads the values with RobotSim::param() (see host/README.md).
+"""
+
+import argparse
+import concurrent.futures
+import csv
+import itertools
+import json
+import os
+import subprocess
+import sys
+
+
+def run(program, config, seconds, params):
+    cmd = [program, "--seconds", str(seconds)]
+    if config:
+        cmd += ["--config", config]
+    for name, value in params.items():
+        cmd += ["--param", "%s=%s" % (name, value)]
+    proc = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True)
+    for line in reversed(proc.stdout.splitlines()):
+        if line.startswith("{"):
+            result = json.loads(line)
+            result["params"] = params
+            return result
+    err = proc.stderr.strip().splitlines()
+    return {"reason": "error", "error": err[-1] if err else "exit %d" % proc.returncode, "params": params}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("program")
+    parser.add_argument("--config")
+    parser.add_argument("--param", action="append", default=[], metavar="NAME=V1,V2,...")
+    parser.add_argument("--seconds", type=float, default=60)
+    parser.add_argument("-j", "--jobs", type=int, default=os.cpu_count())
+    parser.add_argument("--csv", help="also write every run to this file")
+    args = parser.parse_args()
+
+    names, values = [], []
+    for p in args.param:
+        name, _, listed = p.partition("=")
+        if not listed:
+            parser.error("expected NAME=V1,V2,... in --param %s" % p)
+        names.append(name)
+        values.append(listed.split(","))
+    grid = [dict(zip(names, combo)) for combo in itertools.product(*values)]
+
+    with concurrent.futures.ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        results = list(pool.map(lambda p: run(args.program, args.config, args.seconds, p), grid))
+
+    def key(r):
+        finished = r.get("reason") == "finish"
+        return (not finished, r.get("lap_seconds", 0) if finished else -r.get("distance", 0))
+
+    results.sort(key=key)
+    print("%-8s %8s %8s %8s  %s" % ("reason", "lap_s", "dist_in", "speedup", "params"))
+    for r in results:
+        print("%-8s %8.2f %8.1f %8.1f  %s" % (r.get("reason", "?")[:8], r.get("lap_seconds", 0),
+                                               r.get("distance", 0), r.get("speedup", 0),
+                                               " ".join("%s=%s" % kv for kv in r["params"].items())))
+
+    if args.csv:
+        with open(args.csv, "w", newline="") as f:
+            writer = csv.writer(f)
+            writer.writerow(names + ["reason", "lap_seconds", "distance", "min_bus_voltage", "wall_seconds"])
+            for r in results:
+                writer.writerow([r["params"][n] for n in names] +
+                                [r.get(k, "") for k in ("reason", "lap_seconds", "distance",
+                                                        "min_bus_voltage", "wall_seconds")])
+
+    return 0 if any(r.get("reason") == "finish" for r in results) else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,183 @@
+#!/usr/bin/env python3
+"""Decode an FEHTelemetry stream from the robot's USB Serial port or from a capture file.
+
+Packets are [channel][sequence][payload][CRC-16/CCITT-FALSE, little endian], COBS encoded
+and ended with a 0 byte (see include/FEHTelemetry.h). Text on channel 0 is printed as it
+arrives; records on other channels are printed, or written to CSV, using --format.
+
+    telemetry_receive.py --port /dev/ttyACM0 [--baud 2000000]
+                         [--format 1=fff:x,y,heading] [--csv run.csv] [--seconds 30]
+    telemetry_receive.py capture.bin --verify [--expect 1000]
+
+--format takes a Python struct format (little endian, no padding, as avr-gcc lays out a
+struct) and optional field names. --verify exits non-zero on CRC or framing errors and on
+sequence gaps; the robot drops a packet instead of waiting when its TX ring is full, and
+every drop shows up as a gap.
+
+Reading a port needs pyserial (pip install pyserial).
+"""
+
+import argparse
+import binascii
+import csv
+import struct
+import sys
+import time
+
+TEXT_CHANNEL = 0
+
+
+def cobs_decode(frame):
+    """Decode one COBS frame without its 0 delimiter; None if it is malformed."""
+    out = bytearray()
+    i, n = 0, len(frame)
+    while i < n:
+        code = frame[i]
+        end = i + code
+        if code == 0 or end > n:
+            return None
+        out += frame[i + 1:end]
+        if code != 0xFF and end < n:
+            out.append(0)
+        i = end
+    return bytes(out)
+
+
+class Decoder:
+    def __init__(self, resync):
+        # A live port can be opened mid-packet: drop everything up to the first delimiter
+        self.pending = b""
+        self.skip_partial = resync
+        self.packets = 0
+        self.payload_bytes = 0
+        self.wire_bytes = 0
+        self.crc_errors = 0
+        self.framing_errors = 0
+        self.lost = 0
+        self.last_seq = None
+
+    def feed(self, data):
+        """Yield (channel, sequence, payload) for each good packet completed by data."""
+        self.wire_bytes += len(data)
+        frames = (self.pending + data).split(b"\0")
+        self.pending = frames.pop()
+        if self.skip_partial and frames:
+            frames.pop(0)
+            self.skip_partial = False
+        for frame in frames:
+            if not frame:
+                continue
+            packet = cobs_decode(frame)
+            if packet is None or len(packet) < 4:
+                self.framing_errors += 1
+                continue
+            body, crc = packet[:-2], packet[-2] | packet[-1] << 8
+            if binascii.crc_hqx(body, 0xFFFF) != crc:
+                self.crc_errors += 1
+                continue
+            channel, seq = body[0], body[1]
+            # One sequence counter on the robot covers all channels
+            if self.last_seq is not None:
+                self.lost += (seq - self.last_seq - 1) & 0xFF
+            self.last_seq = seq
+            self.packets += 1
+            self.payload_bytes += len(body) - 2
+            yield channel, seq, body[2:]
+
+    def summary(self, seconds):
+        rate = self.wire_bytes / seconds / 1000.0 if seconds > 0 else 0.0
+        return ("%d packets, %d payload bytes, %d wire bytes (%.1f KB/s), %d lost, %d CRC errors, "
+                "%d framing errors" % (self.packets, self.payload_bytes, self.wire_bytes, rate, self.lost,
+                                       self.crc_errors, self.framing_errors))
+
+
+def parse_formats(specs):
+    formats = {}
+    for spec in specs:
+        channel, _, rest = spec.partition("=")
+        fmt, _, names = rest.partition(":")
+        layout = struct.Struct("<" + fmt)
+        fields = names.split(",") if names else ["f%d" % i for i in range(len(layout.unpack(bytes(layout.size))))]
+        formats[int(channel)] = (layout, fields)
+    return formats
+
+
+def open_source(args):
+    if args.port:
+        try:
+            import serial
+        except ImportError:
+            sys.exit("reading a port needs pyserial: pip install pyserial")
+        port = serial.Serial(args.port, args.baud, timeout=0.05)
+        return lambda: port.read(max(1, port.in_waiting)), True
+    stream = sys.stdin.buffer if args.input == "-" else open(args.input, "rb")
+    return lambda: stream.read(65536), False
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", nargs="?", default="-", help="capture file, or - for stdin (default)")
+    parser.add_argument("--port", help="serial port to read instead of a file")
+    parser.add_argument("--baud", type=int, default=2000000)
+    parser.add_argument("--format", action="append", default=[], metavar="CH=FMT[:NAMES]",
+                        help="struct format of a channel's records")
+    parser.add_argument("--csv", help="write decoded records to this file")
+    parser.add_argument("--seconds", type=float, help="stop reading a port after this long")
+    parser.add_argument("--quiet", action="store_true", help="print only the summary")
+    parser.add_argument("--verify", action="store_true", help="fail on lost or damaged packets")
+    parser.add_argument("--expect", type=int, help="with --verify, the number of packets expected")
+    args = parser.parse_args()
+
+    formats = parse_formats(args.format)
+    read, live = open_source(args)
+    decoder = Decoder(resync=live)
+    writer = None
+    if args.csv:
+        csv_file = open(args.csv, "w", newline="")
+        writer = csv.writer(csv_file)
+        writer.writerow(["time", "channel", "sequence", "values"])
+
+    start = time.monotonic()
+    try:
+        while args.seconds is None or time.monotonic() - start < args.seconds:
+            data = read()
+            if not data:
+                if live:
+                    continue
+                break
+            now = time.monotonic() - start
+            for channel, seq, payload in decoder.feed(data):
+                if channel == TEXT_CHANNEL:
+                    if not args.quiet:
+                        sys.stdout.write(payload.decode("ascii", "replace"))
+                    continue
+                if channel in formats and len(payload) == formats[channel][0].size:
+                    layout, fields = formats[channel]
+                    values = layout.unpack(payload)
+                    if writer:
+                        writer.writerow(["%.4f" % now, channel, seq] + list(values))
+                    if not args.quiet:
+                        print("[%d] " % channel + " ".join("%s=%g" % kv for kv in zip(fields, values)))
+                else:
+                    if writer:
+                        writer.writerow(["%.4f" % now, channel, seq, payload.hex()])
+                    if not args.quiet:
+                        print("[%d] %s" % (channel, payload.hex()))
+    except KeyboardInterrupt:
+        pass
+
+    if decoder.pending and not live:
+        decoder.framing_errors += 1
+    print(decoder.summary(time.monotonic() - start), file=sys.stderr)
+
+    if args.verify:
+        bad = decoder.lost or decoder.crc_errors or decoder.framing_errors
+        if args.expect is not None and decoder.packets != args.expect:
+            print("expected %d packets, got %d" % (args.expect, decoder.packets), file=sys.stderr)
+            bad = True
+        return 1 if bad else 0
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
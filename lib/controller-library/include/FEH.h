@@ -13,12 +13,21 @@
 #include <FEHBuzzer.h>
 #include <FEHIO.h>
 #include <FEHLCD.h>
+#include <FEHLineSensor.h>
 #include <FEHMotor.h>
 #include <FEHSD.h>
 #include <FEHServo.h>
 #include <FEHRCS.h>
 #include <FEHTestGUI.h>
 #include <FEHUtility.h>
+#include <FEHTime.h>
+#include <FEHFormat.h>
 #include <FEHLog.h>
+#include <FEHTelemetry.h>
+#include <FEHI2C.h>
+#include <FEHRecorder.h>
+#include <FEHPath.h>
+#include <FEHPeriodic.h>
+#include <FEHTrace.h>
 
 #endif // FEH_H
\ No newline at end of file
@@ -19,6 +19,13 @@
 #define RCS_WIFI_BSSID_BYTES {0x00, 0x00, 0x00, 0x00, 0x00, 0x00}
 #define RCS_WIFI_CHANNEL 6
 #define RCS_SERVER_IP_BYTES {10, 0, 0, 1}
+// Set to 1 in build_flags to start joining the RCS network at the end of startup
+// rather than when the region menu opens
+#ifndef RCS_CONNECT_AT_BOOT
+#define RCS_CONNECT_AT_BOOT 0
+#endif
+#define RCS_WIFI_TIMEOUT_MS 10000
+#define RCS_ACK_TIMEOUT_MS 3000
 
 // Number of motors and servos
 #define NUM_SERVOS 8
@@ -36,6 +43,8 @@ const PROGMEM uint8_t MOTOR_DIRECTION_PINS[] = {24, 23, 26, 25};
 #define MOTOR_nFAULT_01_PIN 28
 #define MOTOR_nFAULT_23_PIN 38
 #define MOTOR_nSLEEP_PIN 27
+// Battery sampling period of FEHMotor::SetBatteryCompensation()
+#define MOTOR_COMPENSATION_MS 20
 
 // IO Pins
 const static PROGMEM uint8_t FEHIOPIN_TO_ARDUINOPIN[] = {
@@ -104,6 +113,40 @@ const static PROGMEM bool FEHIOPIN_VALID_INTERRUPT_PINS[] = {
 #define BATT_LOW_LED_PIN 36
 #define LOW_BATTERY_THRESHOLD 10.0
 
+// Serial console. Override either baud rate with -D in build_flags; the TX ring size is
+// the core's SERIAL_TX_BUFFER_SIZE (64 bytes unless set in build_flags)
+#ifndef SERIAL_CONSOLE_BAUD
+#define SERIAL_CONSOLE_BAUD 115200
+#endif
+// Baud rates that are exact at 16 MHz with U2X: 500000, 1000000 and 2000000
+#ifndef TELEMETRY_BAUD
+#define TELEMETRY_BAUD 2000000
+#endif
+
+// FEHPeriodic callbacks on Timer 1 compare B. The slowest rate keeps a period within half
+// of Timer 1's 32.8 ms wrap; the budgets of all callbacks together may use at most
+// PERIODIC_MAX_LOAD_PERCENT of the CPU, and a callback over its budget
+// PERIODIC_MAX_OVER_BUDGET runs in a row is stopped
+#define PERIODIC_MAX_CALLBACKS 4
+#define PERIODIC_MIN_HZ 100
+#define PERIODIC_MAX_HZ 2000
+#ifndef PERIODIC_MAX_LOAD_PERCENT
+#define PERIODIC_MAX_LOAD_PERCENT 50
+#endif
+#define PERIODIC_MAX_OVER_BUDGET 5
+
+// FEHTrace flight recorder: events kept across a reset, 8 bytes each in .noinit SRAM,
+// plus the same again on the heap after a reset that left a trace. A power of two
+#ifndef TRACE_ENTRIES
+#define TRACE_ENTRIES 32
+#endif
+// Set to 1 once boards carry the stk500v2 bootloader that passes the reset flags on in
+// GPIOR1. The stock one clears MCUSR, so every reset reads as 0 and is reported as unknown;
+// with the new one, 0 can only be a jump to address 0
+#ifndef TRACE_BOOTLOADER_PASSES_RESET_FLAGS
+#define TRACE_BOOTLOADER_PASSES_RESET_FLAGS 0
+#endif
+
 // SD Card
 #define MAX_NUMBER_OF_OPEN_FILES 25
 #define BUFFER_SIZE 256
@@ -0,0 +1,142 @@
+/**
+ * FEHFormat.h
+ *
+ * printf-style formatting into fixed buffers, without the heap.
+ */
+
+#ifndef FEHFORMAT_H
+#define FEHFORMAT_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Format text into @p buf like snprintf(), with the library's own number formatter.
+ *
+ * Unlike the AVR printf, %f works without linking the floating point printf library.
+ * Supported: %d %i %u %x %X %c %s %f %%, %S for a string in program memory, with the 'l' length modifier, the flags
+ * '-' '0' '+' ' ', and width and precision (also as '*'). %e and %g are printed as %f.
+ * Floats of 4294967295 or more print as "ovf", as with Serial.print().
+ *
+ * @param buf   Output, always NUL-terminated if @p size is not 0
+ * @param size  Size of @p buf in bytes
+ * @return Length of the full result; the text was cut short if this is @p size or more
+ */
+int FormatText(char *buf, size_t size, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+
+/**
+ * @brief FormatText() with a va_list.
+ */
+int FormatTextV(char *buf, size_t size, const char *fmt, va_list args);
+
+/**
+ * @brief FormatText() with the format in program memory (PSTR() or F()), so the literal
+ *        takes no RAM.
+ */
+int FormatText_P(char *buf, size_t size, const char *fmt, ...);
+
+/**
+ * @brief FormatText_P() with a va_list.
+ */
+int FormatTextV_P(char *buf, size_t size, const char *fmt, va_list args);
+
+/**
+ * @brief String with a fixed capacity of @p N characters, kept in place (e.g. on the stack).
+ *
+ * Use it instead of Arduino's String to build text: String allocates from the heap on
+ * almost every operation, which is slow and fragments the 8 KB of RAM. Text that does
+ * not fit is cut off, and truncated() reports it.
+ *
+ * Example:
+ * @code
+ * FixedString<32> line("Left: ");
+ * line += left_opto.Value();
+ * LCD.WriteLine(line);
+ * @endcode
+ */
+template <size_t N>
+class FixedString
+{
+public:
+    FixedString() : _length(0), _truncated(false) { _buffer[0] = '\0'; }
+    FixedString(const char *str) : FixedString() { append(str); }
+
+    /**
+     * @brief Append text, a character, or a number. Doubles use @p decimals places.
+     */
+    FixedString &append(const char *str) { return appendf("%s", str); }
+    FixedString &append(char c) { return appendf("%c", c); }
+    FixedString &append(int value) { return appendf("%d", value); }
+    FixedString &append(unsigned int value) { return appendf("%u", value); }
+    FixedString &append(long value) { return appendf("%ld", value); }
+    FixedString &append(unsigned long value) { return appendf("%lu", value); }
+    FixedString &append(double value, uint8_t decimals = 2) { return appendf("%.*f", decimals, value); }
+
+    template <typename T>
+    FixedString &operator+=(T value) { return append(value); }
+
+    /**
+     * @brief Append formatted text (see FormatText()).
+     */
+    __attribute__((format(printf, 2, 3))) FixedString &appendf(const char *fmt, ...)
+    {
+        va_list args;
+        va_start(args, fmt);
+        int n = FormatTextV(_buffer + _length, N + 1 - _length, fmt, args);
+        va_end(args);
+        if (n < 0)
+        {
+            return *this;
+        }
+        if ((size_t)n > N - _length)
+        {
+            _truncated = true;
+            _length = N;
+        }
+        else
+        {
+            _length += n;
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Replace the contents with formatted text (see FormatText()).
+     */
+    __attribute__((format(printf, 2, 3))) FixedString &printf(const char *fmt, ...)
+    {
+        clear();
+        va_list args;
+        va_start(args, fmt);
+        int n = FormatTextV(_buffer, N + 1, fmt, args);
+        va_end(args);
+        _truncated = n > (int)N;
+        _length = n < 0 ? 0 : (_truncated ? N : n);
+        return *this;
+    }
+
+    void clear()
+    {
+        _length = 0;
+        _truncated = false;
+        _buffer[0] = '\0';
+    }
+
+    const char *c_str() const { return _buffer; }
+    operator const char *() const { return _buffer; }
+    size_t length() const { return _length; }
+    static constexpr size_t capacity() { return N; }
+
+    /**
+     * @brief Check whether text has been cut off since construction or the last clear().
+     */
+    bool truncated() const { return _truncated; }
+
+private:
+    char _buffer[N + 1];
+    size_t _length;
+    bool _truncated;
+};
+
+#endif // FEHFORMAT_H
@@ -0,0 +1,134 @@
+#ifndef FEHI2C_H
+#define FEHI2C_H
+
+#include <stdint.h>
+
+enum FEHI2CStatus : uint8_t
+{
+    I2C_OK = 0,
+    I2C_PENDING,       // Queued or on the bus
+    I2C_NACK_ADDRESS,  // No device answered at the address
+    I2C_NACK_DATA,     // The device refused a byte
+    I2C_BUS_ERROR,     // Illegal START/STOP seen, or the fault line went low
+    I2C_TIMEOUT,       // No progress for a health check interval; the bus was recovered
+};
+
+enum FEHI2CSpeed : uint8_t
+{
+    I2C_STANDARD, // 100 kHz
+    I2C_FAST,     // 400 kHz, for devices that support fast mode (e.g. the FT6206 touch panel)
+};
+
+/**
+ * @brief One I2C transaction: an optional write, then an optional read after a repeated
+ *        START, as used to read a device register.
+ *
+ * The caller owns the transaction and its buffers, which must stay valid until it
+ * completes. status is I2C_PENDING until then and can be polled like a future.
+ *
+ * Example, reading 6 bytes from register 0x3B of a device at 0x68:
+ * @code
+ * static uint8_t reg = 0x3B;
+ * static uint8_t data[6];
+ * static FEHI2CTransaction read(0x68, &reg, 1, data, 6, I2C_FAST);
+ * FEHI2C::submit(read);
+ * // ... control loop keeps running ...
+ * if (read.done() && read.status == I2C_OK) { ... }
+ * @endcode
+ */
+struct FEHI2CTransaction
+{
+    uint8_t address; // 7-bit address
+    const uint8_t *writeData;
+    uint8_t writeLength;
+    uint8_t *readData;
+    uint8_t readLength;
+    FEHI2CSpeed speed;
+
+    // Called from the TWI interrupt when the transaction completes; keep it short
+    void (*callback)(FEHI2CTransaction *transaction);
+    void *context;
+
+    volatile FEHI2CStatus status;
+    FEHI2CTransaction *next; // Queue link, owned by FEHI2C
+
+    FEHI2CTransaction(uint8_t address, const uint8_t *writeData, uint8_t writeLength, uint8_t *readData,
+                      uint8_t readLength, FEHI2CSpeed speed = I2C_STANDARD,
+                      void (*callback)(FEHI2CTransaction *) = nullptr, void *context = nullptr)
+        : address(address), writeData(writeData), writeLength(writeLength), readData(readData),
+          readLength(readLength), speed(speed), callback(callback), context(context), status(I2C_OK),
+          next(nullptr)
+    {
+    }
+
+    bool done() const { return status != I2C_PENDING; }
+};
+
+/**
+ * @brief Interrupt-driven I2C on the TWI port. Transactions are queued and run one after
+ *        another from the TWI interrupt, so the caller does not wait for the bus.
+ *
+ * FEHI2C owns the TWI peripheral: use it instead of Wire, which would claim the same
+ * interrupt. A transaction that stops making progress (a device holding SDA low) is
+ * failed with I2C_TIMEOUT by the library's health check, which then clocks the bus free.
+ */
+class FEHI2C
+{
+public:
+    /**
+     * @brief Enable the TWI port with its internal pull-ups. Called by the library at
+     *        startup.
+     */
+    static void begin();
+
+    /**
+     * @brief Queue a transaction.
+     *
+     * @return false if it is still pending from an earlier submit()
+     */
+    static bool submit(FEHI2CTransaction &transaction);
+
+    /**
+     * @brief Wait for a transaction to complete, also from code with interrupts off.
+     *
+     * @return the final status
+     */
+    static FEHI2CStatus wait(FEHI2CTransaction &transaction);
+
+    /**
+     * @brief Run a transaction and wait for it.
+     */
+    static FEHI2CStatus transfer(uint8_t address, const uint8_t *writeData, uint8_t writeLength,
+                                 uint8_t *readData, uint8_t readLength, FEHI2CSpeed speed = I2C_STANDARD);
+
+    /**
+     * @brief Register helpers built on transfer().
+     */
+    static FEHI2CStatus writeRegister(uint8_t address, uint8_t reg, uint8_t value,
+                                      FEHI2CSpeed speed = I2C_STANDARD);
+    static FEHI2CStatus readRegisters(uint8_t address, uint8_t reg, uint8_t *data, uint8_t length,
+                                      FEHI2CSpeed speed = I2C_STANDARD);
+
+    /**
+     * @brief Fail every queued transaction with @p status, release SCL and SDA by clocking
+     *        out a stuck device, and re-enable the port.
+     *
+     * @return true if SDA is high afterwards, i.e. the bus is free
+     */
+    static bool recoverBus(FEHI2CStatus status = I2C_BUS_ERROR);
+
+    /**
+     * @brief Fail and recover a transaction that made no progress since the last call.
+     *        The library's health check calls this every 100 ms.
+     *
+     * @return true if the bus had stalled
+     */
+    static bool checkStalled();
+
+    /**
+     * @brief Number of bus recoveries since startup.
+     */
+    static unsigned long recoveries();
+};
+
+#endif // FEHI2C_H
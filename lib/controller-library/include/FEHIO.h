@@ -41,6 +41,20 @@ public:
     } FEHIOPin;
 };
 
+/**
+ * @brief A debounced press or release reported by a DigitalInputPin with events enabled.
+ *
+ */
+struct DigitalInputEvent
+{
+    /// @brief Student I/O pin the event happened on
+    FEHIO::FEHIOPin pin;
+    /// @brief true if the input was engaged (went to 0), false if it was released (went to 1)
+    bool pressed;
+    /// @brief micros() timestamp of the edge
+    unsigned long timeMicros;
+};
+
 /**
  * @brief Use any of 16 Student I/O pins as a digital input.
  *
@@ -57,8 +71,45 @@ public:
      */
     bool Value();
 
+    /**
+     * @brief Start reporting debounced press and release events for this pin.
+     *
+     * Events are collected in the background, so short contacts are caught even while
+     * the main loop is busy. Pins 8-14 are watched with pin change interrupts and their events
+     * are timestamped at the edge itself. The other pins are sampled about every millisecond.
+     * Read the events with DigitalInputPin::NextEvent().
+     *
+     * @param debounceMs Time the input must settle before another edge is accepted (1 to 50 ms)
+     */
+    void EnableEvents(unsigned int debounceMs = 5);
+
+    /**
+     * @brief Stop reporting events for this pin.
+     */
+    void DisableEvents();
+
+    /**
+     * @brief Returns the debounced value of the pin.
+     *  Same as Value() if events have not been enabled with EnableEvents().
+     */
+    bool DebouncedValue();
+
+    /**
+     * @brief Take the oldest event from the queue shared by all pins with events enabled.
+     *
+     * @param event Filled in with the event if there is one
+     * @return true if an event was returned, false if the queue is empty
+     */
+    static bool NextEvent(DigitalInputEvent *event);
+
+    /**
+     * @brief Number of events thrown away because the queue was full.
+     */
+    static unsigned int DroppedEvents();
+
 private:
     uint8_t _arduinoPin;
+    uint8_t _fehPin;
 };
 
 
@@ -155,6 +206,7 @@ public:
 
 private:
     Encoder *_encoder;
+    uint8_t _pinA;
 };
 
 #endif // FEHIO_H
\ No newline at end of file
@@ -7,6 +7,11 @@
 
 #include <stdint.h>
 
+class __FlashStringHelper;
+
+/* Longest text Printf() and friends write at once, including the terminator */
+#define LCD_FORMAT_BUFFER_SIZE 64
+
 /*
  * LCD Colors
  *
@@ -186,6 +191,14 @@ public:
         West
     } FEHLCDOrientation;
 
+    // Create output states
+    typedef enum
+    {
+        Screen = 0,
+        ScreenAndStream,
+        Stream
+    } FEHLCDOutput;
+
     /**
      * @brief Processes user touch on the LCD screen
      *
@@ -217,6 +230,22 @@ public:
      */
     void SetOrientation(FEHLCDOrientation orientation);
 
+    /**
+     * @brief Sets where drawing goes: to the screen, to the PC as draw commands, or both
+     *
+     * Streamed, each draw call or piece of text is sent as a small record over
+     * FEHTelemetry (channel TELEMETRY_CHANNEL_DISPLAY) instead of costing the SPI time to
+     * draw it, so a debug screen can stay in a timed loop. Call FEHTelemetry::begin()
+     * first, and turn the stream into PNGs on the PC with host/tools/lcd_view.py.
+     *
+     * Icons and the test GUI redraw without compositing while streaming. A fatal error
+     * switches back to Screen to show its message.
+     *
+     * @param output
+     *      Screen (the default), ScreenAndStream or Stream
+     */
+    void SetOutput(FEHLCDOutput output);
+
     /**
      * @brief Clears LCD screen to a given color
      *
@@ -296,9 +325,10 @@ public:
      * {@code} Write()
      *
      * @param 1
-     *      message to be printed to the screen
+     *      message to be printed to the screen; text in F() stays in program memory
      */
     void Write(const char *str);
+    void Write(const __FlashStringHelper *str);
     void Write(int i);
     void Write(float f);
     void Write(double d);
@@ -316,6 +346,7 @@ public:
      */
     void WriteLine();
     void WriteLine(const char *str);
+    void WriteLine(const __FlashStringHelper *str);
     void WriteLine(int i);
     void WriteLine(float f);
     void WriteLine(double d);
@@ -338,6 +369,7 @@ public:
      *      Y-coordinate where a message will be printed
      */
     void WriteAt(const char *str, int x, int y);
+    void WriteAt(const __FlashStringHelper *str, int x, int y);
     void WriteAt(int i, int x, int y);
     void WriteAt(float f, int x, int y);
     void WriteAt(double d, int x, int y);
@@ -362,15 +394,41 @@ public:
      *      Column where a message will be printed
      */
     void WriteRC(const char *str, int row, int col);
+    void WriteRC(const __FlashStringHelper *str, int row, int col);
     void WriteRC(int i, int row, int col);
     void WriteRC(float f, int row, int col);
     void WriteRC(double d, int row, int col);
     void WriteRC(bool b, int row, int col);
     void WriteRC(char c, int row, int col);
 
+    /**
+     * @brief Writes formatted text to the LCD, like printf()
+     *
+     * Formats into a buffer on the stack (see FormatText() in FEHFormat.h for the
+     * supported conversions, including %f), so unlike building text with String it
+     * does not use the heap. Text longer than LCD_FORMAT_BUFFER_SIZE - 1 characters
+     * is cut off.
+     *
+     * Note: This comment applies to Printf(), WriteLinef(), WriteAtf() and WriteRCf()
+     *
+     * @param fmt
+     *      printf-style format string, followed by its arguments. A format in F() is
+     *      read from program memory and takes no RAM.
+     */
+    void Printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+    void WriteLinef(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+    void WriteAtf(int x, int y, const char *fmt, ...) __attribute__((format(printf, 4, 5)));
+    void WriteRCf(int row, int col, const char *fmt, ...) __attribute__((format(printf, 4, 5)));
+    void Printf(const __FlashStringHelper *fmt, ...);
+    void WriteLinef(const __FlashStringHelper *fmt, ...);
+    void WriteAtf(int x, int y, const __FlashStringHelper *fmt, ...);
+    void WriteRCf(int row, int col, const __FlashStringHelper *fmt, ...);
+
 private:
     uint16_t _foregroundColor = 0;
 
+    bool record(uint8_t op, int a, int b, int c = 0, int d = 0);
+
     void setTextCursorRC(int row, int col);
 };
 
@@ -391,22 +449,28 @@ namespace FEHIcon
         unsigned int textcolor;
         char label[20];
         int set;
+        bool composeLabel();
 
     public:
         Icon();
         void SetProperties(char name[20], int start_x, int start_y, int w, int h, unsigned int c, unsigned int tc);
+        void SetProperties(const __FlashStringHelper *name, int start_x, int start_y, int w, int h, unsigned int c, unsigned int tc);
         void Draw();
         void Select();
         void Deselect();
         int Pressed(int x, int y, int mode);
         void WhilePressed(int xi, int yi);
         void ChangeLabelString(const char new_label[20]);
+        void ChangeLabelString(const __FlashStringHelper *new_label);
         void ChangeLabelFloat(float val);
         void ChangeLabelInt(int val);
     };
 
     /* Function prototype for drawing an array of icons in a rows by cols array with top, bot, left, and right margins from edges of screen, labels for each icon from top left across each row to the bottom right, and color for the rectangle and the text color */
     void DrawIconArray(Icon icon[], int rows, int cols, int top, int bot, int left, int right, char labels[][20], unsigned int col, unsigned int txtcol);
+
+    /* DrawIconArray() with the labels kept in program memory, e.g. static const char labels[][20] PROGMEM = {"Start", "Stop"}; */
+    void DrawIconArray_P(Icon icon[], int rows, int cols, int top, int bot, int left, int right, const char labels[][20], unsigned int col, unsigned int txtcol);
 }
 
 #endif // FEHLCD_H
\ No newline at end of file
@@ -0,0 +1,158 @@
+/**
+ * FEHLineSensor.h
+ */
+
+#ifndef FEHLINESENSOR_H
+#define FEHLINESENSOR_H
+
+#include <stdint.h>
+#include <FEHIO.h>
+
+/**
+ * @brief Groups several analog optosensors into one line sensor array.
+ *
+ * All sensors are sampled back-to-back in a single sweep by Update(), normalized
+ * against a stored "off line" / "on line" calibration, and combined into a
+ * weighted-centroid line position. Everything after the ADC sweep is integer math,
+ * so the cost of Update() is fixed (roughly 30 microseconds per sensor plus ~50
+ * microseconds of math) and small enough for a 1 kHz line following loop.
+ *
+ * Example:
+ * @code
+ * FEHIO::FEHIOPin pins[] = {FEHIO::Pin4, FEHIO::Pin3, FEHIO::Pin2};
+ * FEHLineSensor line(pins, 3);
+ *
+ * line.SetCalibration(0, 1.2, 3.6); // left sensor: off-line 1.2 V, on-line 3.6 V
+ * ...
+ * line.Update();
+ * if (!line.LineLost())
+ * {
+ *     int error = line.Position(); // -1000 (far left) to 1000 (far right)
+ * }
+ * @endcode
+ */
+class FEHLineSensor
+{
+public:
+    /// @brief Maximum number of sensors in one array
+    static const uint8_t MAX_SENSORS = 8;
+
+    /// @brief Position reported when the line is under the first / last sensor
+    static const int16_t POSITION_RANGE = 1000;
+
+    /// @brief Full-scale value of Reading() and Confidence()
+    static const int16_t READING_MAX = 1000;
+
+    /**
+     * @brief Declare a line sensor array
+     *
+     * Sensors must be listed in physical order, from left to right.
+     * Only analog-capable pins (0-14) can be used.
+     *
+     * @param pins Array of student I/O pins, ordered left to right
+     * @param count Number of sensors in the array (2 to MAX_SENSORS)
+     */
+    FEHLineSensor(const FEHIO::FEHIOPin *pins, uint8_t count);
+
+    /**
+     * @brief Declare a three sensor array (the standard kit layout)
+     */
+    FEHLineSensor(FEHIO::FEHIOPin left, FEHIO::FEHIOPin middle, FEHIO::FEHIOPin right);
+
+    /**
+     * @brief Set the calibration of one sensor from measured voltages
+     *
+     * Either polarity works: for most optosensors the line reads higher than the floor,
+     * but a sensor whose on-line voltage is lower is handled the same way.
+     *
+     * @param index Sensor index (0 = leftmost)
+     * @param offLineVolts Voltage read when the sensor is over the floor
+     * @param onLineVolts Voltage read when the sensor is centered over the line
+     */
+    void SetCalibration(uint8_t index, float offLineVolts, float onLineVolts);
+
+    /**
+     * @brief Record the current readings of every sensor as the "off line" calibration
+     */
+    void CalibrateOffLine();
+
+    /**
+     * @brief Record the current readings of every sensor as the "on line" calibration
+     */
+    void CalibrateOnLine();
+
+    /**
+     * @brief Set how strong the best reading must be for the line to count as found
+     *
+     * @param threshold Minimum Confidence() (0 to READING_MAX) before LineLost() is false. Default is 250.
+     */
+    void SetLostThreshold(int16_t threshold);
+
+    /**
+     * @brief Sample every sensor once and recompute position, confidence and lost-line state
+     */
+    void Update();
+
+    /**
+     * @brief Line position from the last Update()
+     *
+     * Weighted centroid of the normalized readings. 0 means the line is centered on the array,
+     * -POSITION_RANGE means it is under the leftmost sensor and POSITION_RANGE the rightmost.
+     * While the line is lost, the last edge the line was seen at is reported
+     * (-POSITION_RANGE or POSITION_RANGE) so a controller keeps turning back towards it.
+     *
+     * @return line position, -1000 to 1000
+     */
+    int16_t Position();
+
+    /**
+     * @brief Strength of the strongest normalized reading from the last Update()
+     *
+     * @return 0 (no sensor sees the line) to 1000 (a sensor reads its full on-line value)
+     */
+    int16_t Confidence();
+
+    /**
+     * @brief Whether the line was lost on the last Update()
+     */
+    bool LineLost();
+
+    /**
+     * @brief Normalized reading of one sensor from the last Update()
+     *
+     * @param index Sensor index (0 = leftmost)
+     * @return 0 (off line) to 1000 (on line)
+     */
+    int16_t Reading(uint8_t index);
+
+    /**
+     * @brief Raw 10-bit ADC value of one sensor from the last Update()
+     *
+     * @param index Sensor index (0 = leftmost)
+     */
+    uint16_t RawReading(uint8_t index);
+
+private:
+    void configure(const FEHIO::FEHIOPin *pins, uint8_t count);
+    void sweep();
+    void setCalibrationRaw(uint8_t index, uint16_t offLine, uint16_t onLine);
+
+    uint8_t _count;
+    uint8_t _adcChannel[MAX_SENSORS];
+    int16_t _weight[MAX_SENSORS];
+
+    // Calibration: reading = (raw - _offLine) * _scale >> 8, clamped to [0, READING_MAX]
+    uint16_t _offLine[MAX_SENSORS];
+    int16_t _span[MAX_SENSORS];
+    int32_t _scale[MAX_SENSORS];
+
+    uint16_t _raw[MAX_SENSORS];
+    int16_t _reading[MAX_SENSORS];
+
+    int16_t _lostThreshold;
+    int16_t _position;
+    int16_t _confidence;
+    bool _lost;
+};
+
+#endif // FEHLINESENSOR_H
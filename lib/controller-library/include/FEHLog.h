@@ -4,6 +4,87 @@
 #include <stdarg.h>
 #include <stdint.h>
 
+class __FlashStringHelper;
+
+// Levels of the FEH_LOG_* macros. Levels more detailed than FEH_LOG_LEVEL are
+// removed by the preprocessor, arguments and all; select with e.g.
+// -DFEH_LOG_LEVEL=FEH_LOG_LEVEL_TRACE in build_flags
+#define FEH_LOG_LEVEL_NONE 0
+#define FEH_LOG_LEVEL_ERROR 1
+#define FEH_LOG_LEVEL_WARN 2
+#define FEH_LOG_LEVEL_INFO 3
+#define FEH_LOG_LEVEL_DEBUG 4
+#define FEH_LOG_LEVEL_TRACE 5
+#ifndef FEH_LOG_LEVEL
+#define FEH_LOG_LEVEL FEH_LOG_LEVEL_INFO
+#endif
+
+/**
+ * @brief Modules with their own runtime log level. FEH_LOG_APP is for the program's own
+ *        messages; the rest are library modules.
+ */
+enum FEHLogModule : uint8_t
+{
+    FEH_LOG_APP,
+    FEH_LOG_SCHEDULER,
+    FEH_LOG_ESP32,
+    FEH_LOG_SD,
+    FEH_LOG_RCS,
+    FEH_LOG_MODULE_COUNT
+};
+
+/**
+ * @brief Log a message at a level, e.g. FEH_LOG_WARN(APP, "left encoder %d", counts).
+ *
+ * The first argument is a module without its FEH_LOG_ prefix. Levels more detailed than
+ * FEH_LOG_LEVEL (INFO unless set in build_flags) compile to nothing, so their arguments
+ * are not evaluated. Enabled levels are checked against the module's runtime level
+ * (FEHLog::setLevel()) and whether Serial or BLE logging is on before anything is
+ * formatted. The format stays in program memory. Each message is one line:
+ * "<millis> <E|W|I|D|T> <module>: <message>".
+ *
+ * Scheduler and ESP32 messages never go out over BLE. The scheduler runs inside its own
+ * ISR, so its queue full warning is held and logged, to Serial only, the next time the
+ * main thread sleeps. ESP32 messages over BLE would log their own traffic.
+ */
+#define FEH_LOG_AT(level, module, fmt, ...)                                        \
+    do                                                                             \
+    {                                                                              \
+        if (FEHLog::enabled(FEH_LOG_##module, level))                              \
+            FEHLog::log(level, FEH_LOG_##module, F(fmt), ##__VA_ARGS__);           \
+    } while (0)
+
+#define FEH_LOG_OFF(module, fmt, ...) \
+    do                                \
+    {                                 \
+    } while (0)
+
+#if FEH_LOG_LEVEL >= FEH_LOG_LEVEL_ERROR
+#define FEH_LOG_ERROR(module, fmt, ...) FEH_LOG_AT(FEH_LOG_LEVEL_ERROR, module, fmt, ##__VA_ARGS__)
+#else
+#define FEH_LOG_ERROR FEH_LOG_OFF
+#endif
+#if FEH_LOG_LEVEL >= FEH_LOG_LEVEL_WARN
+#define FEH_LOG_WARN(module, fmt, ...) FEH_LOG_AT(FEH_LOG_LEVEL_WARN, module, fmt, ##__VA_ARGS__)
+#else
+#define FEH_LOG_WARN FEH_LOG_OFF
+#endif
+#if FEH_LOG_LEVEL >= FEH_LOG_LEVEL_INFO
+#define FEH_LOG_INFO(module, fmt, ...) FEH_LOG_AT(FEH_LOG_LEVEL_INFO, module, fmt, ##__VA_ARGS__)
+#else
+#define FEH_LOG_INFO FEH_LOG_OFF
+#endif
+#if FEH_LOG_LEVEL >= FEH_LOG_LEVEL_DEBUG
+#define FEH_LOG_DEBUG(module, fmt, ...) FEH_LOG_AT(FEH_LOG_LEVEL_DEBUG, module, fmt, ##__VA_ARGS__)
+#else
+#define FEH_LOG_DEBUG FEH_LOG_OFF
+#endif
+#if FEH_LOG_LEVEL >= FEH_LOG_LEVEL_TRACE
+#define FEH_LOG_TRACE(module, fmt, ...) FEH_LOG_AT(FEH_LOG_LEVEL_TRACE, module, fmt, ##__VA_ARGS__)
+#else
+#define FEH_LOG_TRACE FEH_LOG_OFF
+#endif
+
 class FEHLog
 {
 public:
@@ -56,20 +137,59 @@ public:
      */
     static void printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
 
+    /**
+     * @brief printf() with the format in F(), so it stays in program memory.
+     */
+    static void printf(const __FlashStringHelper *fmt, ...);
+
     /**
      * @brief Print a plain string (no trailing newline).
      */
     static void print(const char *msg);
 
+    /**
+     * @brief Print a string in F() (no trailing newline).
+     */
+    static void print(const __FlashStringHelper *msg);
+
+    /**
+     * @brief Set the most detailed level logged by one module, or by all of them.
+     *        Levels above FEH_LOG_LEVEL are compiled out and cannot be turned on here.
+     *
+     * @param level  FEH_LOG_LEVEL_NONE to FEH_LOG_LEVEL_TRACE; every module starts at
+     *               FEH_LOG_LEVEL_TRACE, so whatever is compiled in is sent
+     */
+    static void setLevel(FEHLogModule module, uint8_t level);
+    static void setLevel(uint8_t level);
+
+    /**
+     * @brief The runtime level of a module.
+     */
+    static uint8_t level(FEHLogModule module);
+
+    /**
+     * @brief Whether a message of a module at a level would be sent. Used by FEH_LOG_*.
+     */
+    static bool enabled(FEHLogModule module, uint8_t level)
+    {
+        return (s_serialEnabled || s_bleEnabled) && level <= s_levels[module];
+    }
+
+    /**
+     * @brief Send one leveled message. Use the FEH_LOG_* macros rather than calling this.
+     */
+    static void log(uint8_t level, FEHLogModule module, const __FlashStringHelper *fmt, ...);
+
 private:
     static bool s_serialEnabled;
     static bool s_bleEnabled;
+    static uint8_t s_levels[FEH_LOG_MODULE_COUNT];
 
     // Maximum length of a single log message (including null terminator)
     static const int LOG_BUF_SIZE = 256;
 
-    static void _dispatch(bool newline, const char *fmt, va_list args);
-    static void _send(const char *msg, bool newline);
+    static void _dispatch(bool newline, const char *fmt, va_list args, bool flash = false);
+    static void _send(const char *msg, bool newline, bool ble = true);
 };
 
 #endif // FEHLOG_H
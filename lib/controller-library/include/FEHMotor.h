@@ -62,6 +62,29 @@ public:
      */
     void SetPercent(int8_t percent);
 
+    /**
+     * @brief Get the voltage the motor is receiving
+     *
+     * The duty cycle times the battery voltage (the filtered measurement while battery
+     * compensation is on).
+     *
+     * @return float Volts, negative when running in reverse
+     */
+    float EffectiveVolts();
+
+    /**
+     * @brief Deliver commanded voltages as the battery drains
+     *
+     * Off by default: SetPercent(100) gives the duty cycle that makes the motor's max
+     * voltage from a 12 V battery, so motors slow down as the battery drops toward
+     * LOW_BATTERY_THRESHOLD. When on, the battery is sampled every MOTOR_COMPENSATION_MS
+     * in the background and every motor's duty cycle is rescaled so that it receives
+     * percent of its max voltage, as far as the battery allows.
+     *
+     * @param enabled true to compensate, false for the fixed 12 V scaling
+     */
+    static void SetBatteryCompensation(bool enabled);
+
     /// @brief Stop all motors
     static void StopAll();
 
@@ -70,6 +93,7 @@ public:
 
 private:
     uint8_t _powerScalingFactor;
+    uint16_t _maxMillivolts;
     FEHMotorPort _motorPort;
 };
 
@@ -0,0 +1,249 @@
+/**
+ * FEHPath.h
+ */
+
+#ifndef FEHPATH_H
+#define FEHPATH_H
+
+#include <stdint.h>
+#include <FEHIO.h>
+#include <FEHMotor.h>
+
+/**
+ * @brief Drives a differential-drive robot along a path of lines and arcs.
+ *
+ * The path is tracked with pure pursuit on encoder odometry: every PERIOD_MS the robot's
+ * pose is updated from the wheel encoders, a point LOOKAHEAD inches further along the
+ * path is chosen, and the robot steers along the circle through it. The forward speed
+ * follows a trapezoidal profile: it ramps at the acceleration limit, slows before tight
+ * arcs, corners and the end of the path, and carries through segment joins instead of
+ * stopping at each one. Each wheel's speed is held by feedforward from its top speed
+ * plus a proportional correction from its encoder, so moves stay repeatable as the
+ * battery drains (FEHMotor::SetBatteryCompensation() helps further).
+ *
+ * Coordinates are inches with the heading in degrees counterclockwise from +x; the path
+ * starts at the robot's pose when Clear() is called (0, 0, heading 0 after construction).
+ *
+ * Example:
+ * @code
+ * FEHMotor left(FEHMotor::Motor0, 9.0), right(FEHMotor::Motor1, 9.0);
+ * DigitalEncoder leftEncoder(FEHIO::Pin8), rightEncoder(FEHIO::Pin10);
+ * FEHPath path(left, right, leftEncoder, rightEncoder, 2.5, 7.5, 318, 15.0);
+ * path.SetMotorReversed(false, true);
+ *
+ * path.Clear();
+ * path.LineTo(24, 0);
+ * path.Arc(10, 90);           // left turn of radius 10 in
+ * path.LineTo(34, 30);
+ * path.SetFinishHeading(180); // then turn in place to face -x
+ * path.Follow();
+ * @endcode
+ */
+class FEHPath
+{
+public:
+    /// @brief Control period of Follow()
+    static const uint8_t PERIOD_MS = 20;
+
+    /// @brief Maximum number of LineTo() and Arc() segments in one path
+    static const uint8_t MAX_SEGMENTS = 16;
+
+    /**
+     * @brief A wheel encoder of either kind
+     *
+     * Single channel encoders count up in both directions, so their wheel is taken to
+     * turn the way it is being driven.
+     */
+    class Encoder
+    {
+    public:
+        Encoder(DigitalEncoder &encoder) : _single(&encoder), _quadrature(nullptr) {}
+        Encoder(DigitalQuadratureEncoder &encoder) : _single(nullptr), _quadrature(&encoder) {}
+        int Counts();
+        bool Quadrature() const { return _quadrature != nullptr; }
+
+    private:
+        DigitalEncoder *_single;
+        DigitalQuadratureEncoder *_quadrature;
+    };
+
+    struct Pose
+    {
+        float x, y;       ///< Inches
+        float headingDeg; ///< Counterclockwise from +x
+    };
+
+    /**
+     * @brief Declare a path follower for a robot
+     *
+     * @param leftMotor, rightMotor Drive motors
+     * @param leftEncoder, rightEncoder Their wheels' encoders
+     * @param wheelDiameter Wheel diameter in inches
+     * @param trackWidth Distance between the wheels' contact points in inches
+     * @param countsPerRev Encoder counts per wheel revolution
+     * @param topSpeed Wheel speed at SetPercent(100) in inches per second, measured
+     */
+    FEHPath(FEHMotor &leftMotor, FEHMotor &rightMotor, Encoder leftEncoder, Encoder rightEncoder,
+            float wheelDiameter, float trackWidth, int countsPerRev, float topSpeed);
+
+    /**
+     * @brief Set which motors drive their wheel backward for positive percentages
+     */
+    void SetMotorReversed(bool left, bool right);
+
+    /**
+     * @brief Set which quadrature encoders count down when their wheel drives forward
+     */
+    void SetEncoderReversed(bool left, bool right);
+
+    /**
+     * @brief Set the forward speed profile
+     *
+     * @param maxVelocity Cruise speed in inches per second. Default is 90% of the top speed.
+     * @param maxAcceleration Acceleration and deceleration in inches per second squared,
+     *        also the sideways acceleration allowed on arcs and corners. Default is 24.
+     */
+    void SetSpeedLimits(float maxVelocity, float maxAcceleration);
+
+    /**
+     * @brief Set the pure pursuit lookahead distance
+     *
+     * Shorter follows the path more tightly and rounds corners less; longer is smoother.
+     *
+     * @param inches Default is 4
+     */
+    void SetLookahead(float inches);
+
+    /**
+     * @brief Set the wheel speed correction
+     *
+     * @param percentPerInchPerSecond Percent added per inch per second of wheel speed
+     *        error. Default is 2.
+     */
+    void SetSpeedGain(float percentPerInchPerSecond);
+
+    /**
+     * @brief Set where odometry thinks the robot is
+     */
+    void SetPose(float x, float y, float headingDeg);
+
+    /**
+     * @brief Odometry pose, updated by Update() and Follow()
+     */
+    Pose GetPose();
+
+    /**
+     * @brief Start a new path at the current pose
+     */
+    void Clear();
+
+    /**
+     * @brief Add a straight segment from the end of the path to a point
+     *
+     * The robot turns towards the point through a rounded corner if the path's heading
+     * changes here; a sharp corner slows the robot down first.
+     *
+     * @return false if the path is full
+     */
+    bool LineTo(float x, float y);
+
+    /**
+     * @brief Add an arc continuing from the end of the path
+     *
+     * @param radius Turn radius in inches
+     * @param degrees Angle turned, positive to the left (counterclockwise)
+     * @return false if the path is full
+     */
+    bool Arc(float radius, float degrees);
+
+    /**
+     * @brief Turn in place to a heading after the last segment
+     *
+     * @param headingDeg Counterclockwise from +x
+     */
+    void SetFinishHeading(float headingDeg);
+
+    /**
+     * @brief Run one control step of the current path
+     *
+     * For use in a loop that does other work, called about every PERIOD_MS.
+     *
+     * @return true once the path (and finish heading) is complete and the motors stopped
+     */
+    bool Update();
+
+    /**
+     * @brief Drive the current path to its end
+     *
+     * @param timeoutSeconds Stop the motors and give up after this long
+     * @return true if the path was completed
+     */
+    bool Follow(float timeoutSeconds = 30);
+
+    /**
+     * @brief Stop both motors and abandon the path
+     */
+    void Stop();
+
+private:
+    struct Segment
+    {
+        float x, y;      // Start point
+        float heading;   // Start heading, radians
+        float length;    // Inches along the path
+        float curvature; // 1 / radius, positive to the left, 0 for a line
+        float start;     // Path distance at the start of the segment
+        float entrySpeed; // Speed limit where the segment begins
+    };
+
+    enum State
+    {
+        IDLE,
+        TRACKING,
+        TURNING,
+        DONE
+    };
+
+    void updateOdometry(float dt);
+    bool addSegment(float length, float curvature, float heading);
+    void pointAt(float s, float *x, float *y);
+    float project(uint8_t index, float *distance);
+    float profileSpeed(float s);
+    void drive(float leftSpeed, float rightSpeed);
+
+    FEHMotor &_leftMotor;
+    FEHMotor &_rightMotor;
+    Encoder _leftEncoder;
+    Encoder _rightEncoder;
+    float _inchesPerCount;
+    float _trackWidth;
+    float _topSpeed;
+    int8_t _leftMotorSign, _rightMotorSign;
+    int8_t _leftEncoderSign, _rightEncoderSign;
+
+    float _maxVelocity;
+    float _maxAcceleration;
+    float _lookahead;
+    float _speedGain;
+
+    // Odometry
+    float _x, _y, _heading;
+    int _leftCounts, _rightCounts;
+    float _leftSpeed, _rightSpeed;            // Measured, inches per second
+    float _leftCommand, _rightCommand;        // Last wheel speed commands
+    uint64_t _lastMicros;
+
+    // Path
+    Segment _segments[MAX_SEGMENTS];
+    uint8_t _segmentCount;
+    float _endX, _endY, _endHeading;
+    bool _finishTurn;
+    float _finishHeading;
+
+    State _state;
+    uint8_t _current;  // Segment holding the robot's progress
+    float _progress;   // Path distance of the closest point
+    float _speed;      // Profiled forward (or turning wheel) speed
+};
+
+#endif // FEHPATH_H
@@ -0,0 +1,75 @@
+#ifndef FEHPERIODIC_H
+#define FEHPERIODIC_H
+
+#include <stdint.h>
+
+/**
+ * @brief Runs control callbacks at a fixed rate from 100 Hz to 2 kHz, paced by hardware.
+ *
+ * Unlike a loop paced with Sleep(), each run is released on a fixed grid of Timer 1 ticks
+ * (0.5 us) no matter how long the rest of the program takes, so a PID loop sees a steady
+ * sample time. Callbacks run from an interrupt with interrupts enabled, so encoder counts,
+ * servo pulses and the scheduler are not held up by them; they should not call Sleep(),
+ * write to the LCD or SD card, or take longer than their budget.
+ *
+ * Example:
+ * @code
+ * void control()
+ * {
+ *     // read encoders, update motor power
+ * }
+ *
+ * FEHPeriodic::attach(control, 500, 200); // 500 Hz, at most 200 us per run
+ * @endcode
+ *
+ * Each callback has a budget: the longest it may run, including the few microseconds the
+ * dispatcher spends reading the timer around it. The budgets of all callbacks together may
+ * take at most PERIODIC_MAX_LOAD_PERCENT of the CPU, and a callback that runs over its
+ * budget PERIODIC_MAX_OVER_BUDGET times in a row is stopped so it cannot starve the rest
+ * of the program. stats() reports how late each run started (jitter), the longest run, and
+ * overruns: releases that came while the callback was still running and were skipped.
+ */
+class FEHPeriodic
+{
+public:
+    struct Stats
+    {
+        unsigned long runs;            ///< Times the callback has run
+        unsigned long overruns;        ///< Releases skipped because the callback was still running
+        unsigned int overBudget;       ///< Runs longer than the budget
+        unsigned int maxLatencyMicros; ///< Latest start after a release
+        unsigned int maxRunMicros;     ///< Longest run
+        bool stopped;                  ///< Stopped for running over budget
+    };
+
+    /**
+     * @brief Start running a callback periodically, or change the rate of one already
+     *        attached. Attaching a callback stopped for running over budget restarts it.
+     *
+     * @param callback  Function to run
+     * @param hz  Rate, PERIODIC_MIN_HZ to PERIODIC_MAX_HZ. The period is rounded to 0.5 us.
+     * @param budgetMicros  Longest the callback may run; 0 for a quarter of the period
+     * @return false if the rate or budget is out of range, the budgets would exceed
+     *         PERIODIC_MAX_LOAD_PERCENT, or PERIODIC_MAX_CALLBACKS are already attached
+     */
+    static bool attach(void (*callback)(), unsigned int hz, unsigned int budgetMicros = 0);
+
+    /**
+     * @brief Stop running a callback.
+     */
+    static void detach(void (*callback)());
+
+    /**
+     * @brief Timing of an attached callback since it was attached or resetStats().
+     *
+     * @return false if the callback is not attached
+     */
+    static bool stats(void (*callback)(), Stats *stats);
+
+    /**
+     * @brief Clear the statistics of every callback.
+     */
+    static void resetStats();
+};
+
+#endif // FEHPERIODIC_H
@@ -12,9 +12,56 @@ public:
      * @brief Setup system used to select RCS course
      *
      * You must be in range of the course to be able to successfully initialize.
+     * Joining the RCS WiFi network starts before the region menu is shown, so it
+     * overlaps with the selection.
      *
+     * @param team_key The team key used for identification (up to 9 characters)
+     * @param wait true to return once connected; false to return as soon as a region
+     *             is chosen and finish connecting in the background (see IsReady())
      */
-    void InitializeTouchMenu(const char *team_key);
+    void InitializeTouchMenu(const char *team_key, bool wait = true);
+
+    /**
+     * @brief Start joining the RCS WiFi network in the background
+     *
+     * InitializeTouchMenu() calls this, as does startup when RCS_CONNECT_AT_BOOT is set.
+     * The connection carries on from Sleep() and the waits in this class; calling this
+     * again while it is underway or up does nothing.
+     */
+    void BeginConnect();
+
+    /**
+     * @brief Tells you if the RCS connection for the chosen region is up
+     *
+     * @return true once the ESP32 has acknowledged the RCS connect
+     */
+    bool IsReady();
+
+    /**
+     * @brief Wait for a background connection to finish
+     *
+     * @param timeout_ms Longest time to wait
+     * @return true if connected; false if the connection failed, timed out, or no
+     *         region has been chosen
+     */
+    bool WaitReady(unsigned long timeout_ms = 13000);
+
+    /**
+     * @brief millis() when each connect phase was reached, 0 if it has not been
+     */
+    struct ConnectTimes
+    {
+        unsigned long started;       ///< WiFi join sent
+        unsigned long wifiConnected; ///< ESP32 joined the network
+        unsigned long regionChosen;  ///< Region selected
+        unsigned long rcsSent;       ///< RCS connect sent
+        unsigned long ready;         ///< RCS connect acknowledged
+    };
+
+    /**
+     * @brief Phase timestamps of the last connection, for diagnosing slow starts
+     */
+    const ConnectTimes &GetConnectTimes();
 
     /**
      * @brief Get course number corresponding to current region
@@ -72,10 +119,31 @@ private:
     /// @brief Handler for RCS data packets from ESP32
     static void handleRCSData(const uint8_t *data, uint8_t len);
     
-    void Initialize(char region, const char *team_key);
+    void Initialize(char region, const char *team_key, bool wait);
+
+    /// @brief Advance the background connection; true if it sent a command
+    bool service();
+    void fail(const __FlashStringHelper *reason);
+    friend bool _rcsService();
+
+    enum ConnectState
+    {
+        CONNECT_IDLE,
+        CONNECT_JOINING_WIFI,
+        CONNECT_WIFI_UP,
+        CONNECT_JOINING_RCS,
+        CONNECT_READY,
+        CONNECT_FAILED
+    };
 
     bool initialized = false;
     char _region = 'z';
+    char _teamKey[10] = "";
+
+    ConnectState _state = CONNECT_IDLE;
+    const __FlashStringHelper *_failure = nullptr;
+    unsigned long _phaseStart = 0;
+    ConnectTimes _times = {0, 0, 0, 0, 0};
 
     volatile int _correctLever = 0; // Initialize this to a valid lever value so it cannot ALWAYS be used to figure out if the start light has gone off
     volatile int _leverFlipped = 0;
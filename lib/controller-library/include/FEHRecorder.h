@@ -0,0 +1,52 @@
+#ifndef FEHRECORDER_H
+#define FEHRECORDER_H
+
+#include <stdint.h>
+
+/**
+ * @brief Records every input the library reads to the SD card, so a run can be replayed
+ *        and profiled on a PC with the host build (see host/README.md).
+ *
+ * Recorded inputs: digital and analog pin reads, line sensor sweeps, encoder counts,
+ * digital input events, touchscreen reads, ESP32 frames (RCS data) and TimeNow().
+ * Each read is timestamped, and repeated identical reads are stored as a single run.
+ *
+ * Example:
+ * @code
+ * FEHRecorder::start("RUN1.REC");
+ * // ... robot code ...
+ * FEHRecorder::stop();
+ * @endcode
+ *
+ * Records are buffered in RAM and written to the card from Sleep() and from the next
+ * input read made outside an interrupt, so an occasional read takes as long as an SD write.
+ */
+class FEHRecorder
+{
+public:
+    /**
+     * @brief Start recording to a file on the SD card, replacing it if it exists.
+     *
+     * @param filename  8.3 file name, e.g. "RUN1.REC"
+     * @return true if the file was opened
+     */
+    static bool start(const char *filename);
+
+    /**
+     * @brief Write everything still buffered and close the recording.
+     */
+    static void stop();
+
+    /**
+     * @brief Check whether a recording is in progress.
+     */
+    static bool isRecording();
+
+    /**
+     * @brief Number of reads that could not be recorded because the buffer was full.
+     *        A replay of a recording with dropped reads can diverge from the run.
+     */
+    static unsigned long droppedRecords();
+};
+
+#endif // FEHRECORDER_H
@@ -80,6 +80,11 @@ public:
     int FPrintf(FEHFile *fptr, const char *format,
                 /* Pointer to the format string */...);
 
+    /**
+     * @brief FPrintf() with the format in F(), so it stays in program memory
+     */
+    int FPrintf(FEHFile *fptr, const __FlashStringHelper *format, ...);
+
     /**
      * @brief Scan data from a file
      *
@@ -0,0 +1,105 @@
+#ifndef FEHTELEMETRY_H
+#define FEHTELEMETRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <FEHDefines.h>
+
+// Largest payload of one packet
+#define TELEMETRY_MAX_PAYLOAD 128
+
+// Channel that FEHLog and FEHSD::FlushToConsole() text goes to while telemetry is on.
+// Channels 1-254 are free for the program's own records.
+#define TELEMETRY_CHANNEL_TEXT 0
+
+// Channel of FEHLCD draw calls while LCD.SetOutput() streams them
+#define TELEMETRY_CHANNEL_DISPLAY 255
+
+struct TelemetryStatistics
+{
+    unsigned long packets; // Packets queued for sending
+    unsigned long dropped; // Packets dropped because the TX ring was full
+    unsigned long bytes;   // Bytes queued, framing included
+};
+
+/**
+ * @brief Binary telemetry over the USB Serial port at up to 2 Mbaud.
+ *
+ * Each packet is [channel][sequence][payload][CRC-16], COBS encoded and ended with a 0
+ * byte, so a receiver can resync at any packet boundary. The sequence number counts
+ * every send() attempt, so the receiver sees dropped packets as gaps. Decode a stream
+ * on the PC with host/tools/telemetry_receive.py.
+ *
+ * Example:
+ * @code
+ * struct Pose { float x, y, heading; };
+ * FEHTelemetry::begin();
+ * // ...
+ * Pose pose = {x, y, heading};
+ * FEHTelemetry::send(1, pose);
+ * @endcode
+ *
+ * Unless asked to wait, send() never waits: a packet that does not fit in the Serial TX
+ * ring is dropped and counted. The ring is SERIAL_TX_BUFFER_SIZE bytes (64 by default, enough for payloads of
+ * up to 58 bytes); the env:telemetry build in platformio.ini makes it 512. At 2 Mbaud the
+ * port moves 200 KB/s, and each byte costs the sender one TX interrupt (about 4 us).
+ */
+class FEHTelemetry
+{
+public:
+    /**
+     * @brief Switch the Serial port to telemetry framing at @p baud.
+     *
+     * Waits for earlier Serial output to go out first. The PC side must open the port at
+     * the same rate.
+     */
+    static void begin(unsigned long baud = TELEMETRY_BAUD);
+
+    /**
+     * @brief Go back to plain text at SERIAL_CONSOLE_BAUD.
+     */
+    static void end();
+
+    /**
+     * @brief Check whether telemetry framing is on.
+     */
+    static bool isActive();
+
+    /**
+     * @brief Queue one packet, by default without waiting.
+     *
+     * @param channel  Channel number, TELEMETRY_CHANNEL_TEXT for text
+     * @param data     Payload
+     * @param len      Payload length, at most TELEMETRY_MAX_PAYLOAD
+     * @param wait     Wait for room in the TX ring instead of dropping the packet
+     * @return false if telemetry is off, the payload is too long, or the packet was dropped
+     */
+    static bool send(uint8_t channel, const void *data, uint8_t len, bool wait = false);
+
+    /**
+     * @brief Queue a record (a plain struct or number) as one packet.
+     */
+    template <typename T>
+    static bool send(uint8_t channel, const T &record)
+    {
+        static_assert(sizeof(T) <= TELEMETRY_MAX_PAYLOAD, "record is larger than TELEMETRY_MAX_PAYLOAD");
+        return send(channel, &record, (uint8_t)sizeof(T));
+    }
+
+    /**
+     * @brief Send text on TELEMETRY_CHANNEL_TEXT, split into as many packets as needed.
+     *
+     * @param wait  Wait for room in the TX ring instead of dropping packets
+     * @return false if any packet was dropped
+     */
+    static bool sendText(const char *text, size_t len, bool wait = false);
+    static bool sendText(const char *text, bool wait = false);
+
+    /**
+     * @brief Counts since begin() or resetStats().
+     */
+    static TelemetryStatistics stats();
+    static void resetStats();
+};
+
+#endif // FEHTELEMETRY_H
@@ -0,0 +1,192 @@
+/**
+ * FEHTime.h
+ *
+ * 64-bit microsecond clock and timing helpers built on it.
+ */
+
+#ifndef FEHTIME_H
+#define FEHTIME_H
+
+#include <stdint.h>
+
+/**
+ * @brief Microseconds since the controller started, in 4 us steps.
+ *
+ * Unlike micros(), which wraps every 71 minutes, this clock never wraps in practice,
+ * so differences between two readings are always correct. It extends the same Timer 0
+ * count that millis() and micros() use, costs about as much as micros(), and is safe
+ * to call from interrupts.
+ */
+uint64_t TimeNowMicros();
+
+/**
+ * @brief A point in time that code can wait for, e.g. a timeout.
+ *
+ * Example:
+ * @code
+ * Deadline timeout = Deadline::InMillis(5000);
+ * while (!done && !timeout.Expired())
+ * {
+ *     // ...
+ * }
+ * @endcode
+ */
+class Deadline
+{
+public:
+    /**
+     * @brief A deadline that has already expired.
+     */
+    Deadline() : _end(0) {}
+
+    /**
+     * @brief A deadline @p ms milliseconds from now.
+     */
+    static Deadline InMillis(uint32_t ms) { return Deadline(TimeNowMicros() + ms * 1000ULL); }
+
+    /**
+     * @brief A deadline @p us microseconds from now.
+     */
+    static Deadline InMicros(uint64_t us) { return Deadline(TimeNowMicros() + us); }
+
+    /**
+     * @brief Check whether the deadline has passed.
+     */
+    bool Expired() const { return TimeNowMicros() >= _end; }
+
+    /**
+     * @brief Microseconds left until the deadline, or 0 if it has passed.
+     */
+    uint64_t RemainingMicros() const
+    {
+        uint64_t now = TimeNowMicros();
+        return now < _end ? _end - now : 0;
+    }
+
+    /**
+     * @brief Milliseconds left until the deadline, rounded down, or 0 if it has passed.
+     */
+    uint32_t RemainingMillis() const { return (uint32_t)(RemainingMicros() / 1000); }
+
+    /**
+     * @brief Move the deadline @p ms milliseconds later.
+     */
+    void ExtendMillis(uint32_t ms) { _end += ms * 1000ULL; }
+
+private:
+    explicit Deadline(uint64_t end) : _end(end) {}
+
+    uint64_t _end;
+};
+
+/**
+ * @brief Measures time since it was created or last restarted.
+ *
+ * Example:
+ * @code
+ * Stopwatch lap;
+ * // ... drive one lap ...
+ * LCD.WriteLine(lap.ElapsedSeconds());
+ * @endcode
+ */
+class Stopwatch
+{
+public:
+    /**
+     * @brief Create a stopwatch that starts now.
+     */
+    Stopwatch() : _start(TimeNowMicros()) {}
+
+    /**
+     * @brief Start timing again from now.
+     */
+    void Restart() { _start = TimeNowMicros(); }
+
+    /**
+     * @brief Restart and return the time measured before the restart, in microseconds.
+     *        Consecutive laps add up to the total time with nothing lost between them.
+     */
+    uint64_t Lap()
+    {
+        uint64_t now = TimeNowMicros();
+        uint64_t elapsed = now - _start;
+        _start = now;
+        return elapsed;
+    }
+
+    /**
+     * @brief Time since the start, in microseconds.
+     */
+    uint64_t ElapsedMicros() const { return TimeNowMicros() - _start; }
+
+    /**
+     * @brief Time since the start, in milliseconds, rounded down.
+     */
+    uint32_t ElapsedMillis() const { return (uint32_t)(ElapsedMicros() / 1000); }
+
+    /**
+     * @brief Time since the start, in seconds.
+     */
+    float ElapsedSeconds() const { return ElapsedMicros() * 1e-6f; }
+
+private:
+    uint64_t _start;
+};
+
+/**
+ * @brief Lets an action run at most once per period, e.g. a status print in a fast loop.
+ *
+ * Example:
+ * @code
+ * RateLimiter print(250);
+ * while (true)
+ * {
+ *     // ... control loop ...
+ *     if (print.Ready())
+ *     {
+ *         LCD.WriteLine(encoder.Counts());
+ *     }
+ * }
+ * @endcode
+ *
+ * Ready() times are spaced by exactly the period while they are called often enough,
+ * so the action does not drift. After a gap longer than a period, the next Ready()
+ * returns true once and the spacing restarts from then, rather than catching up.
+ */
+class RateLimiter
+{
+public:
+    /**
+     * @param periodMs  Minimum time between two Ready() calls that return true
+     */
+    explicit RateLimiter(uint32_t periodMs) : _period(periodMs * 1000ULL), _next(0) {}
+
+    /**
+     * @brief Check whether the action may run now. Returns true at most once per period.
+     */
+    bool Ready()
+    {
+        uint64_t now = TimeNowMicros();
+        if (now < _next)
+        {
+            return false;
+        }
+        _next += _period;
+        if (_next <= now)
+        {
+            _next = now + _period;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Make the next Ready() call return true.
+     */
+    void Reset() { _next = 0; }
+
+private:
+    uint64_t _period;
+    uint64_t _next;
+};
+
+#endif // FEHTIME_H
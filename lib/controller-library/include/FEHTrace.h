@@ -0,0 +1,67 @@
+#ifndef FEHTRACE_H
+#define FEHTRACE_H
+
+#include <stdint.h>
+
+/**
+ * @brief Flight recorder: the last events before a reset, kept in RAM the reset does not clear.
+ *
+ * The library always records scheduler events, faults, kills, fatal errors, software
+ * resets and ESP32 frames, each with a timestamp, in a ring of the last TRACE_ENTRIES
+ * events. After the watchdog, the reset button or a crash restarts the robot, the ring
+ * from the run before is printed to Serial at boot with the cause of the reset:
+ *
+ * @code
+ * Trace before reset (watchdog), 32 events, newest last:
+ *      12.345676 s  dispatch     0x1a2b
+ *      12.351240 s  fault        i2c io
+ *      12.351300 s  reset        shield off
+ * @endcode
+ *
+ * Add your own events with mark() to see how far the program got:
+ * @code
+ * FEHTrace::mark(1);                   // leaving the start box
+ * FEHTrace::mark(2, (uint16_t)angle);  // turning
+ * @endcode
+ *
+ * Dispatch addresses are word addresses: double them for avr-addr2line or the .map file.
+ * A power-on starts with an empty trace, since RAM holds noise until written.
+ */
+class FEHTrace
+{
+public:
+    /**
+     * @brief Record a user event. Takes about 3 us and is safe in interrupts.
+     *
+     * @param id  Your number for the event
+     * @param value  Any value to keep with it
+     */
+    static void mark(uint8_t id, uint16_t value = 0);
+
+    /**
+     * @brief Cause of the last reset, as MCUSR bits (_BV(WDRF), _BV(EXTRF), ...).
+     *        0 means the program jumped to address 0, usually a crash, or, unless
+     *        TRACE_BOOTLOADER_PASSES_RESET_FLAGS is set, that the bootloader cleared MCUSR.
+     */
+    static uint8_t resetCause();
+
+    /**
+     * @brief Check whether a trace from before the last reset was recovered at boot.
+     */
+    static bool recovered();
+
+    /**
+     * @brief Write the recovered trace to the SD card as text, replacing the file.
+     *
+     * @param filename  8.3 file name, e.g. "TRACE.TXT"
+     * @return false if no trace was recovered or the file could not be written
+     */
+    static bool save(const char *filename);
+
+    /**
+     * @brief Print the events of this run so far to Serial.
+     */
+    static void print();
+};
+
+#endif // FEHTRACE_H
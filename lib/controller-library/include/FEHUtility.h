@@ -10,6 +10,11 @@
 #define FEHUTILITY_H
 
 #include <FEHTestGUI.h>
+#include <FEHTime.h>
+
+// Sleep() idles the CPU until the time is up, and on each wakeup (at least every ms) runs
+// library work left by interrupts, such as ESP32 polls that deliver RCS data. Work that is
+// still running at the deadline can make a Sleep() end late by as long as that work takes.
 
 // Millisecond sleeps
 void Sleep(unsigned long ms);
@@ -19,10 +24,20 @@ void Sleep(int ms);
 void Sleep(double s);
 void Sleep(float s);
 
-// Microsecond sleeps
+// Microsecond sleeps. These busy-wait and run no library work.
 void SleepMicroseconds(unsigned long us);
 void SleepMicroseconds(int us);
 
+// Time accounting of Sleep() calls since start or ResetSleepStats()
+struct SleepStatistics
+{
+    uint64_t sleptMicros;    // Time spent in Sleep()
+    uint64_t servicedMicros; // Part of it spent running library work
+    uint32_t serviceRuns;    // Wakeups that found library work to run
+};
+SleepStatistics SleepStats();
+void ResetSleepStats();
+
 // Battery voltage
 float BatteryVoltage();
 
@@ -38,7 +53,8 @@ extern DummyBattery Battery;
 
 
 
-// Wrapper for millis() but in seconds
+// Wrapper for millis() but in seconds. A float only keeps millisecond steps for the first
+// few hours; use TimeNowMicros() or Stopwatch (FEHTime.h) to measure intervals.
 float TimeNow();
 
 // Random number generation
@@ -0,0 +1,86 @@
+/**
+ * @file AvrUpdateProtocol.h
+ * @brief ESP32 -> Mega application update
+ *
+ * Lets the ESP32 replace the Mega application without a USB cable:
+ *
+ *  1. The library sends CMD_AVR_DOWNLOAD with the image's URL. The ESP32 downloads the raw
+ *     binary (avr-objcopy -O binary) into its own flash, sending NOTIFY_FLASH_PROGRESS, and
+ *     answers NOTIFY_AVR_IMAGE_READY or NOTIFY_AVR_IMAGE_FAILED.
+ *  2. The library writes the update marker to EEPROM and resets (FEHESP32::installApplication()).
+ *  3. The stk500v2 bootloader finds the marker and pulls the image a page per SPI frame
+ *     (espboot.c), writing only pages whose CRC differs from flash.
+ *
+ * The ESP32 keeps the new image until the Mega has committed it, so its flash serves as
+ * the second slot of an A/B update: the Mega's reset vector page is erased first and
+ * written last, after the whole image checks out, and the marker is cleared after that.
+ * An interrupted update leaves the marker set and no reset vector. The bootloader never
+ * starts the application while the marker is set, but waits for avrdude and tries again at
+ * each timeout, and the next reset resumes it; pages already written match their CRC and
+ * are not written again.
+ *
+ * Application protocol frames (48 bytes, see ApplicationProtocol.h):
+ *   CMD_AVR_DOWNLOAD          [url length][url]
+ *   NOTIFY_AVR_IMAGE_READY    [pages:2][image CRC:2][bytes:4]      little endian
+ *   NOTIFY_AVR_IMAGE_FAILED   [error code, ERROR_* or FLASH_ERROR_*]
+ *
+ * Bootloader frames (AVR_UPDATE_FRAME_SIZE bytes each way, SPI mode 0 at
+ * AVR_UPDATE_SPI_CLOCK_HZ). The answer to a request comes in the next frame, so every frame
+ * carries the request for the next page while the previous one is read:
+ *   CMD_AVR_READ_PAGE         [page:2]
+ *   RSP_AVR_PAGE              [page:2][data:256][page CRC:2]
+ *
+ * CRCs are avr-libc _crc16_update() started at 0xFFFF; the image CRC runs over every page
+ * in order, padded with 0xFF to a whole page.
+ */
+
+#ifndef AVR_UPDATE_PROTOCOL_H
+#define AVR_UPDATE_PROTOCOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Application protocol
+ */
+
+/** @brief Download a Mega application image into ESP32 flash. */
+#define CMD_AVR_DOWNLOAD                     0x50
+
+/** @brief The downloaded image is complete and can be served to the bootloader. */
+#define NOTIFY_AVR_IMAGE_READY               0xD0
+
+/** @brief The image could not be downloaded or stored. */
+#define NOTIFY_AVR_IMAGE_FAILED              0xD1
+
+/*
+ * Bootloader protocol
+ */
+
+/** @brief Ask for one page of the downloaded image. */
+#define CMD_AVR_READ_PAGE                    0x51
+
+/** @brief One page of the downloaded image and its CRC. */
+#define RSP_AVR_PAGE                         0xD2
+
+#define AVR_UPDATE_PAGE_SIZE                 256
+#define AVR_UPDATE_FRAME_SIZE                (4 + 2 + AVR_UPDATE_PAGE_SIZE + 2)
+#define AVR_UPDATE_SPI_CLOCK_HZ              4000000UL
+
+/** @brief Pages below the bootloader (0x3E000 bytes) */
+#define AVR_UPDATE_MAX_PAGES                 992
+
+/*
+ * EEPROM marker, in the last bytes of the ATmega2560's EEPROM:
+ * [AVR_UPDATE_MAGIC][pages:2][image CRC:2][~AVR_UPDATE_MAGIC]
+ */
+#define AVR_UPDATE_MARKER_ADDRESS            0x0FF8
+#define AVR_UPDATE_MARKER_SIZE               6
+#define AVR_UPDATE_MAGIC                     0x5A
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AVR_UPDATE_PROTOCOL_H
@@ -5,6 +5,7 @@
 #include "esp32.h"
 #include "UpdaterProtocol.h"
 #include "ApplicationProtocol.h"
+#include "AvrUpdateProtocol.h"
 
 // Define partition constants if not already defined
 #ifndef PARTITION_FACTORY
@@ -45,6 +46,12 @@ public:
     static bool setBootPartition(uint8_t partition);
     static void reset(bool factoryReset);
 
+    // Mega application update (see AvrUpdateProtocol.h)
+    static bool downloadApplication(const char *url);
+    static bool isApplicationReady();
+    static bool stageApplication();
+    static bool installApplication();
+
     // RCS Commands
     static bool connectRCS(char region, const uint8_t *ip, const char *teamKey);
     static bool disconnectRCS();
@@ -65,6 +72,10 @@ public:
     static bool waitForAck(uint8_t cmdId, uint32_t timeoutMs = 1000);
     static bool waitForWifiConnect(uint32_t timeoutMs = 5000);
 
+    // Non-blocking checks for callers that send a command and keep working
+    static bool hasWifiResult(); // connectWifi() was answered; isConnected() says how
+    static bool isAcked(uint8_t cmdId);
+
     // Status accessors
     static ESP32Version getVersion();
     static bool isConnected();
@@ -99,6 +110,9 @@ private:
     static bool s_rcsConnected;
     static ESP32RCSCallback s_rcsCallback;
     static uint8_t s_bleState;
+    static bool s_appReady;
+    static uint16_t s_appPages;
+    static uint16_t s_appCrc;
 };
 
 #endif // FEHESP32_H
@@ -20,22 +20,63 @@
 #define FEHINTERNAL_H
 
 #include <Adafruit_ILI9341.h>
-#include <Adafruit_FT6206.h>
 #include <SdFat.h>
 
 //=============================================================================
 // EXTERNAL HARDWARE INTERFACE OBJECTS
 //=============================================================================
 
+/**
+ * @brief ILI9341 driver that holds the shared SPI bus (see spibus.h) for each of its
+ *        write transactions, and offers the bus to pending SD card or ESP32 work when it
+ *        lets go. Text also goes to the display list while FEHLCD streams it, and only
+ *        moves the cursor while FEHLCD does not draw (see displaylist.h).
+ */
+class FEHILI9341 : public Adafruit_ILI9341
+{
+public:
+    using Adafruit_ILI9341::Adafruit_ILI9341;
+
+    void startWrite(void) override;
+    void endWrite(void) override;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+
+    /// Text magnification set by setTextSize(), for drawing text elsewhere to match
+    uint8_t textSize() const { return textsize_x; }
+
+private:
+    uint8_t _writeDepth = 0;
+    bool _ownsBus = false;
+};
+
 /// @brief ILI9341 LCD display controller instance
-extern Adafruit_ILI9341 ILI9341;
+extern FEHILI9341 ILI9341;
 
-/// @brief FT6206 capacitive touchscreen controller instance
-extern Adafruit_FT6206 FT6206;
+/// @brief Most pixels sent in one hold of the bus (4 KB, about 4 ms at 8 MHz). Longer
+///        fills and blits are cut into bands of whole rows.
+#define LCD_BURST_PIXELS 2048
 
 /// @brief SD card FAT filesystem interface
 extern SdFat FAT;
 
+//=============================================================================
+// SYSTEM UTILITIES
+//=============================================================================
+
+/**
+ * @brief Perform software reset using watchdog timer
+ *
+ * Forces an ATmega2560 reset by enabling the watchdog timer with a short timeout
+ * and then waiting for it to expire. This is used to recover from certain fault
+ * conditions (e.g., shield power-off while robot is running) and to hand an
+ * application update to the bootloader.
+ *
+ * @note This function does not return - system will reset
+ */
+void _softwareReset();
+
 //=============================================================================
 // MOTOR PIN MAPPING
 //=============================================================================
@@ -82,14 +123,14 @@ void _lcdErrorPrelude();
  * Validates that a value falls within the specified inclusive range [min, max].
  * If the value is out of range, prints an error message to Serial but does not halt.
  *
- * @param funcName Name of the calling function (for error message)
- * @param valName Name of the parameter being checked (for error message)
+ * @param funcName Name of the calling function, in F() (for error message)
+ * @param valName Name of the parameter being checked, in F() (for error message)
  * @param val Value to check
  * @param min Minimum allowed value (inclusive)
  * @param max Maximum allowed value (inclusive)
  * @return true if value is in range, false otherwise
  */
-bool _checkRange(const char *funcName, const char *valName, int val, int min, int max);
+bool _checkRange(const __FlashStringHelper *funcName, const __FlashStringHelper *valName, int val, int min, int max);
 
 /**
  * @brief Check if a value is within range and kill robot if not
@@ -97,14 +138,14 @@ bool _checkRange(const char *funcName, const char *valName, int val, int min, in
  * Similar to _checkRange() but treats range violations as fatal errors.
  * If the value is out of range, displays error on LCD and kills the robot.
  *
- * @param funcName Name of the calling function (for error message)
- * @param valName Name of the parameter being checked (for error message)
+ * @param funcName Name of the calling function, in F() (for error message)
+ * @param valName Name of the parameter being checked, in F() (for error message)
  * @param val Value to check
  * @param min Minimum allowed value (inclusive)
  * @param max Maximum allowed value (inclusive)
  * @return true if value is in range, false otherwise (robot killed if false)
  */
-bool _checkRangeFatal(const char *funcName, const char *valName, int val, int min, int max);
+bool _checkRangeFatal(const __FlashStringHelper *funcName, const __FlashStringHelper *valName, int val, int min, int max);
 
 /**
  * @brief Trigger a fatal error with a custom message
@@ -120,6 +161,11 @@ bool _checkRangeFatal(const char *funcName, const char *valName, int val, int mi
  */
 void _fatalError(const char *msg);
 
+/**
+ * @brief _fatalError() with the message in F(), so it takes no RAM until the error
+ */
+void _fatalError(const __FlashStringHelper *msg);
+
 /**
  * @brief Trigger a fatal error with default message
  *
@@ -160,6 +206,11 @@ void _killNoScreen(bool loop = true, bool tone = true);
  */
 void _kill(const char *reason);
 
+/**
+ * @brief _kill() with the reason in F()
+ */
+void _kill(const __FlashStringHelper *reason);
+
 /**
  * @brief Kill the robot with default message
  *
@@ -220,4 +271,104 @@ bool _I2CFault();
  */
 bool _IOFault();
 
+//=============================================================================
+// TOUCHSCREEN
+//=============================================================================
+
+/**
+ * @brief Configure the FT6206 touch panel and start reading it in the background
+ *
+ * From then on the panel is read over FEHI2C every 10 ms at 400 kHz from the scheduler,
+ * and _touchPoint() returns the latest reading without waiting for the bus.
+ *
+ * @param threshold Touch sensitivity threshold
+ * @return true if the panel answered with the FocalTech vendor ID
+ */
+bool _touchBegin(uint8_t threshold);
+
+/**
+ * @brief Latest touch point in panel coordinates
+ *
+ * Before _touchBegin() (e.g. in host tools) this reads the panel and waits for it.
+ *
+ * @return true if the panel is being touched
+ */
+bool _touchPoint(int16_t *x, int16_t *y);
+
+//=============================================================================
+// WIDGET COMPOSITING
+//=============================================================================
+
+/**
+ * @brief Choose how widgets redraw their changing text
+ *
+ * When on (the default), FEHIcon::Icon::ChangeLabel*() and the test GUI's text compose
+ * their new contents in an LcdTile (lcdtile.h) and send it in one window. When off they
+ * erase and draw straight to the display as before, e.g. to compare the two.
+ */
+void _lcdSetCompositing(bool enabled);
+
+/**
+ * @return true if widgets redraw through an LcdTile
+ */
+bool _lcdCompositing();
+
+//=============================================================================
+// DEFERRED WORK
+//=============================================================================
+
+/**
+ * @brief Check whether the caller is an interrupt rather than the main thread
+ *
+ * True with interrupts disabled, and inside FEHPeriodic callbacks, which run from the
+ * Timer 1 ISR with interrupts enabled. Work that must not run in an ISR (SPI traffic, SD
+ * writes) is requested with spiBusRequest() instead.
+ */
+bool _inInterruptContext();
+
+/**
+ * @brief Run library work that interrupts have left for the main thread
+ *
+ * Interrupts only flag work that must not run in an ISR (SPI traffic, SD writes).
+ * This runs whatever is pending: the ESP32 poll requested by the scheduler, reporting
+ * events a full scheduler queue refused and restarting the input event sampler or battery
+ * compensation if it was one of them, the next step of a background RCS connection,
+ * draining the input recorder to the SD card, and sending text the LCD display list is
+ * holding back for more (displaylist.h). Sleep() calls it on every wakeup.
+ *
+ * @return true if any work was pending
+ *
+ * @note Main thread only
+ */
+bool _serviceDeferredWork();
+
+/**
+ * @brief Advance a background RCS connection (FEHRCS::BeginConnect())
+ *
+ * @return true if a command was sent to the ESP32
+ *
+ * @note Main thread only
+ */
+bool _rcsService();
+
+/**
+ * @brief Restart the input event sampler (DigitalInputPin::EnableEvents()) if a full
+ *        scheduler queue stopped it
+ *
+ * @return true if it was restarted
+ *
+ * @note Main thread only
+ */
+bool _eventService();
+
+/**
+ * @brief Restart battery compensation (FEHMotor::SetBatteryCompensation()) if a full
+ *        scheduler queue stopped it
+ *
+ * @return true if it was restarted
+ *
+ * @note Main thread only
+ */
+bool _compensationService();
+
 #endif // FEHINTERNAL_H
\ No newline at end of file
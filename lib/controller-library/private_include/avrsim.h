@@ -0,0 +1,18 @@
+/**
+ * avrsim.h
+ *
+ * Region markers for the simavr harness (host/sim/feh_avrsim.cpp). Writing a nonzero id to
+ * GPIOR0 starts a region and writing 0 ends it; the harness reports the cycles in between.
+ * GPIOR0 is a spare general purpose register, so the markers cost one OUT instruction each
+ * and do nothing on real hardware.
+ */
+
+#ifndef AVRSIM_H
+#define AVRSIM_H
+
+#include <avr/io.h>
+
+#define AVRSIM_BEGIN(id) (GPIOR0 = (id))
+#define AVRSIM_END() (GPIOR0 = 0)
+
+#endif // AVRSIM_H
@@ -0,0 +1,91 @@
+/**
+ * displaylist.h
+ *
+ * FEHLCD draw calls as display-list records, sent as FEHTelemetry packets on
+ * TELEMETRY_CHANNEL_DISPLAY (see FEHLCD::SetOutput()). A record is one draw call, far
+ * smaller than the pixels it draws, so a debug screen costs tens of bytes per update
+ * instead of the SPI time to draw it. host/tools/lcd_view.py rasterizes a capture to PNG.
+ *
+ * Record format
+ * -------------
+ * [op] then little-endian int16 fields, colors RGB565:
+ *
+ *   DISPLAY_LIST_SCREEN:       width height            after SetOutput() and SetOrientation()
+ *   DISPLAY_LIST_CLEAR:        color
+ *   DISPLAY_LIST_PIXEL:        x y color
+ *   DISPLAY_LIST_LINE:         x0 y0 x1 y1 color       inclusive end points
+ *   DISPLAY_LIST_RECT:         x y w h color
+ *   DISPLAY_LIST_FILL_RECT:    x y w h color
+ *   DISPLAY_LIST_CIRCLE:       x y r color
+ *   DISPLAY_LIST_FILL_CIRCLE:  x y r color
+ *   DISPLAY_LIST_TEXT:         x y color background [size] [wrap] [characters]
+ *
+ * Shapes are drawn as Adafruit_GFX draws them. Text is the classic 6x8 font at the given
+ * magnification, starting at the cursor (x, y); the background is transparent when it
+ * equals the color, and wrap is 1 if text wraps at the right edge. Consecutive writes that
+ * continue from where the last one ended share one record until another record is sent,
+ * the record is full, or displayListFlush() runs.
+ */
+
+#ifndef DISPLAYLIST_H
+#define DISPLAYLIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum : uint8_t
+{
+    DISPLAY_LIST_SCREEN = 1,
+    DISPLAY_LIST_CLEAR,
+    DISPLAY_LIST_PIXEL,
+    DISPLAY_LIST_LINE,
+    DISPLAY_LIST_RECT,
+    DISPLAY_LIST_FILL_RECT,
+    DISPLAY_LIST_CIRCLE,
+    DISPLAY_LIST_FILL_CIRCLE,
+    DISPLAY_LIST_TEXT
+} DisplayListOp;
+
+// Largest record, so one fits the default 64-byte Serial TX ring with its framing
+#define DISPLAY_LIST_MAX_RECORD 58
+// Bytes of a text record before its characters, and the most characters it holds
+#define DISPLAY_LIST_TEXT_HEADER 11
+#define DISPLAY_LIST_TEXT_MAX (DISPLAY_LIST_MAX_RECORD - DISPLAY_LIST_TEXT_HEADER)
+
+/**
+ * @brief Choose where FEHLCD output goes: to the display, as records, or both.
+ *
+ * Sends any pending text first.
+ */
+void displayListSetOutput(bool drawing, bool listing);
+
+/**
+ * @return true if FEHLCD calls draw on the display
+ */
+bool displayListDrawing();
+
+/**
+ * @return true if FEHLCD calls are sent as records
+ */
+bool displayListListing();
+
+/**
+ * @brief Send a shape record of @p op with its fields and color. Sends any pending text
+ *        first.
+ */
+void displayListShape(DisplayListOp op, int16_t a, int16_t b, int16_t c, int16_t d, uint16_t color);
+
+/**
+ * @brief Add @p len characters, at most DISPLAY_LIST_TEXT_MAX, written at the cursor
+ *        (@p x, @p y), which moved the cursor to (@p endX, @p endY), to the pending text
+ *        record.
+ */
+void displayListText(int16_t x, int16_t y, int16_t endX, int16_t endY, uint16_t color, uint16_t background,
+                     uint8_t size, bool wrap, const uint8_t *text, uint8_t len);
+
+/**
+ * @brief Send the pending text record, if any.
+ */
+void displayListFlush();
+
+#endif // DISPLAYLIST_H
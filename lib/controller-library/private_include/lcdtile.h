@@ -0,0 +1,69 @@
+/**
+ * lcdtile.h
+ *
+ * Off-screen tile for widget redraws. A widget that erases its old contents and then
+ * draws the new ones sends its rectangle twice and flickers in between; drawn into a
+ * tile instead, the finished rectangle goes to the display once, in one address window.
+ *
+ * Pixels are palette-indexed at 2 bits, so the LCD_TILE_BYTES buffer holds 2048 pixels
+ * (64x32) instead of the 4 KB the same pixels take in RGB565. A taller or wider widget
+ * is drawn in bands of whole rows: the drawing code runs once per band, in screen
+ * coordinates, and everything outside the band is clipped.
+ * @code
+ * const uint16_t palette[] = {BLACK, WHITE, RED}; // palette[0] is the background
+ * LcdTile tile(x, y, w, h, palette, 3);
+ * while (tile.nextBand())
+ * {
+ *     tile.drawRect(x, y, w, h, RED);
+ *     tile.setCursor(x + 4, y + 4);
+ *     tile.print(label);
+ * }
+ * @endcode
+ *
+ * Every color drawn must be in the palette; any other color draws as the background.
+ */
+
+#ifndef LCDTILE_H
+#define LCDTILE_H
+
+#include <Adafruit_GFX.h>
+#include <stdint.h>
+
+#define LCD_TILE_BYTES 512
+#define LCD_TILE_COLORS 4
+
+class LcdTile : public Adafruit_GFX
+{
+public:
+    /**
+     * @brief Tile for the screen rectangle at (@p x, @p y), clipped to the screen, with
+     *        up to LCD_TILE_COLORS colors.
+     */
+    LcdTile(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *palette, uint8_t colors);
+
+    /**
+     * @brief Send the band drawn since the last call, if any, and start the next one,
+     *        cleared to the background.
+     *
+     * @return false once every band has been sent
+     */
+    bool nextBand();
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+    void fillScreen(uint16_t color) override;
+
+private:
+    uint8_t index(uint16_t color) const;
+    void send();
+
+    const uint16_t *_palette;
+    uint8_t _colors;
+    int16_t _x, _y, _w, _h;
+    int16_t _bandY;    ///< First screen row of the current band
+    int16_t _bandRows; ///< Rows in the current band, 0 before the first
+};
+
+#endif // LCDTILE_H
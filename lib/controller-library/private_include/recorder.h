@@ -0,0 +1,107 @@
+/**
+ * recorder.h
+ *
+ * Input recording hooks used by the library's read paths (see FEHRecorder.h).
+ *
+ * Every library function that returns an outside input passes the value through
+ * _recordInput(). While recording, the value is appended to the recording; while
+ * replaying (host build only), the recorded value is returned instead of the live one.
+ * Otherwise the hook costs one load and branch.
+ *
+ * Recording file format
+ * ---------------------
+ * "FEHR" then a version byte, followed by records:
+ *
+ *   [type << 4 | flags] [id] [zigzag varint: start time - previous record's start time, us]
+ *
+ *   RECORD_ESP32:  [varint length] [frame bytes]
+ *   other types:   [zigzag varint value]        absolute if RECORD_FLAG_ABSOLUTE,
+ *                                               else delta from the channel's previous value
+ *                  [varint count - 1] [varint duration us]   only if RECORD_FLAG_RUN
+ *
+ * A channel is a (type, id) pair. Consecutive reads of a channel that return the same
+ * value are stored as one run, so a busy-wait on a bump switch costs a few bytes.
+ * Replay hands each channel's reads back in order and moves the clock to the time of the
+ * first and last read of each run. Records from different channels are not in global time
+ * order, since a run is only written when it ends.
+ */
+
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <stdint.h>
+
+#define RECORDER_MAGIC "FEHR"
+#define RECORDER_VERSION 1
+
+#define RECORD_FLAG_RUN 0x01
+#define RECORD_FLAG_ABSOLUTE 0x02
+
+typedef enum
+{
+    RECORD_DIGITAL = 1, ///< digitalRead() of an Arduino pin, id = Arduino pin
+    RECORD_ANALOG,      ///< 10-bit ADC sample, id = Arduino pin
+    RECORD_ENCODER,     ///< Encoder count, id = FEHIO pin
+    RECORD_TOUCH,       ///< FEHLCD::Touch(), value = x << 12 | y, or -1 if not touched
+    RECORD_TOUCHED,     ///< Touch state in the touch wait loops
+    RECORD_EVENT,       ///< DigitalInputPin::NextEvent(), see FEHIO.cpp
+    RECORD_TIME,        ///< millis() as seen by TimeNow()
+    RECORD_ESP32,       ///< Frame passed to FEHESP32::handleMessage(), id unused
+} RecordType;
+
+enum
+{
+    RECORDER_OFF = 0,
+    RECORDER_RECORDING,
+    RECORDER_REPLAYING,
+};
+
+extern volatile uint8_t _recorderMode;
+
+int32_t _recorderInput(uint8_t type, uint8_t id, int32_t value);
+void _recorderFrame(const uint8_t *frame, uint8_t len);
+
+/**
+ * @brief Record or replay one input read. Safe to call from interrupts.
+ */
+static inline int32_t _recordInput(uint8_t type, uint8_t id, int32_t value)
+{
+    if (_recorderMode == RECORDER_OFF)
+    {
+        return value;
+    }
+    return _recorderInput(type, id, value);
+}
+
+/**
+ * @brief Record a received ESP32 frame. Safe to call from interrupts.
+ */
+static inline void _recordFrame(const uint8_t *frame, uint8_t len)
+{
+    if (_recorderMode == RECORDER_RECORDING)
+    {
+        _recorderFrame(frame, len);
+    }
+}
+
+/**
+ * @brief Write buffered records to the card if enough have built up. Main thread only.
+ *
+ * @return true if anything was written
+ */
+bool _recorderService();
+
+/**
+ * @brief Source of replayed values: returns the next recorded value of a channel.
+ *
+ * Installed by the host backends (recording replay, robot simulation). Returning @p live
+ * leaves the read unchanged.
+ */
+typedef int32_t (*RecorderReplaySource)(uint8_t type, uint8_t id, int32_t live);
+
+/**
+ * @brief Replay reads from @p source, or stop replaying if it is nullptr.
+ */
+void _recorderReplay(RecorderReplaySource source);
+
+#endif // RECORDER_H
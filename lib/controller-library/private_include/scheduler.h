@@ -13,5 +13,9 @@
 bool scheduleEvent(void (*callback)(), uint16_t ticksInFuture);
 void cancelEvents(void (*callback)());
 uint16_t schedulerMsToTicks(int milliseconds);
+bool schedulerHasRoom();
+
+/* Log events refused because the queue was full. Main thread only; returns true if any were. */
+bool schedulerService();
 
 #endif // SCHEDULER_H
\ No newline at end of file
@@ -0,0 +1,167 @@
+/**
+ * spibus.h
+ *
+ * Block transfers on the hardware SPI port, for drivers that move whole frames or pixel
+ * rows. SPI.transfer() waits for each byte to finish before the caller can fetch the
+ * next; these loops load the next byte while the current one is on the wire, so the bus
+ * idles only for the few cycles between SPIF and the SPDR write.
+ *
+ * Settings are the SPCR/SPSR pair SPI.beginTransaction() would compute, made once at
+ * compile time:
+ * @code
+ * static const SpiBusSettings ESP32_SPI = spiBusSettings(1000000, SPI_MODE0);
+ * spiBusBegin(ESP32_SPI);
+ * digitalWrite(cs, LOW);
+ * spiBusTransfer(tx, rx, 48);
+ * digitalWrite(cs, HIGH);
+ * @endcode
+ *
+ * The port must already be enabled with SPI.begin(). Other SPI users (SdFat, the ILI9341
+ * driver) set their own settings at the start of each transaction, so the settings need
+ * not be restored afterwards.
+ *
+ * The display, the SD card and the ESP32 share the bus, so each driver holds it with
+ * spiBusAcquire()/spiBusRelease() (or SpiBusOwner) around its chip select. Interrupts
+ * never use the bus: they call spiBusRequest() and the work runs from the main thread,
+ * either in Sleep() or at a preemption point, where a device that has just released the
+ * bus (the display between row bursts) lets pending higher-priority work go first.
+ */
+
+#ifndef SPIBUS_H
+#define SPIBUS_H
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <stdint.h>
+
+struct SpiBusSettings
+{
+    uint8_t spcr;
+    uint8_t spsr;
+};
+
+/* Index of the slowest divider from F_CPU/2 (0) to F_CPU/128 (7, as 6 does not exist)
+   that keeps SCK at or below clock */
+constexpr uint8_t spiBusDivider(uint32_t clock)
+{
+    return clock >= F_CPU / 2    ? 0
+           : clock >= F_CPU / 4  ? 1
+           : clock >= F_CPU / 8  ? 2
+           : clock >= F_CPU / 16 ? 3
+           : clock >= F_CPU / 32 ? 4
+           : clock >= F_CPU / 64 ? 5
+                                 : 7;
+}
+
+/**
+ * @brief SPCR and SPSR for an MSB-first master at no more than @p clock Hz, as
+ *        SPISettings computes them (the SPR bits select /4 to /128, SPI2X halves it).
+ */
+constexpr SpiBusSettings spiBusSettings(uint32_t clock, uint8_t dataMode)
+{
+    return SpiBusSettings{(uint8_t)(_BV(SPE) | _BV(MSTR) | (dataMode & 0x0C) | (((spiBusDivider(clock) ^ 1) >> 1) & 0x03)),
+                          (uint8_t)((spiBusDivider(clock) ^ 1) & 0x01)};
+}
+
+/**
+ * @brief Apply @p settings to the SPI port.
+ */
+static inline void spiBusBegin(const SpiBusSettings &settings)
+{
+    SPCR = settings.spcr;
+    SPSR = settings.spsr;
+}
+
+/**
+ * @brief Full-duplex transfer: send @p len bytes from @p tx and store the bytes clocked
+ *        in at the same time in @p rx. @p tx and @p rx may be the same buffer.
+ */
+void spiBusTransfer(const uint8_t *tx, uint8_t *rx, uint16_t len);
+
+/**
+ * @brief Send @p len bytes and discard what comes back, e.g. pixel data to the display.
+ */
+void spiBusWrite(const uint8_t *tx, uint16_t len);
+
+/**
+ * @brief Send the 16-bit @p value, high byte first, @p count times, e.g. a run of one
+ *        RGB565 color.
+ */
+void spiBusWriteRepeat16(uint16_t value, uint32_t count);
+
+/* Devices on the bus, in increasing priority */
+enum SpiBusDevice : uint8_t
+{
+    SPI_BUS_LCD,
+    SPI_BUS_SD,
+    SPI_BUS_ESP32,
+    SPI_BUS_DEVICES
+};
+
+struct SpiBusStatistics
+{
+    uint32_t busyMicros[SPI_BUS_DEVICES];       ///< Time each device held the bus
+    uint32_t transactions[SPI_BUS_DEVICES];     ///< Outermost acquisitions
+    uint32_t requests[SPI_BUS_DEVICES];         ///< spiBusRequest() calls
+    uint32_t maxLatencyMicros[SPI_BUS_DEVICES]; ///< Longest wait from request to acquisition
+    uint32_t preemptions; ///< Requests served at a preemption point of a lower-priority device
+    uint32_t conflicts;   ///< Acquisitions refused because another device held the bus
+};
+
+/**
+ * @brief Take the bus for @p device. Nests for the same device.
+ *
+ * @return false if another device holds it, which only happens when called from an
+ *         interrupt that preempted that device; the caller must then leave the bus alone
+ */
+bool spiBusAcquire(SpiBusDevice device);
+
+/**
+ * @brief Give back the bus after the matching spiBusAcquire() that returned true.
+ */
+void spiBusRelease(SpiBusDevice device);
+
+/**
+ * @brief Ask for bus time from an interrupt. The time of the first request is kept until
+ *        the device next acquires the bus, to measure its latency.
+ */
+void spiBusRequest(SpiBusDevice device);
+
+/**
+ * @brief Work that serves a request from the main thread, run at preemption points.
+ */
+void spiBusSetService(SpiBusDevice device, void (*service)());
+
+/**
+ * @brief Preemption point for a device that has just released the bus: run the service
+ *        of every pending request of higher priority, highest first.
+ *
+ * @return true if any ran
+ */
+bool spiBusYield(SpiBusDevice device);
+
+const SpiBusStatistics &spiBusStats();
+void spiBusResetStats();
+
+/**
+ * @brief Holds the bus for one device for the lifetime of the object.
+ */
+class SpiBusOwner
+{
+public:
+    explicit SpiBusOwner(SpiBusDevice device) : _device(device), _owned(spiBusAcquire(device)) {}
+    ~SpiBusOwner()
+    {
+        if (_owned)
+        {
+            spiBusRelease(_device);
+        }
+    }
+    bool owned() const { return _owned; }
+
+private:
+    SpiBusDevice _device;
+    bool _owned;
+};
+
+#endif // SPIBUS_H
@@ -0,0 +1,118 @@
+/**
+ * trace.h
+ *
+ * Flight recorder hooks used by the library (see FEHTrace.h).
+ *
+ * The last TRACE_ENTRIES events are kept in a ring in .noinit SRAM, which the C runtime
+ * does not clear at startup, so the ring outlives a watchdog reset, the reset button and a
+ * crash that jumps to address 0. setup() calls _traceBoot(), which prints the ring to
+ * Serial if it holds a run from before the reset and keeps a copy for FEHTrace::save().
+ *
+ * Entry format (8 bytes)
+ * ----------------------
+ *   time   Timer 0 overflow count << 8 | TCNT0, 4 us per count, so it wraps after 4.7 h
+ *   type   TraceType
+ *   arg    per type, see below
+ *   value  per type, see below
+ *
+ * Recording an event is inlined and disables interrupts for about 50 cycles (3 us): the
+ * Timer 0 reads, one 8-byte store and the index update, with no call.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+#include <FEHDefines.h>
+
+#define TRACE_MAGIC 0x46454854UL // "FEHT"
+#define TRACE_REASON_LENGTH 24
+
+#if (TRACE_ENTRIES & (TRACE_ENTRIES - 1)) != 0 || TRACE_ENTRIES > 128
+#error "TRACE_ENTRIES must be a power of two, at most 128"
+#endif
+
+typedef enum
+{
+    TRACE_BOOT = 1, ///< Start of a run, arg = reset flags (MCUSR bits, 0 if unknown)
+    TRACE_DISPATCH, ///< Scheduler event, value = callback address (a word address on AVR)
+    TRACE_FAULT,    ///< Fault lines seen by the health check, arg = TRACE_FAULT_* bits
+    TRACE_RESET,    ///< _softwareReset() about to be called, arg = TraceResetReason
+    TRACE_KILL,     ///< Robot killed, reason in the ring's reason string
+    TRACE_FATAL,    ///< Fatal error, message in the ring's reason string
+    TRACE_ESP32_RX, ///< Frame from the ESP32, arg = command, value = frame length
+    TRACE_ESP32_TX, ///< Command to the ESP32, arg = command, value = data length
+    TRACE_MARK,     ///< FEHTrace::mark(), arg = id, value = value
+} TraceType;
+
+#define TRACE_FAULT_I2C 0x01
+#define TRACE_FAULT_IO 0x02
+
+typedef enum
+{
+    TRACE_RESET_SHIELD_OFF = 1, ///< Both fault lines, or the ESP32 kill line with no battery
+    TRACE_RESET_UPDATE,         ///< Handing an application update to the bootloader
+} TraceResetReason;
+
+struct TraceEntry
+{
+    uint32_t time;
+    uint8_t type;
+    uint8_t arg;
+    uint16_t value;
+};
+
+struct TraceRing
+{
+    uint32_t magic;
+    uint8_t head;  // Next entry to write
+    uint8_t count; // Entries written, up to TRACE_ENTRIES
+    char reason[TRACE_REASON_LENGTH];
+    TraceEntry entries[TRACE_ENTRIES];
+};
+
+extern TraceRing _traceRing;
+
+/* Defined by the Arduino core (wiring.c) and incremented by its Timer 0 overflow ISR */
+extern volatile unsigned long timer0_overflow_count;
+
+/**
+ * @brief Append an event to the ring. Safe to call from interrupts.
+ */
+static inline void _traceEvent(uint8_t type, uint8_t arg = 0, uint16_t value = 0)
+{
+    uint8_t oldSREG = SREG;
+    cli();
+    uint32_t overflows = timer0_overflow_count;
+    uint8_t ticks = TCNT0;
+    /* The counter wrapped but the ISR has not run yet, as in TimeNowMicros() */
+    if ((TIFR0 & bit(TOV0)) && ticks < 255)
+    {
+        overflows++;
+    }
+    /* Masked here as well, in case the ring is still noise from a power-on */
+    TraceEntry &e = _traceRing.entries[_traceRing.head & (TRACE_ENTRIES - 1)];
+    e.time = overflows << 8 | ticks;
+    e.type = type;
+    e.arg = arg;
+    e.value = value;
+    _traceRing.head = (_traceRing.head + 1) & (TRACE_ENTRIES - 1);
+    _traceRing.count += _traceRing.count < TRACE_ENTRIES;
+    SREG = oldSREG;
+}
+
+/**
+ * @brief Keep the message of a kill or fatal error, which the ring's entries have no room for
+ */
+void _traceReason(const char *reason);
+void _traceReason(const __FlashStringHelper *reason);
+
+/**
+ * @brief Check the ring for a run from before this reset. Called once, early in setup().
+ *
+ * If the ring is intact and the reset was not a power-on, it is printed to Serial with the
+ * reset cause and copied for FEHTrace::save(). The ring then starts over with TRACE_BOOT.
+ */
+void _traceBoot();
+
+#endif // TRACE_H
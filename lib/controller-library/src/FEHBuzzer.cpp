@@ -24,6 +24,11 @@
 #define BUZZER_DDR DDRG
 #define BUZZER_MASK bit(5)
 
+/* Buzzer Singleton */
+FEHBuzzer Buzzer;
+
+FEHBuzzer::FEHBuzzer() {}
+
 /* Callback for scheduler */
 static void buzzerOff()
 {
@@ -1,6 +1,13 @@
 #include "../private_include/FEHESP32.h"
+#include "../private_include/recorder.h"
+#include "../private_include/trace.h"
+#include "../private_include/spibus.h"
+#include "../private_include/FEHInternal.h"
 #include <string.h>
 #include <Arduino.h>
+#include <FEHLog.h>
+#include <FEHTime.h>
+#include <avr/eeprom.h>
 
 ESP32Version FEHESP32::s_version = {0, 0, 0, 0xFF};
 bool FEHESP32::s_connected = false;
@@ -18,10 +25,15 @@ bool FEHESP32::s_wifiConnectSuccess = false;
 bool FEHESP32::s_rcsConnected = false;
 ESP32RCSCallback FEHESP32::s_rcsCallback = nullptr;
 uint8_t FEHESP32::s_bleState = BLE_STATE_OFF;
+bool FEHESP32::s_appReady = false;
+uint16_t FEHESP32::s_appPages = 0;
+uint16_t FEHESP32::s_appCrc = 0;
 
 void FEHESP32::init()
 {
     ESP32::init(FEHESP32::handleMessage);
+    // A poll that falls due mid-drawing goes out between the LCD's row bands
+    spiBusSetService(SPI_BUS_ESP32, FEHESP32::servicePoll);
 }
 
 void FEHESP32::begin()
@@ -59,6 +71,10 @@ bool FEHESP32::connectWifi(const char *ssid, const char *password)
     if (ssidLen > 16 || passLen > 16)
         return false;
 
+    // An answer to an earlier attempt must not be taken for this one's
+    s_wifiConnectResult = false;
+    s_wifiConnectSuccess = false;
+
     buf[0] = ssidLen;
     memcpy(&buf[1], ssid, ssidLen);
     buf[1 + ssidLen] = passLen;
@@ -79,6 +95,9 @@ bool FEHESP32::connectWifiFast(const char *ssid, const char *password, const uin
     if (ssidLen > 16 || passLen > 16 || !bssid)
         return false;
 
+    s_wifiConnectResult = false;
+    s_wifiConnectSuccess = false;
+
     uint8_t pos = 0;
     buf[pos++] = ssidLen;
     memcpy(&buf[pos], ssid, ssidLen);
@@ -95,7 +114,7 @@ bool FEHESP32::connectWifiFast(const char *ssid, const char *password, const uin
     // Copy channel
     buf[pos++] = channel;
 
-    Serial.print("FEHESP32::connectWifiFast called with SSID: ");
+    Serial.print(F("FEHESP32::connectWifiFast called with SSID: "));
     Serial.println(ssid);
     return ESP32::sendCommand(CMD_WIFI_CONNECT_FAST, buf, pos);
 }
@@ -119,6 +138,10 @@ bool FEHESP32::connectRCS(char region, const uint8_t *ip, const char *teamKey)
     memcpy(&buf[pos], teamKey, keyLen);
     pos += keyLen;
 
+    if (s_lastAckedCmd == CMD_RCS_CONNECT)
+    {
+        s_lastAckedCmd = 0x00;
+    }
     return ESP32::sendCommand(CMD_RCS_CONNECT, buf, pos);
 }
 
@@ -157,6 +180,60 @@ bool FEHESP32::downloadAndFlash(const char *url)
     return ESP32::sendCommand(CMD_DOWNLOAD_AND_FLASH, buf, 1 + urlLen);
 }
 
+bool FEHESP32::downloadApplication(const char *url)
+{
+    uint8_t buf[33];
+    uint8_t urlLen = strlen(url);
+
+    if (urlLen > 32)
+        return false;
+
+    buf[0] = urlLen;
+    memcpy(&buf[1], url, urlLen);
+
+    // Progress arrives as for downloadAndFlash()
+    s_appReady = false;
+    s_flashing = true;
+    s_flashComplete = false;
+    s_flashError = false;
+    s_flashBytes = 0;
+    s_flashTotal = 0;
+
+    return ESP32::sendCommand(CMD_AVR_DOWNLOAD, buf, 1 + urlLen);
+}
+
+bool FEHESP32::isApplicationReady()
+{
+    return s_appReady;
+}
+
+bool FEHESP32::stageApplication()
+{
+    if (!s_appReady)
+        return false;
+
+    // The bootloader takes the update from here on every reset until it commits
+    uint8_t marker[AVR_UPDATE_MARKER_SIZE] = {AVR_UPDATE_MAGIC,
+                                              (uint8_t)s_appPages,
+                                              (uint8_t)(s_appPages >> 8),
+                                              (uint8_t)s_appCrc,
+                                              (uint8_t)(s_appCrc >> 8),
+                                              (uint8_t)~AVR_UPDATE_MAGIC};
+    eeprom_update_block(marker, (void *)AVR_UPDATE_MARKER_ADDRESS, sizeof(marker));
+    return true;
+}
+
+bool FEHESP32::installApplication()
+{
+    if (!stageApplication())
+        return false;
+
+    // The ESP32 stays powered: the bootloader reads the image from it
+    _traceEvent(TRACE_RESET, TRACE_RESET_UPDATE);
+    _softwareReset();
+    return true;
+}
+
 bool FEHESP32::validatePartition()
 {
     s_partitionValid = false;
@@ -185,6 +262,7 @@ void FEHESP32::reset(bool factoryReset)
     s_wifiConnectSuccess = false;
     s_rcsConnected = false;
     s_bleState = BLE_STATE_OFF;
+    s_appReady = false;
 }
 
 bool FEHESP32::startBLELog(const char *deviceName)
@@ -294,16 +372,18 @@ bool FEHESP32::waitForAck(uint8_t cmdId, uint32_t timeoutMs)
     // Reset ACK state before waiting
     s_lastAckedCmd = 0x00;
 
-    unsigned long startTime = millis();
-    while (millis() - startTime < timeoutMs)
+    Deadline timeout = Deadline::InMillis(timeoutMs);
+    while (!timeout.Expired())
     {
         poll();
         if (s_lastAckedCmd == cmdId)
         {
+            FEH_LOG_TRACE(ESP32, "ack 0x%02x", cmdId);
             return true;
         }
         delay(10);
     }
+    FEH_LOG_WARN(ESP32, "no ack for 0x%02x in %lu ms", cmdId, (unsigned long)timeoutMs);
     return false;
 }
 
@@ -313,8 +393,8 @@ bool FEHESP32::waitForWifiConnect(uint32_t timeoutMs)
     s_wifiConnectResult = false;
     s_wifiConnectSuccess = false;
 
-    unsigned long startTime = millis();
-    while (millis() - startTime < timeoutMs)
+    Deadline timeout = Deadline::InMillis(timeoutMs);
+    while (!timeout.Expired())
     {
         poll();
         if (s_wifiConnectResult)
@@ -326,15 +406,29 @@ bool FEHESP32::waitForWifiConnect(uint32_t timeoutMs)
     return false;
 }
 
+bool FEHESP32::hasWifiResult()
+{
+    return s_wifiConnectResult;
+}
+
+bool FEHESP32::isAcked(uint8_t cmdId)
+{
+    return s_lastAckedCmd == cmdId;
+}
+
 void FEHESP32::handleMessage(const uint8_t *msg, uint8_t len)
 {
     // msg includes header: [SYNC][SYNC][CMD][LENGTH][DATA...]
     if (len < 4)
         return;
 
+    _recordFrame(msg, len);
+    _traceEvent(TRACE_ESP32_RX, msg[2], len);
+
     uint8_t cmd = msg[2];
     // uint8_t dataLen = msg[3];
     const uint8_t *data = &msg[4];
+    FEH_LOG_TRACE(ESP32, "rx 0x%02x, %u bytes", cmd, len);
 
     switch (cmd)
     {
@@ -361,7 +455,7 @@ void FEHESP32::handleMessage(const uint8_t *msg, uint8_t len)
         if (len > 4)
         {
             uint8_t dataLen = msg[3];
-            Serial.print("ESP32 DEBUG: ");
+            Serial.print(F("ESP32 DEBUG: "));
             for (uint8_t i = 0; i < dataLen; ++i)
             {
                 Serial.write(data[i]);
@@ -371,6 +465,7 @@ void FEHESP32::handleMessage(const uint8_t *msg, uint8_t len)
         break;
 
     case NOTIFY_WIFI_CONNECTED:
+        FEH_LOG_DEBUG(ESP32, "WiFi connected");
         s_connected = true;
         s_wifiConnectResult = true;
         s_wifiConnectSuccess = true;
@@ -378,6 +473,7 @@ void FEHESP32::handleMessage(const uint8_t *msg, uint8_t len)
 
     case NOTIFY_WIFI_DISCONNECTED:
     case NOTIFY_WIFI_FAILED:
+        FEH_LOG_DEBUG(ESP32, "WiFi %s", cmd == NOTIFY_WIFI_FAILED ? "failed" : "disconnected");
         s_connected = false;
         s_wifiConnectResult = true;
         s_wifiConnectSuccess = false;
@@ -414,6 +510,32 @@ void FEHESP32::handleMessage(const uint8_t *msg, uint8_t len)
         break;
 
     case NOTIFY_FLASH_FAILED:
+        s_flashing = false;
+        s_flashError = true;
+        if (len >= 5)
+        {
+            s_flashErrorCode = data[0];
+        }
+        FEH_LOG_WARN(ESP32, "firmware flash failed, error %u", s_flashErrorCode);
+        break;
+
+    case NOTIFY_AVR_IMAGE_READY:
+        // data = [pages:2][image CRC:2][bytes:4]
+        if (len >= 12)
+        {
+            s_appPages = data[0] | (data[1] << 8);
+            s_appCrc = data[2] | (data[3] << 8);
+            memcpy(&s_flashBytes, &data[4], 4);
+            s_flashTotal = s_flashBytes;
+            s_appReady = s_appPages > 0 && s_appPages <= AVR_UPDATE_MAX_PAGES;
+            s_flashing = false;
+            s_flashComplete = s_appReady;
+            s_flashError = !s_appReady;
+            s_flashErrorCode = s_appReady ? 0 : FLASH_ERROR_INVALID_FIRMWARE_IMAGE;
+        }
+        break;
+
+    case NOTIFY_AVR_IMAGE_FAILED:
         s_flashing = false;
         s_flashError = true;
         if (len >= 5)
@@ -0,0 +1,373 @@
+/**
+ * FEHFormat.cpp
+ *
+ * Compact printf-style formatter. Numbers are converted with 32-bit integer arithmetic;
+ * a float is split into its integer part and its fraction scaled to the precision, so
+ * no floating point printf support is needed.
+ */
+
+#include <FEHFormat.h>
+#include <avr/pgmspace.h>
+#include <math.h>
+#include <string.h>
+
+#define FORMAT_MAX_PRECISION 9
+#define FORMAT_FLOAT_MAX 4294967295.0
+
+static const uint32_t POW10[FORMAT_MAX_PRECISION + 1] = {
+    1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL, 1000000UL, 10000000UL, 100000000UL, 1000000000UL,
+};
+
+struct Output
+{
+    char *next;
+    char *end; // Last byte of the buffer, kept for the terminator
+    int length;
+
+    void put(char c)
+    {
+        if (next < end)
+        {
+            *next++ = c;
+        }
+        length++;
+    }
+
+    void put(const char *s, int n)
+    {
+        while (n-- > 0)
+        {
+            put(*s++);
+        }
+    }
+
+    void putFlash(PGM_P s, int n)
+    {
+        while (n-- > 0)
+        {
+            put(pgm_read_byte(s++));
+        }
+    }
+
+    void pad(char c, int n)
+    {
+        while (n-- > 0)
+        {
+            put(c);
+        }
+    }
+};
+
+struct Spec
+{
+    bool left;
+    bool zero;
+    char sign; // '+', ' ' or 0: what to print before a non-negative number
+    int width;
+    int precision; // -1 if not given
+};
+
+static const char DIGITS_UPPER[] PROGMEM = "0123456789ABCDEF";
+static const char DIGITS_LOWER[] PROGMEM = "0123456789abcdef";
+
+/* Write digits in reverse into the end of buf; returns the first digit */
+static char *reverseDigits(char *end, unsigned long value, uint8_t base, bool upper)
+{
+    PGM_P digits = upper ? DIGITS_UPPER : DIGITS_LOWER;
+    char *p = end;
+    do
+    {
+        *--p = pgm_read_byte(digits + value % base);
+        value /= base;
+    } while (value != 0);
+    return p;
+}
+
+/* Emit [sign][zeros][body][fraction] padded to the field width */
+static void emitNumber(Output &out, const Spec &spec, char sign, const char *body, int bodyLen,
+                       const char *fraction = nullptr, int fractionLen = 0)
+{
+    int len = (sign ? 1 : 0) + bodyLen + fractionLen;
+    int padding = spec.width > len ? spec.width - len : 0;
+
+    if (!spec.left && !spec.zero)
+    {
+        out.pad(' ', padding);
+    }
+    if (sign)
+    {
+        out.put(sign);
+    }
+    if (!spec.left && spec.zero)
+    {
+        out.pad('0', padding);
+    }
+    out.put(body, bodyLen);
+    out.put(fraction, fractionLen);
+    if (spec.left)
+    {
+        out.pad(' ', padding);
+    }
+}
+
+/* Emit @p len characters of @p s, from program memory if @p flash, padded to the field width */
+static void emitText(Output &out, const Spec &spec, const char *s, int len, bool flash = false)
+{
+    int padding = spec.width > len ? spec.width - len : 0;
+    if (!spec.left)
+    {
+        out.pad(' ', padding);
+    }
+    if (flash)
+    {
+        out.putFlash(s, len);
+    }
+    else
+    {
+        out.put(s, len);
+    }
+    if (spec.left)
+    {
+        out.pad(' ', padding);
+    }
+}
+
+static void formatFloat(Output &out, Spec spec, double value)
+{
+    char sign = signbit(value) ? '-' : spec.sign;
+    value = fabs(value);
+
+    if (isnan(value) || isinf(value) || value >= FORMAT_FLOAT_MAX)
+    {
+        spec.zero = false;
+        emitNumber(out, spec, sign, isnan(value) ? "nan" : isinf(value) ? "inf" : "ovf", 3);
+        return;
+    }
+
+    int precision = spec.precision < 0 ? 6 : spec.precision;
+    if (precision > FORMAT_MAX_PRECISION)
+    {
+        precision = FORMAT_MAX_PRECISION;
+    }
+
+    uint32_t whole = (uint32_t)value;
+    uint32_t scale = POW10[precision];
+    uint32_t fraction = (uint32_t)((value - whole) * scale + 0.5);
+    if (fraction >= scale)
+    {
+        fraction -= scale;
+        whole++;
+    }
+
+    char wholeDigits[10];
+    char *wholeEnd = wholeDigits + sizeof(wholeDigits);
+    char *wholeStart = reverseDigits(wholeEnd, whole, 10, false);
+
+    char fractionDigits[1 + FORMAT_MAX_PRECISION];
+    int fractionLen = 0;
+    if (precision > 0)
+    {
+        fractionDigits[0] = '.';
+        for (int i = precision; i > 0; i--)
+        {
+            fractionDigits[i] = '0' + fraction % 10;
+            fraction /= 10;
+        }
+        fractionLen = precision + 1;
+    }
+
+    emitNumber(out, spec, sign, wholeStart, wholeEnd - wholeStart, fractionDigits, fractionLen);
+}
+
+static void formatInteger(Output &out, Spec spec, unsigned long magnitude, char sign, uint8_t base, bool upper)
+{
+    char digits[3 * sizeof(unsigned long)];
+    char *end = digits + sizeof(digits);
+    char *start = reverseDigits(end, magnitude, base, upper);
+    int len = end - start;
+
+    /* An explicit precision is a minimum digit count and turns off zero padding */
+    if (spec.precision >= 0)
+    {
+        spec.zero = false;
+        if (spec.precision == 0 && magnitude == 0)
+        {
+            len = 0;
+        }
+        while (len < spec.precision && start > digits)
+        {
+            *--start = '0';
+            len++;
+        }
+    }
+    emitNumber(out, spec, sign, start, len);
+}
+
+/* The format is read through at() so it can be in RAM or, with @p flash, program memory */
+static int formatText(char *buf, size_t size, const char *fmt, va_list args, bool flash)
+{
+    auto at = [flash](const char *p) -> char { return flash ? (char)pgm_read_byte(p) : *p; };
+
+    char scratch;
+    Output out = {buf, buf + (size ? size - 1 : 0), 0};
+    if (size == 0)
+    {
+        out.next = out.end = &scratch;
+    }
+
+    for (; at(fmt); fmt++)
+    {
+        if (at(fmt) != '%')
+        {
+            out.put(at(fmt));
+            continue;
+        }
+
+        Spec spec = {false, false, 0, 0, -1};
+        for (;;)
+        {
+            char c = at(++fmt);
+            if (c == '-')
+                spec.left = true;
+            else if (c == '0')
+                spec.zero = true;
+            else if (c == '+')
+                spec.sign = '+';
+            else if (c == ' ' && spec.sign != '+')
+                spec.sign = ' ';
+            else
+                break;
+        }
+
+        if (at(fmt) == '*')
+        {
+            spec.width = va_arg(args, int);
+            if (spec.width < 0)
+            {
+                spec.left = true;
+                spec.width = -spec.width;
+            }
+            fmt++;
+        }
+        while (at(fmt) >= '0' && at(fmt) <= '9')
+        {
+            spec.width = spec.width * 10 + (at(fmt++) - '0');
+        }
+
+        if (at(fmt) == '.')
+        {
+            fmt++;
+            spec.precision = 0;
+            if (at(fmt) == '*')
+            {
+                spec.precision = va_arg(args, int);
+                fmt++;
+            }
+            while (at(fmt) >= '0' && at(fmt) <= '9')
+            {
+                spec.precision = spec.precision * 10 + (at(fmt++) - '0');
+            }
+        }
+
+        bool isLong = false;
+        while (at(fmt) == 'l' || at(fmt) == 'h')
+        {
+            isLong |= at(fmt) == 'l';
+            fmt++;
+        }
+
+        switch (at(fmt))
+        {
+        case 'd':
+        case 'i':
+        {
+            long value = isLong ? va_arg(args, long) : va_arg(args, int);
+            unsigned long magnitude = value < 0 ? 0UL - (unsigned long)value : (unsigned long)value;
+            formatInteger(out, spec, magnitude, value < 0 ? '-' : spec.sign, 10, false);
+            break;
+        }
+        case 'u':
+        case 'x':
+        case 'X':
+        {
+            unsigned long value = isLong ? va_arg(args, unsigned long) : va_arg(args, unsigned int);
+            formatInteger(out, spec, value, 0, at(fmt) == 'u' ? 10 : 16, at(fmt) == 'X');
+            break;
+        }
+        case 'c':
+        {
+            char c = (char)va_arg(args, int);
+            emitText(out, spec, &c, 1);
+            break;
+        }
+        case 's':
+        case 'S':
+        {
+            // %S takes a string in program memory, as with avr-libc's printf
+            bool inFlash = at(fmt) == 'S';
+            const char *s = va_arg(args, const char *);
+            if (s == nullptr)
+            {
+                s = PSTR("(null)");
+                inFlash = true;
+            }
+            int len = 0;
+            while ((inFlash ? pgm_read_byte(s + len) : s[len]) && (spec.precision < 0 || len < spec.precision))
+            {
+                len++;
+            }
+            emitText(out, spec, s, len, inFlash);
+            break;
+        }
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+            formatFloat(out, spec, va_arg(args, double));
+            break;
+        case '%':
+            out.put('%');
+            break;
+        case '\0':
+            fmt--; // Lone '%' at the end
+            break;
+        default:
+            out.put('%');
+            out.put(at(fmt));
+            break;
+        }
+    }
+
+    *out.next = '\0';
+    return out.length;
+}
+
+int FormatTextV(char *buf, size_t size, const char *fmt, va_list args)
+{
+    return formatText(buf, size, fmt, args, false);
+}
+
+int FormatTextV_P(char *buf, size_t size, const char *fmt, va_list args)
+{
+    return formatText(buf, size, fmt, args, true);
+}
+
+int FormatText(char *buf, size_t size, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    int n = FormatTextV(buf, size, fmt, args);
+    va_end(args);
+    return n;
+}
+
+int FormatText_P(char *buf, size_t size, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    int n = FormatTextV_P(buf, size, fmt, args);
+    va_end(args);
+    return n;
+}
@@ -0,0 +1,292 @@
+/**
+ * FEHI2C.cpp
+ *
+ * TWI master driven from TWI_vect. Each interrupt handles one bus event (START sent,
+ * address or data byte acknowledged, byte received) and starts the next, so a 10-byte
+ * register read costs the CPU a dozen short interrupts instead of a busy-wait for the
+ * whole transfer. The status codes are those of util/twi.h.
+ */
+
+#include <Arduino.h>
+#include <FEHI2C.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <util/twi.h>
+
+// wait() gives up on a transaction after this long without completion
+#define I2C_WAIT_TIMEOUT_US 25000UL
+
+// SCL frequency = F_CPU / (16 + 2 * TWBR) with the prescaler at 1
+#define I2C_TWBR(hz) ((F_CPU / (hz) - 16) / 2)
+
+static FEHI2CTransaction *volatile s_head = nullptr; // On the bus
+static FEHI2CTransaction *s_tail = nullptr;
+static uint8_t s_index;        // Next byte of the current phase
+static bool s_reading;         // In the read phase
+static volatile uint16_t s_events; // Bus events handled, for checkStalled()
+static uint16_t s_lastEvents;
+static unsigned long s_recoveries;
+
+static inline void twiCommand(uint8_t bits)
+{
+    TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWIE) | bits;
+}
+
+static void startTransaction(FEHI2CTransaction *t)
+{
+    TWBR = t->speed == I2C_FAST ? I2C_TWBR(400000UL) : I2C_TWBR(100000UL);
+    s_index = 0;
+    s_reading = t->writeLength == 0 && t->readLength > 0;
+    s_events++;
+    twiCommand(_BV(TWSTA));
+}
+
+/* STOP, then hand the transaction back and start the next one. Interrupts are off. */
+static void finish(FEHI2CStatus status)
+{
+    FEHI2CTransaction *t = s_head;
+
+    TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWSTO);
+    while (TWCR & _BV(TWSTO))
+    {
+    }
+
+    s_head = t->next;
+    if (s_head == nullptr)
+    {
+        s_tail = nullptr;
+    }
+    t->next = nullptr;
+    t->status = status;
+    if (t->callback)
+    {
+        t->callback(t);
+    }
+
+    if (s_head)
+    {
+        startTransaction(s_head);
+    }
+}
+
+/* One bus event; called from TWI_vect, or from wait() with interrupts off */
+static void twiEvent()
+{
+    FEHI2CTransaction *t = s_head;
+    s_events++;
+    if (t == nullptr)
+    {
+        TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWSTO);
+        return;
+    }
+
+    switch (TW_STATUS)
+    {
+    case TW_START:
+    case TW_REP_START:
+        TWDR = (t->address << 1) | (s_reading ? TW_READ : TW_WRITE);
+        twiCommand(0);
+        break;
+
+    case TW_MT_SLA_ACK:
+    case TW_MT_DATA_ACK:
+        if (s_index < t->writeLength)
+        {
+            TWDR = t->writeData[s_index++];
+            twiCommand(0);
+        }
+        else if (t->readLength > 0)
+        {
+            s_reading = true;
+            s_index = 0;
+            twiCommand(_BV(TWSTA));
+        }
+        else
+        {
+            finish(I2C_OK);
+        }
+        break;
+
+    case TW_MR_SLA_ACK:
+        twiCommand(t->readLength > 1 ? _BV(TWEA) : 0);
+        break;
+
+    case TW_MR_DATA_ACK:
+        t->readData[s_index++] = TWDR;
+        twiCommand(s_index + 1 < t->readLength ? _BV(TWEA) : 0);
+        break;
+
+    case TW_MR_DATA_NACK:
+        t->readData[s_index++] = TWDR;
+        finish(I2C_OK);
+        break;
+
+    case TW_MT_SLA_NACK:
+    case TW_MR_SLA_NACK:
+        finish(I2C_NACK_ADDRESS);
+        break;
+
+    case TW_MT_DATA_NACK:
+        finish(I2C_NACK_DATA);
+        break;
+
+    case TW_MT_ARB_LOST:
+        // Another master won: send START again once the bus is free
+        s_index = 0;
+        s_reading = t->writeLength == 0 && t->readLength > 0;
+        twiCommand(_BV(TWSTA));
+        break;
+
+    default: // TW_BUS_ERROR
+        finish(I2C_BUS_ERROR);
+        break;
+    }
+}
+
+ISR(TWI_vect)
+{
+    twiEvent();
+}
+
+void FEHI2C::begin()
+{
+    // Internal pull-ups on SDA and SCL, as Wire does; the shield adds external ones
+    digitalWrite(SDA, HIGH);
+    digitalWrite(SCL, HIGH);
+    TWSR = 0; // Prescaler 1
+    TWBR = I2C_TWBR(100000UL);
+    TWCR = _BV(TWEN) | _BV(TWIE);
+}
+
+bool FEHI2C::submit(FEHI2CTransaction &transaction)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (transaction.status == I2C_PENDING)
+        {
+            return false;
+        }
+        transaction.status = I2C_PENDING;
+        transaction.next = nullptr;
+        if (s_head == nullptr)
+        {
+            s_head = s_tail = &transaction;
+            startTransaction(&transaction);
+        }
+        else
+        {
+            s_tail->next = &transaction;
+            s_tail = &transaction;
+        }
+    }
+    return true;
+}
+
+FEHI2CStatus FEHI2C::wait(FEHI2CTransaction &transaction)
+{
+    unsigned long waited = 0;
+    while (transaction.status == I2C_PENDING)
+    {
+        // With interrupts off nothing else will run the bus
+        if (!(SREG & _BV(SREG_I)) && (TWCR & _BV(TWINT)))
+        {
+            twiEvent();
+            continue;
+        }
+        if (waited++ >= I2C_WAIT_TIMEOUT_US)
+        {
+            recoverBus(I2C_TIMEOUT);
+            break;
+        }
+        delayMicroseconds(1);
+    }
+    return transaction.status;
+}
+
+FEHI2CStatus FEHI2C::transfer(uint8_t address, const uint8_t *writeData, uint8_t writeLength, uint8_t *readData,
+                              uint8_t readLength, FEHI2CSpeed speed)
+{
+    FEHI2CTransaction t(address, writeData, writeLength, readData, readLength, speed);
+    submit(t);
+    return wait(t);
+}
+
+FEHI2CStatus FEHI2C::writeRegister(uint8_t address, uint8_t reg, uint8_t value, FEHI2CSpeed speed)
+{
+    uint8_t data[2] = {reg, value};
+    return transfer(address, data, 2, nullptr, 0, speed);
+}
+
+FEHI2CStatus FEHI2C::readRegisters(uint8_t address, uint8_t reg, uint8_t *data, uint8_t length, FEHI2CSpeed speed)
+{
+    return transfer(address, &reg, 1, data, length, speed);
+}
+
+bool FEHI2C::recoverBus(FEHI2CStatus status)
+{
+    bool free;
+    FEHI2CTransaction *failed;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        TWCR = 0;
+        failed = s_head;
+        s_head = s_tail = nullptr;
+
+        // A device stuck mid-byte releases SDA after at most 9 clocks
+        pinMode(SDA, INPUT_PULLUP);
+        for (uint8_t i = 0; i < 9 && digitalRead(SDA) == LOW; i++)
+        {
+            pinMode(SCL, OUTPUT);
+            digitalWrite(SCL, LOW);
+            delayMicroseconds(5);
+            pinMode(SCL, INPUT_PULLUP);
+            delayMicroseconds(5);
+        }
+
+        // STOP: SDA rises while SCL is high
+        pinMode(SDA, OUTPUT);
+        digitalWrite(SDA, LOW);
+        delayMicroseconds(5);
+        pinMode(SDA, INPUT_PULLUP);
+        delayMicroseconds(5);
+        free = digitalRead(SDA) == HIGH;
+
+        s_recoveries++;
+        s_lastEvents = s_events;
+        begin();
+
+        // Fail what was queued only now, so callbacks can submit again
+        while (failed)
+        {
+            FEHI2CTransaction *next = failed->next;
+            failed->next = nullptr;
+            failed->status = status;
+            if (failed->callback)
+            {
+                failed->callback(failed);
+            }
+            failed = next;
+        }
+    }
+    return free;
+}
+
+bool FEHI2C::checkStalled()
+{
+    bool stalled;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        stalled = s_head != nullptr && s_events == s_lastEvents;
+        s_lastEvents = s_events;
+    }
+    if (stalled)
+    {
+        recoverBus(I2C_TIMEOUT);
+    }
+    return stalled;
+}
+
+unsigned long FEHI2C::recoveries()
+{
+    return s_recoveries;
+}
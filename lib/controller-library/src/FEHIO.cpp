@@ -8,6 +8,8 @@
 
 #include <FEH.h>
 #include "../private_include/FEHInternal.h"
+#include "../private_include/scheduler.h"
+#include "../private_include/recorder.h"
 #include <Arduino.h>
 #include <avr/interrupt.h>
 #include <util/atomic.h>
@@ -16,23 +18,24 @@ DigitalInputPin::DigitalInputPin(FEHIO::FEHIOPin pin, bool usePullup)
 {
     if ((uint8_t)pin > 15)
     {
-        _fatalError("DigitalInputPin:\npin out of range");
+        _fatalError(F("DigitalInputPin:\npin out of range"));
     }
 
+    _fehPin = pin;
     _arduinoPin = pgm_read_byte(FEHIOPIN_TO_ARDUINOPIN + pin);
     pinMode(_arduinoPin, usePullup ? INPUT_PULLUP : INPUT);
 }
 
 bool DigitalInputPin::Value()
 {
-    return digitalRead(_arduinoPin);
+    return _recordInput(RECORD_DIGITAL, _arduinoPin, digitalRead(_arduinoPin));
 }
 
 DigitalOutputPin::DigitalOutputPin(FEHIO::FEHIOPin pin)
 {
     if ((uint8_t)pin > 15)
     {
-        _fatalError("DigitalOutputPin: \npin out of range");
+        _fatalError(F("DigitalOutputPin: \npin out of range"));
     }
    _arduinoPin = pgm_read_byte(FEHIOPIN_TO_ARDUINOPIN + pin);
    pinMode(_arduinoPin, OUTPUT);
@@ -58,21 +61,21 @@ AnalogInputPin::AnalogInputPin(FEHIO::FEHIOPin pin, bool usePullup)
 {
     if ((uint8_t)pin > 15)
     {
-        _fatalError("AnalogInputPin:\npin out of range");
+        _fatalError(F("AnalogInputPin:\npin out of range"));
     }
 
     if (!pgm_read_byte(FEHIOPIN_VALID_ANALOG_PINS + pin))
     {
         char msg[128];
-        snprintf(
+        snprintf_P(
             msg, 128,
-            "AnalogInputPin:\n"
-            "\n"
-            "Attemped to use\n"
-            "non-analog pin %d.\n"
-            "\n"
-            "Valid analog pins are:\n"
-            "0-14.\n",
+            PSTR("AnalogInputPin:\n"
+                 "\n"
+                 "Attemped to use\n"
+                 "non-analog pin %d.\n"
+                 "\n"
+                 "Valid analog pins are:\n"
+                 "0-14.\n"),
             pin);
 
         _fatalError(msg);
@@ -84,15 +87,21 @@ AnalogInputPin::AnalogInputPin(FEHIO::FEHIOPin pin, bool usePullup)
 
 float AnalogInputPin::Value()
 {
+    /* The scheduler ISR reads the battery; a conversion it interrupts would return that channel */
+    int raw;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        raw = analogRead(_arduinoPin);
+    }
     /* Arduino ADC is 10-bit by default */
-    return analogRead(_arduinoPin) * (5.0 / 1023.0);
+    return _recordInput(RECORD_ANALOG, _arduinoPin, raw) * (5.0 / 1023.0);
 }
 
 DigitalQuadratureEncoder::DigitalQuadratureEncoder(FEHIO::FEHIOPin pinA, FEHIO::FEHIOPin pinB)
 {
     if ((uint8_t)pinA > 15 || (uint8_t)pinB > 15)
     {
-        _fatalError("DigitalQuadratureEncoder:\npin out of range");
+        _fatalError(F("DigitalQuadratureEncoder:\npin out of range"));
     }
 
     // Throw a fatal error if the pins are not valid interrupt pins
@@ -100,15 +109,15 @@ DigitalQuadratureEncoder::DigitalQuadratureEncoder(FEHIO::FEHIOPin pinA, FEHIO::
         !pgm_read_byte(FEHIOPIN_VALID_INTERRUPT_PINS + pinB))
     {
         char msg[128];
-        snprintf(
+        snprintf_P(
             msg, 128,
-            "DigitalQuadratureEncoder:\n"
-            "\n"
-            "Attemped to use\n"
-            "non-interrupt pin %d or %d.\n"
-            "\n"
-            "Valid interrupt pins are:\n"
-            "8-14.\n",
+            PSTR("DigitalQuadratureEncoder:\n"
+                 "\n"
+                 "Attemped to use\n"
+                 "non-interrupt pin %d or %d.\n"
+                 "\n"
+                 "Valid interrupt pins are:\n"
+                 "8-14.\n"),
             pinA,
             pinB);
 
@@ -118,6 +127,7 @@ DigitalQuadratureEncoder::DigitalQuadratureEncoder(FEHIO::FEHIOPin pinA, FEHIO::
     pinMode(pgm_read_byte(FEHIOPIN_TO_ARDUINOPIN + pinA), INPUT_PULLUP);
     pinMode(pgm_read_byte(FEHIOPIN_TO_ARDUINOPIN + pinB), INPUT_PULLUP);
 
+    _pinA = pinA;
     _encoder = new Encoder(
         pgm_read_byte(FEHIOPIN_TO_ARDUINOPIN + pinA),
         pgm_read_byte(FEHIOPIN_TO_ARDUINOPIN + pinB));
@@ -127,7 +137,7 @@ DigitalQuadratureEncoder::DigitalQuadratureEncoder(FEHIO::FEHIOPin pinA, FEHIO::
 
 int DigitalQuadratureEncoder::Counts()
 {
-    return _encoder->read();
+    return _recordInput(RECORD_ENCODER, _pinA, _encoder->read());
 }
 
 void DigitalQuadratureEncoder::ResetCounts()
@@ -148,22 +158,22 @@ DigitalEncoder::DigitalEncoder(FEHIO::FEHIOPin pin)
 {
     if ((uint8_t)pin > 15)
     {
-        _fatalError("DigitalEncoder:\npin out of range");
+        _fatalError(F("DigitalEncoder:\npin out of range"));
     }
 
     // Throw a fatal error if the pin is not a valid interrupt pin
     if (!pgm_read_byte(FEHIOPIN_VALID_INTERRUPT_PINS + pin))
     {
         char msg[128];
-        snprintf(
+        snprintf_P(
             msg, 128,
-            "DigitalEncoder:\n"
-            "\n"
-            "Attemped to use\n"
-            "non-interrupt pin %d.\n"
-            "\n"
-            "Valid interrupt pins are:\n"
-            "8-14.\n",
+            PSTR("DigitalEncoder:\n"
+                 "\n"
+                 "Attemped to use\n"
+                 "non-interrupt pin %d.\n"
+                 "\n"
+                 "Valid interrupt pins are:\n"
+                 "8-14.\n"),
             pin);
 
         _fatalError(msg);
@@ -195,14 +205,334 @@ DigitalEncoder::DigitalEncoder(FEHIO::FEHIOPin pin)
     sei();
 }
 
-// ISR for all digital encoders
+/*
+ * Digital input events.
+ *
+ * Pins 8-14 (port K) share the PCINT2 interrupt with DigitalEncoder. An edge is accepted as soon as it
+ * arrives unless the pin is still inside the debounce window of its previous accepted edge, so the
+ * event carries the timestamp of the first edge of a contact and the chatter after it is ignored.
+ *
+ * All other pins are sampled from the scheduler about once per millisecond, and a new level is accepted
+ * once it has been seen for debounceMs consecutive samples. The scheduler tick also re-checks the
+ * interrupt pins so a release that happens inside the debounce window is not lost.
+ *
+ * Both producers run in interrupt context, and the main thread is the only consumer of a ring with
+ * 8-bit indices. An ISR that re-enables interrupts (FEHPeriodic) lets one producer preempt the other,
+ * so eventAccept() runs with interrupts off and the ring keeps a single producer at a time.
+ */
+
+#define EVENT_QUEUE_SIZE 16 // Must be a power of two
+#define EVENT_SAMPLE_MS 1
+#define EVENT_MAX_DEBOUNCE_MS 50
+
+static DigitalInputEvent _eventQueue[EVENT_QUEUE_SIZE];
+static volatile uint8_t _eventHead = 0; // Written by eventAccept() only
+static volatile uint8_t _eventTail = 0; // Written by the main thread only
+static volatile unsigned int _eventsDropped = 0;
+
+// Per student pin state, indexed by FEHIO pin number
+static volatile uint16_t _eventEnabled = 0;     // Pins with events enabled
+static volatile uint16_t _eventStable = 0xFFFF; // Debounced level of each pin
+static volatile uint8_t *_eventInputReg[NUM_STUDENT_GPIO];
+static uint8_t _eventBitMask[NUM_STUDENT_GPIO];
+static uint8_t _eventDebounceMs[NUM_STUDENT_GPIO];
+static uint8_t _eventPendingSamples[NUM_STUDENT_GPIO]; // Consecutive samples that disagreed with _eventStable
+static unsigned long _eventFirstSeen[NUM_STUDENT_GPIO]; // micros() of the first disagreeing sample
+static unsigned long _eventLastAccepted[NUM_STUDENT_GPIO];
+
+// Port K pins (student pins 8-14) with events enabled
+static volatile uint8_t _event_isr_mask = 0;
+static volatile bool _eventSamplerRunning = false;
+
+static void eventPush(uint8_t pin, bool level, unsigned long timeMicros)
+{
+    uint8_t head = _eventHead;
+    if ((uint8_t)(head - _eventTail) >= EVENT_QUEUE_SIZE)
+    {
+        _eventsDropped++;
+        return;
+    }
+
+    DigitalInputEvent &e = _eventQueue[head & (EVENT_QUEUE_SIZE - 1)];
+    e.pin = (FEHIO::FEHIOPin)pin;
+    e.pressed = !level;
+    e.timeMicros = timeMicros;
+
+    /* Publish the event only after it is fully written */
+    _eventHead = head + 1;
+}
+
+static void eventAccept(uint8_t pin, bool level, unsigned long timeMicros)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (level)
+        {
+            _eventStable |= (1U << pin);
+        }
+        else
+        {
+            _eventStable &= ~(1U << pin);
+        }
+        _eventLastAccepted[pin] = timeMicros;
+        _eventPendingSamples[pin] = 0;
+        eventPush(pin, level, timeMicros);
+    }
+}
+
+/* Called from the PCINT2 ISR with the port K pins that changed and have events enabled */
+static void eventPortKEdge(uint8_t changed, uint8_t state)
+{
+    unsigned long now = micros();
+
+    for (uint8_t bitIndex = 0; bitIndex < 7; bitIndex++)
+    {
+        if (!(changed & (1 << bitIndex)))
+        {
+            continue;
+        }
+
+        uint8_t pin = bitIndex + 8;
+        bool level = state & (1 << bitIndex);
+        bool stable = _eventStable & (1U << pin);
+
+        if (level != stable && now - _eventLastAccepted[pin] >= _eventDebounceMs[pin] * 1000UL)
+        {
+            eventAccept(pin, level, now);
+        }
+    }
+}
+
+/* Scheduler callback: samples non-interrupt pins and settles interrupt pins */
+static void eventSample()
+{
+    uint16_t enabled = _eventEnabled;
+    if (enabled == 0)
+    {
+        _eventSamplerRunning = false;
+        return;
+    }
+
+    unsigned long now = micros();
+
+    for (uint8_t pin = 0; pin < NUM_STUDENT_GPIO; pin++)
+    {
+        if (!(enabled & (1U << pin)))
+        {
+            continue;
+        }
+
+        bool level = *_eventInputReg[pin] & _eventBitMask[pin];
+        bool stable = _eventStable & (1U << pin);
+
+        if (level == stable)
+        {
+            _eventPendingSamples[pin] = 0;
+            continue;
+        }
+
+        if (pgm_read_byte(FEHIOPIN_VALID_INTERRUPT_PINS + pin))
+        {
+            /* The edge itself was ignored inside the debounce window; accept the level once it expires */
+            if (now - _eventLastAccepted[pin] >= _eventDebounceMs[pin] * 1000UL)
+            {
+                eventAccept(pin, level, now);
+            }
+        }
+        else
+        {
+            if (_eventPendingSamples[pin] == 0)
+            {
+                _eventFirstSeen[pin] = now;
+            }
+
+            if (++_eventPendingSamples[pin] >= _eventDebounceMs[pin] / EVENT_SAMPLE_MS)
+            {
+                eventAccept(pin, level, _eventFirstSeen[pin]);
+            }
+        }
+    }
+
+    /* A full queue stops the sampler; _eventService() restarts it from the main thread */
+    if (!scheduleEvent(eventSample, schedulerMsToTicks(EVENT_SAMPLE_MS)))
+    {
+        _eventSamplerRunning = false;
+    }
+}
+
+bool _eventService()
+{
+    // Retrying into a full queue would only log another dropped event
+    if (_eventSamplerRunning || _eventEnabled == 0 || !schedulerHasRoom())
+    {
+        return false;
+    }
+    bool restarted;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        restarted = scheduleEvent(eventSample, schedulerMsToTicks(EVENT_SAMPLE_MS));
+        _eventSamplerRunning = restarted;
+    }
+    if (restarted)
+    {
+        FEH_LOG_WARN(SCHEDULER, "input event sampler restarted");
+    }
+    return restarted;
+}
+
+void DigitalInputPin::EnableEvents(unsigned int debounceMs)
+{
+    if (debounceMs < EVENT_SAMPLE_MS)
+    {
+        debounceMs = EVENT_SAMPLE_MS;
+    }
+    else if (debounceMs > EVENT_MAX_DEBOUNCE_MS)
+    {
+        debounceMs = EVENT_MAX_DEBOUNCE_MS;
+    }
+
+    uint8_t pin = _fehPin;
+    uint8_t port = digitalPinToPort(_arduinoPin);
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        _eventInputReg[pin] = portInputRegister(port);
+        _eventBitMask[pin] = digitalPinToBitMask(_arduinoPin);
+        _eventDebounceMs[pin] = debounceMs;
+        _eventPendingSamples[pin] = 0;
+        _eventLastAccepted[pin] = micros() - debounceMs * 1000UL;
+
+        /* Start from the current level so enabling does not produce an event */
+        if (*_eventInputReg[pin] & _eventBitMask[pin])
+        {
+            _eventStable |= (1U << pin);
+        }
+        else
+        {
+            _eventStable &= ~(1U << pin);
+        }
+
+        _eventEnabled |= (1U << pin);
+
+        if (pgm_read_byte(FEHIOPIN_VALID_INTERRUPT_PINS + pin))
+        {
+            uint8_t portKpin = pin - 8;
+            _event_isr_mask |= (1 << portKpin);
+            _portK_last_state = PINK;
+            PCICR |= (1 << PCIE2);
+            PCMSK2 |= (1 << portKpin);
+        }
+    }
+
+    if (!_eventSamplerRunning)
+    {
+        _eventSamplerRunning = scheduleEvent(eventSample, schedulerMsToTicks(EVENT_SAMPLE_MS));
+    }
+}
+
+void DigitalInputPin::DisableEvents()
+{
+    uint8_t pin = _fehPin;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        _eventEnabled &= ~(1U << pin);
+
+        if (pgm_read_byte(FEHIOPIN_VALID_INTERRUPT_PINS + pin))
+        {
+            uint8_t portKpin = pin - 8;
+            _event_isr_mask &= ~(1 << portKpin);
+
+            /* Leave the interrupt on if a DigitalEncoder still uses this pin */
+            if (!(_encoder_isr_mask & (1 << portKpin)))
+            {
+                PCMSK2 &= ~(1 << portKpin);
+            }
+        }
+    }
+}
+
+bool DigitalInputPin::DebouncedValue()
+{
+    if (!(_eventEnabled & (1U << _fehPin)))
+    {
+        return Value();
+    }
+    return _recordInput(RECORD_DIGITAL, _arduinoPin, (bool)(_eventStable & (1U << _fehPin)));
+}
+
+/*
+ * Passes a NextEvent() result through the recorder as one value: -1 for no event, otherwise
+ * the pin, the pressed flag, and how long ago the event happened (26 bits of microseconds).
+ */
+static bool eventRecord(DigitalInputEvent *event, bool found)
+{
+    unsigned long now = micros();
+    int32_t packed = -1;
+    if (found)
+    {
+        unsigned long age = now - event->timeMicros;
+        if (age > 0x3FFFFFFUL)
+        {
+            age = 0x3FFFFFFUL;
+        }
+        packed = (int32_t)(age << 5) | (event->pressed << 4) | event->pin;
+    }
+
+    packed = _recordInput(RECORD_EVENT, 0, packed);
+    if (packed < 0)
+    {
+        return false;
+    }
+
+    event->pin = (FEHIO::FEHIOPin)(packed & 0x0F);
+    event->pressed = packed & 0x10;
+    event->timeMicros = now - ((uint32_t)packed >> 5);
+    return true;
+}
+
+bool DigitalInputPin::NextEvent(DigitalInputEvent *event)
+{
+    bool found = false;
+    uint8_t tail = _eventTail;
+    if (tail != _eventHead)
+    {
+        *event = _eventQueue[tail & (EVENT_QUEUE_SIZE - 1)];
+
+        /* Release the slot only after it has been copied out */
+        _eventTail = tail + 1;
+        found = true;
+    }
+
+    if (_recorderMode != RECORDER_OFF)
+    {
+        found = eventRecord(event, found);
+    }
+    return found;
+}
+
+unsigned int DigitalInputPin::DroppedEvents()
+{
+    unsigned int dropped;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        dropped = _eventsDropped;
+    }
+    return dropped;
+}
+
+// ISR for all digital encoders and port K digital input events
 ISR(PCINT2_vect)
 {
-    // Find the pins that have changed within the mask
-    _pinchange = (PINK ^ _portK_last_state) & _encoder_isr_mask;
+    // Read port K once so encoders and events see the same state
+    uint8_t state = PINK;
+    uint8_t changed = state ^ _portK_last_state;
 
     // store current state of port K
-    _portK_last_state = PINK;
+    _portK_last_state = state;
+
+    // Find the pins that have changed within the mask
+    _pinchange = changed & _encoder_isr_mask;
 
     // Add to the count if the pin has changed
     for (uint8_t i = 0; i < 8; i++)
@@ -212,13 +542,20 @@ ISR(PCINT2_vect)
             digital_encoder_counts[i]++;
         }
     }
+
+    if (changed & _event_isr_mask)
+    {
+        eventPortKEdge(changed & _event_isr_mask, state);
+    }
 }
 
 int DigitalEncoder::Counts()
 {
+    int counts;
     ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
-        return digital_encoder_counts[_portKpin];
+        counts = digital_encoder_counts[_portKpin];
     }
+    return _recordInput(RECORD_ENCODER, _portKpin + 8, counts);
 }
 
 void DigitalEncoder::ResetCounts()
@@ -14,10 +14,16 @@
  */
 
 #include <FEH.h>
+#include <FEHI2C.h>
 #include "../private_include/FEHInternal.h"
 #include "../private_include/scheduler.h"
+#include "../private_include/recorder.h"
+#include "../private_include/trace.h"
 #include "../private_include/FEHESP32.h"
+#include "../private_include/spibus.h"
+#include "../private_include/displaylist.h"
 #include <avr/wdt.h>
+#include <util/atomic.h>
 
 //=============================================================================
 // FORWARD DECLARATIONS
@@ -29,6 +35,7 @@ void initSplashScreen();
 /// @brief Update the status message on the splash screen
 /// @param status Status text to display (centered)
 void updateSplashScreenWithStatus(const char *status);
+void updateSplashScreenWithStatus(const __FlashStringHelper *status);
 
 /// @brief Wait for the ESP32 to be ready by polling for a successful ping response
 /// @param timeout_ms
@@ -38,16 +45,7 @@ bool waitForESP32Ready(unsigned long timeout_ms);
 // SYSTEM UTILITIES
 //=============================================================================
 
-/**
- * @brief Perform software reset using watchdog timer
- *
- * Forces an ATmega2560 reset by enabling the watchdog timer with a short timeout
- * and then waiting for it to expire. This is used to recover from certain fault
- * conditions (e.g., shield power-off while robot is running).
- *
- * @note This function does not return - system will reset
- */
-static void _softwareReset()
+void _softwareReset()
 {
     // Disable watchdog first to ensure clean state
     wdt_disable();
@@ -86,36 +84,70 @@ volatile bool g_esp32PollPending = false;
 static void eventESP32Poll()
 {
     // Never do SPI from an ISR - the LCD may have its CS asserted mid-draw.
-    // Just set a flag; servicePoll() will drain it from the main thread.
+    // Just set a flag; servicePoll() will drain it from the main thread, in Sleep() or
+    // at the LCD's next preemption point.
     g_esp32PollPending = true;
+    spiBusRequest(SPI_BUS_ESP32);
     // 781 ticks = ~50ms at 64µs/tick
     scheduleEvent(eventESP32Poll, 781);
 }
 
+bool _serviceDeferredWork()
+{
+    bool worked = false;
+    if (g_esp32PollPending)
+    {
+        FEHESP32::servicePoll();
+        worked = true;
+    }
+    worked |= schedulerService();
+    worked |= _eventService();
+    worked |= _compensationService();
+    worked |= _rcsService();
+    worked |= _recorderService();
+    displayListFlush();
+    return worked;
+}
+
 static void eventHealthCheck()
 {
     // TODO: Make health checks write to LCD, with concurrency and reentrancy in mind
     // TODO: - Reading motor status lines FAULT_12, FAULT_34
 
+    // Fail and clock free an I2C transaction that has stopped making progress
+    FEHI2C::checkStalled();
+
     // Check hardware fault lines
     bool i2cFault = _I2CFault();
     bool ioFault = _IOFault();
 
+    // An I2C fault on its own may be a device holding the bus: try to free it first
+    if (i2cFault && !ioFault && FEHI2C::recoverBus())
+    {
+        i2cFault = _I2CFault();
+    }
+
+    if (i2cFault || ioFault)
+    {
+        _traceEvent(TRACE_FAULT, (i2cFault ? TRACE_FAULT_I2C : 0) | (ioFault ? TRACE_FAULT_IO : 0));
+    }
+
     if (i2cFault && ioFault)
     {
         // Both faults indicate shield is likely powered off
         // Perform software reset to recover cleanly
+        _traceEvent(TRACE_RESET, TRACE_RESET_SHIELD_OFF);
         _softwareReset();
     }
     else if (i2cFault)
     {
         // I2C fault only - this is a critical error
-        _kill("I2C fault");
+        _kill(F("I2C fault"));
     }
     else if (ioFault)
     {
         // I/O fault only - this is a critical error
-        _kill("IO fault");
+        _kill(F("IO fault"));
     }
 
     // Monitor battery voltage and control warning LED
@@ -179,9 +211,12 @@ void ERCMain(void);
  */
 void setup()
 {
-    Serial.begin(115200);
+    Serial.begin(SERIAL_CONSOLE_BAUD);
+
+    // Print the flight recorder's trace if a reset interrupted the last run
+    _traceBoot();
 
-    Serial.println("FEH Library initializing...");
+    Serial.println(F("FEH Library initializing..."));
 
     //-------------------------------------------------------------------------
     // Phase 1: Pin Configuration
@@ -249,15 +284,15 @@ void setup()
 
     // Display Ohio State splash screen
     initSplashScreen();
-    Serial.println("Initializing splash screen...");
-    updateSplashScreenWithStatus("Starting ESP32...");
+    Serial.println(F("Initializing splash screen..."));
+    updateSplashScreenWithStatus(F("Starting ESP32..."));
 
     //-------------------------------------------------------------------------
     // Phase 5: ESP32 Boot and Firmware Verification
     //-------------------------------------------------------------------------
 
-    Serial.println("Starting ESP32 firmware verification...");
-    updateSplashScreenWithStatus("Connecting to ESP32...");
+    Serial.println(F("Starting ESP32 firmware verification..."));
+    updateSplashScreenWithStatus(F("Connecting to ESP32..."));
 
     FEHESP32::init();
     FEHESP32::begin();
@@ -296,7 +331,7 @@ void setup()
     // If we are running the app partition, first check if the OTA update host wifi network is available
     if (needUpdate)
     {
-        updateSplashScreenWithStatus("ESP32 should update, checking network...");
+        updateSplashScreenWithStatus(F("ESP32 should update, checking network..."));
 
         uint8_t bssid[] = OTA_WIFI_BSSID_BYTES;
         FEHESP32::connectWifiFast(OTA_WIFI_SSID, OTA_WIFI_PASS, bssid, OTA_WIFI_CHANNEL);
@@ -314,7 +349,7 @@ void setup()
         if (runningAppPartition)
         {
             // Factory reset ESP32
-            updateSplashScreenWithStatus("Updating ESP32...");
+            updateSplashScreenWithStatus(F("Updating ESP32..."));
             FEHESP32::reset(true);
 
             // Wait for esp32 to be ready (timeout 2s)
@@ -323,12 +358,12 @@ void setup()
             // Display updater version on splash screen
             ver = FEHESP32::getVersion();
             char statusBuf[64];
-            snprintf(statusBuf, sizeof(statusBuf), "Updater v%d.%d.%d", ver.major, ver.minor, ver.patch);
+            snprintf_P(statusBuf, sizeof(statusBuf), PSTR("Updater v%d.%d.%d"), ver.major, ver.minor, ver.patch);
             updateSplashScreenWithStatus(statusBuf);
             delay(250);
 
             // Connect to WiFi (fast connect using known BSSID and channel)
-            updateSplashScreenWithStatus("Connecting to WiFi...");
+            updateSplashScreenWithStatus(F("Connecting to WiFi..."));
             uint8_t bssid[] = OTA_WIFI_BSSID_BYTES;
             FEHESP32::connectWifiFast(OTA_WIFI_SSID, OTA_WIFI_PASS, bssid, OTA_WIFI_CHANNEL);
             // FEHESP32::connectWifi(OTA_WIFI_SSID, OTA_WIFI_PASS);
@@ -337,8 +372,8 @@ void setup()
             FEHESP32::waitForWifiConnect(5000);
             if (!FEHESP32::isConnected())
             {
-                Serial.println("WiFi Connection Failed");
-                updateSplashScreenWithStatus("WiFi Connection Failed");
+                Serial.println(F("WiFi Connection Failed"));
+                updateSplashScreenWithStatus(F("WiFi Connection Failed"));
                 delay(1000);
             }
         }
@@ -346,23 +381,23 @@ void setup()
         {
             // Display updater version on splash screen
             char statusBuf[64];
-            snprintf(statusBuf, sizeof(statusBuf), "Updater v%d.%d.%d", ver.major, ver.minor, ver.patch);
+            snprintf_P(statusBuf, sizeof(statusBuf), PSTR("Updater v%d.%d.%d"), ver.major, ver.minor, ver.patch);
             updateSplashScreenWithStatus(statusBuf);
             delay(250);
         }
 
         // Download and Flash
-        updateSplashScreenWithStatus("Downloading firmware update...");
+        updateSplashScreenWithStatus(F("Downloading firmware update..."));
         FEHESP32::downloadAndFlash(FIRMWARE_URL);
         // wait for flash progress, 10 second timeout for flash to start
-        unsigned long t0 = millis();
+        Deadline flashStart = Deadline::InMillis(10000);
         while (FEHESP32::getFlashProgress() == 0.0)
         {
             FEHESP32::poll();
             delay(50);
-            if (millis() - t0 > 10000)
+            if (flashStart.Expired())
             {
-                updateSplashScreenWithStatus("Flash timeout");
+                updateSplashScreenWithStatus(F("Flash timeout"));
                 delay(500);
                 break;
             }
@@ -372,33 +407,33 @@ void setup()
         {
             FEHESP32::poll();
             char buf[64];
-            snprintf(buf, sizeof(buf), "Flashing: %d%%", (int)(FEHESP32::getFlashProgress() * 100));
+            snprintf_P(buf, sizeof(buf), PSTR("Flashing: %d%%"), (int)(FEHESP32::getFlashProgress() * 100));
             updateSplashScreenWithStatus(buf);
             delay(50);
         }
 
         if (FEHESP32::hasFlashError())
         {
-            Serial.println("Flash Error");
-            updateSplashScreenWithStatus("Flash Error");
+            Serial.println(F("Flash Error"));
+            updateSplashScreenWithStatus(F("Flash Error"));
             delay(500);
         }
 
         if (!FEHESP32::isFlashComplete())
         {
-            Serial.println("Flash Incomplete");
-            updateSplashScreenWithStatus("Flash Incomplete");
+            Serial.println(F("Flash Incomplete"));
+            updateSplashScreenWithStatus(F("Flash Incomplete"));
             delay(500);
         }
 
         // Validate
-        updateSplashScreenWithStatus("Validating...");
+        updateSplashScreenWithStatus(F("Validating..."));
         FEHESP32::validatePartition();
 
         // Wait for validation response (timeout 5s)
-        t0 = millis();
+        Deadline validation = Deadline::InMillis(5000);
         bool validated = false;
-        while (millis() - t0 < 5000)
+        while (!validation.Expired())
         {
             FEHESP32::poll();
             if (FEHESP32::isPartitionValid())
@@ -411,8 +446,8 @@ void setup()
 
         if (!validated || FEHESP32::getValidatedPartition() != PARTITION_OTA_0)
         {
-            Serial.println("Partition Validation Failed");
-            updateSplashScreenWithStatus("Partition Validation Failed");
+            Serial.println(F("Partition Validation Failed"));
+            updateSplashScreenWithStatus(F("Partition Validation Failed"));
             delay(500);
         }
 
@@ -420,18 +455,18 @@ void setup()
         FEHESP32::setBootPartition(PARTITION_OTA_0);
         if (!FEHESP32::waitForAck(CMD_SET_BOOT_PARTITION, 1000))
         {
-            Serial.println("Set boot partition failed");
-            updateSplashScreenWithStatus("Set boot partition failed");
+            Serial.println(F("Set boot partition failed"));
+            updateSplashScreenWithStatus(F("Set boot partition failed"));
             delay(500);
         }
 
         // Reset
-        updateSplashScreenWithStatus("Rebooting ESP32...");
+        updateSplashScreenWithStatus(F("Rebooting ESP32..."));
         FEHESP32::reset(false);
     }
     else if (needUpdate && !networkAvailable)
     {
-        updateSplashScreenWithStatus("Network Unavailable, continuing with existing firmware...");
+        updateSplashScreenWithStatus(F("Network Unavailable, continuing with existing firmware..."));
         delay(500);
     }
 
@@ -439,10 +474,15 @@ void setup()
 
     ver = FEHESP32::getVersion();
     char statusBuf[64];
-    snprintf(statusBuf, sizeof(statusBuf), "ESP32 Ready v%d.%d.%d", ver.major, ver.minor, ver.patch);
+    snprintf_P(statusBuf, sizeof(statusBuf), PSTR("ESP32 Ready v%d.%d.%d"), ver.major, ver.minor, ver.patch);
     updateSplashScreenWithStatus(statusBuf);
     delay(500);
 
+#if RCS_CONNECT_AT_BOOT
+    // Join the RCS network while the rest of startup and the region menu run
+    RCS.BeginConnect();
+#endif
+
     //-------------------------------------------------------------------------
     // Phase 6: Health Monitoring Setup
     //-------------------------------------------------------------------------
@@ -455,11 +495,13 @@ void setup()
     // Phase 7: Touchscreen Initialization
     //-------------------------------------------------------------------------
 
-    updateSplashScreenWithStatus("Initializing touchscreen...");
+    updateSplashScreenWithStatus(F("Initializing touchscreen..."));
 
-    // Initialize FT6206 capacitive touchscreen controller
+    // Initialize FT6206 capacitive touchscreen controller, which is then read in the
+    // background over the interrupt-driven I2C bus
     // 128 = touch sensitivity threshold
-    FT6206.begin(128, &Wire);
+    FEHI2C::begin();
+    _touchBegin(128);
 
     // Set LCD defaults to match Proteus simulator
     LCD.SetOrientation(FEHLCD::South);
@@ -470,7 +512,7 @@ void setup()
     // Phase 8: Serial Communication
     //-------------------------------------------------------------------------
 
-    updateSplashScreenWithStatus("Starting serial communication...");
+    updateSplashScreenWithStatus(F("Starting serial communication..."));
     // Serial.begin(115200);
 
     //-------------------------------------------------------------------------
@@ -524,7 +566,7 @@ void setup()
     // Phase 10: Motor Driver Enable
     //-------------------------------------------------------------------------
 
-    updateSplashScreenWithStatus("Enabling motors...");
+    updateSplashScreenWithStatus(F("Enabling motors..."));
 
     // Wake motor drivers by asserting nMSLEEP
     // This was originally in motor.cpp but moved here to prevent individual
@@ -536,8 +578,8 @@ void setup()
     // Phase 11: Startup Complete
     //-------------------------------------------------------------------------
 
-    updateSplashScreenWithStatus("Playing startup sound...");
-    Serial.println("FEH Library initialized successfully.");
+    updateSplashScreenWithStatus(F("Playing startup sound..."));
+    Serial.println(F("FEH Library initialized successfully."));
 
     // Play ascending tone sequence to indicate successful initialization
     Buzzer.Tone(Buzzer.NOTE_C5);
@@ -601,6 +643,9 @@ void loop()
 
 void _lcdErrorPrelude()
 {
+    // The message must reach the screen even if the program was only streaming it
+    displayListSetOutput(true, false);
+
     // Safe to call multiple times - reinitializes LCD if needed
     ILI9341.begin();
 
@@ -616,30 +661,30 @@ void _lcdErrorPrelude()
     // Large white "ERROR!" heading
     ILI9341.setTextColor(FEHLCD::White);
     ILI9341.setTextSize(8);
-    ILI9341.println("ERROR!");
+    ILI9341.println(F("ERROR!"));
 
     // Switch to smaller text for error details
     ILI9341.setTextSize(2);
     ILI9341.println(); // Add blank line after heading
 }
 
-bool _checkRange(const char *funcName, const char *valName, int val, int min, int max)
+bool _checkRange(const __FlashStringHelper *funcName, const __FlashStringHelper *valName, int val, int min, int max)
 {
     // Check if value is within valid range [min, max]
     if (val < min || val > max)
     {
         // Print detailed error message to serial console
-        Serial.print("ERROR! ");
+        Serial.print(F("ERROR! "));
         Serial.print(funcName);
-        Serial.print("(): ");
+        Serial.print(F("(): "));
         Serial.print(valName);
-        Serial.print(" out of range. Minimum is ");
+        Serial.print(F(" out of range. Minimum is "));
         Serial.print(min);
-        Serial.print(", maximum is ");
+        Serial.print(F(", maximum is "));
         Serial.print(max);
-        Serial.print(". Value of ");
+        Serial.print(F(". Value of "));
         Serial.print(val);
-        Serial.println(" provided.");
+        Serial.println(F(" provided."));
 
         return false;
     }
@@ -647,7 +692,7 @@ bool _checkRange(const char *funcName, const char *valName, int val, int min, in
     return true;
 }
 
-bool _checkRangeFatal(const char *funcName, const char *valName, int val, int min, int max)
+bool _checkRangeFatal(const __FlashStringHelper *funcName, const __FlashStringHelper *valName, int val, int min, int max)
 {
     // First perform standard range check (prints to serial)
     bool check = _checkRange(funcName, valName, val, min, max);
@@ -659,25 +704,25 @@ bool _checkRangeFatal(const char *funcName, const char *valName, int val, int mi
 
         // Display function name
         LCD.Write(funcName);
-        LCD.WriteLine("(): ");
+        LCD.WriteLine(F("(): "));
 
         // Display parameter name
         LCD.Write(valName);
-        LCD.WriteLine(" out of range.");
+        LCD.WriteLine(F(" out of range."));
         LCD.WriteLine();
 
         // Display valid range
-        LCD.Write("Minimum is ");
+        LCD.Write(F("Minimum is "));
         LCD.Write(min);
-        LCD.WriteLine(".");
-        LCD.Write("Maximum is ");
+        LCD.WriteLine(F("."));
+        LCD.Write(F("Maximum is "));
         LCD.Write(max);
-        LCD.WriteLine(".");
+        LCD.WriteLine(F("."));
 
         // Display invalid value that was provided
-        LCD.Write("Value of ");
+        LCD.Write(F("Value of "));
         LCD.Write(val);
-        LCD.WriteLine(" provided.");
+        LCD.WriteLine(F(" provided."));
 
         // Note: Caller typically calls _killNoScreen() after this
     }
@@ -687,6 +732,9 @@ bool _checkRangeFatal(const char *funcName, const char *valName, int val, int mi
 
 void _fatalError(const char *msg)
 {
+    _traceReason(msg);
+    _traceEvent(TRACE_FATAL);
+
     // Ensure Arduino core is fully initialized
     // This is critical because _fatalError() can be called from global constructors
     // which run BEFORE Arduino's main() function (not ERCMain, but the hidden
@@ -701,10 +749,21 @@ void _fatalError(const char *msg)
     _killNoScreen();
 }
 
+void _fatalError(const __FlashStringHelper *msg)
+{
+    // As above, with the message read from program memory
+    _traceReason(msg);
+    _traceEvent(TRACE_FATAL);
+    init();
+    _lcdErrorPrelude();
+    ILI9341.print(msg);
+    _killNoScreen();
+}
+
 void _fatalError()
 {
     // Call _fatalError() with generic error message
-    _fatalError("Unspecified fatal error.");
+    _fatalError(F("Unspecified fatal error."));
 }
 
 //=============================================================================
@@ -714,7 +773,7 @@ void _fatalError()
 void _kill()
 {
     // Call _kill() with generic message
-    _kill("Unspecified kill.");
+    _kill(F("Unspecified kill."));
 }
 
 void _kill_esp()
@@ -731,18 +790,29 @@ void _kill_esp()
     if (shield_on)
     {
         // Shield is on - this is a legitimate RCS kill command
-        _kill("RCS kill signal");
+        _kill(F("RCS kill signal"));
     }
     else
     {
         // Shield is off - BOOT_SEL went low due to power-down, not a kill
         // Perform software reset to recover cleanly
+        _traceEvent(TRACE_RESET, TRACE_RESET_SHIELD_OFF);
         _softwareReset();
     }
 }
 
+void _kill(const __FlashStringHelper *reason)
+{
+    char text[64];
+    strncpy_P(text, (PGM_P)reason, sizeof(text) - 1);
+    text[sizeof(text) - 1] = '\0';
+    _kill(text);
+}
+
 void _kill(const char *reason)
 {
+    _traceReason(reason);
+
     // First stop motors and disable interrupts without LCD output
     // Pass false to loop parameter so we return and can display kill screen
     _killNoScreen(false);
@@ -758,14 +828,14 @@ void _kill(const char *reason)
 
     // Large "KILLED" heading
     ILI9341.setTextSize(8);
-    ILI9341.println("KILLED");
+    ILI9341.println(F("KILLED"));
 
     // Display instructions and reason
     ILI9341.setTextSize(2);
     ILI9341.println();
-    ILI9341.println("Power cycle to reset.");
+    ILI9341.println(F("Power cycle to reset."));
     ILI9341.println();
-    ILI9341.println("Source:");
+    ILI9341.println(F("Source:"));
     ILI9341.println(reason);
 
     // Loop forever with interrupts disabled
@@ -777,6 +847,8 @@ void _kill(const char *reason)
 
 void _killNoScreen(bool loop, bool tone)
 {
+    _traceEvent(TRACE_KILL);
+
     // Optionally play descending warning tone
     if (tone)
     {
@@ -812,7 +884,14 @@ float _batteryVoltage()
     // Hardware: 12-bit ADC (0-1023), 5V reference voltage
     // Circuit: 3:1 voltage divider on battery input
     // Formula: ADC_value * (5V / 1023) * 3 = ADC_value * (15 / 1023)
-    return analogRead(BATTERY_PIN) * (15.0 / 1023.0);
+    // Called from the main thread as well as the health check, so the conversion must not
+    // be interleaved with the scheduler ISR's battery compensation sample
+    int raw;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        raw = analogRead(BATTERY_PIN);
+    }
+    return _recordInput(RECORD_ANALOG, BATTERY_PIN, raw) * (15.0 / 1023.0);
 }
 
 bool _I2CFault()
@@ -858,9 +937,18 @@ static void drawOhioStateImage(int x, int y)
     unsigned char image[] = {23, 0, 52, 2, 45, 0, 54, 2, 43, 0, 56, 2, 41, 0, 58, 2, 39, 0, 6, 2, 48, 0, 6, 2, 37, 0, 6, 2, 50, 0, 6, 2, 35, 0, 6, 2, 52, 0, 6, 2, 33, 0, 6, 2, 4, 0, 46, 1, 4, 0, 6, 2, 31, 0, 6, 2, 4, 0, 48, 1, 4, 0, 6, 2, 29, 0, 6, 2, 4, 0, 50, 1, 4, 0, 6, 2, 27, 0, 6, 2, 4, 0, 52, 1, 4, 0, 6, 2, 25, 0, 6, 2, 4, 0, 54, 1, 4, 0, 6, 2, 23, 0, 6, 2, 4, 0, 56, 1, 4, 0, 6, 2, 21, 0, 6, 2, 4, 0, 58, 1, 4, 0, 6, 2, 19, 0, 6, 2, 4, 0, 60, 1, 4, 0, 6, 2, 17, 0, 6, 2, 4, 0, 62, 1, 4, 0, 6, 2, 15, 0, 6, 2, 4, 0, 64, 1, 4, 0, 6, 2, 13, 0, 6, 2, 4, 0, 66, 1, 4, 0, 6, 2, 11, 0, 6, 2, 4, 0, 68, 1, 4, 0, 6, 2, 9, 0, 6, 2, 4, 0, 70, 1, 4, 0, 6, 2, 7, 0, 6, 2, 4, 0, 72, 1, 4, 0, 6, 2, 5, 0, 6, 2, 4, 0, 74, 1, 4, 0, 6, 2, 3, 0, 6, 2, 4, 0, 76, 1, 4, 0, 6, 2, 1, 0, 6, 2, 4, 0, 78, 1, 4, 0, 11, 2, 4, 0, 80, 1, 4, 0, 9, 2, 4, 0, 82, 1, 4, 0, 8, 2, 3, 0, 84, 1, 3, 0, 8, 2, 3, 0, 84, 1, 3, 0, 8, 2, 3, 0, 29, 1, 26, 0, 29, 1, 3, 0, 8, 2, 3, 0, 28, 1, 28, 0, 28, 1, 3, 0, 8, 2, 3, 0, 27, 1, 30, 0, 27, 1, 3, 0, 8, 2, 3, 0, 26, 1, 4, 0, 24, 2, 4, 0, 26, 1, 3, 0, 8, 2, 3, 0, 25, 1, 4, 0, 26, 2, 4, 0, 25, 1, 3, 0, 8, 2, 3, 0, 24, 1, 4, 0, 28, 2, 4, 0, 24, 1, 3, 0, 8, 2, 3, 0, 23, 1, 4, 0, 30, 2, 4, 0, 23, 1, 3, 0, 8, 2, 3, 0, 22, 1, 4, 0, 6, 2, 21, 0, 5, 2, 4, 0, 22, 1, 3, 0, 8, 2, 3, 0, 21, 1, 4, 0, 6, 2, 23, 0, 5, 2, 4, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 6, 2, 25, 0, 5, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 5, 2, 27, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 4, 2, 28, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 5, 2, 27, 0, 4, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 3, 0, 6, 2, 25, 0, 5, 2, 3, 0, 21, 1, 3, 0, 8, 2, 3, 0, 21, 1, 4, 0, 6, 2, 23, 0, 5, 2, 4, 0, 21, 1, 3, 0, 8, 2, 3, 0, 22, 1, 4, 0, 6, 2, 21, 0, 5, 2, 4, 0, 22, 1, 3, 0, 8, 2, 3, 0, 23, 1, 4, 0, 30, 2, 4, 0, 23, 1, 3, 0, 8, 2, 3, 0, 24, 1, 4, 0, 28, 2, 4, 0, 24, 1, 3, 0, 8, 2, 3, 0, 25, 1, 4, 0, 26, 2, 4, 0, 25, 1, 3, 0, 8, 2, 3, 0, 26, 1, 4, 0, 24, 2, 4, 0, 26, 1, 3, 0, 8, 2, 3, 0, 27, 1, 30, 0, 27, 1, 3, 0, 8, 2, 3, 0, 28, 1, 28, 0, 28, 1, 3, 0, 8, 2, 3, 0, 29, 1, 26, 0, 29, 1, 3, 0, 8, 2, 3, 0, 84, 1, 3, 0, 8, 2, 3, 0, 84, 1, 3, 0, 8, 2, 4, 0, 82, 1, 4, 0, 9, 2, 4, 0, 80, 1, 4, 0, 11, 2, 4, 0, 78, 1, 4, 0, 6, 2, 1, 0, 6, 2, 4, 0, 76, 1, 4, 0, 6, 2, 3, 0, 6, 2, 4, 0, 74, 1, 4, 0, 6, 2, 5, 0, 6, 2, 4, 0, 72, 1, 4, 0, 6, 2, 7, 0, 6, 2, 4, 0, 70, 1, 4, 0, 6, 2, 9, 0, 6, 2, 4, 0, 68, 1, 4, 0, 6, 2, 11, 0, 6, 2, 4, 0, 66, 1, 4, 0, 6, 2, 13, 0, 6, 2, 4, 0, 64, 1, 4, 0, 6, 2, 15, 0, 6, 2, 4, 0, 62, 1, 4, 0, 6, 2, 17, 0, 6, 2, 4, 0, 60, 1, 4, 0, 6, 2, 19, 0, 6, 2, 4, 0, 58, 1, 4, 0, 6, 2, 21, 0, 6, 2, 4, 0, 56, 1, 4, 0, 6, 2, 23, 0, 6, 2, 4, 0, 54, 1, 4, 0, 6, 2, 25, 0, 6, 2, 4, 0, 52, 1, 4, 0, 6, 2, 27, 0, 6, 2, 4, 0, 50, 1, 4, 0, 6, 2, 29, 0, 6, 2, 4, 0, 48, 1, 4, 0, 6, 2, 31, 0, 6, 2, 4, 0, 46, 1, 4, 0, 6, 2, 33, 0, 6, 2, 52, 0, 6, 2, 35, 0, 6, 2, 50, 0, 6, 2, 37, 0, 6, 2, 48, 0, 6, 2, 39, 0, 58, 2, 41, 0, 56, 2, 43, 0, 54, 2, 45, 0, 52, 2, 23, 0};
 
     // Image dimensions: 98x126
+    const int width = 98;
+    const int height = 126;
     int image_length = sizeof(image) / sizeof(image[0]);
-    int currentX = x;
-    int currentY = y;
+
+    // One row of RGB565 pixels, high byte first, as the panel takes them
+    uint8_t row[width * 2];
+    int column = 0;
+    int rowsSent = 0;
+    const int bandRows = LCD_BURST_PIXELS / width;
+
+    ILI9341.startWrite();
+    ILI9341.setAddrWindow(x, y, width, height);
 
     for (int i = 0; i < image_length; i += 2)
     {
@@ -889,18 +977,28 @@ static void drawOhioStateImage(int x, int y)
 
         uint16_t color = convertRGBTo16Bit(r, g, b);
 
-        // Draw 'image[i]' pixels of this color
+        // Add 'image[i]' pixels of this color, sending each row as it fills
         for (int j = 0; j < image[i]; j++)
         {
-            ILI9341.drawPixel(currentX, currentY, color);
-            currentX++;
-            if (currentX >= x + 98) // Wrap to next line after 98 pixels
+            row[2 * column] = color >> 8;
+            row[2 * column + 1] = color & 0xFF;
+            if (++column == width)
             {
-                currentX = x;
-                currentY++;
+                spiBusWrite(row, sizeof(row));
+                column = 0;
+
+                // Give up the bus between bands, then continue in a window for the rest
+                if (++rowsSent % bandRows == 0 && rowsSent < height)
+                {
+                    ILI9341.endWrite();
+                    ILI9341.startWrite();
+                    ILI9341.setAddrWindow(x, y + rowsSent, width, height - rowsSent);
+                }
             }
         }
     }
+
+    ILI9341.endWrite();
 }
 
 void initSplashScreen()
@@ -924,7 +1022,7 @@ void initSplashScreen()
 
     LCD.SetFontColor(BLACK);
     LCD.SetFontSize(2);
-    LCD.WriteAt("EED Robot Controller 2", 30, 160);
+    LCD.WriteAt(F("EED Robot Controller 2"), 30, 160);
 
     // Reset to smaller font for status messages
     LCD.SetFontSize(1);
@@ -938,6 +1036,14 @@ void initSplashScreen()
  *
  * @param status Status message to display (null-terminated string)
  */
+void updateSplashScreenWithStatus(const __FlashStringHelper *status)
+{
+    char text[64];
+    strncpy_P(text, (PGM_P)status, sizeof(text) - 1);
+    text[sizeof(text) - 1] = '\0';
+    updateSplashScreenWithStatus(text);
+}
+
 void updateSplashScreenWithStatus(const char *status)
 {
     //-------------------------------------------------------------------------
@@ -992,7 +1098,7 @@ void updateSplashScreenWithStatus(const char *status)
         hundredths = 0;
 
     char battBuf[32];
-    snprintf(battBuf, sizeof(battBuf), "Battery: %d.%02d V", volts, hundredths);
+    snprintf_P(battBuf, sizeof(battBuf), PSTR("Battery: %d.%02d V"), volts, hundredths);
 
     int battTextLength = strlen(battBuf);
     int battTextWidth = battTextLength * 6; // approx 6 px per char for font size 1
@@ -1006,10 +1112,10 @@ void updateSplashScreenWithStatus(const char *status)
 
 bool waitForESP32Ready(unsigned long timeout_ms)
 {
-    unsigned long t0 = millis();
+    Deadline timeout = Deadline::InMillis(timeout_ms);
     ESP32Version ver;
 
-    while (millis() - t0 < timeout_ms)
+    while (!timeout.Expired())
     {
         // Repeatedly ping and poll the ESP32 to check if it's ready
         FEHESP32::poll();
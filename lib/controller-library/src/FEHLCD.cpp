@@ -9,19 +9,262 @@
  */
 
 #include <FEH.h>
-#include <Wire.h> // this is needed for FT6206
+#include <FEHI2C.h>
 #include <Adafruit_ILI9341.h>
-#include <Adafruit_FT6206.h>
+#include <util/atomic.h>
+#include "../private_include/FEHInternal.h"
+#include "../private_include/displaylist.h"
+#include "../private_include/lcdtile.h"
+#include "../private_include/recorder.h"
+#include "../private_include/scheduler.h"
+#include "../private_include/spibus.h"
 
 #define LCD_CS 53
 #define LCD_DC 42
 #define LCD_RST 48
 
 /* LCD Singleton */
-Adafruit_ILI9341 ILI9341 = Adafruit_ILI9341(LCD_CS, LCD_DC, LCD_RST);
+FEHILI9341 ILI9341(LCD_CS, LCD_DC, LCD_RST);
 
-/* Touchscreen Singleton */
-Adafruit_FT6206 FT6206 = Adafruit_FT6206();
+void FEHILI9341::startWrite(void)
+{
+    // The library does not nest write transactions, but a fatal error screen drawn from
+    // an interrupt may start one inside another
+    if (_writeDepth++ == 0)
+    {
+        // Refused only when an interrupt draws while another device holds the bus; the
+        // error screen is drawn regardless
+        _ownsBus = spiBusAcquire(SPI_BUS_LCD);
+    }
+    Adafruit_ILI9341::startWrite();
+}
+
+void FEHILI9341::endWrite(void)
+{
+    Adafruit_ILI9341::endWrite();
+    if (--_writeDepth == 0 && _ownsBus)
+    {
+        _ownsBus = false;
+        spiBusRelease(SPI_BUS_LCD);
+        spiBusYield(SPI_BUS_LCD);
+    }
+}
+
+size_t FEHILI9341::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t FEHILI9341::write(const uint8_t *buffer, size_t size)
+{
+    // Pieces that fit one text record, each recorded with the cursor it started at
+    for (size_t done = 0; done < size;)
+    {
+        uint8_t n = size - done < DISPLAY_LIST_TEXT_MAX ? size - done : DISPLAY_LIST_TEXT_MAX;
+        int16_t x = cursor_x;
+        int16_t y = cursor_y;
+        for (uint8_t i = 0; i < n; i++)
+        {
+            uint8_t c = buffer[done + i];
+            if (displayListDrawing())
+            {
+                Adafruit_ILI9341::write(c);
+            }
+            else if (c == '\n')
+            {
+                // Adafruit_GFX::write() for the classic font, without drawing
+                cursor_x = 0;
+                cursor_y += textsize_y * 8;
+            }
+            else if (c != '\r')
+            {
+                if (wrap && cursor_x + textsize_x * 6 > _width)
+                {
+                    cursor_x = 0;
+                    cursor_y += textsize_y * 8;
+                }
+                cursor_x += textsize_x * 6;
+            }
+        }
+        if (displayListListing())
+        {
+            displayListText(x, y, cursor_x, cursor_y, textcolor, textbgcolor, textsize_x, wrap, buffer + done, n);
+        }
+        done += n;
+    }
+    return size;
+}
+
+/* Horizontal spans of a shape, one per row, sent as the rectangles they stack into: a span
+   the same as the one on the row above or below the current rectangle grows it, anything
+   else sends it and starts a new one. Use inside a write transaction. */
+class SpanMerger
+{
+public:
+    explicit SpanMerger(uint16_t color) : _color(color) {}
+    ~SpanMerger() { flush(); }
+
+    void add(int x, int y, int w)
+    {
+        if (_h > 0 && x == _x && w == _w)
+        {
+            if (y == _y + _h)
+            {
+                _h++;
+                return;
+            }
+            if (y == _y - 1)
+            {
+                _y--;
+                _h++;
+                return;
+            }
+        }
+        flush();
+        _x = x;
+        _y = y;
+        _w = w;
+        _h = 1;
+    }
+
+    void flush()
+    {
+        if (_h > 0)
+        {
+            ILI9341.writeFillRect(_x, _y, _w, _h, _color);
+            _h = 0;
+        }
+    }
+
+private:
+    uint16_t _color;
+    int _x = 0, _y = 0, _w = 0, _h = 0;
+};
+
+/* Fill a rectangle in bands of at most LCD_BURST_PIXELS, each its own write transaction */
+static void fillBanded(int x, int y, int w, int h, uint16_t color)
+{
+    if (w < 0)
+    {
+        x += w + 1;
+        w = -w;
+    }
+    if (h < 0)
+    {
+        y += h + 1;
+        h = -h;
+    }
+    if (w == 0 || h == 0)
+    {
+        return;
+    }
+
+    int rows = w < LCD_BURST_PIXELS ? LCD_BURST_PIXELS / w : 1;
+    while (h > 0)
+    {
+        int band = h < rows ? h : rows;
+        ILI9341.fillRect(x, y, w, band, color);
+        y += band;
+        h -= band;
+    }
+}
+
+/* FT6206 touch panel registers */
+#define FT6206_ADDRESS 0x38
+#define FT6206_REG_TD_STATUS 0x02 // Number of touches
+#define FT6206_REG_THRESHOLD 0x80
+#define FT6206_REG_VENDID 0xA8
+#define FT6206_VENDID 0x11
+#define FT6206_POINT_BYTES 7 // Registers 0x00-0x06: status and the first touch point
+
+#define TOUCH_POLL_MS 10
+
+/* Latest reading of the panel, in panel coordinates */
+struct TouchSample
+{
+    bool touched;
+    int16_t x;
+    int16_t y;
+};
+
+static volatile TouchSample _touchSample;
+static bool _touchPolling = false;
+
+static uint8_t _touchRegister = 0x00;
+static uint8_t _touchData[FT6206_POINT_BYTES];
+
+static TouchSample decodeTouch(const uint8_t *regs)
+{
+    // Same decoding as Adafruit_FT6206::readData(): a count above 2 is a bad read
+    uint8_t touches = regs[FT6206_REG_TD_STATUS] & 0x0F;
+    TouchSample sample = {false, 0, 0};
+    if (touches > 0 && touches <= 2)
+    {
+        sample.touched = true;
+        sample.x = ((regs[0x03] & 0x0F) << 8) | regs[0x04];
+        sample.y = ((regs[0x05] & 0x0F) << 8) | regs[0x06];
+    }
+    return sample;
+}
+
+/* Runs in the TWI interrupt */
+static void touchReadDone(FEHI2CTransaction *t)
+{
+    if (t->status == I2C_OK)
+    {
+        TouchSample sample = decodeTouch(_touchData);
+        _touchSample.touched = sample.touched;
+        _touchSample.x = sample.x;
+        _touchSample.y = sample.y;
+    }
+}
+
+static FEHI2CTransaction _touchRead(FT6206_ADDRESS, &_touchRegister, 1, _touchData, FT6206_POINT_BYTES, I2C_FAST,
+                                    touchReadDone);
+
+static void eventTouchPoll()
+{
+    // Still on the bus from last time (e.g. behind a slow transaction): skip this poll
+    FEHI2C::submit(_touchRead);
+    scheduleEvent(eventTouchPoll, SCHEDULER_MS_TO_TICKS(TOUCH_POLL_MS));
+}
+
+bool _touchBegin(uint8_t threshold)
+{
+    uint8_t vendor = 0;
+    FEHI2C::writeRegister(FT6206_ADDRESS, FT6206_REG_THRESHOLD, threshold, I2C_FAST);
+    FEHI2C::readRegisters(FT6206_ADDRESS, FT6206_REG_VENDID, &vendor, 1, I2C_FAST);
+
+    _touchPolling = true;
+    scheduleEvent(eventTouchPoll, 0);
+    return vendor == FT6206_VENDID;
+}
+
+bool _touchPoint(int16_t *x, int16_t *y)
+{
+    TouchSample sample;
+    if (_touchPolling)
+    {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            sample.touched = _touchSample.touched;
+            sample.x = _touchSample.x;
+            sample.y = _touchSample.y;
+        }
+    }
+    else
+    {
+        uint8_t regs[FT6206_POINT_BYTES];
+        if (FEHI2C::readRegisters(FT6206_ADDRESS, 0x00, regs, sizeof(regs), I2C_FAST) != I2C_OK)
+        {
+            return false;
+        }
+        sample = decodeTouch(regs);
+    }
+    *x = sample.x;
+    *y = sample.y;
+    return sample.touched;
+}
 
 /* LCD Singleton */
 FEHLCD LCD;
@@ -50,20 +293,25 @@ void FEHLCD::SetFontSize(uint8_t size)
 
 bool FEHLCD::Touch(int *x_pos, int *y_pos)
 {
-    TS_Point point = FT6206.getPoint();
-    // DO NOT USE FT6206.touched() TO DETERMINE TOUCH STATUS
-    // IF THE USER STOPS TOUCHING THE SCREEN BETWEEN YOU CALLING FT6206.touched() AND YOUR FT6206.getPoint() CALL
-    // THAT WILL RESULT IN AN INVALID TOUCH READ
-    // THE LIBRARY RETURNS Z=0 WHEN NOTHING IS BEING TOUCHED SO USE THAT TO DETERMINE TOUCH STATUS
-    bool touched = point.z != 0;
+    // The status and the point come from one read of the panel, so they always agree
+    int16_t pointX, pointY;
+    bool touched = _touchPoint(&pointX, &pointY);
+
+    if (_recorderMode != RECORDER_OFF)
+    {
+        int32_t packed = _recordInput(RECORD_TOUCH, 0, touched ? ((int32_t)pointX << 12) | pointY : -1);
+        touched = packed >= 0;
+        pointX = packed >> 12;
+        pointY = packed & 0xFFF;
+    }
 
     if (touched)
     {
-        /* *x_pos = point.y IS CORRECT */
+        /* *x_pos = pointY IS CORRECT */
         /* THE TOUCHSCREEN IS ROTATED 90% FROM THE SCREEN */
         /* Flip x */
-        *x_pos = LCD_WIDTH - point.y;
-        *y_pos = point.x;
+        *x_pos = LCD_WIDTH - pointY;
+        *y_pos = pointX;
     }
 
     return touched;
@@ -71,14 +319,16 @@ bool FEHLCD::Touch(int *x_pos, int *y_pos)
 
 void FEHLCD::WaitForTouchToStart()
 {
-    while (!FT6206.touched())
+    int16_t x, y;
+    while (!_recordInput(RECORD_TOUCHED, 0, _touchPoint(&x, &y)))
     {
     }
 }
 
 void FEHLCD::WaitForTouchToEnd()
 {
-    while (FT6206.touched())
+    int16_t x, y;
+    while (_recordInput(RECORD_TOUCHED, 0, _touchPoint(&x, &y)))
     {
     }
 }
@@ -86,6 +336,23 @@ void FEHLCD::WaitForTouchToEnd()
 void FEHLCD::SetOrientation(FEHLCDOrientation orientation)
 {
     ILI9341.setRotation(orientation);
+    record(DISPLAY_LIST_SCREEN, ILI9341.width(), ILI9341.height());
+}
+
+void FEHLCD::SetOutput(FEHLCDOutput output)
+{
+    displayListSetOutput(output != Stream, output != Screen);
+    record(DISPLAY_LIST_SCREEN, ILI9341.width(), ILI9341.height());
+}
+
+/* Send the draw call as a record while streaming; returns whether to draw it as well */
+bool FEHLCD::record(uint8_t op, int a, int b, int c, int d)
+{
+    if (displayListListing())
+    {
+        displayListShape((DisplayListOp)op, a, b, c, d, _foregroundColor);
+    }
+    return displayListDrawing();
 }
 
 void FEHLCD::Clear()
@@ -97,7 +364,14 @@ void FEHLCD::Clear(uint16_t color)
 {
     /* Set text cursor to 0,0 to match Proteus LCD.Clear() behavior */
     ILI9341.setCursor(0, 0);
-    ILI9341.fillScreen(color);
+    if (displayListListing())
+    {
+        displayListShape(DISPLAY_LIST_CLEAR, 0, 0, 0, 0, color);
+    }
+    if (displayListDrawing())
+    {
+        fillBanded(0, 0, ILI9341.width(), ILI9341.height(), color);
+    }
 }
 
 void FEHLCD::Write(const char *str)
@@ -120,15 +394,20 @@ void FEHLCD::Write(double d)
     ILI9341.print(d);
 }
 
+void FEHLCD::Write(const __FlashStringHelper *str)
+{
+    ILI9341.print(str);
+}
+
 void FEHLCD::Write(bool b)
 {
     if (b)
     {
-        ILI9341.print("true");
+        ILI9341.print(F("true"));
     }
     else
     {
-        ILI9341.print("false");
+        ILI9341.print(F("false"));
     }
 }
 
@@ -162,15 +441,20 @@ void FEHLCD::WriteLine(double d)
     ILI9341.println(d);
 }
 
+void FEHLCD::WriteLine(const __FlashStringHelper *str)
+{
+    ILI9341.println(str);
+}
+
 void FEHLCD::WriteLine(bool b)
 {
     if (b)
     {
-        ILI9341.println("true");
+        ILI9341.println(F("true"));
     }
     else
     {
-        ILI9341.println("false");
+        ILI9341.println(F("false"));
     }
 }
 
@@ -185,6 +469,12 @@ void FEHLCD::WriteAt(const char *str, int x, int y)
     this->Write(str);
 }
 
+void FEHLCD::WriteAt(const __FlashStringHelper *str, int x, int y)
+{
+    this->SetTextCursor(x, y);
+    this->Write(str);
+}
+
 void FEHLCD::WriteAt(int i, int x, int y)
 {
     this->SetTextCursor(x, y);
@@ -231,6 +521,12 @@ void FEHLCD::WriteRC(const char *str, int row, int col)
     this->Write(str);
 }
 
+void FEHLCD::WriteRC(const __FlashStringHelper *str, int row, int col)
+{
+    this->setTextCursorRC(row, col);
+    this->Write(str);
+}
+
 void FEHLCD::WriteRC(int i, int row, int col)
 {
     this->setTextCursorRC(row, col);
@@ -261,50 +557,314 @@ void FEHLCD::WriteRC(char c, int row, int col)
     this->Write(c);
 }
 
+void FEHLCD::Printf(const char *fmt, ...)
+{
+    char buf[LCD_FORMAT_BUFFER_SIZE];
+    va_list args;
+    va_start(args, fmt);
+    FormatTextV(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    ILI9341.print(buf);
+}
+
+void FEHLCD::WriteLinef(const char *fmt, ...)
+{
+    char buf[LCD_FORMAT_BUFFER_SIZE];
+    va_list args;
+    va_start(args, fmt);
+    FormatTextV(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    ILI9341.println(buf);
+}
+
+void FEHLCD::WriteAtf(int x, int y, const char *fmt, ...)
+{
+    char buf[LCD_FORMAT_BUFFER_SIZE];
+    va_list args;
+    va_start(args, fmt);
+    FormatTextV(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    this->WriteAt(buf, x, y);
+}
+
+void FEHLCD::WriteRCf(int row, int col, const char *fmt, ...)
+{
+    char buf[LCD_FORMAT_BUFFER_SIZE];
+    va_list args;
+    va_start(args, fmt);
+    FormatTextV(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    this->WriteRC(buf, row, col);
+}
+
+void FEHLCD::Printf(const __FlashStringHelper *fmt, ...)
+{
+    char buf[LCD_FORMAT_BUFFER_SIZE];
+    va_list args;
+    va_start(args, fmt);
+    FormatTextV_P(buf, sizeof(buf), (const char *)fmt, args);
+    va_end(args);
+    ILI9341.print(buf);
+}
+
+void FEHLCD::WriteLinef(const __FlashStringHelper *fmt, ...)
+{
+    char buf[LCD_FORMAT_BUFFER_SIZE];
+    va_list args;
+    va_start(args, fmt);
+    FormatTextV_P(buf, sizeof(buf), (const char *)fmt, args);
+    va_end(args);
+    ILI9341.println(buf);
+}
+
+void FEHLCD::WriteAtf(int x, int y, const __FlashStringHelper *fmt, ...)
+{
+    char buf[LCD_FORMAT_BUFFER_SIZE];
+    va_list args;
+    va_start(args, fmt);
+    FormatTextV_P(buf, sizeof(buf), (const char *)fmt, args);
+    va_end(args);
+    this->WriteAt(buf, x, y);
+}
+
+void FEHLCD::WriteRCf(int row, int col, const __FlashStringHelper *fmt, ...)
+{
+    char buf[LCD_FORMAT_BUFFER_SIZE];
+    va_list args;
+    va_start(args, fmt);
+    FormatTextV_P(buf, sizeof(buf), (const char *)fmt, args);
+    va_end(args);
+    this->WriteRC(buf, row, col);
+}
+
 void FEHLCD::DrawPixel(int x, int y)
 {
+    if (!record(DISPLAY_LIST_PIXEL, x, y))
+    {
+        return;
+    }
     ILI9341.drawPixel(x, y, _foregroundColor);
 }
 
 void FEHLCD::DrawHorizontalLine(int y, int x1, int x2)
 {
+    if (!record(DISPLAY_LIST_LINE, x1, y, x2, y))
+    {
+        return;
+    }
     ILI9341.drawFastHLine(x1, y, x2 - x1 + 1, _foregroundColor);
 }
 
 void FEHLCD::DrawVerticalLine(int x, int y1, int y2)
 {
+    if (!record(DISPLAY_LIST_LINE, x, y1, x, y2))
+    {
+        return;
+    }
     ILI9341.drawFastVLine(x, y1, y2 - y1 + 1, _foregroundColor);
 }
 
 void FEHLCD::DrawLine(int x0, int y0, int x1, int y1)
 {
-    ILI9341.drawLine(x0, y0, x1, y1, _foregroundColor);
+    if (!record(DISPLAY_LIST_LINE, x0, y0, x1, y1))
+    {
+        return;
+    }
+    if (x0 == x1 || y0 == y1)
+    {
+        // Already a single span
+        ILI9341.drawLine(x0, y0, x1, y1, _foregroundColor);
+        return;
+    }
+
+    /* The Bresenham walk of Adafruit_GFX::writeLine(), which sends every pixel in its own
+       address window; here each run of pixels on one row (one column for a steep line)
+       goes out as one span */
+    bool steep = abs(y1 - y0) > abs(x1 - x0);
+    if (steep)
+    {
+        int t = x0;
+        x0 = y0;
+        y0 = t;
+        t = x1;
+        x1 = y1;
+        y1 = t;
+    }
+    if (x0 > x1)
+    {
+        int t = x0;
+        x0 = x1;
+        x1 = t;
+        t = y0;
+        y0 = y1;
+        y1 = t;
+    }
+
+    int dx = x1 - x0;
+    int dy = abs(y1 - y0);
+    int err = dx / 2;
+    int ystep = y0 < y1 ? 1 : -1;
+    int runStart = x0;
+
+    ILI9341.startWrite();
+    for (; x0 <= x1; x0++)
+    {
+        err -= dy;
+        bool step = err < 0;
+        if (step || x0 == x1)
+        {
+            if (steep)
+            {
+                ILI9341.writeFastVLine(y0, runStart, x0 - runStart + 1, _foregroundColor);
+            }
+            else
+            {
+                ILI9341.writeFastHLine(runStart, y0, x0 - runStart + 1, _foregroundColor);
+            }
+            runStart = x0 + 1;
+        }
+        if (step)
+        {
+            y0 += ystep;
+            err += dx;
+        }
+    }
+    ILI9341.endWrite();
 }
 
 void FEHLCD::DrawRectangle(int x, int y, int w, int h)
 {
-    ILI9341.drawRect(x, y, w, h, _foregroundColor);
+    if (!record(DISPLAY_LIST_RECT, x, y, w, h))
+    {
+        return;
+    }
+    if (w < 0)
+    {
+        x += w + 1;
+        w = -w;
+    }
+    if (h < 0)
+    {
+        y += h + 1;
+        h = -h;
+    }
+    if (w == 0 || h == 0)
+    {
+        return;
+    }
+
+    // The sides run between the top and bottom edges, so no corner is sent twice
+    ILI9341.startWrite();
+    ILI9341.writeFastHLine(x, y, w, _foregroundColor);
+    if (h > 1)
+    {
+        ILI9341.writeFastHLine(x, y + h - 1, w, _foregroundColor);
+    }
+    if (h > 2)
+    {
+        ILI9341.writeFastVLine(x, y + 1, h - 2, _foregroundColor);
+        if (w > 1)
+        {
+            ILI9341.writeFastVLine(x + w - 1, y + 1, h - 2, _foregroundColor);
+        }
+    }
+    ILI9341.endWrite();
 }
 
 void FEHLCD::FillRectangle(int x, int y, int w, int h)
 {
-    ILI9341.fillRect(x, y, w, h, _foregroundColor);
+    if (!record(DISPLAY_LIST_FILL_RECT, x, y, w, h))
+    {
+        return;
+    }
+    fillBanded(x, y, w, h, _foregroundColor);
 }
 
 void FEHLCD::DrawCircle(int x0, int y0, int r)
 {
+    if (!record(DISPLAY_LIST_CIRCLE, x0, y0, r))
+    {
+        return;
+    }
     ILI9341.drawCircle(x0, y0, r, _foregroundColor);
 }
 
 void FEHLCD::FillCircle(int x0, int y0, int r)
 {
-    ILI9341.fillCircle(x0, y0, r, _foregroundColor);
+    if (!record(DISPLAY_LIST_FILL_CIRCLE, x0, y0, r))
+    {
+        return;
+    }
+    if (r < 0)
+    {
+        return;
+    }
+
+    /* Adafruit_GFX::fillCircle() fills the circle as columns, each its own address window.
+       The midpoint walk it uses is symmetric about the diagonals, so the same walk with x
+       and y exchanged gives the same pixels as rows. Rows come from four fronts (inner
+       rows moving out from the middle, outer rows moving in from the top and bottom, each
+       above and below), and consecutive rows of the same width within a front merge. */
+    ILI9341.startWrite();
+    {
+        SpanMerger lowerInner(_foregroundColor), upperInner(_foregroundColor);
+        SpanMerger lowerOuter(_foregroundColor), upperOuter(_foregroundColor);
+
+        lowerInner.add(x0 - r, y0, 2 * r + 1);
+
+        int f = 1 - r;
+        int ddF_x = 1;
+        int ddF_y = -2 * r;
+        int x = 0;
+        int y = r;
+        int px = x;
+        int py = y;
+
+        while (x < y)
+        {
+            if (f >= 0)
+            {
+                y--;
+                ddF_y += 2;
+                f += ddF_y;
+            }
+            x++;
+            ddF_x += 2;
+            f += ddF_x;
+            if (x < y + 1)
+            {
+                lowerInner.add(x0 - y, y0 + x, 2 * y + 1);
+                upperInner.add(x0 - y, y0 - x, 2 * y + 1);
+            }
+            if (y != py)
+            {
+                lowerOuter.add(x0 - px, y0 + py, 2 * px + 1);
+                upperOuter.add(x0 - px, y0 - py, 2 * px + 1);
+                py = y;
+            }
+            px = x;
+        }
+    }
+    ILI9341.endWrite();
 }
 
 /*
  * FEHIcon API.
  */
 
+static bool _compositing = true;
+
+void _lcdSetCompositing(bool enabled)
+{
+    _compositing = enabled;
+}
+
+bool _lcdCompositing()
+{
+    // A tile is sent as pixels, which the display list does not carry
+    return _compositing && !displayListListing();
+}
+
 /* Icon constructor function */
 FEHIcon::Icon::Icon() {}
 
@@ -323,6 +883,14 @@ void FEHIcon::Icon::SetProperties(char name[20], int start_x, int start_y, int w
     set = 0;
 }
 
+void FEHIcon::Icon::SetProperties(const __FlashStringHelper *name, int start_x, int start_y, int w, int h, unsigned int c, unsigned int tc)
+{
+    char text[sizeof(label)];
+    strncpy_P(text, (PGM_P)name, sizeof(text) - 1);
+    text[sizeof(text) - 1] = '\0';
+    SetProperties(text, start_x, start_y, w, h, c, tc);
+}
+
 /* Icon function to draw it and write label */
 void FEHIcon::Icon::Draw()
 {
@@ -332,6 +900,37 @@ void FEHIcon::Icon::Draw()
     LCD.WriteAt(label, x_start + ((width - (strlen(label) * 12)) / 2), y_start + ((height - 17) / 2)); // equation to center text inside the icon
 }
 
+/* Icon function to redraw it, label and selection rings included, in one window instead of erasing first */
+bool FEHIcon::Icon::composeLabel()
+{
+    if (!_lcdCompositing())
+    {
+        return false;
+    }
+
+    const uint16_t palette[] = {BLACK, (uint16_t)color, (uint16_t)textcolor};
+    LcdTile tile(x_start, y_start, width, height, palette, 3);
+    while (tile.nextBand())
+    {
+        tile.drawRect(x_start, y_start, width, height, color);
+        if (set)
+        {
+            for (int i = 1; i <= 3; i++)
+            {
+                tile.drawRect(x_start + i, y_start + i, width - 2 * i, height - 2 * i, color);
+            }
+        }
+        tile.setTextColor(textcolor);
+        tile.setCursor(x_start + ((width - (strlen(label) * 12)) / 2), y_start + ((height - 17) / 2));
+        tile.print(label);
+    }
+
+    // Leave the font color and cursor as Draw() would
+    LCD.SetFontColor(textcolor);
+    ILI9341.setCursor(tile.getCursorX(), tile.getCursorY());
+    return true;
+}
+
 /* Icon function to make the icon selected and set */
 void FEHIcon::Icon::Select()
 {
@@ -399,12 +998,24 @@ void FEHIcon::Icon::ChangeLabelString(const char new_label[])
     if (strcmp(label, new_label))
     {
         strcpy(label, new_label);
+        if (composeLabel())
+        {
+            return;
+        }
         LCD.SetFontColor(BLACK);
         LCD.FillRectangle(x_start + 1, y_start + 1, width - 2, height - 2);
         Draw();
     }
 }
 
+void FEHIcon::Icon::ChangeLabelString(const __FlashStringHelper *new_label)
+{
+    char text[sizeof(label)];
+    strncpy_P(text, (PGM_P)new_label, sizeof(text) - 1);
+    text[sizeof(text) - 1] = '\0';
+    ChangeLabelString(text);
+}
+
 /* Icon function to change the label of an icon with a float */
 void FEHIcon::Icon::ChangeLabelFloat(float val)
 {
@@ -418,14 +1029,19 @@ void FEHIcon::Icon::ChangeLabelFloat(float val)
     {
         d = (int)val;
         r = (int)((val - d) * 1000);
-        sprintf(label, "%d.%03d", d, r);
+        sprintf_P(label, PSTR("%d.%03d"), d, r);
     }
     else
     {
         val *= -1;
         d = (int)val;
         r = (int)((val - d) * 1000);
-        sprintf(label, "-%d.%03d", d, r);
+        sprintf_P(label, PSTR("-%d.%03d"), d, r);
+    }
+
+    if (composeLabel())
+    {
+        return;
     }
 
     LCD.SetFontColor(BLACK);
@@ -461,7 +1077,12 @@ void FEHIcon::Icon::ChangeLabelInt(int val)
     strcpy(temp_label, label);
 
     /* Convert int to string so it can be auto-centered in icon */
-    sprintf(label, "%d", val);
+    sprintf_P(label, PSTR("%d"), val);
+
+    if (composeLabel())
+    {
+        return;
+    }
 
     LCD.SetFontColor(BLACK);
     /* If the new label is not the same length as the old one, then erase the old one so that it does not show up behind the new one */
@@ -486,8 +1107,8 @@ void FEHIcon::Icon::ChangeLabelInt(int val)
     Draw();
 }
 
-/* Function to draw an array of icons in a given space and size and label them */
-void FEHIcon::DrawIconArray(Icon icon[], int rows, int cols, int top, int bot, int left, int right, char labels[][20], unsigned int col, unsigned int txtcol)
+/* Lay out and draw an array of icons, copying each label from RAM or, with flash, program memory */
+static void drawIconArray(FEHIcon::Icon icon[], int rows, int cols, int top, int bot, int left, int right, const char labels[][20], bool flash, unsigned int col, unsigned int txtcol)
 {
     int xs = left;
     int ys = top;
@@ -500,7 +1121,17 @@ void FEHIcon::DrawIconArray(Icon icon[], int rows, int cols, int top, int bot, i
     {
         for (nx = 1; nx <= cols; nx++)
         {
-            icon[N].SetProperties(labels[N], xs, ys, w, h, col, txtcol);
+            char name[20];
+            if (flash)
+            {
+                memcpy_P(name, labels[N], sizeof(name));
+            }
+            else
+            {
+                memcpy(name, labels[N], sizeof(name));
+            }
+            name[sizeof(name) - 1] = '\0';
+            icon[N].SetProperties(name, xs, ys, w, h, col, txtcol);
             icon[N].Draw();
             N = N + 1;
             xs = xs + w;
@@ -508,4 +1139,16 @@ void FEHIcon::DrawIconArray(Icon icon[], int rows, int cols, int top, int bot, i
         ys = ys + h;
         xs = left;
     }
+}
+
+/* Function to draw an array of icons in a given space and size and label them */
+void FEHIcon::DrawIconArray(Icon icon[], int rows, int cols, int top, int bot, int left, int right, char labels[][20], unsigned int col, unsigned int txtcol)
+{
+    drawIconArray(icon, rows, cols, top, bot, left, right, labels, false, col, txtcol);
+}
+
+/* DrawIconArray() with the labels in a PROGMEM array */
+void FEHIcon::DrawIconArray_P(Icon icon[], int rows, int cols, int top, int bot, int left, int right, const char labels[][20], unsigned int col, unsigned int txtcol)
+{
+    drawIconArray(icon, rows, cols, top, bot, left, right, labels, true, col, txtcol);
 }
\ No newline at end of file
@@ -0,0 +1,259 @@
+/**
+ * FEHLineSensor.cpp
+ *
+ * Line sensor array built on the student analog I/O pins.
+ *
+ * The ADC is driven directly instead of through analogRead() so that a whole array
+ * can be sampled in one tight sweep, and the normalization and centroid are done in
+ * fixed point so the cost of Update() does not depend on the readings.
+ */
+
+#include <FEH.h>
+#include "../private_include/FEHInternal.h"
+#include "../private_include/recorder.h"
+#include <Arduino.h>
+#include <util/atomic.h>
+
+/* Analog pin numbers start at A0 (54) on the Mega; ADC channel = pin - A0 */
+#define ADC_CHANNEL_OF(arduinoPin) ((uint8_t)((arduinoPin) - A0))
+
+/* Default "line found" threshold, in Reading()/Confidence() units */
+#define DEFAULT_LOST_THRESHOLD 250
+
+const uint8_t FEHLineSensor::MAX_SENSORS;
+const int16_t FEHLineSensor::POSITION_RANGE;
+const int16_t FEHLineSensor::READING_MAX;
+
+FEHLineSensor::FEHLineSensor(const FEHIO::FEHIOPin *pins, uint8_t count)
+{
+    configure(pins, count);
+}
+
+FEHLineSensor::FEHLineSensor(FEHIO::FEHIOPin left, FEHIO::FEHIOPin middle, FEHIO::FEHIOPin right)
+{
+    FEHIO::FEHIOPin pins[] = {left, middle, right};
+    configure(pins, 3);
+}
+
+void FEHLineSensor::configure(const FEHIO::FEHIOPin *pins, uint8_t count)
+{
+    if (count < 2 || count > MAX_SENSORS)
+    {
+        _fatalError(F("FEHLineSensor:\nsensor count must\nbe 2 to 8"));
+    }
+
+    _count = count;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        FEHIO::FEHIOPin pin = pins[i];
+
+        if ((uint8_t)pin > 15 || !pgm_read_byte(FEHIOPIN_VALID_ANALOG_PINS + pin))
+        {
+            char msg[128];
+            snprintf_P(
+                msg, 128,
+                PSTR("FEHLineSensor:\n"
+                     "\n"
+                     "Attemped to use\n"
+                     "non-analog pin %d.\n"
+                     "\n"
+                     "Valid analog pins are:\n"
+                     "0-14.\n"),
+                pin);
+
+            _fatalError(msg);
+        }
+
+        uint8_t arduinoPin = pgm_read_byte(FEHIOPIN_TO_ARDUINOPIN + pin);
+        pinMode(arduinoPin, INPUT);
+        _adcChannel[i] = ADC_CHANNEL_OF(arduinoPin);
+
+        /* Evenly spaced weights from -POSITION_RANGE (leftmost) to POSITION_RANGE (rightmost) */
+        _weight[i] = -POSITION_RANGE + (int16_t)(((int32_t)2 * POSITION_RANGE * i) / (count - 1));
+
+        /* Until calibrated, map the full 0-5 V range linearly */
+        setCalibrationRaw(i, 0, 1023);
+
+        _raw[i] = 0;
+        _reading[i] = 0;
+    }
+
+    _lostThreshold = DEFAULT_LOST_THRESHOLD;
+    _position = 0;
+    _confidence = 0;
+    _lost = true;
+}
+
+void FEHLineSensor::setCalibrationRaw(uint8_t index, uint16_t offLine, uint16_t onLine)
+{
+    int16_t span = (int16_t)onLine - (int16_t)offLine;
+
+    /* A zero span would divide by zero; treat it as a 1 LSB span instead */
+    if (span == 0)
+    {
+        span = 1;
+    }
+
+    _offLine[index] = offLine;
+    _span[index] = span;
+
+    /* Precompute the reciprocal in Q8 so Update() never divides per sensor */
+    _scale[index] = ((int32_t)READING_MAX << 8) / span;
+}
+
+void FEHLineSensor::SetCalibration(uint8_t index, float offLineVolts, float onLineVolts)
+{
+    if (!_checkRange(F("FEHLineSensor::SetCalibration"), F("index"), index, 0, _count - 1))
+    {
+        return;
+    }
+
+    /* Convert volts back to 10-bit ADC counts */
+    uint16_t offLine = constrain((int)(offLineVolts * (1023.0 / 5.0) + 0.5), 0, 1023);
+    uint16_t onLine = constrain((int)(onLineVolts * (1023.0 / 5.0) + 0.5), 0, 1023);
+
+    setCalibrationRaw(index, offLine, onLine);
+}
+
+void FEHLineSensor::CalibrateOffLine()
+{
+    sweep();
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        setCalibrationRaw(i, _raw[i], _offLine[i] + _span[i]);
+    }
+}
+
+void FEHLineSensor::CalibrateOnLine()
+{
+    sweep();
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        setCalibrationRaw(i, _offLine[i], _raw[i]);
+    }
+}
+
+void FEHLineSensor::SetLostThreshold(int16_t threshold)
+{
+    _lostThreshold = constrain(threshold, 0, READING_MAX);
+}
+
+void FEHLineSensor::sweep()
+{
+    /*
+     * Temporarily run the ADC at clk/32 (500 kHz) instead of the Arduino default of clk/128.
+     * A conversion then takes 26 us instead of 104 us. The datasheet allows this at the cost
+     * of roughly one LSB of extra noise, which is far below optosensor noise.
+     */
+    uint8_t oldAdcsra = ADCSRA;
+    ADCSRA = bit(ADEN) | bit(ADPS2) | bit(ADPS0);
+
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        uint8_t channel = _adcChannel[i];
+
+        /* The health check reads the battery from the scheduler ISR, so each conversion */
+        /* must not be interleaved with another analogRead(). */
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            /* MUX5 selects channels 8-15, the low 3 bits go in ADMUX with the AVCC reference */
+            ADCSRB = (ADCSRB & ~bit(MUX5)) | (((channel >> 3) & 0x01) << MUX5);
+            ADMUX = bit(REFS0) | (channel & 0x07);
+
+            ADCSRA |= bit(ADSC);
+            while (ADCSRA & bit(ADSC))
+            {
+            }
+
+            _raw[i] = ADC;
+        }
+
+        _raw[i] = _recordInput(RECORD_ANALOG, A0 + channel, _raw[i]);
+    }
+
+    ADCSRA = oldAdcsra;
+}
+
+void FEHLineSensor::Update()
+{
+    sweep();
+
+    int32_t weightedSum = 0;
+    int32_t total = 0;
+    int16_t peak = 0;
+
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        int16_t delta = (int16_t)_raw[i] - (int16_t)_offLine[i];
+        int32_t reading = ((int32_t)delta * _scale[i]) >> 8;
+
+        if (reading < 0)
+        {
+            reading = 0;
+        }
+        else if (reading > READING_MAX)
+        {
+            reading = READING_MAX;
+        }
+
+        _reading[i] = (int16_t)reading;
+        weightedSum += reading * _weight[i];
+        total += reading;
+
+        if (reading > peak)
+        {
+            peak = (int16_t)reading;
+        }
+    }
+
+    _confidence = peak;
+    _lost = (peak < _lostThreshold) || (total == 0);
+
+    if (!_lost)
+    {
+        /* The only division in the update */
+        _position = (int16_t)(weightedSum / total);
+    }
+    else if (_position < 0)
+    {
+        _position = -POSITION_RANGE;
+    }
+    else if (_position > 0)
+    {
+        _position = POSITION_RANGE;
+    }
+}
+
+int16_t FEHLineSensor::Position()
+{
+    return _position;
+}
+
+int16_t FEHLineSensor::Confidence()
+{
+    return _confidence;
+}
+
+bool FEHLineSensor::LineLost()
+{
+    return _lost;
+}
+
+int16_t FEHLineSensor::Reading(uint8_t index)
+{
+    if (index >= _count)
+    {
+        return 0;
+    }
+    return _reading[index];
+}
+
+uint16_t FEHLineSensor::RawReading(uint8_t index)
+{
+    if (index >= _count)
+    {
+        return 0;
+    }
+    return _raw[index];
+}
@@ -7,6 +7,7 @@
 #include <Arduino.h>
 #include <stdio.h>
 #include <FEHLog.h>
+#include <FEHTelemetry.h>
 #include "../private_include/FEHESP32.h"
 #include "../private_include/ApplicationProtocol.h"
 
@@ -16,6 +17,12 @@
 
 bool FEHLog::s_serialEnabled = false;
 bool FEHLog::s_bleEnabled    = false;
+uint8_t FEHLog::s_levels[FEH_LOG_MODULE_COUNT] = {FEH_LOG_LEVEL_TRACE, FEH_LOG_LEVEL_TRACE, FEH_LOG_LEVEL_TRACE,
+                                                  FEH_LOG_LEVEL_TRACE, FEH_LOG_LEVEL_TRACE};
+static_assert(FEH_LOG_MODULE_COUNT == 5, "initialize s_levels and MODULE_NAMES for every module");
+
+static const char MODULE_NAMES[FEH_LOG_MODULE_COUNT][10] PROGMEM = {"app", "scheduler", "esp32", "sd", "rcs"};
+static const char LEVEL_LETTERS[] PROGMEM = "EWIDT";
 
 // ---------------------------------------------------------------------------
 // Public methods
@@ -34,7 +41,7 @@ void FEHLog::disableSerial()
 bool FEHLog::enableBLE(int controllerNumber)//, uint32_t ackTimeoutMs)
 {
     char deviceName[16];
-    snprintf(deviceName, sizeof(deviceName), "FEH-%03d", controllerNumber);
+    snprintf_P(deviceName, sizeof(deviceName), PSTR("FEH-%03d"), controllerNumber);
     FEHESP32::startBLELog(deviceName);
     // bool ok = FEHESP32::waitForAck(CMD_BLE_START, ackTimeoutMs);
     s_bleEnabled = true;
@@ -66,25 +73,91 @@ void FEHLog::printf(const char *fmt, ...)
     va_end(args);
 }
 
+void FEHLog::printf(const __FlashStringHelper *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    _dispatch(false, (const char *)fmt, args, true);
+    va_end(args);
+}
+
 void FEHLog::print(const char *msg)
 {
     _send(msg, false);
 }
 
+void FEHLog::print(const __FlashStringHelper *msg)
+{
+    char buf[LOG_BUF_SIZE];
+    strncpy_P(buf, (PGM_P)msg, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    _send(buf, false);
+}
+
+void FEHLog::setLevel(FEHLogModule module, uint8_t level)
+{
+    if (module < FEH_LOG_MODULE_COUNT)
+        s_levels[module] = level;
+}
+
+void FEHLog::setLevel(uint8_t level)
+{
+    for (uint8_t &l : s_levels)
+        l = level;
+}
+
+uint8_t FEHLog::level(FEHLogModule module)
+{
+    return module < FEH_LOG_MODULE_COUNT ? s_levels[module] : FEH_LOG_LEVEL_NONE;
+}
+
+void FEHLog::log(uint8_t level, FEHLogModule module, const __FlashStringHelper *fmt, ...)
+{
+    if (level < FEH_LOG_LEVEL_ERROR || level > FEH_LOG_LEVEL_TRACE || module >= FEH_LOG_MODULE_COUNT)
+        return;
+
+    char name[sizeof(MODULE_NAMES[0])];
+    strcpy_P(name, MODULE_NAMES[module]);
+    char buf[LOG_BUF_SIZE];
+    int n = snprintf_P(buf, sizeof(buf), PSTR("%lu %c %s: "), (unsigned long)millis(),
+                       pgm_read_byte(LEVEL_LETTERS + level - 1), name);
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf_P(buf + n, sizeof(buf) - n, (PGM_P)fmt, args);
+    va_end(args);
+
+    // BLE logs travel over the ESP32 link, so its own messages would feed back, and the
+    // scheduler can log from its ISR, where SPI to the ESP32 is not safe
+    _send(buf, true, module != FEH_LOG_ESP32 && module != FEH_LOG_SCHEDULER);
+}
+
 // ---------------------------------------------------------------------------
 // Private helpers
 // ---------------------------------------------------------------------------
 
-void FEHLog::_dispatch(bool newline, const char *fmt, va_list args)
+void FEHLog::_dispatch(bool newline, const char *fmt, va_list args, bool flash)
 {
+    if (!s_serialEnabled && !s_bleEnabled)
+        return;
+
     char buf[LOG_BUF_SIZE];
-    vsnprintf(buf, sizeof(buf), fmt, args);
+    if (flash)
+        vsnprintf_P(buf, sizeof(buf), fmt, args);
+    else
+        vsnprintf(buf, sizeof(buf), fmt, args);
     _send(buf, newline);
 }
 
-void FEHLog::_send(const char *msg, bool newline)
+void FEHLog::_send(const char *msg, bool newline, bool ble)
 {
-    if (s_serialEnabled)
+    if (s_serialEnabled && FEHTelemetry::isActive())
+    {
+        // Framed and never waits; a message that does not fit in the TX ring is dropped
+        FEHTelemetry::sendText(msg);
+        if (newline)
+            FEHTelemetry::sendText("\r\n");
+    }
+    else if (s_serialEnabled)
     {
         if (newline)
             Serial.println(msg);
@@ -92,13 +165,13 @@ void FEHLog::_send(const char *msg, bool newline)
             Serial.print(msg);
     }
 
-    if (s_bleEnabled)
+    if (s_bleEnabled && ble)
     {
         if (newline)
         {
             // Append newline for BLE consumers that parse line-by-line
             char buf[LOG_BUF_SIZE];
-            snprintf(buf, sizeof(buf), "%s\n", msg);
+            snprintf_P(buf, sizeof(buf), PSTR("%s\n"), msg);
             FEHESP32::sendBLELog(buf);
         }
         else
@@ -11,13 +11,37 @@
 
 #include <FEH.h>
 #include "../private_include/FEHInternal.h"
+#include "../private_include/recorder.h"
+#include "../private_include/scheduler.h"
 #include <Arduino.h>
+#include <util/atomic.h>
 
 /* If set to true, motor PWM is slowed down so it can be measured in software by a unit test. */
 /* Used by test/test_motors_and_servos. */
 bool debug_motorSlowPwm = false;
 
 
+/*
+ * Battery compensation state, shared with eventBatteryCompensation(). SetPercent() records
+ * what each port should deliver; the event rescales the duty cycles for the battery.
+ */
+static volatile bool _compensating = false;
+static volatile bool _compensationScheduled = false;
+static uint8_t _activePorts = 0;
+static uint8_t _reversePorts = 0;
+static volatile uint16_t _commandMillivolts[4];
+static uint8_t _nominalDuty[4];
+
+/* Filtered battery reading in ADC counts << 4, and the duty cycle (in 1/65536ths of a
+ * step) per millivolt that it gives */
+static volatile uint16_t _batteryFiltered;
+static volatile uint16_t _dutyPerMillivolt;
+
+/* 255 * 65536 / millivolts, with millivolts = counts16 / 16 * 15000 / 1023 */
+#define DUTY_PER_MV_FROM_COUNTS16 18235785UL
+/* Readings below 6 V (the shield is off) are clamped, which bounds the products below */
+#define BATTERY_COUNTS16_MIN (409 << 4)
+
 uint8_t _getMotorPwmPin(uint8_t motorIndex)
 {
     return pgm_read_byte(MOTOR_PWM_PINS + motorIndex);
@@ -31,7 +55,7 @@ uint8_t _getMotorDirectionPin(uint8_t motorIndex)
 FEHMotor::FEHMotor(FEHMotor::FEHMotorPort motorPort, float maxVoltage)
     : _motorPort(motorPort)
 {
-    if (!_checkRangeFatal("FEHMotor::FEHMotor", "motorPort", motorPort, 0, 3))
+    if (!_checkRangeFatal(F("FEHMotor::FEHMotor"), F("motorPort"), motorPort, 0, 3))
     {
         return;
     }
@@ -48,6 +72,7 @@ FEHMotor::FEHMotor(FEHMotor::FEHMotorPort motorPort, float maxVoltage)
 
     /* This is used to scale the passed-in percentage in FEHMotor::SetPercent() */
     _powerScalingFactor = (uint8_t)((maxVoltage / 12.0) * 255.0);
+    _maxMillivolts = (uint16_t)(maxVoltage * 1000.0);
 
     /*
      * Initialize Timers 3 and 5 which we use for motor PWM.
@@ -92,6 +117,161 @@ FEHMotor::FEHMotor(FEHMotor::FEHMotorPort motorPort, float maxVoltage)
     default:
         _fatalError();
     }
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        _commandMillivolts[motorPort] = 0;
+        _nominalDuty[motorPort] = 0;
+        _activePorts |= 1 << motorPort;
+    }
+}
+
+/* Set a port's pulse width */
+static void writeDuty(uint8_t motorPort, uint8_t pwm)
+{
+    switch (motorPort)
+    {
+    case FEHMotor::Motor0: // D3, PE5, OC3C
+        OCR3C = pwm;
+        break;
+    case FEHMotor::Motor1: // D45, PL4, OC5B
+        OCR5B = pwm;
+        break;
+    case FEHMotor::Motor2: // D44, PL5, OC5C
+        OCR5C = pwm;
+        break;
+    case FEHMotor::Motor3: // D46, PL3, OC5A
+        OCR5A = pwm;
+        break;
+    }
+}
+
+static uint8_t readDuty(uint8_t motorPort)
+{
+    switch (motorPort)
+    {
+    case FEHMotor::Motor0:
+        return OCR3C;
+    case FEHMotor::Motor1:
+        return OCR5B;
+    case FEHMotor::Motor2:
+        return OCR5C;
+    default:
+        return OCR5A;
+    }
+}
+
+/* Duty cycle that delivers @p millivolts, saturating at full on */
+static uint8_t compensatedDuty(uint16_t millivolts, uint16_t dutyPerMillivolt)
+{
+    uint32_t duty = ((uint32_t)millivolts * dutyPerMillivolt) >> 16;
+    return duty > 255 ? 255 : duty;
+}
+
+/* Fold one battery sample into the filter (time constant ~4 samples) and rescale */
+static void sampleBattery(bool seed)
+{
+    /* Seeding runs on the main thread, where the health check could interleave a conversion */
+    int raw;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        raw = analogRead(BATTERY_PIN);
+    }
+    uint16_t sample = (uint16_t)_recordInput(RECORD_ANALOG, BATTERY_PIN, raw) << 4;
+    uint16_t filtered = seed ? sample : _batteryFiltered + ((int32_t)sample - _batteryFiltered) / 4;
+    _batteryFiltered = filtered;
+    _dutyPerMillivolt = DUTY_PER_MV_FROM_COUNTS16 / (filtered > BATTERY_COUNTS16_MIN ? filtered : BATTERY_COUNTS16_MIN);
+}
+
+static void eventBatteryCompensation()
+{
+    if (!_compensating)
+    {
+        _compensationScheduled = false;
+        return;
+    }
+
+    sampleBattery(false);
+    for (uint8_t port = 0; port < 4; port++)
+    {
+        if (_activePorts & (1 << port))
+        {
+            writeDuty(port, compensatedDuty(_commandMillivolts[port], _dutyPerMillivolt));
+        }
+    }
+
+    /* A full queue stops compensation; _compensationService() restarts it from the main thread */
+    if (!scheduleEvent(eventBatteryCompensation, SCHEDULER_MS_TO_TICKS(MOTOR_COMPENSATION_MS)))
+    {
+        _compensationScheduled = false;
+    }
+}
+
+void FEHMotor::SetBatteryCompensation(bool enabled)
+{
+    /* The event only samples while compensating, so the filter can be seeded here */
+    if (enabled && !_compensating)
+    {
+        sampleBattery(true);
+    }
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        _compensating = enabled;
+
+        for (uint8_t port = 0; port < 4; port++)
+        {
+            if (_activePorts & (1 << port))
+            {
+                writeDuty(port, enabled ? compensatedDuty(_commandMillivolts[port], _dutyPerMillivolt)
+                                        : _nominalDuty[port]);
+            }
+        }
+
+        if (enabled && !_compensationScheduled)
+        {
+            _compensationScheduled =
+                scheduleEvent(eventBatteryCompensation, SCHEDULER_MS_TO_TICKS(MOTOR_COMPENSATION_MS));
+        }
+    }
+}
+
+bool _compensationService()
+{
+    // Retrying into a full queue would only log another dropped event
+    if (_compensationScheduled || !_compensating || !schedulerHasRoom())
+    {
+        return false;
+    }
+    bool restarted;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        restarted = scheduleEvent(eventBatteryCompensation, SCHEDULER_MS_TO_TICKS(MOTOR_COMPENSATION_MS));
+        _compensationScheduled = restarted;
+    }
+    if (restarted)
+    {
+        FEH_LOG_WARN(SCHEDULER, "battery compensation restarted");
+    }
+    return restarted;
+}
+
+float FEHMotor::EffectiveVolts()
+{
+    float battery;
+    uint8_t duty;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        battery = _compensating ? _batteryFiltered * (15.0f / 1023.0f / 16.0f) : -1.0f;
+        duty = readDuty(_motorPort);
+    }
+    if (battery < 0)
+    {
+        battery = _batteryVoltage();
+    }
+
+    float volts = duty / 255.0f * battery;
+    return (_reversePorts & (1 << _motorPort)) ? -volts : volts;
 }
 
 void FEHMotor::SetPercent(int8_t percent)
@@ -138,11 +318,31 @@ void FEHMotor::SetPercent(int8_t percent)
 
     /* Scale for 8-bit PWM, and based on power scaling factor */
     int pwm = (abs(percent) * _powerScalingFactor) / 100;
+    uint16_t millivolts = (uint16_t)(((uint32_t)abs(percent) * _maxMillivolts) / 100);
 
     /* Determine direction based on if percentage is positive or negative */
     /* Invert direction so LED indicator appears correct*/
     bool direction = percent < 0;
 
+    /* Record the command for battery compensation, and use its duty cycle while it is on */
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        _commandMillivolts[_motorPort] = millivolts;
+        _nominalDuty[_motorPort] = pwm;
+        if (direction)
+        {
+            _reversePorts |= 1 << _motorPort;
+        }
+        else
+        {
+            _reversePorts &= ~(1 << _motorPort);
+        }
+        if (_compensating)
+        {
+            pwm = compensatedDuty(millivolts, _dutyPerMillivolt);
+        }
+    }
+
     uint8_t directionPin = _getMotorDirectionPin(_motorPort);
     /* Set direction pin as output*/
     pinMode(directionPin, OUTPUT);
@@ -151,22 +351,8 @@ void FEHMotor::SetPercent(int8_t percent)
     /* Set PWM pin as output */
     pinMode(_getMotorPwmPin(_motorPort), OUTPUT);
 
-    switch (_motorPort)
-    {
-    case Motor0: // D3, PE5, OC3C
-        /* Set pulse width */
-        OCR3C = pwm;
-        break;
-    case Motor1: // D45, PL4, OC5B
-        OCR5B = pwm;
-        break;
-    case Motor2: // D44, PL5, OC5C
-        OCR5C = pwm;
-        break;
-    case Motor3: // D46, PL3, OC5A
-        OCR5A = pwm;
-        break;
-    }
+    /* Set pulse width */
+    writeDuty(_motorPort, pwm);
 }
 
 void FEHMotor::Stop()
@@ -0,0 +1,457 @@
+/**
+ * FEHPath.cpp
+ *
+ * Path following for differential-drive robots: encoder odometry, an online trapezoidal
+ * speed profile and pure pursuit steering. See FEHPath.h.
+ *
+ * Every segment, line or arc, is stored as a start pose, a length and a curvature, so a
+ * point at a distance along the path and the closest point to the robot both come from
+ * the same closed forms.
+ */
+
+#include <FEH.h>
+#include <FEHPath.h>
+#include <math.h>
+
+/* Remaining distance at which the path counts as driven */
+#define END_TOLERANCE 0.25f
+/* Heading error at which a finish turn is complete */
+#define TURN_TOLERANCE (1.5f * (float)M_PI / 180.0f)
+/* Slowest profiled speed before the end, so friction cannot stall the robot short */
+#define MIN_SPEED 1.5f
+/* Longest time step used for speed estimates, e.g. on the first Update() of a path */
+#define MAX_STEP 0.1f
+
+static float wrapAngle(float a)
+{
+    while (a > (float)M_PI)
+    {
+        a -= 2 * (float)M_PI;
+    }
+    while (a <= -(float)M_PI)
+    {
+        a += 2 * (float)M_PI;
+    }
+    return a;
+}
+
+int FEHPath::Encoder::Counts()
+{
+    return _single ? _single->Counts() : _quadrature->Counts();
+}
+
+FEHPath::FEHPath(FEHMotor &leftMotor, FEHMotor &rightMotor, Encoder leftEncoder, Encoder rightEncoder,
+                 float wheelDiameter, float trackWidth, int countsPerRev, float topSpeed)
+    : _leftMotor(leftMotor), _rightMotor(rightMotor), _leftEncoder(leftEncoder), _rightEncoder(rightEncoder)
+{
+    _inchesPerCount = (float)M_PI * wheelDiameter / countsPerRev;
+    _trackWidth = trackWidth;
+    _topSpeed = topSpeed;
+    _leftMotorSign = _rightMotorSign = 1;
+    _leftEncoderSign = _rightEncoderSign = 1;
+
+    _maxVelocity = 0.9f * topSpeed;
+    _maxAcceleration = 24;
+    _lookahead = 4;
+    _speedGain = 2;
+
+    _x = _y = _heading = 0;
+    _leftCounts = _leftEncoder.Counts();
+    _rightCounts = _rightEncoder.Counts();
+    _leftSpeed = _rightSpeed = 0;
+    _leftCommand = _rightCommand = 0;
+    _lastMicros = TimeNowMicros();
+
+    Clear();
+    _state = IDLE;
+}
+
+void FEHPath::SetMotorReversed(bool left, bool right)
+{
+    _leftMotorSign = left ? -1 : 1;
+    _rightMotorSign = right ? -1 : 1;
+}
+
+void FEHPath::SetEncoderReversed(bool left, bool right)
+{
+    _leftEncoderSign = left ? -1 : 1;
+    _rightEncoderSign = right ? -1 : 1;
+}
+
+void FEHPath::SetSpeedLimits(float maxVelocity, float maxAcceleration)
+{
+    _maxVelocity = maxVelocity > _topSpeed ? _topSpeed : maxVelocity;
+    _maxAcceleration = maxAcceleration;
+}
+
+void FEHPath::SetLookahead(float inches)
+{
+    _lookahead = inches;
+}
+
+void FEHPath::SetSpeedGain(float percentPerInchPerSecond)
+{
+    _speedGain = percentPerInchPerSecond;
+}
+
+void FEHPath::SetPose(float x, float y, float headingDeg)
+{
+    _x = x;
+    _y = y;
+    _heading = headingDeg * (float)M_PI / 180.0f;
+}
+
+FEHPath::Pose FEHPath::GetPose()
+{
+    Pose pose = {_x, _y, _heading * 180.0f / (float)M_PI};
+    return pose;
+}
+
+//=============================================================================
+// PATH
+//=============================================================================
+
+void FEHPath::Clear()
+{
+    _segmentCount = 0;
+    _endX = _x;
+    _endY = _y;
+    _endHeading = _heading;
+    _finishTurn = false;
+    _state = TRACKING;
+    _current = 0;
+    _progress = 0;
+    _speed = 0;
+}
+
+bool FEHPath::addSegment(float length, float curvature, float heading)
+{
+    if (_segmentCount >= MAX_SEGMENTS || length <= 0)
+    {
+        return _segmentCount < MAX_SEGMENTS;
+    }
+
+    Segment &seg = _segments[_segmentCount];
+    seg.x = _endX;
+    seg.y = _endY;
+    seg.heading = heading;
+    seg.length = length;
+    seg.curvature = curvature;
+    seg.start = _segmentCount ? _segments[_segmentCount - 1].start + _segments[_segmentCount - 1].length : 0;
+
+    // Arcs are limited by sideways acceleration
+    float limit = _maxVelocity;
+    if (curvature != 0)
+    {
+        limit = fminf(limit, sqrtf(_maxAcceleration / fabsf(curvature)));
+    }
+    if (_segmentCount)
+    {
+        // A heading change at the join is rounded by pure pursuit into a turn of about
+        // lookahead / (2 sin(turn / 2)) radius
+        float turn = fabsf(wrapAngle(heading - _endHeading));
+        if (turn > 0.01f)
+        {
+            float radius = _lookahead / (2 * sinf(turn / 2));
+            limit = fminf(limit, sqrtf(_maxAcceleration * radius));
+        }
+        const Segment &prev = _segments[_segmentCount - 1];
+        if (prev.curvature != 0)
+        {
+            limit = fminf(limit, sqrtf(_maxAcceleration / fabsf(prev.curvature)));
+        }
+    }
+    seg.entrySpeed = limit;
+    _segmentCount++;
+
+    _current = 0;
+    pointAt(seg.start + length, &_endX, &_endY);
+    _endHeading = heading + curvature * length;
+    return true;
+}
+
+bool FEHPath::LineTo(float x, float y)
+{
+    float dx = x - _endX, dy = y - _endY;
+    return addSegment(sqrtf(dx * dx + dy * dy), 0, atan2f(dy, dx));
+}
+
+bool FEHPath::Arc(float radius, float degrees)
+{
+    float angle = degrees * (float)M_PI / 180.0f;
+    float curvature = (angle < 0 ? -1 : 1) / radius;
+    return addSegment(fabsf(angle) * radius, curvature, _endHeading);
+}
+
+void FEHPath::SetFinishHeading(float headingDeg)
+{
+    _finishTurn = true;
+    _finishHeading = headingDeg * (float)M_PI / 180.0f;
+}
+
+/* Point at path distance @p s. Past the end the path continues straight along its final
+ * heading, so the lookahead point never stops short of the robot. */
+void FEHPath::pointAt(float s, float *x, float *y)
+{
+    if (_segmentCount == 0)
+    {
+        *x = _endX;
+        *y = _endY;
+        return;
+    }
+
+    uint8_t i = _current;
+    while (i + 1 < _segmentCount && s > _segments[i].start + _segments[i].length)
+    {
+        i++;
+    }
+    const Segment &seg = _segments[i];
+    float u = s - seg.start;
+    if (i + 1 == _segmentCount && u > seg.length && seg.curvature != 0)
+    {
+        float ex, ey;
+        float h = seg.heading + seg.curvature * seg.length;
+        pointAt(seg.start + seg.length, &ex, &ey);
+        *x = ex + (u - seg.length) * cosf(h);
+        *y = ey + (u - seg.length) * sinf(h);
+        return;
+    }
+
+    float k = seg.curvature;
+    if (k == 0)
+    {
+        *x = seg.x + u * cosf(seg.heading);
+        *y = seg.y + u * sinf(seg.heading);
+    }
+    else
+    {
+        *x = seg.x + (sinf(seg.heading + k * u) - sinf(seg.heading)) / k;
+        *y = seg.y - (cosf(seg.heading + k * u) - cosf(seg.heading)) / k;
+    }
+}
+
+/* Distance along segment @p index of the point closest to the robot, and how far away it is */
+float FEHPath::project(uint8_t index, float *distance)
+{
+    const Segment &seg = _segments[index];
+    bool last = index + 1 == _segmentCount;
+    float u;
+
+    if (seg.curvature == 0)
+    {
+        u = (_x - seg.x) * cosf(seg.heading) + (_y - seg.y) * sinf(seg.heading);
+        // The last line extends past its end so the remaining distance can go negative
+        u = u < 0 ? 0 : (!last && u > seg.length ? seg.length : u);
+    }
+    else
+    {
+        float k = seg.curvature;
+        float cx = seg.x - sinf(seg.heading) / k, cy = seg.y + cosf(seg.heading) / k;
+        float a0 = atan2f(seg.y - cy, seg.x - cx);
+        float a = atan2f(_y - cy, _x - cx);
+        // Choose the turn nearest to the current progress, so arcs past 180 degrees work
+        float expected = index == _current ? k * (_progress - seg.start) : 0;
+        float turned = wrapAngle(a - a0 - expected) + expected;
+        u = turned / k;
+        u = u < 0 ? 0 : (u > seg.length ? seg.length : u);
+    }
+
+    float px, py;
+    uint8_t current = _current;
+    _current = index;
+    pointAt(seg.start + u, &px, &py);
+    _current = current;
+    *distance = sqrtf((_x - px) * (_x - px) + (_y - py) * (_y - py));
+    return u;
+}
+
+/* Fastest speed at path distance @p s that can still slow for every limit ahead */
+float FEHPath::profileSpeed(float s)
+{
+    const Segment &seg = _segments[_current];
+    float v = _maxVelocity;
+    if (seg.curvature != 0)
+    {
+        v = fminf(v, sqrtf(_maxAcceleration / fabsf(seg.curvature)));
+    }
+    for (uint8_t i = _current + 1; i < _segmentCount; i++)
+    {
+        float d = _segments[i].start - s;
+        v = fminf(v, sqrtf(_segments[i].entrySpeed * _segments[i].entrySpeed + 2 * _maxAcceleration * d));
+    }
+    const Segment &last = _segments[_segmentCount - 1];
+    float remaining = last.start + last.length - s;
+    return fminf(v, sqrtf(2 * _maxAcceleration * (remaining > 0 ? remaining : 0)));
+}
+
+//=============================================================================
+// CONTROL
+//=============================================================================
+
+void FEHPath::updateOdometry(float dt)
+{
+    int leftCounts = _leftEncoder.Counts(), rightCounts = _rightEncoder.Counts();
+    int16_t leftDelta = (int16_t)(leftCounts - _leftCounts), rightDelta = (int16_t)(rightCounts - _rightCounts);
+    _leftCounts = leftCounts;
+    _rightCounts = rightCounts;
+
+    float left = leftDelta * _inchesPerCount;
+    float right = rightDelta * _inchesPerCount;
+    left *= _leftEncoder.Quadrature() ? _leftEncoderSign : (_leftCommand < 0 ? -1 : 1);
+    right *= _rightEncoder.Quadrature() ? _rightEncoderSign : (_rightCommand < 0 ? -1 : 1);
+
+    float turn = (right - left) / _trackWidth;
+    float mid = _heading + turn / 2;
+    float forward = (left + right) / 2;
+    _x += forward * cosf(mid);
+    _y += forward * sinf(mid);
+    _heading = wrapAngle(_heading + turn);
+
+    if (dt > 0)
+    {
+        _leftSpeed = (_leftSpeed + left / dt) / 2;
+        _rightSpeed = (_rightSpeed + right / dt) / 2;
+    }
+}
+
+/* Hold each wheel at its speed: feedforward from the top speed plus a correction */
+void FEHPath::drive(float leftSpeed, float rightSpeed)
+{
+    _leftCommand = leftSpeed;
+    _rightCommand = rightSpeed;
+
+    float left = 100 * leftSpeed / _topSpeed + _speedGain * (leftSpeed - _leftSpeed);
+    float right = 100 * rightSpeed / _topSpeed + _speedGain * (rightSpeed - _rightSpeed);
+    left = fmaxf(-100, fminf(100, left));
+    right = fmaxf(-100, fminf(100, right));
+
+    _leftMotor.SetPercent((int8_t)lroundf(left * _leftMotorSign));
+    _rightMotor.SetPercent((int8_t)lroundf(right * _rightMotorSign));
+}
+
+void FEHPath::Stop()
+{
+    _leftMotor.Stop();
+    _rightMotor.Stop();
+    _leftCommand = _rightCommand = 0;
+    _speed = 0;
+    _state = DONE;
+}
+
+bool FEHPath::Update()
+{
+    uint64_t now = TimeNowMicros();
+    float dt = (now - _lastMicros) * 1e-6f;
+    _lastMicros = now;
+    if (dt > MAX_STEP)
+    {
+        dt = MAX_STEP;
+    }
+    updateOdometry(dt);
+
+    if (_state == TRACKING)
+    {
+        float remaining = 0;
+        if (_segmentCount)
+        {
+            // Progress moves to the next segment once the robot is closer to it
+            float distance, nextDistance;
+            float u = project(_current, &distance);
+            while (_current + 1 < _segmentCount)
+            {
+                float next = project(_current + 1, &nextDistance);
+                if (next <= 0 || nextDistance > distance)
+                {
+                    break;
+                }
+                _current++;
+                u = next;
+                distance = nextDistance;
+            }
+            float s = _segments[_current].start + u;
+            _progress = s > _progress ? s : _progress;
+
+            const Segment &last = _segments[_segmentCount - 1];
+            remaining = last.start + last.length - _progress;
+        }
+
+        if (remaining <= END_TOLERANCE)
+        {
+            _speed = 0;
+            _state = _finishTurn ? TURNING : DONE;
+        }
+        else
+        {
+            _speed = fminf(profileSpeed(_progress), _speed + _maxAcceleration * dt);
+            _speed = fmaxf(_speed, MIN_SPEED);
+
+            // Steer along the circle through the lookahead point
+            float tx, ty;
+            pointAt(_progress + _lookahead, &tx, &ty);
+            float dx = tx - _x, dy = ty - _y;
+            float ahead = dx * cosf(_heading) + dy * sinf(_heading);
+            float side = -dx * sinf(_heading) + dy * cosf(_heading);
+            float curvature = 2 * side / (ahead * ahead + side * side);
+
+            float left = _speed * (1 - curvature * _trackWidth / 2);
+            float right = _speed * (1 + curvature * _trackWidth / 2);
+            float fastest = fmaxf(fabsf(left), fabsf(right));
+            if (fastest > _topSpeed)
+            {
+                left *= _topSpeed / fastest;
+                right *= _topSpeed / fastest;
+            }
+            drive(left, right);
+            return false;
+        }
+    }
+
+    if (_state == TURNING)
+    {
+        float error = wrapAngle(_finishHeading - _heading);
+        if (fabsf(error) < TURN_TOLERANCE)
+        {
+            Stop();
+            return true;
+        }
+
+        // Wheel speed profile over the arc each wheel still has to roll
+        float arc = fabsf(error) * _trackWidth / 2;
+        float limit = fminf(_maxVelocity, sqrtf(2 * _maxAcceleration * arc));
+        if ((error > 0) != (_rightCommand > 0))
+        {
+            _speed = 0;
+        }
+        _speed = fmaxf(fminf(limit, _speed + _maxAcceleration * dt), MIN_SPEED);
+        float direction = error > 0 ? 1 : -1;
+        drive(-direction * _speed, direction * _speed);
+        return false;
+    }
+
+    if (_state == DONE || _state == IDLE)
+    {
+        if (_leftCommand != 0 || _rightCommand != 0)
+        {
+            Stop();
+        }
+        return true;
+    }
+    return false;
+}
+
+bool FEHPath::Follow(float timeoutSeconds)
+{
+    Deadline timeout = Deadline::InMillis((uint32_t)(timeoutSeconds * 1000));
+    _lastMicros = TimeNowMicros();
+
+    while (!Update())
+    {
+        if (timeout.Expired())
+        {
+            Stop();
+            return false;
+        }
+        Sleep((int)PERIOD_MS);
+    }
+    return true;
+}
@@ -0,0 +1,269 @@
+/**
+ * FEHPeriodic.cpp
+ *
+ * Periodic callbacks on Timer 1 compare B.
+ *
+ * Timer 1 counts at clk/8 (0.5 us) and free-runs: the servo library paces its frames with
+ * OCR1A and this file paces releases with OCR1B, so the two share the counter without
+ * disturbing each other. Every callback keeps its next release as a Timer 1 count; OCR1B
+ * is pointed at the soonest one. Periods are at most 20000 ticks, under half the counter's
+ * range, so signed differences of counts order them correctly across the wrap.
+ *
+ * The ISR masks its own interrupt and then enables interrupts while callbacks run, so the
+ * servo frames, encoder pin changes and the scheduler can preempt a control loop.
+ */
+
+#include <FEH.h>
+#include <FEHPeriodic.h>
+#include "../private_include/FEHInternal.h"
+#include <Arduino.h>
+#include <util/atomic.h>
+
+#define TICKS_PER_US 2
+
+struct PeriodicEntry
+{
+    void (*callback)();
+    uint16_t period;  // Ticks
+    uint16_t budget;  // Ticks
+    uint16_t release; // Timer 1 count of the next release
+    uint8_t strikes;  // Runs over budget in a row
+    uint16_t maxLatency;
+    uint16_t maxRun;
+    FEHPeriodic::Stats stats;
+};
+
+static PeriodicEntry s_entries[PERIODIC_MAX_CALLBACKS];
+
+/* Set while the ISR runs callbacks; it re-arms OCR1B itself when they are done */
+static volatile bool s_dispatching;
+
+/* TCNT1 with interrupts enabled: a nested ISR touching Timer 1 between the two byte reads
+ * would overwrite the shared TEMP register holding the high byte */
+static inline uint16_t timer1Now()
+{
+    uint16_t now;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        now = TCNT1;
+    }
+    return now;
+}
+
+/**
+ * Point OCR1B at the soonest release. Called with interrupts disabled.
+ *
+ * @return true if a release is already due, in which case nothing is armed
+ */
+static bool armNext()
+{
+    uint16_t now = TCNT1;
+    uint16_t soonest = 0xFFFF;
+    bool any = false;
+    for (PeriodicEntry &e : s_entries)
+    {
+        if (e.callback == NULL || e.stats.stopped)
+        {
+            continue;
+        }
+        int16_t wait = (int16_t)(e.release - now);
+        if (wait <= 0)
+        {
+            return true;
+        }
+        if ((uint16_t)wait < soonest)
+        {
+            soonest = wait;
+            any = true;
+        }
+    }
+
+    if (!any)
+    {
+        TIMSK1 &= ~_BV(OCIE1B);
+        return false;
+    }
+    uint16_t next = now + soonest;
+    OCR1B = next;
+    TIFR1 = _BV(OCF1B);
+    TIMSK1 |= _BV(OCIE1B);
+    // The counter may have passed the compare value while it was written
+    return (int16_t)(TCNT1 - next) >= 0;
+}
+
+static void runEntry(PeriodicEntry &e, uint16_t start)
+{
+    uint16_t latency = start - e.release;
+    e.callback();
+    uint16_t end = timer1Now();
+    uint16_t run = end - start;
+
+    e.stats.runs++;
+    e.maxLatency = latency > e.maxLatency ? latency : e.maxLatency;
+    e.maxRun = run > e.maxRun ? run : e.maxRun;
+    if (run > e.budget)
+    {
+        e.stats.overBudget++;
+        if (++e.strikes >= PERIODIC_MAX_OVER_BUDGET)
+        {
+            e.stats.stopped = true;
+        }
+    }
+    else
+    {
+        e.strikes = 0;
+    }
+
+    // Releases that passed while it ran are skipped, not run late back to back
+    uint16_t next = e.release + e.period;
+    while ((int16_t)(end - next) >= 0)
+    {
+        next += e.period;
+        e.stats.overruns++;
+    }
+    e.release = next;
+}
+
+bool _inInterruptContext()
+{
+    return !(SREG & bit(SREG_I)) || s_dispatching;
+}
+
+ISR(TIMER1_COMPB_vect)
+{
+    TIMSK1 &= ~_BV(OCIE1B);
+    s_dispatching = true;
+    do
+    {
+        sei();
+        for (PeriodicEntry &e : s_entries)
+        {
+            if (e.callback == NULL || e.stats.stopped)
+            {
+                continue;
+            }
+            uint16_t start = timer1Now();
+            if ((int16_t)(start - e.release) >= 0)
+            {
+                runEntry(e, start);
+            }
+        }
+        cli();
+    } while (armNext());
+    s_dispatching = false;
+}
+
+bool FEHPeriodic::attach(void (*callback)(), unsigned int hz, unsigned int budgetMicros)
+{
+    if (callback == NULL || hz < PERIODIC_MIN_HZ || hz > PERIODIC_MAX_HZ)
+    {
+        return false;
+    }
+    uint16_t period = (uint16_t)((F_CPU / 8) / hz);
+    uint32_t budget = budgetMicros ? (uint32_t)budgetMicros * TICKS_PER_US : period / 4;
+    if (budget >= period)
+    {
+        return false;
+    }
+
+    // Load in thousandths of the CPU, counting this callback at its new rate
+    PeriodicEntry *slot = NULL;
+    uint32_t load = budget * 1000 / period;
+    for (PeriodicEntry &e : s_entries)
+    {
+        if (e.callback == callback)
+        {
+            slot = &e;
+        }
+        else if (e.callback != NULL && !e.stats.stopped)
+        {
+            load += (uint32_t)e.budget * 1000 / e.period;
+        }
+    }
+    if (load > PERIODIC_MAX_LOAD_PERCENT * 10)
+    {
+        return false;
+    }
+    for (PeriodicEntry &e : s_entries)
+    {
+        if (slot == NULL && e.callback == NULL)
+        {
+            slot = &e;
+        }
+    }
+    if (slot == NULL)
+    {
+        return false;
+    }
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        // The servo library may not have started Timer 1
+        if ((TCCR1B & (_BV(CS12) | _BV(CS11) | _BV(CS10))) == 0)
+        {
+            TCCR1A = 0;
+            TCCR1B = _BV(CS11);
+        }
+
+        memset(slot, 0, sizeof(*slot));
+        slot->callback = callback;
+        slot->period = period;
+        slot->budget = budget;
+        slot->release = TCNT1 + period;
+        if (!s_dispatching)
+        {
+            armNext();
+        }
+    }
+    return true;
+}
+
+void FEHPeriodic::detach(void (*callback)())
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        for (PeriodicEntry &e : s_entries)
+        {
+            if (e.callback == callback)
+            {
+                e.callback = NULL;
+            }
+        }
+        if (!s_dispatching)
+        {
+            armNext();
+        }
+    }
+}
+
+bool FEHPeriodic::stats(void (*callback)(), Stats *stats)
+{
+    for (PeriodicEntry &e : s_entries)
+    {
+        if (callback != NULL && e.callback == callback)
+        {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                *stats = e.stats;
+                stats->maxLatencyMicros = e.maxLatency / TICKS_PER_US;
+                stats->maxRunMicros = e.maxRun / TICKS_PER_US;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void FEHPeriodic::resetStats()
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        for (PeriodicEntry &e : s_entries)
+        {
+            bool stopped = e.stats.stopped;
+            memset(&e.stats, 0, sizeof(e.stats));
+            e.stats.stopped = stopped;
+            e.maxLatency = e.maxRun = 0;
+        }
+    }
+}
@@ -25,7 +25,7 @@ FEHRCS RCS;
  *
  * @param team_key The team key used for authentication or identification.
  */
-void FEHRCS::InitializeTouchMenu(const char *team_key)
+void FEHRCS::InitializeTouchMenu(const char *team_key, bool wait)
 {
     int cancel = 1;
     int c = 0, d = 0, n;
@@ -33,16 +33,19 @@ void FEHRCS::InitializeTouchMenu(const char *team_key)
     char region;
 
     FEHIcon::Icon regions_title[1];
-    char regions_title_label[1][20] = {"Select RCS Region"};
+    static const char regions_title_label[1][20] PROGMEM = {"Select RCS Region"};
 
     FEHIcon::Icon regions[REGION_COUNT];
-    char regions_labels[12][20] = {"A", "B", "C", "D", "E", "F", "G", "H", "I", "J", "K", "L"};
+    static const char regions_labels[12][20] PROGMEM = {"A", "B", "C", "D", "E", "F", "G", "H", "I", "J", "K", "L"};
 
     FEHIcon::Icon confirm_title[1];
     char confirm_title_label[1][20] = {""};
 
     FEHIcon::Icon confirm[2];
-    char confirm_labels[2][20] = {"Ok", "Cancel"};
+    static const char confirm_labels[2][20] PROGMEM = {"Ok", "Cancel"};
+
+    // Join the network while the region is chosen
+    BeginConnect();
 
     while (cancel)
     {
@@ -52,12 +55,13 @@ void FEHRCS::InitializeTouchMenu(const char *team_key)
 
         int regionLabelRowCount = REGION_COUNT / 4;
 
-        FEHIcon::DrawIconArray(regions_title, 1, 1, 1, 201, 1, 1, regions_title_label, BLACK, WHITE);
-        FEHIcon::DrawIconArray(regions, regionLabelRowCount, 4, 40, 2, 1, 1, regions_labels, WHITE, WHITE);
+        FEHIcon::DrawIconArray_P(regions_title, 1, 1, 1, 201, 1, 1, regions_title_label, BLACK, WHITE);
+        FEHIcon::DrawIconArray_P(regions, regionLabelRowCount, 4, 40, 2, 1, 1, regions_labels, WHITE, WHITE);
 
         // Wait for region selection
         while (!c)
         {
+            _serviceDeferredWork();
             if (LCD.Touch(&x, &y))
             {
                 for (n = 0; n < REGION_COUNT; n++)
@@ -73,15 +77,16 @@ void FEHRCS::InitializeTouchMenu(const char *team_key)
 
         // Compute region character and update the confirm title without switch-case
         region = 'A' + c - 1;
-        sprintf(confirm_title_label[0], "Choice: %c", region);
+        snprintf_P(confirm_title_label[0], sizeof(confirm_title_label[0]), PSTR("Choice: %c"), region);
 
         LCD.Clear(BLACK);
         FEHIcon::DrawIconArray(confirm_title, 1, 1, 60, 201, 1, 1, confirm_title_label, BLACK, WHITE);
-        FEHIcon::DrawIconArray(confirm, 1, 2, 60, 60, 1, 1, confirm_labels, WHITE, WHITE);
+        FEHIcon::DrawIconArray_P(confirm, 1, 2, 60, 60, 1, 1, confirm_labels, WHITE, WHITE);
 
         // Wait for confirmation selection
         while (!d)
         {
+            _serviceDeferredWork();
             if (LCD.Touch(&x, &y))
             {
                 for (n = 0; n < 2; n++)
@@ -99,7 +104,7 @@ void FEHRCS::InitializeTouchMenu(const char *team_key)
         cancel = (d == 1) ? 0 : 1;
     }
 
-    Initialize(region, team_key);
+    Initialize(region, team_key, wait);
 }
 
 /**
@@ -108,70 +113,216 @@ void FEHRCS::InitializeTouchMenu(const char *team_key)
  * Sends CMD_RCS_CONNECT to the ESP32, which opens a UDP socket and begins
  * continuously sending RobotIdentPacket to the RCS server (gateway IP, port 5000).
  * The ESP32 forwards received RobotPacket data as NOTIFY_RCS_DATA notifications.
+ * The connect is sent by service() once the WiFi join started by BeginConnect() is up.
  *
  * @param region The selected course region to connect to ('A'-'H').
  * @param team_key The team key used for identification (up to 9 characters).
+ * @param wait Block until connected, failing fatally if the connection fails.
  */
-void FEHRCS::Initialize(char region, const char *team_key)
+void FEHRCS::Initialize(char region, const char *team_key, bool wait)
 {
     // Check that region is in the range A-H
     if (region < 'A' || region > 'H')
     {
-        _fatalError("Invalid region selected: " + region);
+        char msg[32];
+        snprintf_P(msg, sizeof(msg), PSTR("Invalid region selected: %c"), region);
+        _fatalError(msg);
     }
 
-    LCD.Clear();
+    // Set internal region variable
+    _region = region;
+    strncpy(_teamKey, team_key, sizeof(_teamKey) - 1);
+    _teamKey[sizeof(_teamKey) - 1] = '\0';
+    _times.regionChosen = millis();
 
-    // Connect to RCS wifi network (separate from OTA wifi network)
-    LCD.WriteLine("Connecting to RCS WiFi...");
-    FEHESP32::connectWifi(RCS_WIFI_SSID, RCS_WIFI_PASS);
-    bool connected = FEHESP32::waitForWifiConnect(10000);
-    if (!connected)
+    BeginConnect();
+    // A background join has its time limit restarted by the choice
+    if (_state == CONNECT_JOINING_WIFI)
     {
-        _fatalError("Failed to connect to RCS.");
+        _phaseStart = _times.regionChosen;
     }
+    service();
 
-    // Set internal region variable
-    _region = region;
+    if (!wait)
+    {
+        return;
+    }
+
+    LCD.Clear();
+    if (!IsReady())
+    {
+        LCD.Write(F("Connecting to RCS region "));
+        LCD.Write(region);
+        LCD.WriteLine(F("..."));
+    }
 
-    // Register RCS data callback with ESP32 driver
-    FEHESP32::setRCSCallback(handleRCSData);
+    if (!WaitReady())
+    {
+        _fatalError(_failure ? _failure : F("Failed to connect to RCS."));
+    }
 
-    LCD.Write("Connecting to RCS region ");
+    LCD.Write(F("RCS Region "));
     LCD.Write(region);
-    LCD.WriteLine("...");
+    LCD.WriteLine(F(" connected!"));
+}
+
+void FEHRCS::BeginConnect()
+{
+    if (_state != CONNECT_IDLE && _state != CONNECT_FAILED)
+    {
+        return;
+    }
+
+    // Connect to RCS wifi network (separate from OTA wifi network)
+    _failure = nullptr;
+    _times.started = millis();
+    _times.wifiConnected = 0;
+    _times.rcsSent = 0;
+    _times.ready = 0;
+    _phaseStart = _times.started;
+    _state = CONNECT_JOINING_WIFI;
+    FEHESP32::connectWifi(RCS_WIFI_SSID, RCS_WIFI_PASS);
+}
+
+void FEHRCS::fail(const __FlashStringHelper *reason)
+{
+    _failure = reason;
+    _state = CONNECT_FAILED;
+
+    // The log's %s takes a string in RAM
+    char text[48];
+    strncpy_P(text, (PGM_P)reason, sizeof(text) - 1);
+    text[sizeof(text) - 1] = '\0';
+    FEH_LOG_WARN(RCS, "%s", text);
+}
 
-    // Send RCS connect command to ESP32
-    uint8_t rcs_server_ip[] = RCS_SERVER_IP_BYTES;
-    FEHESP32::connectRCS(region, rcs_server_ip, team_key);
+/*
+ * One step of the background connection. Until a region is chosen a WiFi join that
+ * fails or goes unanswered is retried; after that it fails the connection, as the
+ * blocking connect did.
+ */
+bool FEHRCS::service()
+{
+    unsigned long now = millis();
 
-    // Wait for ACK from ESP32
-    if (!FEHESP32::waitForAck(CMD_RCS_CONNECT, 3000))
+    switch (_state)
     {
-        _fatalError("ESP32 did not acknowledge RCS connect.");
+    case CONNECT_JOINING_WIFI:
+        if (FEHESP32::hasWifiResult() && FEHESP32::isConnected())
+        {
+            _times.wifiConnected = now;
+            _state = CONNECT_WIFI_UP;
+            FEH_LOG_DEBUG(RCS, "WiFi up after %lu ms", now - _times.started);
+            return service();
+        }
+        if (FEHESP32::hasWifiResult() || now - _phaseStart >= RCS_WIFI_TIMEOUT_MS)
+        {
+            if (_region != 'z')
+            {
+                fail(F("Failed to connect to RCS."));
+                return false;
+            }
+            FEH_LOG_DEBUG(RCS, "no region yet, joining WiFi again");
+            _phaseStart = now;
+            FEHESP32::connectWifi(RCS_WIFI_SSID, RCS_WIFI_PASS);
+            return true;
+        }
+        return false;
+
+    case CONNECT_WIFI_UP:
+        if (!FEHESP32::isConnected())
+        {
+            // Dropped before the region was chosen: join again
+            FEH_LOG_WARN(RCS, "WiFi dropped, joining again");
+            _phaseStart = now;
+            _state = CONNECT_JOINING_WIFI;
+            FEHESP32::connectWifi(RCS_WIFI_SSID, RCS_WIFI_PASS);
+            return true;
+        }
+        if (_region == 'z')
+        {
+            return false;
+        }
+        {
+            // Register RCS data callback with ESP32 driver
+            FEHESP32::setRCSCallback(handleRCSData);
+
+            // Send RCS connect command to ESP32
+            uint8_t rcs_server_ip[] = RCS_SERVER_IP_BYTES;
+            FEHESP32::connectRCS(_region, rcs_server_ip, _teamKey);
+        }
+        FEH_LOG_DEBUG(RCS, "region %c sent", _region);
+        _times.rcsSent = now;
+        _phaseStart = now;
+        _state = CONNECT_JOINING_RCS;
+        return true;
+
+    case CONNECT_JOINING_RCS:
+        if (FEHESP32::isAcked(CMD_RCS_CONNECT))
+        {
+            _times.ready = now;
+            _state = CONNECT_READY;
+            initialized = true;
+            FEH_LOG_INFO(RCS, "connected: WiFi +%lu ms, region +%lu ms, ready +%lu ms",
+                         _times.wifiConnected - _times.started, _times.regionChosen - _times.started,
+                         _times.ready - _times.started);
+        }
+        else if (now - _phaseStart >= RCS_ACK_TIMEOUT_MS)
+        {
+            fail(F("ESP32 did not acknowledge RCS connect."));
+        }
+        return false;
+
+    default:
+        return false;
     }
+}
 
-    LCD.Write("RCS Region ");
-    LCD.Write(region);
-    LCD.WriteLine(" connected!");
+bool _rcsService()
+{
+    return RCS.service();
+}
+
+bool FEHRCS::IsReady()
+{
+    service();
+    return _state == CONNECT_READY;
+}
 
-    initialized = true;
+bool FEHRCS::WaitReady(unsigned long timeout_ms)
+{
+    Deadline timeout = Deadline::InMillis(timeout_ms);
+    while (!IsReady())
+    {
+        if (_region == 'z' || _state == CONNECT_IDLE || _state == CONNECT_FAILED || timeout.Expired())
+        {
+            return false;
+        }
+        delay(10);
+        FEHESP32::poll();
+    }
+    return true;
+}
+
+const FEHRCS::ConnectTimes &FEHRCS::GetConnectTimes()
+{
+    return _times;
 }
 
 int FEHRCS::CurrentCourse()
 {
-    if (!initialized)
+    if (!initialized && !WaitReady())
     {
-        _fatalError("FEHRCS not initialized and FEHRCS::CurrentCourse() called.");
+        _fatalError(F("FEHRCS not initialized and FEHRCS::CurrentCourse() called."));
     }
     return (int)(_region - 'A');
 }
 
 char FEHRCS::CurrentRegionLetter()
 {
-    if (!initialized)
+    if (!initialized && !WaitReady())
     {
-        _fatalError("FEHRCS not initialized and FEHRCS::CurrentRegionLetter() called.");
+        _fatalError(F("FEHRCS not initialized and FEHRCS::CurrentRegionLetter() called."));
     }
     return _region;
 }
@@ -195,23 +346,24 @@ void FEHRCS::handleRCSData(const uint8_t *data, uint8_t len)
         RCS._dualSliderStatus = data[2];
         RCS._time = data[3];
         // data[4] = kill switch (not currently exposed via FEHRCS API)
+        FEH_LOG_TRACE(RCS, "lever %u/%u slider %u time %u", data[0], data[1], data[2], data[3]);
     }
 }
 
 int FEHRCS::GetLever()
 {
-    if (!initialized)
+    if (!initialized && !WaitReady())
     {
-        _fatalError("FEHRCS not initialized and FEHRCS::GetLever() called.");
+        _fatalError(F("FEHRCS not initialized and FEHRCS::GetLever() called."));
     }
     return _correctLever;
 }
 
 int FEHRCS::isLeverFlipped()
 {
-    if (!initialized)
+    if (!initialized && !WaitReady())
     {
-        _fatalError("FEHRCS not initialized and FEHRCS::isLeverFlipped() called.");
+        _fatalError(F("FEHRCS not initialized and FEHRCS::isLeverFlipped() called."));
     }
     if (RCS._leverFlipped == 1)
     {
@@ -222,9 +374,9 @@ int FEHRCS::isLeverFlipped()
 
 int FEHRCS::isWindowOpen()
 {
-    if (!initialized)
+    if (!initialized && !WaitReady())
     {
-        _fatalError("FEHRCS not initialized and FEHRCS::isWindowOpen() called.");
+        _fatalError(F("FEHRCS not initialized and FEHRCS::isWindowOpen() called."));
     }
     if (RCS._dualSliderStatus == 2)
     {
@@ -236,9 +388,9 @@ int FEHRCS::isWindowOpen()
 // returns the match time in seconds
 int FEHRCS::Time()
 {
-    if (!initialized)
+    if (!initialized && !WaitReady())
     {
-        _fatalError("FEHRCS not initialized and FEHRCS::Time() called.");
+        _fatalError(F("FEHRCS not initialized and FEHRCS::Time() called."));
     }
     return (int)RCS._time;
 }
\ No newline at end of file
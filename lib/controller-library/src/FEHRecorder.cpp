@@ -0,0 +1,372 @@
+/**
+ * FEHRecorder.cpp
+ *
+ * Input recorder. The file format is described in private_include/recorder.h.
+ *
+ * Reads come from the main thread and from interrupts (battery checks, ESP32 polling,
+ * FEHPeriodic callbacks), so the channel table and the ring buffer are only touched with
+ * interrupts disabled. The buffer is drained to the SD card by reads made from the main
+ * thread and by Sleep().
+ */
+
+#include <FEHRecorder.h>
+#include "../private_include/FEHInternal.h"
+#include "../private_include/recorder.h"
+#include "../private_include/spibus.h"
+#include <Arduino.h>
+#include <SdFat.h>
+#include <util/atomic.h>
+
+#define RECORDER_BUFFER_SIZE 256 // Indexed with uint8_t, so must stay 256
+#define RECORDER_FLUSH_BYTES 64
+#define RECORDER_CHANNELS 16
+#define RECORDER_MAX_RECORD 20 // Largest non-frame record: 2 + 3 * 5 + 3 varint bytes
+#define RECORDER_MAX_RUN 0xFFFF
+
+volatile uint8_t _recorderMode = RECORDER_OFF;
+
+static RecorderReplaySource _replaySource = nullptr;
+
+struct RecorderChannel
+{
+    uint8_t type; // 0 if the slot is free
+    uint8_t id;
+    bool known;             // value holds the last written value, so the next can be a delta
+    int32_t value;          // Last written value
+    int32_t runValue;       // Value of the pending run
+    uint16_t runCount;      // Reads in the pending run, 0 if none
+    unsigned long runStart; // micros() of the first and last read of the pending run
+    unsigned long runEnd;
+};
+
+static RecorderChannel *_channels = nullptr;
+static uint8_t *_buffer = nullptr;
+static uint8_t _head = 0; // Written with interrupts disabled
+static uint8_t _tail = 0; // Written by flush() only
+static uint8_t _nextVictim = 0;
+static unsigned long _lastRecordTime = 0;
+static unsigned long _dropped = 0;
+static bool _flushing = false;
+static SdFile _file;
+
+static uint8_t putVarint(uint8_t *out, uint32_t value)
+{
+    uint8_t n = 0;
+    while (value >= 0x80)
+    {
+        out[n++] = (uint8_t)value | 0x80;
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+static uint8_t putZigzag(uint8_t *out, int32_t value)
+{
+    return putVarint(out, ((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+}
+
+/* Copy into the ring. Interrupts must be disabled. */
+static bool bufferPut(const uint8_t *data, uint8_t len, uint8_t reserve)
+{
+    uint8_t used = _head - _tail;
+    if ((uint16_t)used + len + reserve > RECORDER_BUFFER_SIZE - 1)
+    {
+        return false;
+    }
+    for (uint8_t i = 0; i < len; i++)
+    {
+        _buffer[(uint8_t)(_head + i)] = data[i];
+    }
+    _head += len;
+    return true;
+}
+
+/* Start a record header. Interrupts must be disabled. */
+static uint8_t putHeader(uint8_t *out, uint8_t type, uint8_t flags, uint8_t id, unsigned long start)
+{
+    out[0] = (type << 4) | flags;
+    out[1] = id;
+    return 2 + putZigzag(out + 2, (int32_t)(start - _lastRecordTime));
+}
+
+/* Write the pending run of a channel. Interrupts must be disabled. */
+static void writeRun(RecorderChannel &c)
+{
+    if (c.runCount == 0)
+    {
+        return;
+    }
+
+    uint8_t flags = (c.runCount > 1 ? RECORD_FLAG_RUN : 0) | (c.known ? 0 : RECORD_FLAG_ABSOLUTE);
+    uint8_t record[RECORDER_MAX_RECORD];
+    uint8_t n = putHeader(record, c.type, flags, c.id, c.runStart);
+    n += putZigzag(record + n, c.known ? c.runValue - c.value : c.runValue);
+    if (c.runCount > 1)
+    {
+        n += putVarint(record + n, c.runCount - 1);
+        n += putVarint(record + n, c.runEnd - c.runStart);
+    }
+
+    if (bufferPut(record, n, 0))
+    {
+        _lastRecordTime = c.runStart;
+        c.value = c.runValue;
+        c.known = true;
+    }
+    else
+    {
+        /* The reader no longer knows this channel's value */
+        _dropped += c.runCount;
+        c.known = false;
+    }
+    c.runCount = 0;
+}
+
+/* Find or claim the slot of a channel. Interrupts must be disabled. */
+static RecorderChannel &channelFor(uint8_t type, uint8_t id)
+{
+    RecorderChannel *free = nullptr;
+    for (uint8_t i = 0; i < RECORDER_CHANNELS; i++)
+    {
+        RecorderChannel &c = _channels[i];
+        if (c.type == type && c.id == id)
+        {
+            return c;
+        }
+        if (c.type == 0 && free == nullptr)
+        {
+            free = &c;
+        }
+    }
+
+    if (free == nullptr)
+    {
+        free = &_channels[_nextVictim];
+        _nextVictim = (_nextVictim + 1) % RECORDER_CHANNELS;
+        writeRun(*free);
+    }
+
+    free->type = type;
+    free->id = id;
+    free->known = false;
+    free->runCount = 0;
+    return *free;
+}
+
+/* Drain the ring to the card. Main thread only. */
+static void flush()
+{
+    if (_flushing)
+    {
+        return;
+    }
+    SpiBusOwner bus(SPI_BUS_SD);
+    if (!bus.owned())
+    {
+        return;
+    }
+    _flushing = true;
+
+    uint8_t chunk[RECORDER_FLUSH_BYTES];
+    for (;;)
+    {
+        uint8_t n;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            uint8_t used = _head - _tail;
+            n = used < sizeof(chunk) ? used : sizeof(chunk);
+            for (uint8_t i = 0; i < n; i++)
+            {
+                chunk[i] = _buffer[(uint8_t)(_tail + i)];
+            }
+            _tail += n;
+        }
+        if (n == 0)
+        {
+            break;
+        }
+        _file.write(chunk, n);
+    }
+
+    _flushing = false;
+}
+
+/* Flush requested from an interrupt, run at an LCD preemption point */
+static void serviceFlush()
+{
+    _recorderService();
+}
+
+int32_t _recorderInput(uint8_t type, uint8_t id, int32_t value)
+{
+    if (_recorderMode == RECORDER_REPLAYING)
+    {
+        return _replaySource(type, id, value);
+    }
+
+    bool mainThread = !_inInterruptContext();
+    uint8_t used;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        unsigned long now = micros();
+        RecorderChannel &c = channelFor(type, id);
+
+        if (c.runCount > 0 && (c.runValue != value || c.runCount == RECORDER_MAX_RUN))
+        {
+            writeRun(c);
+        }
+
+        if (c.runCount == 0)
+        {
+            c.runValue = value;
+            c.runStart = now;
+        }
+        c.runCount++;
+        c.runEnd = now;
+
+        used = _head - _tail;
+    }
+
+    if (used >= RECORDER_FLUSH_BYTES)
+    {
+        if (mainThread)
+        {
+            flush();
+        }
+        else
+        {
+            spiBusRequest(SPI_BUS_SD);
+        }
+    }
+
+    return value;
+}
+
+void _recorderFrame(const uint8_t *frame, uint8_t len)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        unsigned long now = micros();
+        uint8_t header[2 + 5 + 2];
+        uint8_t n = putHeader(header, RECORD_ESP32, 0, 0, now);
+        n += putVarint(header + n, len);
+
+        if (bufferPut(header, n, len))
+        {
+            bufferPut(frame, len, 0);
+            _lastRecordTime = now;
+        }
+        else
+        {
+            _dropped++;
+        }
+    }
+}
+
+bool _recorderService()
+{
+    if (_recorderMode != RECORDER_RECORDING)
+    {
+        return false;
+    }
+
+    uint8_t used;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        used = _head - _tail;
+    }
+    if (used < RECORDER_FLUSH_BYTES)
+    {
+        return false;
+    }
+    flush();
+    return true;
+}
+
+void _recorderReplay(RecorderReplaySource source)
+{
+    _replaySource = source;
+    _recorderMode = source ? RECORDER_REPLAYING : RECORDER_OFF;
+}
+
+bool FEHRecorder::start(const char *filename)
+{
+    if (_recorderMode != RECORDER_OFF)
+    {
+        return false;
+    }
+
+    if (_buffer == nullptr)
+    {
+        _buffer = (uint8_t *)malloc(RECORDER_BUFFER_SIZE);
+        _channels = (RecorderChannel *)malloc(RECORDER_CHANNELS * sizeof(RecorderChannel));
+        if (_buffer == nullptr || _channels == nullptr)
+        {
+            _fatalError(F("FEHRecorder:\nout of memory"));
+        }
+    }
+
+    SpiBusOwner bus(SPI_BUS_SD);
+    if (!_file.open(filename, O_CREAT | O_TRUNC | O_WRITE))
+    {
+        return false;
+    }
+    spiBusSetService(SPI_BUS_SD, serviceFlush);
+
+    memset(_channels, 0, RECORDER_CHANNELS * sizeof(RecorderChannel));
+    _head = _tail = 0;
+    _nextVictim = 0;
+    _dropped = 0;
+    _lastRecordTime = micros();
+
+    uint8_t header[sizeof(RECORDER_MAGIC) - 1 + 1 + 4];
+    memcpy(header, RECORDER_MAGIC, 4);
+    header[4] = RECORDER_VERSION;
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        header[5 + i] = (uint8_t)(_lastRecordTime >> (8 * i));
+    }
+    _file.write(header, sizeof(header));
+
+    _recorderMode = RECORDER_RECORDING;
+    return true;
+}
+
+void FEHRecorder::stop()
+{
+    if (_recorderMode != RECORDER_RECORDING)
+    {
+        return;
+    }
+
+    for (uint8_t i = 0; i < RECORDER_CHANNELS; i++)
+    {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            writeRun(_channels[i]);
+        }
+        flush();
+    }
+
+    _recorderMode = RECORDER_OFF;
+    flush();
+    SpiBusOwner bus(SPI_BUS_SD);
+    _file.close();
+}
+
+bool FEHRecorder::isRecording()
+{
+    return _recorderMode == RECORDER_RECORDING;
+}
+
+unsigned long FEHRecorder::droppedRecords()
+{
+    unsigned long dropped;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        dropped = _dropped;
+    }
+    return dropped;
+}
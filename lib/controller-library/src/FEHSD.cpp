@@ -1,6 +1,7 @@
 #include "FEH.h"
 
 #include "../private_include/FEHInternal.h"
+#include "../private_include/spibus.h"
 
 SdFat FAT;
 
@@ -23,37 +24,37 @@ FEHFile *FEHSD::FOpen(const char *str, const char *mode)
     FEHFile *File = new FEHFile();
 
     // Choosing the appropriate access mode
-    if (strcmp(mode, "r") == 0)
+    if (strcmp_P(mode, PSTR("r")) == 0)
     {
         oflag = O_READ;
     }
-    else if (strcmp(mode, "r+") == 0)
+    else if (strcmp_P(mode, PSTR("r+")) == 0)
     {
         oflag = O_RDWR;
     }
-    else if (strcmp(mode, "w") == 0)
+    else if (strcmp_P(mode, PSTR("w")) == 0)
     {
         oflag = O_CREAT | O_TRUNC | O_WRITE;
     }
-    else if (strcmp(mode, "w+") == 0)
+    else if (strcmp_P(mode, PSTR("w+")) == 0)
     {
         oflag = O_CREAT | O_TRUNC | O_RDWR;
     }
-    else if (strcmp(mode, "a") == 0)
+    else if (strcmp_P(mode, PSTR("a")) == 0)
     {
         oflag = O_CREAT | O_APPEND | O_WRITE;
         inAppendMode = true;
     }
-    else if (strcmp(mode, "a+") == 0)
+    else if (strcmp_P(mode, PSTR("a+")) == 0)
     {
         oflag = O_CREAT | O_APPEND | O_WRITE | O_READ;
         inAppendMode = true;
     }
-    else if (strcmp(mode, "wx") == 0)
+    else if (strcmp_P(mode, PSTR("wx")) == 0)
     {
         oflag = O_CREAT | O_EXCL | O_WRITE;
     }
-    else if (strcmp(mode, "w+x") == 0)
+    else if (strcmp_P(mode, PSTR("w+x")) == 0)
     {
         oflag = O_CREAT | O_EXCL | O_RDWR;
     }
@@ -62,19 +63,24 @@ FEHFile *FEHSD::FOpen(const char *str, const char *mode)
         oflag = O_CREAT | O_TRUNC | O_WRITE;
     }
 
-    f_res = (File->file_ptr).open(str, oflag);
+    {
+        SpiBusOwner bus(SPI_BUS_SD);
+        f_res = (File->file_ptr).open(str, oflag);
+        if (f_res != 0 && inAppendMode)
+        {
+            (File->file_ptr).seekSet((File->file_ptr).fileSize()); // go to the end of the file to append
+        }
+    }
 
     if (f_res == 0)
     {
-        LCD.WriteLine("File failed to open");
+        FEH_LOG_WARN(SD, "open %s (%s) failed", str, mode);
+        LCD.WriteLine(F("File failed to open"));
         return NULL;
     }
-    else if (inAppendMode)
-    {
-        (File->file_ptr).seekSet((File->file_ptr).fileSize()); // go to the end of the file to append
-    }
 
     files[numberOfFiles++] = File;
+    FEH_LOG_DEBUG(SD, "opened %s (%s), %d open", str, mode, numberOfFiles);
 
     return File;
 }
@@ -90,6 +96,7 @@ int FEHSD::FClose(FEHFile *fptr)
             {
                 if (files[i]->file_ptr.isOpen())
                 {
+                    SpiBusOwner bus(SPI_BUS_SD);
                     (files[i]->file_ptr).close(); // I banish thy memoryleaks
                 }
                 // Shift all elements in array one over to the left
@@ -100,6 +107,7 @@ int FEHSD::FClose(FEHFile *fptr)
                 files[numberOfFiles - 1] = NULL;
 
                 numberOfFiles--;
+                FEH_LOG_TRACE(SD, "closed, %d open", numberOfFiles);
                 break;
             }
         }
@@ -116,6 +124,7 @@ int FEHSD::FCloseAll()
         {
             if (files[i]->file_ptr.isOpen())
             {
+                SpiBusOwner bus(SPI_BUS_SD);
                 (files[i]->file_ptr).close(); // I banish thy memoryleaks
             }
             files[i] = NULL;
@@ -130,6 +139,25 @@ int FEHSD::FEof(FEHFile *fptr)
     return (fptr->file_ptr).available64() > 0;
 }
 
+// Write text formatted by FPrintf() to the file
+static int writeFormatted(FEHFile *fptr, const char *buffer)
+{
+    int numChars;
+    {
+        SpiBusOwner bus(SPI_BUS_SD);
+        numChars = (fptr->file_ptr).write(buffer);
+    }
+
+    if (numChars <= 0)
+    {
+        FEH_LOG_WARN(SD, "write of %u bytes failed", (unsigned)strlen(buffer));
+        LCD.WriteLine(F("Error printing to file"));
+        return -1;
+    }
+    // Return number of characters printed
+    return numChars;
+}
+
 int FEHSD::FPrintf(FEHFile *fptr,
                    const char *str, /* Pointer to the format string */
                    ...)
@@ -142,15 +170,20 @@ int FEHSD::FPrintf(FEHFile *fptr,
 
     va_end(args);
 
-    int numChars = (fptr->file_ptr).write(buffer);
+    return writeFormatted(fptr, buffer);
+}
 
-    if (numChars <= 0)
-    {
-        LCD.WriteLine("Error printing to file");
-        return -1;
-    }
-    // Return number of characters printed
-    return numChars;
+int FEHSD::FPrintf(FEHFile *fptr, const __FlashStringHelper *str, ...)
+{
+    va_list args;
+    va_start(args, str);
+    char buffer[BUFFER_SIZE];
+
+    vsnprintf_P(buffer, BUFFER_SIZE, (PGM_P)str, args);
+
+    va_end(args);
+
+    return writeFormatted(fptr, buffer);
 }
 
 int FEHSD::FScanf(FEHFile *fptr, const char *format, ...)
@@ -161,23 +194,26 @@ int FEHSD::FScanf(FEHFile *fptr, const char *format, ...)
     // Check for end of file, return -1 if eof
     if (FEof(fptr) == 0)
     {
-        LCD.WriteLine("Reached end of file");
+        LCD.WriteLine(F("Reached end of file"));
         return -1;
     }
 
     char buffer[BUFFER_SIZE];
 
     int i = 0;
-    while ((fptr->file_ptr).isOpen() && i < BUFFER_SIZE)
     {
-        char c = (fptr->file_ptr).read();
-        if (c == EOF || c == '\n' || c == '\r')
+        SpiBusOwner bus(SPI_BUS_SD);
+        while ((fptr->file_ptr).isOpen() && i < BUFFER_SIZE)
         {
-            buffer[i] = '\0';
-            break;
+            char c = (fptr->file_ptr).read();
+            if (c == EOF || c == '\n' || c == '\r')
+            {
+                buffer[i] = '\0';
+                break;
+            }
+            buffer[i] = c;
+            i++;
         }
-        buffer[i] = c;
-        i++;
     }
 
     //  Scan line and store in args; also get number of args read
@@ -187,7 +223,8 @@ int FEHSD::FScanf(FEHFile *fptr, const char *format, ...)
 
     if (numRead == -1)
     {
-        LCD.WriteLine("Error reading from file");
+        FEH_LOG_WARN(SD, "line did not match \"%s\"", format);
+        LCD.WriteLine(F("Error reading from file"));
         return -1;
     }
 
@@ -197,6 +234,7 @@ int FEHSD::FScanf(FEHFile *fptr, const char *format, ...)
 
 int FEHSD::FSeek(FEHFile *fptr, long int offset, int position)
 {
+    SpiBusOwner bus(SPI_BUS_SD);
     if (position == SEEK_CUR)
     {
         return (fptr->file_ptr).seekSet((fptr->file_ptr).curPosition() + offset);
@@ -211,34 +249,83 @@ int FEHSD::FSeek(FEHFile *fptr, long int offset, int position)
     }
 }
 
+// Console output for FlushToConsole(): framed text while telemetry is on, which waits for
+// room rather than dropping file contents
+static void consoleWrite(const char *text, size_t len)
+{
+    if (FEHTelemetry::isActive())
+        FEHTelemetry::sendText(text, len, true);
+    else
+        Serial.write((const uint8_t *)text, len);
+}
+
+static void consolePrint(const char *text, bool newline = false)
+{
+    consoleWrite(text, strlen(text));
+    if (newline)
+        consoleWrite("\r\n", 2);
+}
+
+static void consolePrint(const __FlashStringHelper *text, bool newline = false)
+{
+    char buf[48];
+    strncpy_P(buf, (PGM_P)text, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    consolePrint(buf, newline);
+}
+
+// Copy a file to the console a buffer at a time instead of one read() per byte
+static void consoleCopy(SdFile &file)
+{
+    char chunk[64];
+    for (;;)
+    {
+        // Hold the bus only for the card read, not while Serial drains
+        int n;
+        {
+            SpiBusOwner bus(SPI_BUS_SD);
+            n = file.read(chunk, sizeof(chunk));
+        }
+        if (n <= 0)
+        {
+            break;
+        }
+        consoleWrite(chunk, n);
+    }
+}
+
 void FEHSD::FlushToConsole(const char *str)
 {
     SdFile file;
-    if (!FAT.exists(str))
+    bool exists, opened = false;
+    {
+        SpiBusOwner bus(SPI_BUS_SD);
+        exists = FAT.exists(str);
+        opened = exists && file.open(str, O_READ);
+    }
+
+    if (!exists)
     {
-        Serial.print(str);
-        Serial.print(" does not exist on SD card.");
+        consolePrint(str);
+        consolePrint(F(" does not exist on SD card."));
     }
-    else if (file.open(str, O_READ))
+    else if (opened)
     {
         char message[100];
-        strcpy(message, "Printing contents of ");
+        strcpy_P(message, PSTR("Printing contents of "));
         strcat(message, str);
-        Serial.println(message);
+        consolePrint(message, true);
 
-        while (file.available64())
-        {
-            char data = file.read();
-            Serial.print(data);
-        }
+        consoleCopy(file);
+        SpiBusOwner bus(SPI_BUS_SD);
         file.close();
     }
     else
     {
         char message[50];
-        strcpy(message, "Failed to open ");
+        strcpy_P(message, PSTR("Failed to open "));
         strcat(message, str);
-        Serial.println(message);
+        consolePrint(message, true);
     }
 }
 
@@ -246,15 +333,11 @@ void FEHSD::FlushToConsole(FEHFile *fptr)
 {
     if ((fptr->file_ptr).isReadable())
     {
-        while ((fptr->file_ptr).available64())
-        {
-            char data = (fptr->file_ptr).read();
-            Serial.print(data);
-        }
+        consoleCopy(fptr->file_ptr);
     }
     else
     {
-        Serial.println("FEHFile given is not open for reading");
+        consolePrint(F("FEHFile given is not open for reading"), true);
     }
 }
 
@@ -390,7 +473,7 @@ int FEHSD::my_vsscanf(const char *str, const char *format, va_list args)
             }
             default:
                 formatLevel = 0;
-                LCD.WriteLine("***Unknown format string found.");
+                LCD.WriteLine(F("***Unknown format string found."));
                 // Handle unknown format
                 break;
             }
@@ -26,7 +26,7 @@ const static PROGMEM uint8_t SERVO_NUM_TO_PIN[NUM_SERVOS] = {12, 11, 10, 9, 8, 7
 FEHServo::FEHServo(FEHServoPort servoPort)
     : _servoPort(servoPort), _servoMin(MIN_PULSE_WIDTH), _servoMax(MAX_PULSE_WIDTH)
 {
-    if (!_checkRange("servoInit", "servoNum", servoPort, 0, Servo7))
+    if (!_checkRange(F("servoInit"), F("servoNum"), servoPort, 0, Servo7))
     {
         return;
     }
@@ -37,7 +37,7 @@ FEHServo::FEHServo(FEHServoPort servoPort)
 
 void FEHServo::SetDegree(int16_t degree)
 {
-    if (!_checkRange("SetDegree", "degree", degree, 0, 180))
+    if (!_checkRange(F("SetDegree"), F("degree"), degree, 0, 180))
     {
         return;
     }
@@ -68,22 +68,22 @@ void FEHServo::TouchCalibrate()
     LCD.SetFontColor(WHITE);
 
     FEHIcon::Icon VAL[2];
-    char val_labels[2][20] = {"Current Minimum", ""};
-    FEHIcon::DrawIconArray(VAL, 2, 1, 41, 160, 1, 1, val_labels, YELLOW, WHITE);
+    static const char val_labels[2][20] PROGMEM = {"Current Minimum", ""};
+    FEHIcon::DrawIconArray_P(VAL, 2, 1, 41, 160, 1, 1, val_labels, YELLOW, WHITE);
 
     FEHIcon::Icon MOVE[2];
-    char move_labels[2][20] = {"Backward", "Forward"};
-    FEHIcon::DrawIconArray(MOVE, 1, 2, 80, 40, 1, 1, move_labels, RED, WHITE);
+    static const char move_labels[2][20] PROGMEM = {"Backward", "Forward"};
+    FEHIcon::DrawIconArray_P(MOVE, 1, 2, 80, 40, 1, 1, move_labels, RED, WHITE);
 
     FEHIcon::Icon SET[1];
-    char set_label[1][20] = {"SET MIN"};
-    FEHIcon::DrawIconArray(SET, 1, 1, 201, 2, 1, 1, set_label, BLUE, WHITE);
+    static const char set_label[1][20] PROGMEM = {"SET MIN"};
+    FEHIcon::DrawIconArray_P(SET, 1, 1, 201, 2, 1, 1, set_label, BLUE, WHITE);
 
     LCD.SetTextCursor(0, 0);
-    LCD.WriteLine("Use icons to select min.");
-    LCD.WriteLine("Press "
+    LCD.WriteLine(F("Use icons to select min."));
+    LCD.WriteLine(F("Press "
                   "SET MIN"
-                  " when ready.");
+                  " when ready."));
 
     servos[_servoPort].write(servo_min);
 
@@ -123,20 +123,20 @@ void FEHServo::TouchCalibrate()
 
     LCD.Clear(BLACK);
 
-    VAL[0].ChangeLabelString("Current Maximum");
+    VAL[0].ChangeLabelString(F("Current Maximum"));
     VAL[0].Draw();
     VAL[1].Draw();
 
-    FEHIcon::DrawIconArray(MOVE, 1, 2, 80, 40, 1, 1, move_labels, RED, WHITE);
+    FEHIcon::DrawIconArray_P(MOVE, 1, 2, 80, 40, 1, 1, move_labels, RED, WHITE);
 
-    SET[0].ChangeLabelString("SET MAX");
+    SET[0].ChangeLabelString(F("SET MAX"));
     SET[0].Draw();
 
     LCD.SetTextCursor(0, 0);
-    LCD.WriteLine("Use icons to select max.");
-    LCD.WriteLine("Press "
+    LCD.WriteLine(F("Use icons to select max."));
+    LCD.WriteLine(F("Press "
                   "SET MAX"
-                  " when ready.");
+                  " when ready."));
 
     servos[_servoPort].write(servo_max);
 
@@ -186,12 +186,12 @@ void FEHServo::TouchCalibrate()
     LCD.Clear(BLACK);
 
     FEHIcon::Icon OUT[4];
-    char out_labels[4][20] = {"SERVO MIN", "SERVO MAX", "", ""};
-    FEHIcon::DrawIconArray(OUT, 2, 2, 80, 120, 20, 20, out_labels, BLACK, WHITE);
+    static const char out_labels[4][20] PROGMEM = {"SERVO MIN", "SERVO MAX", "", ""};
+    FEHIcon::DrawIconArray_P(OUT, 2, 2, 80, 120, 20, 20, out_labels, BLACK, WHITE);
 
     FEHIcon::Icon EXIT[1];
-    char exit_label[1][20] = {"EXIT"};
-    FEHIcon::DrawIconArray(EXIT, 1, 1, 121, 40, 20, 20, exit_label, RED, WHITE);
+    static const char exit_label[1][20] PROGMEM = {"EXIT"};
+    FEHIcon::DrawIconArray_P(EXIT, 1, 1, 121, 40, 20, 20, exit_label, RED, WHITE);
 
     OUT[2].ChangeLabelInt(servo_min);
     OUT[2].Draw();
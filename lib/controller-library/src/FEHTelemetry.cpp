@@ -0,0 +1,154 @@
+/**
+ * FEHTelemetry.cpp
+ *
+ * Packets are COBS encoded into a stack buffer while the CRC is computed, then handed to
+ * HardwareSerial in one write, which the core's UDRE interrupt drains from its TX ring.
+ */
+
+#include <Arduino.h>
+#include <FEHTelemetry.h>
+#include <util/crc16.h>
+#include <string.h>
+
+// [COBS code][channel][sequence][payload][CRC low][CRC high][0]; one COBS code byte is
+// enough because a packet is shorter than 254 bytes
+#define TELEMETRY_HEADER_SIZE 2
+#define TELEMETRY_MAX_FRAME (1 + TELEMETRY_HEADER_SIZE + TELEMETRY_MAX_PAYLOAD + 2 + 1)
+
+static bool s_active = false;
+static uint8_t s_sequence = 0;
+static TelemetryStatistics s_stats;
+
+/* Consistent overhead byte stuffing, one byte at a time. Each code byte holds the
+   distance to the next 0 of the input, which is then left out. */
+struct CobsWriter
+{
+    uint8_t *out;
+    uint8_t *code;
+    uint16_t crc;
+
+    CobsWriter(uint8_t *buf) : out(buf + 1), code(buf), crc(0xFFFF)
+    {
+        *code = 1;
+    }
+
+    void put(uint8_t b)
+    {
+        if (b == 0)
+        {
+            code = out++;
+            *code = 1;
+        }
+        else
+        {
+            *out++ = b;
+            (*code)++;
+        }
+    }
+
+    void putChecked(uint8_t b)
+    {
+        crc = _crc_xmodem_update(crc, b);
+        put(b);
+    }
+
+    /* Append the CRC and the delimiter; returns the frame length */
+    size_t finish(uint8_t *start)
+    {
+        uint16_t sum = crc;
+        put(sum & 0xFF);
+        put(sum >> 8);
+        *out++ = 0;
+        return out - start;
+    }
+};
+
+static size_t encodeFrame(uint8_t *frame, uint8_t channel, uint8_t sequence, const uint8_t *data, uint8_t len)
+{
+    CobsWriter writer(frame);
+    writer.putChecked(channel);
+    writer.putChecked(sequence);
+    for (uint8_t i = 0; i < len; i++)
+    {
+        writer.putChecked(data[i]);
+    }
+    return writer.finish(frame);
+}
+
+static bool sendFrame(uint8_t channel, const void *data, uint8_t len, bool wait)
+{
+    uint8_t frame[TELEMETRY_MAX_FRAME];
+    size_t n = encodeFrame(frame, channel, s_sequence++, (const uint8_t *)data, len);
+
+    if (!wait && (size_t)Serial.availableForWrite() < n)
+    {
+        s_stats.dropped++;
+        return false;
+    }
+    Serial.write(frame, n);
+    s_stats.packets++;
+    s_stats.bytes += n;
+    return true;
+}
+
+void FEHTelemetry::begin(unsigned long baud)
+{
+    Serial.flush();
+    Serial.begin(baud);
+    s_sequence = 0;
+    resetStats();
+    s_active = true;
+}
+
+void FEHTelemetry::end()
+{
+    Serial.flush();
+    s_active = false;
+    Serial.begin(SERIAL_CONSOLE_BAUD);
+}
+
+bool FEHTelemetry::isActive()
+{
+    return s_active;
+}
+
+bool FEHTelemetry::send(uint8_t channel, const void *data, uint8_t len, bool wait)
+{
+    if (!s_active || len > TELEMETRY_MAX_PAYLOAD)
+    {
+        return false;
+    }
+    return sendFrame(channel, data, len, wait);
+}
+
+bool FEHTelemetry::sendText(const char *text, size_t len, bool wait)
+{
+    if (!s_active)
+    {
+        return false;
+    }
+    bool ok = true;
+    while (len > 0)
+    {
+        uint8_t chunk = len > TELEMETRY_MAX_PAYLOAD ? TELEMETRY_MAX_PAYLOAD : (uint8_t)len;
+        ok &= sendFrame(TELEMETRY_CHANNEL_TEXT, text, chunk, wait);
+        text += chunk;
+        len -= chunk;
+    }
+    return ok;
+}
+
+bool FEHTelemetry::sendText(const char *text, bool wait)
+{
+    return sendText(text, strlen(text), wait);
+}
+
+TelemetryStatistics FEHTelemetry::stats()
+{
+    return s_stats;
+}
+
+void FEHTelemetry::resetStats()
+{
+    s_stats = {0, 0, 0};
+}
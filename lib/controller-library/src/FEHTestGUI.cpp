@@ -6,6 +6,7 @@
 #include <Adafruit_ILI9341.h>
 #include <FEH.h>
 #include "../private_include/FEHInternal.h"
+#include "../private_include/lcdtile.h"
 #include "../private_include/scheduler.h"
 
 #include "FEHDefines.h"
@@ -19,10 +20,13 @@ private:
     uint8_t text_size;
     bool centered;
     void drawInternal(bool useBgColor);
+    int16_t left(const char *str, uint16_t *width);
+    void compose(const char *newText);
 
 public:
     uiText(int16_t x, int16_t y, uint16_t color, uint8_t size, bool centered);
     void draw(const char *newText);
+    void draw(const __FlashStringHelper *newText);
 };
 
 /*
@@ -80,8 +84,53 @@ void uiText::drawInternal(bool eraseMode)
     ILI9341.setTextWrap(true);
 }
 
+/* Left edge and width of @p str as drawn, with the font size already set */
+int16_t uiText::left(const char *str, uint16_t *width)
+{
+    int16_t x1, y1;
+    uint16_t height;
+    ILI9341.getTextBounds(str, 0, 0, &x1, &y1, width, &height);
+    return this->centered ? this->x - *width / 2 : this->x;
+}
+
+/* Draw the new text over the old in one window, without erasing first */
+void uiText::compose(const char *newText)
+{
+    ILI9341.setTextWrap(false);
+    LCD.SetFontSize(this->text_size);
+
+    uint16_t oldWidth, newWidth;
+    int16_t oldX = this->left(this->text, &oldWidth);
+    strlcpy(this->text, newText, sizeof(this->text));
+    int16_t newX = this->left(this->text, &newWidth);
+
+    int16_t x0 = oldWidth && oldX < newX ? oldX : newX;
+    int16_t x1 = oldWidth && oldX + oldWidth > newX + newWidth ? oldX + oldWidth : newX + newWidth;
+
+    const uint16_t palette[] = {UI_BG_COLOR, this->color};
+    LcdTile tile(x0, this->y, x1 - x0, 8 * this->text_size, palette, 2);
+    tile.setTextWrap(false);
+    tile.setTextColor(this->color, UI_BG_COLOR);
+    while (tile.nextBand())
+    {
+        tile.setCursor(newX, this->y);
+        tile.print(this->text);
+    }
+
+    // Leave the font and cursor as drawInternal() would
+    LCD.SetFontColor(this->color, UI_BG_COLOR);
+    ILI9341.setCursor(tile.getCursorX(), tile.getCursorY());
+    ILI9341.setTextWrap(true);
+}
+
 void uiText::draw(const char *newText)
 {
+    if (_lcdCompositing())
+    {
+        this->compose(newText);
+        return;
+    }
+
     if (strlen(newText) < strlen(this->text))
     {
         /* If text size becomes smaller erase old text first */
@@ -93,13 +142,20 @@ void uiText::draw(const char *newText)
     this->drawInternal(false);
 }
 
+void uiText::draw(const __FlashStringHelper *newText)
+{
+    char buf[sizeof(this->text)];
+    strncpy_P(buf, (PGM_P)newText, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    this->draw(buf);
+}
+
 // Takes a value as a percentage and maps it to the slider's x-coordinates
 void drawTickMark(int value, int y, int endY)
 {
     static constexpr int tickDist = 5;
     int x = map(value, 0, 100, SLIDER_MIN_X, SLIDER_MAX_X);
-    LCD.DrawLine(x + 0, y - tickDist, x + 0, endY + tickDist);
-    LCD.DrawLine(x + 1, y - tickDist, x + 1, endY + tickDist);
+    LCD.FillRectangle(x, y - tickDist, 2, endY - y + 2 * tickDist + 1);
 }
 
 void drawSlider(int y)
@@ -107,9 +163,7 @@ void drawSlider(int y)
     LCD.SetFontColor(WHITE);
 
     /* Draw slider*/
-    LCD.DrawLine(40, y + 0, LCD_WIDTH - 40, y + 0);
-    LCD.DrawLine(40, y + 1, LCD_WIDTH - 40, y + 1);
-    LCD.DrawLine(40, y + 2, LCD_WIDTH - 40, y + 2);
+    LCD.FillRectangle(40, y, LCD_WIDTH - 80 + 1, 3);
 
     int endY = y + 2;
 
@@ -139,7 +193,7 @@ int forceBounds(int val, int min, int max, bool wrap)
     return val;
 }
 
-void labelSlider(int y, const char *minLabel, const char *midLabel, const char *maxLabel)
+void labelSlider(int y, const __FlashStringHelper *minLabel, const __FlashStringHelper *midLabel, const __FlashStringHelper *maxLabel)
 {
     int labelY = y + 20;
 
@@ -192,11 +246,12 @@ typedef enum
     TOUCH
 } selectedMenu;
 
+static const char BACK_LABEL[1][20] PROGMEM = {"Back"};
+
 class TestingMenu
 {
 
 private:
-    char _backLabel[1][20] = {"Back"};
 
 
 public:
@@ -246,14 +301,14 @@ public:
         LCD.SetFontSize(2);
 
         FEHIcon::Icon _main_title_icon_arr[1];
-        char _main_title[1][20] = {"ERC2 TEST GUI"};
-        FEHIcon::DrawIconArray(_main_title_icon_arr, 1, 1, 1, 201, 1, 1, _main_title, HI_C, TEXT_C);
+        static const char _main_title[1][20] PROGMEM = {"ERC2 TEST GUI"};
+        FEHIcon::DrawIconArray_P(_main_title_icon_arr, 1, 1, 1, 201, 1, 1, _main_title, HI_C, TEXT_C);
         _main_title_icon_arr[0].Select();
 
         static constexpr int NUM_MAIN_ICONS = 6;
         FEHIcon::Icon _main_icon_arr[NUM_MAIN_ICONS];
-        char _main_icon_labels[NUM_MAIN_ICONS][20] = {"Motor", "Servo", "Digital In", "Analog In", "Battery", "Touch"};
-        FEHIcon::DrawIconArray(_main_icon_arr, (NUM_MAIN_ICONS + 1) / 2, 2, 40, 20, 1, 1, _main_icon_labels, MENU_C, TEXT_C);
+        static const char _main_icon_labels[NUM_MAIN_ICONS][20] PROGMEM = {"Motor", "Servo", "Digital In", "Analog In", "Battery", "Touch"};
+        FEHIcon::DrawIconArray_P(_main_icon_arr, (NUM_MAIN_ICONS + 1) / 2, 2, 40, 20, 1, 1, _main_icon_labels, MENU_C, TEXT_C);
 
         while (_sel_menu == MAIN)
         {
@@ -283,7 +338,7 @@ public:
 
         // Create back to main menu icon
         FEHIcon::Icon _motor_back_icon_arr[1];
-        FEHIcon::DrawIconArray(_motor_back_icon_arr, 1, 1, 1, 201, 1, 1, _backLabel, MENU_C, TEXT_C);
+        FEHIcon::DrawIconArray_P(_motor_back_icon_arr, 1, 1, 1, 201, 1, 1, BACK_LABEL, MENU_C, TEXT_C);
         _motor_back_icon_arr[0].Select();
 
         scheduleEvent(motorRampingCallback, 0);
@@ -293,22 +348,22 @@ public:
         int motorUnderTest = 0;
 
         drawSlider(SLIDER_Y);
-        labelSlider(SLIDER_Y, "-100%", "0%", "100%");
+        labelSlider(SLIDER_Y, F("-100%"), F("0%"), F("100%"));
 
         uiText leftArrow(SLIDER_MIN_X, TOP_LABEL_Y, FEHLCD::White, 4, true);
         uiText rightArrow(SLIDER_MAX_X, TOP_LABEL_Y, FEHLCD::White, 4, true);
-        leftArrow.draw("<");
-        rightArrow.draw(">");
+        leftArrow.draw(F("<"));
+        rightArrow.draw(F(">"));
 
         uiText tMotor(160, TOP_LABEL_Y, FEHLCD::White, 4, true);
         uiText tPercent(160, 110, FEHLCD::White, 6, true);
 
         while (_sel_menu == MOTOR)
         {
-            snprintf(label, 64, "Motor%d", motorUnderTest);
+            snprintf_P(label, 64, PSTR("Motor%d"), motorUnderTest);
             tMotor.draw(label);
 
-            snprintf(label, 64, "%d%%", targetMotorSpeeds[motorUnderTest]);
+            snprintf_P(label, 64, PSTR("%d%%"), targetMotorSpeeds[motorUnderTest]);
             tPercent.draw(label);
 
             while (true)
@@ -334,7 +389,7 @@ public:
                         if (abs(p) < 10)
                             p = 0;
 
-                        snprintf(label, 64, "%d%%", p);
+                        snprintf_P(label, 64, PSTR("%d%%"), p);
                         tPercent.draw(label);
 
                         targetMotorSpeeds[motorUnderTest] = p;
@@ -384,7 +439,7 @@ public:
 
         // Create back to main menu icon
         FEHIcon::Icon _servo_back_icon_arr[1];
-        FEHIcon::DrawIconArray(_servo_back_icon_arr, 1, 1, 1, 201, 1, 1, _backLabel, MENU_C, TEXT_C);
+        FEHIcon::DrawIconArray_P(_servo_back_icon_arr, 1, 1, 1, 201, 1, 1, BACK_LABEL, MENU_C, TEXT_C);
         _servo_back_icon_arr[0].Select();
 
         char label[64];
@@ -392,12 +447,12 @@ public:
         int servoUnderTest = 0;
 
         drawSlider(SLIDER_Y);
-        labelSlider(SLIDER_Y, "0", "90", "180");
+        labelSlider(SLIDER_Y, F("0"), F("90"), F("180"));
 
         uiText leftArrow(SLIDER_MIN_X, TOP_LABEL_Y, FEHLCD::White, 4, true);
         uiText rightArrow(SLIDER_MAX_X, TOP_LABEL_Y, FEHLCD::White, 4, true);
-        leftArrow.draw("<");
-        rightArrow.draw(">");
+        leftArrow.draw(F("<"));
+        rightArrow.draw(F(">"));
 
         uiText tServo(160, TOP_LABEL_Y, FEHLCD::White, 4, true);
         uiText tAngle(160, 110, FEHLCD::White, 6, true);
@@ -406,10 +461,10 @@ public:
 
         while (_sel_menu == SERVO)
         {
-            snprintf(label, 64, "Servo%d", servoUnderTest);
+            snprintf_P(label, 64, PSTR("Servo%d"), servoUnderTest);
             tServo.draw(label);
 
-            snprintf(label, 64, "%d", targetServoPositions[servoUnderTest]);
+            snprintf_P(label, 64, PSTR("%d"), targetServoPositions[servoUnderTest]);
             tAngle.draw(label);
 
             while (true)
@@ -431,7 +486,7 @@ public:
                         int p = map(touchX, SLIDER_MIN_X, SLIDER_MAX_X, 0, 180);
                         p = forceBounds(p, 0, 180, false);
 
-                        snprintf(label, 64, "%d", p);
+                        snprintf_P(label, 64, PSTR("%d"), p);
                         tAngle.draw(label);
                         targetServoPositions[servoUnderTest] = p;
                         servos[servoUnderTest].SetDegree(p);
@@ -468,18 +523,18 @@ public:
 
         // Create back to main menu icon
         FEHIcon::Icon _digital_back_icon_arr[1];
-        FEHIcon::DrawIconArray(_digital_back_icon_arr, 1, 1, 1, 201, 1, 1, _backLabel, MENU_C, TEXT_C);
+        FEHIcon::DrawIconArray_P(_digital_back_icon_arr, 1, 1, 1, 201, 1, 1, BACK_LABEL, MENU_C, TEXT_C);
         _digital_back_icon_arr[0].Select();
 
         char label[64];
 
         // // Label the screen
         uiText tTitle(160, TOP_LABEL_Y, FEHLCD::White, 3, true);
-        tTitle.draw("Digital In");
+        tTitle.draw(F("Digital In"));
         uiText leftArrow(20, TOP_LABEL_Y, FEHLCD::White, 4, true);
         uiText rightArrow(300, TOP_LABEL_Y, FEHLCD::White, 4, true);
-        leftArrow.draw("<");
-        rightArrow.draw(">");
+        leftArrow.draw(F("<"));
+        rightArrow.draw(F(">"));
 
         LCD.SetFontSize(2);
 
@@ -510,7 +565,7 @@ public:
             DigitalInputPin(FEHIO::Pin15),
         };
 
-        Serial.println("D");
+        Serial.println(F("D"));
 
 
         int page = 0;
@@ -547,9 +602,9 @@ public:
                     // Change the labels of the icons
                     for (size_t i = 0; i < 4; i++)
                     {
-                        snprintf(label, 64, "Pin %d", i + 8 * page);
+                        snprintf_P(label, 64, PSTR("Pin %d"), i + 8 * page);
                         _iconGroup0[i].ChangeLabelString(label);
-                        snprintf(label, 64, "Pin %d", i + 4 + 8 * page);
+                        snprintf_P(label, 64, PSTR("Pin %d"), i + 4 + 8 * page);
                         _iconGroup1[i].ChangeLabelString(label);
                     }
                     pageswitch = false;
@@ -558,8 +613,8 @@ public:
                 // Update digital input values
                 for (size_t i = 0; i < 4; i++)
                 {
-                    _iconGroup0[i + 4].ChangeLabelString(digitalPins[i + 8 * page].Value() ? "T" : "F");
-                    _iconGroup1[i + 4].ChangeLabelString(digitalPins[i + 4 + 8 * page].Value() ? "T" : "F");
+                    _iconGroup0[i + 4].ChangeLabelString(digitalPins[i + 8 * page].Value() ? F("T") : F("F"));
+                    _iconGroup1[i + 4].ChangeLabelString(digitalPins[i + 4 + 8 * page].Value() ? F("T") : F("F"));
                 }
             }
         }
@@ -574,18 +629,18 @@ public:
 
         // Create back to main menu icon
         FEHIcon::Icon _servo_back_icon_arr[1];
-        FEHIcon::DrawIconArray(_servo_back_icon_arr, 1, 1, 1, 201, 1, 1, _backLabel, MENU_C, TEXT_C);
+        FEHIcon::DrawIconArray_P(_servo_back_icon_arr, 1, 1, 1, 201, 1, 1, BACK_LABEL, MENU_C, TEXT_C);
         _servo_back_icon_arr[0].Select();
 
         char label[64];
 
         // Label the screen
         uiText tTitle(160, TOP_LABEL_Y, FEHLCD::White, 3, true);
-        tTitle.draw("Analog In");
+        tTitle.draw(F("Analog In"));
         uiText leftArrow(20, TOP_LABEL_Y, FEHLCD::White, 4, true);
         uiText rightArrow(300, TOP_LABEL_Y, FEHLCD::White, 4, true);
-        leftArrow.draw("<");
-        rightArrow.draw(">");
+        leftArrow.draw(F("<"));
+        rightArrow.draw(F(">"));
 
         LCD.SetFontSize(2);
 
@@ -648,9 +703,9 @@ public:
                     // Change the labels of the icons
                     for (size_t i = 0; i < 4; i++)
                     {
-                        snprintf(label, 64, "Pin %d", i + 8 * page);
+                        snprintf_P(label, 64, PSTR("Pin %d"), i + 8 * page);
                         _iconGroup0[i].ChangeLabelString(label);
-                        snprintf(label, 64, "Pin %d", i + 4 + 8 * page);
+                        snprintf_P(label, 64, PSTR("Pin %d"), i + 4 + 8 * page);
                         _iconGroup1[i].ChangeLabelString(label);
                     }
                     pageswitch = false;
@@ -662,7 +717,7 @@ public:
                     _iconGroup0[i + 4].ChangeLabelFloat(analogPins[i + 8 * page].Value());
                     if (i == 3 && page == 1)
                     {
-                        _iconGroup1[i + 4].ChangeLabelString(pin15.Value() ? "T" : "F");
+                        _iconGroup1[i + 4].ChangeLabelString(pin15.Value() ? F("T") : F("F"));
                     }
                     else
                     {
@@ -679,7 +734,7 @@ public:
 
         // Create back to main menu icon
         FEHIcon::Icon _motor_back_icon_arr[1];
-        FEHIcon::DrawIconArray(_motor_back_icon_arr, 1, 1, 1, 201, 1, 1, _backLabel, MENU_C, TEXT_C);
+        FEHIcon::DrawIconArray_P(_motor_back_icon_arr, 1, 1, 1, 201, 1, 1, BACK_LABEL, MENU_C, TEXT_C);
         _motor_back_icon_arr[0].Select();
 
         char label[64];
@@ -692,7 +747,7 @@ public:
             {
                 int touchX, touchY;
 
-                snprintf(label, 64, "%0.2fV", (double)BatteryVoltage());
+                snprintf_P(label, 64, PSTR("%0.2fV"), (double)BatteryVoltage());
                 tPercent.draw(label);
 
                 if (LCD.Touch(&touchX, &touchY))
@@ -716,7 +771,7 @@ public:
 
         // Create back to main menu icon
         FEHIcon::Icon _motor_back_icon_arr[1];
-        FEHIcon::DrawIconArray(_motor_back_icon_arr, 1, 1, 1, 201, 1, 1, _backLabel, MENU_C, TEXT_C);
+        FEHIcon::DrawIconArray_P(_motor_back_icon_arr, 1, 1, 1, 201, 1, 1, BACK_LABEL, MENU_C, TEXT_C);
         _motor_back_icon_arr[0].Select();
 
         while (_sel_menu == TOUCH)
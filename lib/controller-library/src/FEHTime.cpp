@@ -0,0 +1,58 @@
+/**
+ * FEHTime.cpp
+ *
+ * TimeNowMicros() reads Timer 0 the way micros() does: the core's overflow count plus
+ * the live counter, with a pending overflow accounted for. Timer 0 runs at clk/64, so
+ * one count is 4 us and one overflow is 1024 us. The 32-bit overflow count itself wraps
+ * after about 50 days; _overflowWraps extends it. A wrap is told apart from the count
+ * being reset (the host build's power cycle) by the modular difference being forward,
+ * so the function has to be called at least once every 25 days.
+ */
+
+#include <FEHTime.h>
+#include <Arduino.h>
+
+#if F_CPU != 16000000UL
+#error "TimeNowMicros() assumes Timer 0 counts 4 us per tick (16 MHz, clk/64)"
+#endif
+
+/* Defined by the Arduino core (wiring.c) and incremented by its Timer 0 overflow ISR */
+extern volatile unsigned long timer0_overflow_count;
+
+static uint32_t _lastOverflows = 0;
+static uint8_t _overflowWraps = 0;
+
+uint64_t TimeNowMicros()
+{
+    uint32_t overflows;
+    uint8_t ticks;
+
+    uint8_t oldSREG = SREG;
+    cli();
+    overflows = timer0_overflow_count;
+    ticks = TCNT0;
+    /* The counter wrapped but the ISR has not run yet */
+    if ((TIFR0 & bit(TOV0)) && ticks < 255)
+    {
+        overflows++;
+    }
+    if (overflows < _lastOverflows && (int32_t)(overflows - _lastOverflows) > 0)
+    {
+        _overflowWraps++;
+    }
+    _lastOverflows = overflows;
+    SREG = oldSREG;
+
+    /*
+     * Microseconds are (wraps:overflows:ticks) * 4, 48 bits in all. Assembling the two
+     * 32-bit halves avoids 64-bit shifts, which avr-gcc does in a library loop.
+     */
+    union
+    {
+        uint64_t value;
+        uint32_t half[2];
+    } us;
+    us.half[0] = (overflows << 10) | ((uint32_t)ticks << 2);
+    us.half[1] = (overflows >> 22) | ((uint32_t)_overflowWraps << 10);
+    return us.value;
+}
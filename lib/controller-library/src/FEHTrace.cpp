@@ -0,0 +1,239 @@
+/**
+ * FEHTrace.cpp
+ *
+ * Flight recorder. The ring and its entries are described in private_include/trace.h.
+ *
+ * The reset cause is read in .init3, before the C runtime clears .bss and before anything
+ * can enable interrupts. The stk500v2 bootloader clears MCUSR before it starts the
+ * application and passes the flags on in GPIOR1; without the bootloader they are still in
+ * MCUSR. Both are cleared, so a later jump to address 0, which resets neither, reads 0.
+ */
+
+#include <FEHTrace.h>
+#include "../private_include/trace.h"
+#include "../private_include/spibus.h"
+#include <Arduino.h>
+#include <SdFat.h>
+#include <avr/wdt.h>
+#include <util/atomic.h>
+
+#ifdef __AVR__
+#define NOINIT __attribute__((section(".noinit")))
+#else
+/* The host build has no startup code: RAM keeps its contents across HostHardware::reset() */
+#define NOINIT
+#endif
+
+#define TICKS_PER_SECOND 250000UL // Timer 0 counts per second, 4 us each
+
+TraceRing _traceRing NOINIT;
+
+/* Written in .init3, so it must not be in .bss, which is cleared after */
+static uint8_t s_resetFlags NOINIT;
+
+/* Copy of the ring from before the reset, if one was recovered */
+static TraceRing *s_recovered = nullptr;
+
+static const char TYPE_NAMES[][9] PROGMEM = {
+    "?", "boot", "dispatch", "fault", "reset", "kill", "fatal", "esp32 rx", "esp32 tx", "mark",
+};
+
+#ifdef __AVR__
+void _traceResetCause() __attribute__((naked, used, section(".init3")));
+#endif
+void _traceResetCause()
+{
+    s_resetFlags = MCUSR | GPIOR1;
+    MCUSR = 0;
+    GPIOR1 = 0;
+    // After a watchdog reset the watchdog stays enabled at its shortest timeout until
+    // WDRF is cleared, which would reset again long before setup()
+    wdt_disable();
+}
+
+static const __FlashStringHelper *resetCauseName(uint8_t flags)
+{
+    if (flags & _BV(WDRF))
+        return F("watchdog");
+    if (flags & _BV(BORF))
+        return F("brown-out");
+    if (flags & _BV(EXTRF))
+        return F("reset button");
+    if (flags & _BV(JTRF))
+        return F("JTAG");
+    if (flags & _BV(PORF))
+        return F("power-on");
+#if TRACE_BOOTLOADER_PASSES_RESET_FLAGS
+    return F("jump to 0, likely a crash");
+#else
+    return F("unknown, bootloader cleared MCUSR");
+#endif
+}
+
+static void printEntry(Print &out, const TraceEntry &e)
+{
+    char line[64];
+    char name[sizeof(TYPE_NAMES[0])];
+    strcpy_P(name, TYPE_NAMES[e.type < sizeof(TYPE_NAMES) / sizeof(TYPE_NAMES[0]) ? e.type : 0]);
+    // Kills and fatal errors have nothing after the name to align
+    bool detail = e.type != TRACE_KILL && e.type != TRACE_FATAL;
+    snprintf_P(line, sizeof(line), detail ? PSTR("%5lu.%06lu s  %-9s") : PSTR("%5lu.%06lu s  %s"),
+               (unsigned long)(e.time / TICKS_PER_SECOND), (unsigned long)(e.time % TICKS_PER_SECOND * 4), name);
+    out.print(line);
+
+    switch (e.type)
+    {
+    case TRACE_BOOT:
+        out.print(resetCauseName(e.arg));
+        break;
+    case TRACE_DISPATCH:
+        snprintf_P(line, sizeof(line), PSTR("0x%04x"), e.value);
+        out.print(line);
+        break;
+    case TRACE_FAULT:
+        out.print((e.arg & TRACE_FAULT_I2C) ? F("i2c ") : F(""));
+        out.print((e.arg & TRACE_FAULT_IO) ? F("io") : F(""));
+        break;
+    case TRACE_RESET:
+        out.print(e.arg == TRACE_RESET_SHIELD_OFF ? F("shield off") : e.arg == TRACE_RESET_UPDATE ? F("update") : F("?"));
+        break;
+    case TRACE_ESP32_RX:
+    case TRACE_ESP32_TX:
+        snprintf_P(line, sizeof(line), PSTR("0x%02x, %u bytes"), e.arg, e.value);
+        out.print(line);
+        break;
+    case TRACE_MARK:
+        snprintf_P(line, sizeof(line), PSTR("%u, %u"), e.arg, e.value);
+        out.print(line);
+        break;
+    }
+    out.println();
+}
+
+/* Entries of a ring that is not being written, oldest first */
+static void printRing(Print &out, const TraceRing &ring)
+{
+    if (ring.reason[0] != '\0')
+    {
+        out.print(F("Last kill or fatal error: "));
+        out.println(ring.reason);
+    }
+    uint8_t i = ring.head - ring.count;
+    for (uint8_t n = 0; n < ring.count; n++, i++)
+    {
+        printEntry(out, ring.entries[i & (TRACE_ENTRIES - 1)]);
+    }
+}
+
+static void printHeader(Print &out, const __FlashStringHelper *title, uint8_t flags, uint8_t count)
+{
+    out.print(title);
+    out.print(F(" ("));
+    out.print(resetCauseName(flags));
+    out.print(F("), "));
+    out.print(count);
+    out.println(F(" events, newest last:"));
+}
+
+void _traceReason(const char *reason)
+{
+    strncpy(_traceRing.reason, reason, TRACE_REASON_LENGTH - 1);
+    _traceRing.reason[TRACE_REASON_LENGTH - 1] = '\0';
+}
+
+void _traceReason(const __FlashStringHelper *reason)
+{
+    strncpy_P(_traceRing.reason, (PGM_P)reason, TRACE_REASON_LENGTH - 1);
+    _traceRing.reason[TRACE_REASON_LENGTH - 1] = '\0';
+}
+
+void _traceBoot()
+{
+#ifndef __AVR__
+    _traceResetCause();
+    // A host program may boot more than once
+    free(s_recovered);
+    s_recovered = nullptr;
+#endif
+
+    // RAM holds noise after a power-on, which may pass the checks by chance
+    bool intact = _traceRing.magic == TRACE_MAGIC && _traceRing.head < TRACE_ENTRIES &&
+                  _traceRing.count > 0 && _traceRing.count <= TRACE_ENTRIES &&
+                  memchr(_traceRing.reason, '\0', TRACE_REASON_LENGTH) != NULL;
+    if (intact && !(s_resetFlags & _BV(PORF)))
+    {
+        printHeader(Serial, F("Trace before reset"), s_resetFlags, _traceRing.count);
+        printRing(Serial, _traceRing);
+
+        s_recovered = (TraceRing *)malloc(sizeof(TraceRing));
+        if (s_recovered != nullptr)
+        {
+            memcpy(s_recovered, &_traceRing, sizeof(TraceRing));
+        }
+    }
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        _traceRing.magic = TRACE_MAGIC;
+        _traceRing.head = 0;
+        _traceRing.count = 0;
+        _traceRing.reason[0] = '\0';
+        _traceEvent(TRACE_BOOT, s_resetFlags);
+    }
+}
+
+void FEHTrace::mark(uint8_t id, uint16_t value)
+{
+    _traceEvent(TRACE_MARK, id, value);
+}
+
+uint8_t FEHTrace::resetCause()
+{
+    return s_resetFlags;
+}
+
+bool FEHTrace::recovered()
+{
+    return s_recovered != nullptr;
+}
+
+bool FEHTrace::save(const char *filename)
+{
+    if (s_recovered == nullptr)
+    {
+        return false;
+    }
+
+    SpiBusOwner bus(SPI_BUS_SD);
+    SdFile file;
+    if (!file.open(filename, O_CREAT | O_TRUNC | O_WRITE))
+    {
+        return false;
+    }
+    printHeader(file, F("Trace before reset"), s_resetFlags, s_recovered->count);
+    printRing(file, *s_recovered);
+    return file.close();
+}
+
+void FEHTrace::print()
+{
+    uint8_t head, count;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        head = _traceRing.head;
+        count = _traceRing.count;
+    }
+    printHeader(Serial, F("Trace since boot"), s_resetFlags, count);
+
+    // Events recorded while printing replace the oldest ones, which may then print out of order
+    uint8_t i = head - count;
+    for (uint8_t n = 0; n < count; n++, i++)
+    {
+        TraceEntry e;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            e = _traceRing.entries[i & (TRACE_ENTRIES - 1)];
+        }
+        printEntry(Serial, e);
+    }
+}
@@ -2,24 +2,95 @@
 #include <Arduino.h>
 #include "../private_include/FEHInternal.h"
 #include "../private_include/FEHESP32.h"
+#include "../private_include/recorder.h"
+#include <avr/sleep.h>
+
+extern volatile bool g_esp32PollPending;
+
+// Below this much time left, Sleep() busy-waits instead of idling until the next
+// Timer 0 overflow (every 1024 us), which could overshoot the deadline
+#define SLEEP_IDLE_MIN_US 1100
+
+static SleepStatistics _sleepStats;
+
+/*
+ * Serviced wait: run deferred work, then idle until the next interrupt, until the
+ * deadline. Timer 0 overflows wake the CPU at least every 1024 us. Interrupts are
+ * disabled between checking the ESP32 poll flag and sleeping, and SEI always executes
+ * the next instruction first, so a flag set in between still wakes the CPU.
+ */
+static void servicedSleep(uint64_t us)
+{
+    if (!(SREG & bit(SREG_I)))
+    {
+        /* Nothing could wake the CPU, so busy-wait */
+        while (us > 0)
+        {
+            unsigned int chunk = us > 10000 ? 10000 : us;
+            delayMicroseconds(chunk);
+            us -= chunk;
+        }
+        return;
+    }
+
+    uint64_t start = TimeNowMicros();
+    Deadline end = Deadline::InMicros(us);
+    set_sleep_mode(SLEEP_MODE_IDLE);
+
+    for (;;)
+    {
+        uint64_t before = TimeNowMicros();
+        if (_serviceDeferredWork())
+        {
+            _sleepStats.servicedMicros += TimeNowMicros() - before;
+            _sleepStats.serviceRuns++;
+        }
+
+        uint64_t left = end.RemainingMicros();
+        if (left == 0)
+        {
+            break;
+        }
+        if (left < SLEEP_IDLE_MIN_US)
+        {
+            delayMicroseconds(left);
+            break;
+        }
+
+        cli();
+        if (!g_esp32PollPending)
+        {
+            sleep_enable();
+            sei();
+            sleep_cpu();
+            sleep_disable();
+        }
+        sei();
+    }
+
+    _sleepStats.sleptMicros += TimeNowMicros() - start;
+}
 
 // Millisecond sleeps
-void Sleep(unsigned long ms) { FEHESP32::servicePoll(); delay(ms); }
-void Sleep(int ms) { FEHESP32::servicePoll(); delay(ms); }
+void Sleep(unsigned long ms) { servicedSleep(ms * 1000ULL); }
+void Sleep(int ms) { servicedSleep(ms > 0 ? ms * 1000ULL : 0); }
 
 // Second sleeps
-void Sleep(double s) { FEHESP32::servicePoll(); delay(s * 1000); }
-void Sleep(float s) { FEHESP32::servicePoll(); delay(s * 1000); }
+void Sleep(double s) { servicedSleep(s > 0 ? (uint64_t)(s * 1e6) : 0); }
+void Sleep(float s) { servicedSleep(s > 0 ? (uint64_t)(s * 1e6f) : 0); }
 
 // Microsecond sleeps
 void SleepMicroseconds(unsigned long us) { delayMicroseconds(us); }
 void SleepMicroseconds(int us) { delayMicroseconds(us); }
 
+SleepStatistics SleepStats() { return _sleepStats; }
+void ResetSleepStats() { _sleepStats = SleepStatistics(); }
+
 // Battery voltage
 float BatteryVoltage() { return _batteryVoltage(); }
 
 // Wrapper for millis() but in seconds
-float TimeNow() { return millis() / 1000.0; }
+float TimeNow() { return (unsigned long)_recordInput(RECORD_TIME, 0, millis()) * 0.001f; }
 
 // Random number generation
 int RandInt(int min, int max)
@@ -49,10 +49,13 @@ uint8_t ServoCount = 0;                                     // the total number
 
 /************ static functions common to all instances ***********************/
 
+// Timer 1 free-runs so its OCR1B can pace FEHPeriodic; each refresh frame is measured from its start count
+static volatile uint16_t FrameStart[_Nbr_16timers];
+
 static inline void handle_interrupts(timer16_Sequence_t timer, volatile uint16_t *TCNTn, volatile uint16_t* OCRnA)
 {
   if( Channel[timer] < 0 )
-    *TCNTn = 0; // channel set to -1 indicated that refresh interval completed so reset the timer
+    FrameStart[timer] = *TCNTn; // channel set to -1 indicated that refresh interval completed so start a new frame
   else{
     if( SERVO_INDEX(timer,Channel[timer]) < ServoCount && SERVO(timer,Channel[timer]).Pin.isActive == true )
       digitalWrite( SERVO(timer,Channel[timer]).Pin.nbr,LOW); // pulse this channel low if activated
@@ -66,8 +69,9 @@ static inline void handle_interrupts(timer16_Sequence_t timer, volatile uint16_t
   }
   else {
     // finished all channels so wait for the refresh period to expire before starting over
-    if( ((unsigned)*TCNTn) + 4 < usToTicks(REFRESH_INTERVAL) )  // allow a few ticks to ensure the next OCR1A not missed
-      *OCRnA = (unsigned int)usToTicks(REFRESH_INTERVAL);
+    uint16_t elapsed = *TCNTn - FrameStart[timer];  // Timer 1 free-runs, so measure from the frame start
+    if( elapsed < (uint16_t)(usToTicks(REFRESH_INTERVAL) - 4) )  // allow a few ticks to ensure the next OCR1A not missed
+      *OCRnA = FrameStart[timer] + (unsigned int)usToTicks(REFRESH_INTERVAL);
     else
       *OCRnA = *TCNTn + 4;  // at least REFRESH_INTERVAL has elapsed
     Channel[timer] = -1; // this will get incremented at the end of the refresh period to start again at the first channel
@@ -127,13 +131,13 @@ static void initISR(timer16_Sequence_t timer)
   if(timer == _timer1) {
     TCCR1A = 0;             // normal counting mode
     TCCR1B = _BV(CS11);     // set prescaler of 8
-    TCNT1 = 0;              // clear the timer count
+    OCR1A = TCNT1 + 4;      // start the first frame; the count is left running for FEHPeriodic
 #if defined(__AVR_ATmega8__)|| defined(__AVR_ATmega128__)
     TIFR |= _BV(OCF1A);      // clear any pending interrupts
     TIMSK |=  _BV(OCIE1A) ;  // enable the output compare interrupt
 #else
     // here if not ATmega8 or ATmega128
-    TIFR1 |= _BV(OCF1A);     // clear any pending interrupts
+    TIFR1 = _BV(OCF1A);      // clear any pending interrupts (only OCF1A, FEHPeriodic's OCF1B may be pending)
     TIMSK1 |=  _BV(OCIE1A) ; // enable the output compare interrupt
 #endif
 #if defined(WIRING)
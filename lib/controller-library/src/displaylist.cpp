@@ -0,0 +1,114 @@
+/**
+ * displaylist.cpp
+ *
+ * Display-list records for FEHLCD; see private_include/displaylist.h. Records are sent as
+ * they are made, waiting for room in the Serial TX ring rather than dropping one: a lost
+ * clear or fill would leave the viewer wrong until the next full redraw.
+ */
+
+#include <Arduino.h>
+#include <FEHTelemetry.h>
+#include "../private_include/displaylist.h"
+#include <string.h>
+
+static bool s_drawing = true;
+static bool s_listing = false;
+
+// Pending text record, and where the cursor was left after its last character
+static uint8_t s_text[DISPLAY_LIST_MAX_RECORD];
+static uint8_t s_textLen;
+static int16_t s_textEndX, s_textEndY;
+
+/* Append a little-endian int16 and return the next position */
+static uint8_t *put16(uint8_t *p, int16_t v)
+{
+    *p++ = v & 0xFF;
+    *p++ = (uint16_t)v >> 8;
+    return p;
+}
+
+static void send(const uint8_t *record, uint8_t len)
+{
+    FEHTelemetry::send(TELEMETRY_CHANNEL_DISPLAY, record, len, true);
+}
+
+void displayListSetOutput(bool drawing, bool listing)
+{
+    displayListFlush();
+    s_drawing = drawing;
+    s_listing = listing;
+}
+
+bool displayListDrawing()
+{
+    return s_drawing;
+}
+
+bool displayListListing()
+{
+    return s_listing;
+}
+
+void displayListShape(DisplayListOp op, int16_t a, int16_t b, int16_t c, int16_t d, uint16_t color)
+{
+    displayListFlush();
+
+    uint8_t record[11];
+    uint8_t *p = record;
+    *p++ = op;
+    switch (op)
+    {
+    case DISPLAY_LIST_SCREEN:
+        p = put16(put16(p, a), b);
+        send(record, p - record);
+        return;
+    case DISPLAY_LIST_CLEAR:
+        break;
+    case DISPLAY_LIST_PIXEL:
+        p = put16(put16(p, a), b);
+        break;
+    case DISPLAY_LIST_CIRCLE:
+    case DISPLAY_LIST_FILL_CIRCLE:
+        p = put16(put16(put16(p, a), b), c);
+        break;
+    default:
+        p = put16(put16(put16(put16(p, a), b), c), d);
+        break;
+    }
+    p = put16(p, color);
+    send(record, p - record);
+}
+
+void displayListText(int16_t x, int16_t y, int16_t endX, int16_t endY, uint16_t color, uint16_t background,
+                     uint8_t size, bool wrap, const uint8_t *text, uint8_t len)
+{
+    uint8_t header[DISPLAY_LIST_TEXT_HEADER];
+    uint8_t *p = header;
+    *p++ = DISPLAY_LIST_TEXT;
+    p = put16(put16(put16(put16(p, x), y), color), background);
+    *p++ = size;
+    *p++ = wrap;
+
+    // Continue the pending record if this text starts where it ended, in the same style
+    bool continues = s_textLen > 0 && x == s_textEndX && y == s_textEndY &&
+                     !memcmp(s_text + 5, header + 5, DISPLAY_LIST_TEXT_HEADER - 5);
+    if (!continues || s_textLen + len > DISPLAY_LIST_MAX_RECORD)
+    {
+        displayListFlush();
+        memcpy(s_text, header, DISPLAY_LIST_TEXT_HEADER);
+        s_textLen = DISPLAY_LIST_TEXT_HEADER;
+    }
+    memcpy(s_text + s_textLen, text, len);
+    s_textLen += len;
+    s_textEndX = endX;
+    s_textEndY = endY;
+}
+
+void displayListFlush()
+{
+    if (s_textLen > 0)
+    {
+        send(s_text, s_textLen);
+        s_textLen = 0;
+    }
+}
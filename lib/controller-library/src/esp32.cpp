@@ -1,5 +1,10 @@
 #include "../private_include/esp32.h"
 #include "../private_include/UpdaterProtocol.h"
+#include "../private_include/spibus.h"
+#include "../private_include/trace.h"
+
+// SPCR/SPSR for the ESP32 link, computed at compile time instead of on every frame
+static const SpiBusSettings ESP32_SPI = spiBusSettings(ESP32_SPI_CLOCK_HZ, SPI_MODE0);
 
 // Minimal static state (~5 bytes of RAM only)
 static ESP32MessageCallback s_rxCallback = nullptr;
@@ -7,7 +12,7 @@ static uint32_t s_lastPollTime = 0;
 static bool s_isInitialized = false;
 
 // Forward declarations
-static void spiTransfer(uint8_t *tx, uint8_t *rx, uint8_t len);
+static bool spiTransfer(uint8_t *tx, uint8_t *rx, uint8_t len);
 static void handleReceivedMessage(const uint8_t *rxBuf);
 
 void ESP32::init(ESP32MessageCallback messageCallback) {
@@ -50,20 +55,21 @@ void ESP32::reset(bool factoryReset) {
 	powerOn(factoryReset);
 }
 
-static void spiTransfer(uint8_t *tx, uint8_t *rx, uint8_t len) {
-	SPI.beginTransaction(SPISettings(ESP32_SPI_CLOCK_HZ, MSBFIRST, SPI_MODE0));
-	digitalWrite(ESP32_PIN_CS, LOW);
-
-	for (uint8_t i = 0; i < len; ++i) {
-		rx[i] = SPI.transfer(tx[i]);
-	}
+static bool spiTransfer(uint8_t *tx, uint8_t *rx, uint8_t len) {
+	// Only refused if called from an interrupt while the LCD or SD card is mid-transaction
+	SpiBusOwner bus(SPI_BUS_ESP32);
+	if (!bus.owned()) return false;
 
+	spiBusBegin(ESP32_SPI);
+	digitalWrite(ESP32_PIN_CS, LOW);
+	spiBusTransfer(tx, rx, len);
 	digitalWrite(ESP32_PIN_CS, HIGH);
-	SPI.endTransaction();
+	return true;
 }
 
 bool ESP32::sendCommand(uint8_t cmd, const uint8_t *data, uint8_t dataLen) {
 	if (!s_isInitialized) return false;
+	_traceEvent(TRACE_ESP32_TX, cmd, dataLen);
 
 	uint8_t tx[ESP32_TX_BUF_LEN];
 	uint8_t rx[ESP32_TX_BUF_LEN];
@@ -87,7 +93,7 @@ bool ESP32::sendCommand(uint8_t cmd, const uint8_t *data, uint8_t dataLen) {
 		}
 	}
 
-	spiTransfer(tx, rx, ESP32_TX_BUF_LEN);
+	if (!spiTransfer(tx, rx, ESP32_TX_BUF_LEN)) return false;
 	handleReceivedMessage(rx);
 
 	return true;
@@ -105,7 +111,7 @@ void ESP32::poll() {
 	// Send empty poll packet (all zeros - no sync bytes needed for poll)
 	// ESP32 will respond with queued message if any
 
-	spiTransfer(tx, rx, ESP32_TX_BUF_LEN);
+	if (!spiTransfer(tx, rx, ESP32_TX_BUF_LEN)) return;
 	handleReceivedMessage(rx);
 }
 
@@ -0,0 +1,161 @@
+/**
+ * lcdtile.cpp
+ *
+ * Off-screen tile for widget redraws; see private_include/lcdtile.h. There is one
+ * buffer, so only one tile may be drawing at a time.
+ */
+
+#include "../private_include/lcdtile.h"
+#include "../private_include/FEHInternal.h"
+#include "../private_include/spibus.h"
+#include <string.h>
+
+#define LCD_TILE_PIXELS (LCD_TILE_BYTES * 4)
+#define LCD_TILE_CHUNK 32 // Pixels expanded to RGB565 per spiBusWrite()
+
+// Four 2-bit palette indices per byte, lowest bits first
+static uint8_t s_pixels[LCD_TILE_BYTES];
+
+LcdTile::LcdTile(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *palette, uint8_t colors)
+    : Adafruit_GFX(ILI9341.width(), ILI9341.height()), _palette(palette),
+      _colors(colors > LCD_TILE_COLORS ? LCD_TILE_COLORS : colors), _bandRows(0)
+{
+    // Clip to the screen, as the display would
+    if (x < 0)
+    {
+        w += x;
+        x = 0;
+    }
+    if (y < 0)
+    {
+        h += y;
+        y = 0;
+    }
+    if (x + w > _width)
+    {
+        w = _width - x;
+    }
+    if (y + h > _height)
+    {
+        h = _height - y;
+    }
+    _x = x;
+    _y = y;
+    _w = w > 0 ? w : 0;
+    _h = h > 0 ? h : 0;
+    _bandY = _y;
+
+    // Text drawn into the tile sizes and wraps as it would on the display
+    setTextSize(ILI9341.textSize());
+}
+
+bool LcdTile::nextBand()
+{
+    if (_bandRows)
+    {
+        send();
+        _bandY += _bandRows;
+    }
+    if (_w == 0 || _bandY >= _y + _h)
+    {
+        _bandRows = 0;
+        return false;
+    }
+
+    int16_t rows = LCD_TILE_PIXELS / _w;
+    _bandRows = _y + _h - _bandY < rows ? _y + _h - _bandY : rows;
+    memset(s_pixels, 0, sizeof(s_pixels));
+    return true;
+}
+
+uint8_t LcdTile::index(uint16_t color) const
+{
+    for (uint8_t i = 1; i < _colors; i++)
+    {
+        if (_palette[i] == color)
+        {
+            return i;
+        }
+    }
+    return 0;
+}
+
+void LcdTile::drawPixel(int16_t x, int16_t y, uint16_t color)
+{
+    fillRect(x, y, 1, 1, color);
+}
+
+void LcdTile::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    // Clip to the current band
+    int16_t x0 = x > _x ? x : _x;
+    int16_t x1 = x + w < _x + _w ? x + w : _x + _w;
+    int16_t y0 = y > _bandY ? y : _bandY;
+    int16_t y1 = y + h < _bandY + _bandRows ? y + h : _bandY + _bandRows;
+    if (x0 >= x1 || y0 >= y1)
+    {
+        return;
+    }
+
+    uint8_t i = index(color);
+    for (int16_t row = y0; row < y1; row++)
+    {
+        uint16_t p = (uint16_t)(row - _bandY) * _w + (x0 - _x);
+        for (int16_t col = x0; col < x1; col++, p++)
+        {
+            uint8_t shift = (p & 3) * 2;
+            s_pixels[p >> 2] = (s_pixels[p >> 2] & ~(3 << shift)) | (i << shift);
+        }
+    }
+}
+
+void LcdTile::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+    fillRect(x, y, w, 1, color);
+}
+
+void LcdTile::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+    fillRect(x, y, 1, h, color);
+}
+
+void LcdTile::fillScreen(uint16_t color)
+{
+    fillRect(_x, _y, _w, _h, color);
+}
+
+void LcdTile::send()
+{
+    // RGB565, high byte first, as the panel takes them
+    uint8_t colors[LCD_TILE_COLORS][2] = {};
+    for (uint8_t i = 0; i < _colors; i++)
+    {
+        colors[i][0] = _palette[i] >> 8;
+        colors[i][1] = _palette[i] & 0xFF;
+    }
+
+    uint8_t out[LCD_TILE_CHUNK * 2];
+    uint16_t count = (uint16_t)_w * _bandRows;
+
+    ILI9341.startWrite();
+    ILI9341.setAddrWindow(_x, _bandY, _w, _bandRows);
+    for (uint16_t p = 0; p < count;)
+    {
+        uint8_t *o = out;
+        uint8_t n = count - p < LCD_TILE_CHUNK ? count - p : LCD_TILE_CHUNK;
+        // Whole bytes of four pixels; the last may be partly past the band
+        for (uint8_t b = 0; b < n; b += 4)
+        {
+            uint8_t packed = s_pixels[(p + b) >> 2];
+            for (uint8_t k = 0; k < 4; k++, packed >>= 2)
+            {
+                *o++ = colors[packed & 3][0];
+                *o++ = colors[packed & 3][1];
+            }
+        }
+        spiBusWrite(out, 2 * n);
+        p += n;
+    }
+    // Each band is its own transaction, so pending bus work can go between bands
+    ILI9341.endWrite();
+}
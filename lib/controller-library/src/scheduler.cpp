@@ -17,6 +17,9 @@
  */
 
 #include <Arduino.h>
+#include <FEHLog.h>
+#include <util/atomic.h>
+#include "../private_include/trace.h"
 #define SCHEDULER_MAX_EVENTS 8
 
 struct EventData
@@ -29,6 +32,11 @@ struct EventData
 static EventData eventData[SCHEDULER_MAX_EVENTS];
 static volatile uint8_t numEventsPending = 0;
 
+/* Events refused because the queue was full, reported by schedulerService(). scheduleEvent()
+ * runs inside the ISR whenever an event reschedules itself, where logging is not safe. */
+static volatile uint8_t droppedEvents = 0;
+static void (*volatile lastDroppedCallback)() = nullptr;
+
 static void schedulerTimerDisable()
 {
     /* Stop Timer 4 so we can schedule. */
@@ -89,6 +97,8 @@ bool scheduleEvent(void (*callback)(), uint16_t ticks)
     /* Prevent UB in case too many events are added */
     if (numEventsPending >= SCHEDULER_MAX_EVENTS)
     {
+        droppedEvents += droppedEvents < 255;
+        lastDroppedCallback = callback;
         return false;
     }
 
@@ -176,6 +186,7 @@ ISR(TIMER4_COMPA_vect)
         numEventsPending--;
 
         /* Dispatch the event */
+        _traceEvent(TRACE_DISPATCH, 0, (uint16_t)(uintptr_t)e.callback);
         e.callback();
     }
 
@@ -232,6 +243,29 @@ void cancelEvents(void (*callback)())
     schedulerTimerSetup();
 }
 
+bool schedulerHasRoom()
+{
+    return numEventsPending < SCHEDULER_MAX_EVENTS;
+}
+
+bool schedulerService()
+{
+    uint8_t dropped;
+    void (*callback)();
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        dropped = droppedEvents;
+        callback = lastDroppedCallback;
+        droppedEvents = 0;
+    }
+    if (dropped == 0)
+    {
+        return false;
+    }
+    FEH_LOG_WARN(SCHEDULER, "queue full, %u events dropped, last %lx", dropped, (unsigned long)(uintptr_t)callback);
+    return true;
+}
+
 uint16_t schedulerMsToTicks(int milliseconds)
 {
     // 64 micros per tick
@@ -0,0 +1,201 @@
+/**
+ * spibus.cpp
+ *
+ * Pipelined block transfers on the hardware SPI port. Each loop fetches the next byte
+ * into a register before polling SPIF, and stores the received byte only after SPDR has
+ * been reloaded, so the memory accesses overlap the byte on the wire. At SCK = F_CPU/2 a
+ * byte takes 16 cycles, which leaves just enough time for the loop itself.
+ *
+ * The arbiter below is bookkeeping only: it never waits for the bus. The main thread is
+ * the only user of the port, so a refusal means an interrupt tried to use it mid-transfer.
+ */
+
+#include "../private_include/spibus.h"
+#include <string.h>
+#include <util/atomic.h>
+
+#define SPI_BUS_FREE 0xFF
+
+static volatile uint8_t s_owner = SPI_BUS_FREE;
+static uint8_t s_depth;
+static unsigned long s_acquiredAt;
+static volatile uint8_t s_pending; // One bit per device with a request outstanding
+static unsigned long s_requestedAt[SPI_BUS_DEVICES];
+static void (*s_service[SPI_BUS_DEVICES])();
+static bool s_yielding;
+static SpiBusStatistics s_stats;
+
+//=============================================================================
+// BLOCK TRANSFERS
+//=============================================================================
+
+static inline void waitForByte()
+{
+    while (!(SPSR & _BV(SPIF)))
+    {
+    }
+}
+
+void spiBusTransfer(const uint8_t *tx, uint8_t *rx, uint16_t len)
+{
+    if (len == 0)
+    {
+        return;
+    }
+
+    SPDR = *tx++;
+    while (--len)
+    {
+        uint8_t out = *tx++;
+        waitForByte();
+        uint8_t in = SPDR;
+        SPDR = out;
+        *rx++ = in;
+    }
+    waitForByte();
+    *rx = SPDR;
+}
+
+void spiBusWrite(const uint8_t *tx, uint16_t len)
+{
+    if (len == 0)
+    {
+        return;
+    }
+
+    SPDR = *tx++;
+    while (--len)
+    {
+        uint8_t out = *tx++;
+        waitForByte();
+        SPDR = out;
+    }
+    waitForByte();
+    // Reading SPDR after SPIF clears it for the next user of the port
+    (void)SPDR;
+}
+
+void spiBusWriteRepeat16(uint16_t value, uint32_t count)
+{
+    uint8_t high = value >> 8;
+    uint8_t low = value & 0xFF;
+
+    while (count--)
+    {
+        SPDR = high;
+        waitForByte();
+        SPDR = low;
+        waitForByte();
+    }
+    (void)SPDR;
+}
+
+//=============================================================================
+// ARBITER
+//=============================================================================
+
+bool spiBusAcquire(SpiBusDevice device)
+{
+    unsigned long now = micros();
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (s_owner == device)
+        {
+            s_depth++;
+            return true;
+        }
+        if (s_owner != SPI_BUS_FREE)
+        {
+            s_stats.conflicts++;
+            return false;
+        }
+
+        s_owner = device;
+        s_depth = 1;
+        s_acquiredAt = now;
+        s_stats.transactions[device]++;
+        if (s_pending & _BV(device))
+        {
+            s_pending &= ~_BV(device);
+            unsigned long latency = now - s_requestedAt[device];
+            if (latency > s_stats.maxLatencyMicros[device])
+            {
+                s_stats.maxLatencyMicros[device] = latency;
+            }
+        }
+    }
+    return true;
+}
+
+void spiBusRelease(SpiBusDevice device)
+{
+    unsigned long now = micros();
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (s_owner == device && --s_depth == 0)
+        {
+            s_stats.busyMicros[device] += now - s_acquiredAt;
+            s_owner = SPI_BUS_FREE;
+        }
+    }
+}
+
+void spiBusRequest(SpiBusDevice device)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (!(s_pending & _BV(device)))
+        {
+            s_pending |= _BV(device);
+            s_requestedAt[device] = micros();
+        }
+        s_stats.requests[device]++;
+    }
+}
+
+void spiBusSetService(SpiBusDevice device, void (*service)())
+{
+    s_service[device] = service;
+}
+
+bool spiBusYield(SpiBusDevice device)
+{
+    uint8_t higher = (uint8_t)(0xFF << (device + 1));
+    if (!(s_pending & higher) || s_owner != SPI_BUS_FREE || s_yielding)
+    {
+        return false;
+    }
+
+    // A service may draw or log in turn; its own preemption points must not nest
+    s_yielding = true;
+    bool ran = false;
+    for (int8_t d = SPI_BUS_DEVICES - 1; d > device; d--)
+    {
+        if ((s_pending & _BV(d)) && s_service[d])
+        {
+            s_service[d]();
+            // Served even if the service found nothing to send
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                s_pending &= ~_BV(d);
+            }
+            s_stats.preemptions++;
+            ran = true;
+        }
+    }
+    s_yielding = false;
+    return ran;
+}
+
+const SpiBusStatistics &spiBusStats()
+{
+    return s_stats;
+}
+
+void spiBusResetStats()
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        memset(&s_stats, 0, sizeof(s_stats));
+    }
+}
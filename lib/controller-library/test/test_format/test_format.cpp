@@ -0,0 +1,114 @@
+/*
+ * test_format.cpp
+ *
+ * Unit tests for FormatText() and FixedString with the AVR's 16-bit int and 32-bit
+ * double. Under the simavr harness (pio test -e simavr) the cycles to build one line of
+ * text with String and with FormatText() are reported as regions.
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include <FEH.h>
+#include "../private_include/avrsim.h"
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+static void assertFormat(const char *expected, const char *fmt, ...)
+{
+    char buf[48];
+    va_list args;
+    va_start(args, fmt);
+    int n = FormatTextV(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    TEST_ASSERT_EQUAL_STRING(expected, buf);
+    TEST_ASSERT_EQUAL(strlen(expected), n);
+}
+
+void test_format_integers()
+{
+    assertFormat("-32768 65535", "%d %u", -32768, 65535u);
+    assertFormat("-2147483648 ffffffff", "%ld %lx", -2147483647L - 1, 0xFFFFFFFFUL);
+    assertFormat("  42|42   |-0042", "%4d|%-5d|%05d", 42, 42, -42);
+}
+
+void test_format_floats()
+{
+    assertFormat("3.14", "%.2f", 3.14159f);
+    assertFormat("-0.50|  2.000|1", "%.2f|%7.3f|%.0f", -0.5f, 2.0f, 0.9f);
+    assertFormat("Left Optosensor Value:1.23", "Left Optosensor Value:%.2f", 1.234f);
+    assertFormat("ovf nan", "%f %f", 5e9, NAN);
+}
+
+void test_fixed_string()
+{
+    FixedString<16> s("L=");
+    s += 1.5f;
+    s += " R=";
+    s += 2;
+    TEST_ASSERT_EQUAL_STRING("L=1.50 R=2", s.c_str());
+    TEST_ASSERT_FALSE(s.truncated());
+
+    s += " and more text";
+    TEST_ASSERT_EQUAL(16, s.length());
+    TEST_ASSERT_TRUE(s.truncated());
+}
+
+void test_line_build_regions()
+{
+    Serial.println("AVRSIM REGION 1 String_line");
+    Serial.println("AVRSIM REGION 2 FormatText_line");
+    Serial.println("AVRSIM REGION 3 FixedString_line");
+
+    volatile float value = 1.234f;
+    volatile size_t sink;
+    char buf[LCD_FORMAT_BUFFER_SIZE];
+
+    for (int i = 0; i < 20; i++)
+    {
+        AVRSIM_BEGIN(1);
+        {
+            String line = "Left Optosensor Value:" + String(value);
+            sink = line.length();
+        }
+        AVRSIM_END();
+
+        AVRSIM_BEGIN(2);
+        sink = FormatText(buf, sizeof(buf), "Left Optosensor Value:%.2f", value);
+        AVRSIM_END();
+
+        AVRSIM_BEGIN(3);
+        {
+            FixedString<40> line("Left Optosensor Value:");
+            line += value;
+            sink = line.length();
+        }
+        AVRSIM_END();
+    }
+    (void)sink;
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(2000);
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_format_integers);
+    RUN_TEST(test_format_floats);
+    RUN_TEST(test_fixed_string);
+    RUN_TEST(test_line_build_regions);
+
+    UNITY_END();
+}
+
+void loop()
+{
+}
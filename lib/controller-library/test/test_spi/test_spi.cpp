@@ -0,0 +1,195 @@
+/*
+ * test_spi.cpp
+ *
+ * Unit tests for the SPI block transfers in spibus.h, and their throughput against a
+ * SPI.transfer() loop for a 48-byte ESP32 frame and a 4 KB display block. Every chip
+ * select stays high, so nothing on the shield sees the traffic. The bus arbiter is checked
+ * for ownership and for serving pending requests highest priority first.
+ * Under the simavr harness (pio test -e simavr) each transfer is also reported as a region.
+ */
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <unity.h>
+#include <FEH.h>
+#include "../private_include/spibus.h"
+#include "../private_include/avrsim.h"
+
+#define FRAME_LEN 48
+#define BLOCK_LEN 4096
+
+static const uint8_t CS_PINS[] = {40, 43, 53}; // ESP32, SD card, display
+
+static uint8_t s_tx[BLOCK_LEN];
+static uint8_t s_rx[BLOCK_LEN];
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_settings_match_spisettings()
+{
+    static const uint32_t CLOCKS[] = {16000000, 8000000, 4000000, 2000000, 1000000, 500000, 250000, 125000, 50000};
+    static const uint8_t MODES[] = {SPI_MODE0, SPI_MODE3};
+
+    for (uint8_t m = 0; m < sizeof(MODES); m++)
+    {
+        for (uint8_t c = 0; c < sizeof(CLOCKS) / sizeof(CLOCKS[0]); c++)
+        {
+            SPI.beginTransaction(SPISettings(CLOCKS[c], MSBFIRST, MODES[m]));
+            uint8_t spcr = SPCR;
+            uint8_t spsr = SPSR & _BV(SPI2X);
+            SPI.endTransaction();
+
+            SpiBusSettings settings = spiBusSettings(CLOCKS[c], MODES[m]);
+            TEST_ASSERT_EQUAL_HEX8(spcr, settings.spcr);
+            TEST_ASSERT_EQUAL_HEX8(spsr, settings.spsr);
+        }
+    }
+}
+
+/* Bytes per second of @p len bytes sent in @p micros, printed for the log */
+static uint32_t report(const char *name, uint16_t len, uint32_t micros)
+{
+    uint32_t rate = (uint32_t)((uint64_t)len * 1000000UL / (micros ? micros : 1));
+    char line[80];
+    snprintf(line, sizeof(line), "spi: %s %u bytes in %lu us, %lu bytes/s", name, len, micros, rate);
+    Serial.println(line);
+    return rate;
+}
+
+void test_frame_throughput()
+{
+    Serial.println("AVRSIM REGION 1 frame_48_per_byte");
+    Serial.println("AVRSIM REGION 2 frame_48_block");
+
+    static const SpiBusSettings FAST = spiBusSettings(8000000, SPI_MODE0);
+
+    uint32_t start = micros();
+    AVRSIM_BEGIN(1);
+    SPI.beginTransaction(SPISettings(8000000, MSBFIRST, SPI_MODE0));
+    for (uint8_t i = 0; i < FRAME_LEN; i++)
+    {
+        s_rx[i] = SPI.transfer(s_tx[i]);
+    }
+    SPI.endTransaction();
+    AVRSIM_END();
+    uint32_t perByte = report("frame_48/per_byte", FRAME_LEN, micros() - start);
+
+    start = micros();
+    AVRSIM_BEGIN(2);
+    spiBusBegin(FAST);
+    spiBusTransfer(s_tx, s_rx, FRAME_LEN);
+    AVRSIM_END();
+    uint32_t block = report("frame_48/block", FRAME_LEN, micros() - start);
+
+    TEST_ASSERT_TRUE(block > perByte);
+}
+
+void test_block_throughput()
+{
+    Serial.println("AVRSIM REGION 3 block_4k_per_byte");
+    Serial.println("AVRSIM REGION 4 block_4k_write");
+
+    SPI.beginTransaction(SPISettings(8000000, MSBFIRST, SPI_MODE0));
+
+    uint32_t start = micros();
+    AVRSIM_BEGIN(3);
+    for (uint16_t i = 0; i < BLOCK_LEN; i++)
+    {
+        SPI.transfer(s_tx[i]);
+    }
+    AVRSIM_END();
+    uint32_t perByte = report("block_4k/per_byte", BLOCK_LEN, micros() - start);
+
+    start = micros();
+    AVRSIM_BEGIN(4);
+    spiBusWrite(s_tx, BLOCK_LEN);
+    AVRSIM_END();
+    uint32_t block = report("block_4k/write", BLOCK_LEN, micros() - start);
+
+    SPI.endTransaction();
+
+    // 8 MHz SCK carries at most 1 MB/s
+    TEST_ASSERT_TRUE(block > perByte);
+    TEST_ASSERT_TRUE(block <= 1000000UL);
+}
+
+static uint8_t s_served[SPI_BUS_DEVICES];
+static uint8_t s_serveCount;
+
+static void serveSd()
+{
+    s_served[s_serveCount++] = SPI_BUS_SD;
+    SpiBusOwner bus(SPI_BUS_SD);
+}
+
+static void serveEsp32()
+{
+    s_served[s_serveCount++] = SPI_BUS_ESP32;
+    SpiBusOwner bus(SPI_BUS_ESP32);
+}
+
+void test_arbiter()
+{
+    spiBusResetStats();
+    spiBusSetService(SPI_BUS_SD, serveSd);
+    spiBusSetService(SPI_BUS_ESP32, serveEsp32);
+
+    TEST_ASSERT_TRUE(spiBusAcquire(SPI_BUS_LCD));
+    TEST_ASSERT_FALSE(spiBusAcquire(SPI_BUS_ESP32));
+    spiBusRequest(SPI_BUS_SD);
+    spiBusRequest(SPI_BUS_ESP32);
+    TEST_ASSERT_FALSE(spiBusYield(SPI_BUS_LCD)); // Still held
+    spiBusRelease(SPI_BUS_LCD);
+
+    s_serveCount = 0;
+    TEST_ASSERT_TRUE(spiBusYield(SPI_BUS_LCD));
+    TEST_ASSERT_EQUAL_UINT8(2, s_serveCount);
+    TEST_ASSERT_EQUAL_UINT8(SPI_BUS_ESP32, s_served[0]);
+    TEST_ASSERT_EQUAL_UINT8(SPI_BUS_SD, s_served[1]);
+    TEST_ASSERT_FALSE(spiBusYield(SPI_BUS_LCD)); // Nothing left pending
+
+    const SpiBusStatistics &stats = spiBusStats();
+    TEST_ASSERT_EQUAL_UINT32(1, stats.conflicts);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.preemptions);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.transactions[SPI_BUS_ESP32]);
+
+    spiBusSetService(SPI_BUS_SD, NULL);
+    spiBusSetService(SPI_BUS_ESP32, NULL);
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(2000);
+
+    for (uint8_t i = 0; i < sizeof(CS_PINS); i++)
+    {
+        pinMode(CS_PINS[i], OUTPUT);
+        digitalWrite(CS_PINS[i], HIGH);
+    }
+    SPI.begin();
+    for (uint16_t i = 0; i < BLOCK_LEN; i++)
+    {
+        s_tx[i] = (uint8_t)(i * 7);
+    }
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_settings_match_spisettings);
+    RUN_TEST(test_frame_throughput);
+    RUN_TEST(test_block_throughput);
+    RUN_TEST(test_arbiter);
+
+    UNITY_END();
+}
+
+void loop()
+{
+}
@@ -0,0 +1,176 @@
+/*
+ * test_time.cpp
+ *
+ * Unit tests for TimeNowMicros(), the Deadline, Stopwatch and RateLimiter helpers, and
+ * the timing of Sleep().
+ * Under the simavr harness (pio test -e simavr) the cost of each clock read is also
+ * reported as a region.
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include <FEH.h>
+#include "../private_include/avrsim.h"
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_now_micros_follows_micros()
+{
+    for (int i = 0; i < 200; i++)
+    {
+        unsigned long before = micros();
+        uint64_t now = TimeNowMicros();
+        unsigned long after = micros();
+
+        /* Both read Timer 0, so they agree to its 4 us step */
+        TEST_ASSERT_TRUE((unsigned long)now - before <= after - before + 4);
+        delayMicroseconds(97);
+    }
+}
+
+void test_now_micros_monotonic_across_overflows()
+{
+    /* Timer 0 overflows every 1024 us; sample densely across several of them */
+    uint64_t last = TimeNowMicros();
+    for (int i = 0; i < 5000; i++)
+    {
+        uint64_t now = TimeNowMicros();
+        TEST_ASSERT_TRUE(now >= last);
+        last = now;
+    }
+}
+
+void test_deadline()
+{
+    TEST_ASSERT_TRUE(Deadline().Expired());
+
+    Deadline d = Deadline::InMillis(20);
+    TEST_ASSERT_FALSE(d.Expired());
+    TEST_ASSERT_UINT32_WITHIN(1, 19, d.RemainingMillis());
+
+    delay(10);
+    TEST_ASSERT_FALSE(d.Expired());
+    d.ExtendMillis(10);
+    delay(15);
+    TEST_ASSERT_FALSE(d.Expired());
+    delay(6);
+    TEST_ASSERT_TRUE(d.Expired());
+    TEST_ASSERT_EQUAL_UINT32(0, d.RemainingMillis());
+}
+
+void test_stopwatch()
+{
+    Stopwatch watch;
+    delay(30);
+    TEST_ASSERT_UINT32_WITHIN(1, 30, watch.ElapsedMillis());
+
+    uint64_t lap = watch.Lap();
+    TEST_ASSERT_UINT32_WITHIN(1100, 30000, (uint32_t)lap);
+    TEST_ASSERT_TRUE(watch.ElapsedMicros() < 1000);
+
+    delay(50);
+    TEST_ASSERT_FLOAT_WITHIN(0.002, 0.05, watch.ElapsedSeconds());
+}
+
+void test_rate_limiter()
+{
+    RateLimiter limiter(10);
+    int ready = 0;
+
+    /* Ready immediately, then every 10 ms without drift */
+    Stopwatch watch;
+    while (watch.ElapsedMillis() < 95)
+    {
+        ready += limiter.Ready();
+    }
+    TEST_ASSERT_EQUAL(10, ready);
+
+    /* After a gap, one Ready() and no burst to catch up */
+    delay(50);
+    TEST_ASSERT_TRUE(limiter.Ready());
+    TEST_ASSERT_FALSE(limiter.Ready());
+
+    limiter.Reset();
+    TEST_ASSERT_TRUE(limiter.Ready());
+}
+
+void test_sleep_keeps_time()
+{
+    ResetSleepStats();
+
+    Stopwatch watch;
+    Sleep(50);
+    TEST_ASSERT_UINT32_WITHIN(200, 50000, (uint32_t)watch.ElapsedMicros());
+
+    watch.Restart();
+    Sleep(0.25);
+    TEST_ASSERT_UINT32_WITHIN(200, 250000, (uint32_t)watch.ElapsedMicros());
+
+    SleepStatistics stats = SleepStats();
+    TEST_ASSERT_UINT32_WITHIN(400, 300000, (uint32_t)stats.sleptMicros);
+    TEST_ASSERT_TRUE(stats.servicedMicros <= stats.sleptMicros);
+}
+
+void test_clock_read_regions()
+{
+    Serial.println("AVRSIM REGION 1 micros");
+    Serial.println("AVRSIM REGION 2 millis");
+    Serial.println("AVRSIM REGION 3 TimeNowMicros");
+    Serial.println("AVRSIM REGION 4 TimeNow");
+    Serial.println("AVRSIM REGION 5 Deadline_Expired");
+
+    volatile uint64_t sink;
+    Deadline d = Deadline::InMillis(1000);
+    for (int i = 0; i < 100; i++)
+    {
+        AVRSIM_BEGIN(1);
+        sink = micros();
+        AVRSIM_END();
+
+        AVRSIM_BEGIN(2);
+        sink = millis();
+        AVRSIM_END();
+
+        AVRSIM_BEGIN(3);
+        sink = TimeNowMicros();
+        AVRSIM_END();
+
+        AVRSIM_BEGIN(4);
+        sink = (uint64_t)TimeNow();
+        AVRSIM_END();
+
+        AVRSIM_BEGIN(5);
+        sink = d.Expired();
+        AVRSIM_END();
+    }
+    (void)sink;
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(2000);
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_now_micros_follows_micros);
+    RUN_TEST(test_now_micros_monotonic_across_overflows);
+    RUN_TEST(test_deadline);
+    RUN_TEST(test_stopwatch);
+    RUN_TEST(test_rate_limiter);
+    RUN_TEST(test_sleep_keeps_time);
+    RUN_TEST(test_clock_read_regions);
+
+    UNITY_END();
+}
+
+void loop()
+{
+}
@@ -0,0 +1,138 @@
+/*
+ * test_waveforms.cpp
+ *
+ * Timer register and waveform tests, meant for the simavr harness (pio test -e simavr).
+ * Register values are checked here; pin waveforms are measured by the harness from the
+ * "AVRSIM EXPECT" lines and reported as extra tests. On a real Mega the register tests
+ * still run and the AVRSIM lines are just printed.
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include <FEH.h>
+#include "../private_include/scheduler.h"
+#include "../private_include/avrsim.h"
+
+FEHMotor motor0(FEHMotor::FEHMotorPort::Motor0, 12);
+FEHServo servo0(FEHServo::FEHServoPort::Servo0);
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void dummyCallback(void)
+{
+}
+
+/* The queue holds 8 events. Distinct bodies keep the linker from folding them into one. */
+static volatile uint8_t fillerFired;
+void (*const QUEUE_FILLERS[])(void) = {
+    [] { fillerFired = 1; }, [] { fillerFired = 2; }, [] { fillerFired = 3; }, [] { fillerFired = 4; },
+    [] { fillerFired = 5; }, [] { fillerFired = 6; }, [] { fillerFired = 7; },
+};
+
+void test_motor0_pwm_registers()
+{
+    motor0.SetPercent(25);
+
+    /* Phase correct 8-bit PWM, non-inverting on OC3C, clk/1 */
+    TEST_ASSERT_EQUAL_HEX8(bit(COM3C1) | bit(WGM30), TCCR3A);
+    TEST_ASSERT_EQUAL_HEX8(bit(CS30), TCCR3B);
+    TEST_ASSERT_EQUAL(63, OCR3C);
+
+    /* High for 63 / 255 of each 16 MHz / 510 period on PE5 */
+    Serial.println("AVRSIM EXPECT E5 duty_pct 24.7 0.3");
+    Serial.println("AVRSIM EXPECT E5 freq_hz 31372.5 1");
+}
+
+void test_servo0_pulse_registers()
+{
+    servo0.SetDegree(90);
+
+    /* Servo library runs Timer 1 in normal mode at clk/8 */
+    TEST_ASSERT_EQUAL_HEX8(bit(CS11), TCCR1B);
+    TEST_ASSERT_TRUE(TIMSK1 & bit(OCIE1A));
+
+    /* Halfway between 500 and 2500 us, on pin 12 (PB6), every 20 ms */
+    Serial.println("AVRSIM EXPECT B6 high_us 1500 8");
+    Serial.println("AVRSIM EXPECT B6 freq_hz 50 0.5");
+}
+
+void test_buzzer_tone_registers()
+{
+    Buzzer.Tone(440);
+
+    /* CTC at clk/128: 16 MHz / (2 * 128 * (141 + 1)) = 440.1 Hz */
+    TEST_ASSERT_EQUAL_HEX8(bit(WGM21), TCCR2A);
+    TEST_ASSERT_EQUAL_HEX8(bit(CS22) | bit(CS20), TCCR2B);
+    TEST_ASSERT_EQUAL(141, OCR2A);
+    TEST_ASSERT_TRUE(TIMSK2 & bit(OCIE2A));
+
+    Serial.println("AVRSIM EXPECT G5 freq_hz 440.1 0.5");
+    Serial.println("AVRSIM EXPECT G5 duty_pct 50 1");
+}
+
+void test_scheduler_insert_regions()
+{
+    /* Region n times an insert into a queue already holding n - 1 events */
+    for (int depth = 0; depth < 8; depth++)
+    {
+        Serial.print("AVRSIM REGION ");
+        Serial.print(depth + 1);
+        Serial.print(" scheduleEvent_depth");
+        Serial.println(depth);
+
+        for (int i = 0; i < depth; i++)
+        {
+            TEST_ASSERT_TRUE(scheduleEvent(QUEUE_FILLERS[i], 60000));
+        }
+
+        AVRSIM_BEGIN(depth + 1);
+        bool scheduled = scheduleEvent(dummyCallback, 30000);
+        AVRSIM_END();
+        TEST_ASSERT_TRUE(scheduled);
+
+        AVRSIM_BEGIN(depth + 9);
+        cancelEvents(dummyCallback);
+        AVRSIM_END();
+
+        for (int i = 0; i < depth; i++)
+        {
+            cancelEvents(QUEUE_FILLERS[i]);
+        }
+    }
+    for (int depth = 0; depth < 8; depth++)
+    {
+        Serial.print("AVRSIM REGION ");
+        Serial.print(depth + 9);
+        Serial.print(" cancelEvents_depth");
+        Serial.println(depth);
+    }
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(2000);
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_motor0_pwm_registers);
+    RUN_TEST(test_servo0_pulse_registers);
+    RUN_TEST(test_buzzer_tone_registers);
+    RUN_TEST(test_scheduler_insert_regions);
+
+    /* Waveforms are measured from here until the harness stops the simulation */
+    Serial.println("AVRSIM MARK");
+
+    UNITY_END();
+}
+
+void loop()
+{
+}
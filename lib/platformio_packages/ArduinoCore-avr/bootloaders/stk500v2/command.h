@@ -112,3 +112,9 @@
 
 #define ANSWER_CKSUM_ERROR                  0xB0
 
+
+// *****************[ FEH vendor command constants ]***************************
+// Used by lib/controller-library/host/tools/fast_upload.py, see stk500boot.c
+
+#define CMD_FEH_SET_BAUD                    0xF0
+#define CMD_FEH_PAGE_CRC                    0xF1
@@ -0,0 +1,228 @@
+//************************************************************************
+//*	espboot.c
+//*
+//*	Application update from the ESP32, see espboot.h.
+//*
+//*	Pages 1 to n-1 are fetched and written first, then page 0, which holds the
+//*	reset vector, once the whole image checks out. Page 0 is erased before
+//*	anything else. Pages after it may still hold the old application or part of
+//*	the new one, so the bootloader starts nothing while the update is pending
+//*	(espbootStart()) and the next reset or wait timeout resumes the update.
+//************************************************************************
+
+#ifdef ENABLE_ESP32_UPDATE
+
+#include	<inttypes.h>
+#include	<avr/io.h>
+#include	<util/crc16.h>
+#include	"espboot.h"
+#include	"AvrUpdateProtocol.h"
+
+#define	PAGE_NONE		0xFFFF
+#define	FRAME_PAGE		4								//*	[page:2] after the header
+#define	FRAME_DATA		(FRAME_PAGE + 2)
+#define	FRAME_CRC		(FRAME_DATA + AVR_UPDATE_PAGE_SIZE)
+
+static uint8_t	gFrame[AVR_UPDATE_FRAME_SIZE];
+
+
+//*****************************************************************************
+static uint16_t	CrcBlock(uint16_t crc, const uint8_t *data)
+{
+uint16_t	ii;
+
+	for (ii=0; ii<AVR_UPDATE_PAGE_SIZE; ii++)
+	{
+		crc	=	_crc16_update(crc, data[ii]);
+	}
+	return crc;
+}
+
+//*****************************************************************************
+static uint16_t	CrcFlash(uint16_t crc, uint16_t page)
+{
+uint32_t	address	=	(uint32_t)page * AVR_UPDATE_PAGE_SIZE;
+uint16_t	ii;
+
+	for (ii=0; ii<AVR_UPDATE_PAGE_SIZE; ii++)
+	{
+		crc	=	_crc16_update(crc, espbootFlashByte(address + ii));
+	}
+	return crc;
+}
+
+//*****************************************************************************
+/*
+ * Send one frame asking for page "request" and return the page answered by it
+ * (the answer to the previous frame's request), or PAGE_NONE if it is not a
+ * good RSP_AVR_PAGE
+ */
+static uint16_t	Exchange(uint16_t request)
+{
+uint16_t	ii;
+uint16_t	page;
+
+	gFrame[0]	=	0xAA;
+	gFrame[1]	=	0x55;
+	gFrame[2]	=	CMD_AVR_READ_PAGE;
+	gFrame[3]	=	2;
+	gFrame[4]	=	request & 0xFF;
+	gFrame[5]	=	request >> 8;
+	for (ii=6; ii<AVR_UPDATE_FRAME_SIZE; ii++)
+	{
+		gFrame[ii]	=	0;
+	}
+	espbootSpiFrame(gFrame, AVR_UPDATE_FRAME_SIZE);
+
+	if ((gFrame[0] != 0xAA) || (gFrame[1] != 0x55) || (gFrame[2] != RSP_AVR_PAGE))
+	{
+		return PAGE_NONE;
+	}
+	page	=	gFrame[FRAME_PAGE] | (gFrame[FRAME_PAGE + 1] << 8);
+	if (CrcBlock(0xFFFF, gFrame + FRAME_DATA) != (gFrame[FRAME_CRC] | (gFrame[FRAME_CRC + 1] << 8)))
+	{
+		return PAGE_NONE;
+	}
+	return page;
+}
+
+//*****************************************************************************
+/*
+ * Write the page in gFrame unless flash already holds it; false if it does not
+ * read back
+ */
+static uint8_t	WritePage(uint16_t page)
+{
+uint16_t	crc	=	gFrame[FRAME_CRC] | (gFrame[FRAME_CRC + 1] << 8);
+
+	if (CrcFlash(0xFFFF, page) == crc)
+	{
+		return 1;
+	}
+	espbootFlashWrite((uint32_t)page * AVR_UPDATE_PAGE_SIZE, gFrame + FRAME_DATA);
+	return CrcFlash(0xFFFF, page) == crc;
+}
+
+//*****************************************************************************
+/*
+ * Read the update marker; false if none is set or it does not describe an
+ * image that fits
+ */
+static uint8_t	ReadMarker(uint16_t *pages, uint16_t *imageCrc)
+{
+uint8_t		marker[AVR_UPDATE_MARKER_SIZE];
+uint16_t	ii;
+
+	for (ii=0; ii<AVR_UPDATE_MARKER_SIZE; ii++)
+	{
+		marker[ii]	=	espbootEepromRead(AVR_UPDATE_MARKER_ADDRESS + ii);
+	}
+	*pages		=	marker[1] | (marker[2] << 8);
+	*imageCrc	=	marker[3] | (marker[4] << 8);
+	return (marker[0] == AVR_UPDATE_MAGIC) && (marker[5] == (uint8_t)~AVR_UPDATE_MAGIC)
+		&& (*pages != 0) && (*pages <= AVR_UPDATE_MAX_PAGES);
+}
+
+//*****************************************************************************
+uint8_t	espbootPending(void)
+{
+uint16_t	pages;
+uint16_t	imageCrc;
+
+	return ReadMarker(&pages, &imageCrc);
+}
+
+//*****************************************************************************
+uint8_t	espbootRun(void)
+{
+uint16_t	pages;
+uint16_t	imageCrc;
+uint16_t	crc;
+uint16_t	ii;
+uint16_t	page;
+uint16_t	pending;
+uint16_t	request;
+uint16_t	fails;
+
+	if (!ReadMarker(&pages, &imageCrc))
+	{
+		return ESPBOOT_NOT_PENDING;
+	}
+
+	//*	uncommit: no reset vector until the whole image is in
+	for (ii=0; ii<AVR_UPDATE_PAGE_SIZE; ii++)
+	{
+		gFrame[ii]	=	0xFF;
+	}
+	if (CrcFlash(0xFFFF, 0) != CrcBlock(0xFFFF, gFrame))
+	{
+		espbootFlashWrite(0, gFrame);
+	}
+
+	//*	pages 1..n-1, then 0. Each frame asks for the page after the one it expects,
+	//*	unless the last answer went astray, when it asks for that page again.
+	ii		=	1;
+	pending	=	PAGE_NONE;
+	fails	=	0;
+	while (ii <= pages)
+	{
+		uint16_t	want	=	(ii < pages) ? ii : 0;
+		uint16_t	next	=	(ii + 1 < pages) ? ii + 1 : 0;
+
+		request	=	(pending == want) ? next : want;
+		page	=	Exchange(request);
+		pending	=	request;
+
+		if (page != want)
+		{
+			if (++fails > ESPBOOT_RETRIES)
+			{
+				return ESPBOOT_NO_ANSWER;
+			}
+			espbootIdle();
+			continue;
+		}
+		fails	=	0;
+
+		if (want == 0)
+		{
+			//*	commit only if page 0 and the pages already written make the image
+			crc	=	CrcBlock(0xFFFF, gFrame + FRAME_DATA);
+			for (page=1; page<pages; page++)
+			{
+				crc	=	CrcFlash(crc, page);
+			}
+			if (crc != imageCrc)
+			{
+				return ESPBOOT_BAD_IMAGE;
+			}
+		}
+		if (!WritePage(want))
+		{
+			return ESPBOOT_WRITE_FAILED;
+		}
+		ii++;
+	}
+
+	for (ii=0; ii<AVR_UPDATE_MARKER_SIZE; ii++)
+	{
+		espbootEepromWrite(AVR_UPDATE_MARKER_ADDRESS + ii, 0xFF);
+	}
+	return ESPBOOT_DONE;
+}
+
+//*****************************************************************************
+uint8_t	espbootStart(uint8_t resetFlags)
+{
+	if (!(resetFlags & _BV(EXTRF)) && espbootPending())
+	{
+		espbootSpiBegin();
+		espbootRun();
+		espbootSpiEnd();
+	}
+	//*	a pending update has erased page 0; the 0xFFFF sled would run into
+	//*	whatever the later pages hold
+	return !espbootPending() && ((espbootFlashByte(0) != 0xFF) || (espbootFlashByte(1) != 0xFF));
+}
+
+#endif
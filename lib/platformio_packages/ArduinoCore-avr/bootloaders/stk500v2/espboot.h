@@ -0,0 +1,59 @@
+//************************************************************************
+//*	espboot.h
+//*
+//*	Receives a Mega application from the ESP32 over SPI when the library has
+//*	marked an update pending in EEPROM. Protocol, marker and commit rule are in
+//*	lib/controller-library/private_include/AvrUpdateProtocol.h.
+//*
+//*	espboot.c only decides what to send and write; the hardware is reached through
+//*	the hooks below, which stk500boot.c implements for the ATmega2560 and the host
+//*	tests implement against a stand-in ESP32 (controller-library/host/tests/test_esp_update.cpp).
+//************************************************************************
+
+#ifndef _ESPBOOT_H_
+#define _ESPBOOT_H_
+
+#include	<inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//*	espbootRun() results
+#define	ESPBOOT_NOT_PENDING		0	//*	no update marked, nothing done
+#define	ESPBOOT_DONE			1	//*	image written and committed, marker cleared
+#define	ESPBOOT_NO_ANSWER		2	//*	the ESP32 stopped answering; marker kept
+#define	ESPBOOT_WRITE_FAILED	3	//*	a page did not read back as sent; marker kept
+#define	ESPBOOT_BAD_IMAGE		4	//*	pages arrived but the image CRC is wrong; marker kept
+
+//*	Failed frames in a row before giving up, espbootIdle() between each
+#define	ESPBOOT_RETRIES			2000
+
+//*	Hooks
+void		espbootSpiBegin(void);							//*	power the ESP32 and take the SPI bus
+void		espbootSpiEnd(void);							//*	release the SPI bus
+void		espbootSpiFrame(uint8_t *frame, uint16_t len);	//*	full duplex, answer replaces frame
+void		espbootIdle(void);								//*	pause after a frame that was not answered
+uint8_t		espbootFlashByte(uint32_t address);
+void		espbootFlashWrite(uint32_t address, const uint8_t *page);	//*	erase and write one page
+uint8_t		espbootEepromRead(uint16_t address);
+void		espbootEepromWrite(uint16_t address, uint8_t value);
+
+//*	Run a pending update to completion
+uint8_t		espbootRun(void);
+
+//*	Whether an update is marked pending in EEPROM
+uint8_t		espbootPending(void);
+
+//*	Run a pending update between espbootSpiBegin() and espbootSpiEnd(), unless
+//*	resetFlags (MCUSR) holds EXTRF, which is how avrdude asks for the UART
+//*	bootloader. Returns 1 if there is an application to start: no update pending
+//*	and a reset vector in page 0. Called at reset, and with resetFlags 0 each
+//*	time the wait for avrdude times out.
+uint8_t		espbootStart(uint8_t resetFlags);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
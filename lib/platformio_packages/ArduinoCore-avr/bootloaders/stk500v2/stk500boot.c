@@ -86,6 +86,11 @@ LICENSE:
 //*	Jan  1,	2012	<MLS> Issue 543: CMD_CHIP_ERASE_ISP now returns STATUS_CMD_FAILED instead of STATUS_CMD_OK
 //*	Jan  1,	2012	<MLS> Issue 543: Write EEPROM now does something (NOT TESTED)
 //*	Jan  1,	2012	<MLS> Issue 544: stk500v2 bootloader doesn't support reading fuses
+//*	Oct 17,	2026	<FEH> Added CMD_FEH_SET_BAUD and CMD_FEH_PAGE_CRC for fast_upload.py
+//*	Oct 17,	2026	<FEH> CMD_PROGRAM_FLASH_ISP erases the page it writes, so pages can be skipped
+//*	Oct 17,	2026	<FEH> ENABLE_ESP32_UPDATE: application updates from the ESP32 over SPI (espboot.c)
+//*	Oct 17,	2026	<FEH> The reset flags are passed to the application in GPIOR1
+//*	Oct 17,	2026	<FEH> No jump to the application while an ESP32 update is pending
 //************************************************************************
 
 //************************************************************************
@@ -109,11 +114,13 @@ LICENSE:
 #include	<avr/eeprom.h>
 #include	<avr/common.h>
 #include	<stdlib.h>
+#include	<util/crc16.h>
 #include	"command.h"
 
 
-#if defined(_MEGA_BOARD_) || defined(_BOARD_AMBER128_) || defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__) \
-	|| defined(__AVR_ATmega2561__) || defined(__AVR_ATmega1284P__) || defined(ENABLE_MONITOR)
+//*	the ESP32 update receiver needs the room the monitor takes
+#if !defined(ENABLE_ESP32_UPDATE) && (defined(_MEGA_BOARD_) || defined(_BOARD_AMBER128_) || defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__) \
+	|| defined(__AVR_ATmega2561__) || defined(__AVR_ATmega1284P__) || defined(ENABLE_MONITOR))
 	#undef		ENABLE_MONITOR
 	#define		ENABLE_MONITOR
 	static void	RunMonitor(void);
@@ -136,6 +143,7 @@ LICENSE:
 //#define	REMOVE_PROGRAM_LOCK_BIT_SUPPORT		// disable program lock bits
 //#define	REMOVE_BOOTLOADER_LED				// no LED to show active bootloader
 //#define	REMOVE_CMD_SPI_MULTI				// disable processing of SPI_MULTI commands, Remark this line for AVRDUDE <Worapoht>
+//#define	REMOVE_FEH_FAST_UPLOAD				// disable CMD_FEH_SET_BAUD and CMD_FEH_PAGE_CRC
 //
 
 
@@ -527,11 +535,103 @@ uint32_t count = 0;
 void (*app_start)(void) = 0x0000;
 
 
+#ifdef ENABLE_ESP32_UPDATE
+#include	"espboot.h"
+#include	"AvrUpdateProtocol.h"
+
+//************************************************************************
+//*	espboot.c hooks for the FEH shield: ESP32 chip select on D40 (PG1) and
+//*	enable on D22 (PA0); the LCD (D53, PB0 = SS) and SD card (D43, PL6) chip
+//*	selects are held high to keep them off the bus
+//************************************************************************
+void	espbootSpiFrame(uint8_t *frame, uint16_t len)
+{
+	PORTG	&=	~(1 << PG1);
+	while (len--)
+	{
+		SPDR	=	*frame;
+		while (!(SPSR & (1 << SPIF)))
+		{
+			// wait for the byte
+		}
+		*frame++	=	SPDR;
+	}
+	PORTG	|=	(1 << PG1);
+}
+
+//*****************************************************************************
+void	espbootIdle(void)
+{
+	_delay_ms(1);
+}
+
+//*****************************************************************************
+uint8_t	espbootFlashByte(uint32_t address)
+{
+#if (FLASHEND > 0x10000)
+	return pgm_read_byte_far(address);
+#else
+	return pgm_read_byte_near(address);
+#endif
+}
+
+//*****************************************************************************
+void	espbootFlashWrite(uint32_t address, const uint8_t *page)
+{
+unsigned int	ii;
+
+	boot_page_erase(address);
+	boot_spm_busy_wait();
+	for (ii=0; ii<SPM_PAGESIZE; ii+=2)
+	{
+		boot_page_fill(address + ii, page[ii] | (page[ii + 1] << 8));
+	}
+	boot_page_write(address);
+	boot_spm_busy_wait();
+	boot_rww_enable();
+}
+
+//*****************************************************************************
+uint8_t	espbootEepromRead(uint16_t address)
+{
+	return eeprom_read_byte((uint8_t *)address);
+}
+
+//*****************************************************************************
+void	espbootEepromWrite(uint16_t address, uint8_t value)
+{
+	eeprom_write_byte((uint8_t *)address, value);
+}
+
+//*****************************************************************************
+void	espbootSpiBegin(void)
+{
+	PORTA	|=	(1 << PA0);								// ESP32 stays powered
+	DDRA	|=	(1 << PA0);
+	PORTG	|=	(1 << PG1);
+	DDRG	|=	(1 << PG1);
+	PORTL	|=	(1 << PL6);
+	DDRL	|=	(1 << PL6);
+	PORTB	|=	(1 << PB0);
+	DDRB	|=	(1 << PB0) | (1 << PB1) | (1 << PB2);	// SS, SCK, MOSI
+	SPCR	=	(1 << SPE) | (1 << MSTR);				// mode 0, F_CPU / 4 = AVR_UPDATE_SPI_CLOCK_HZ
+}
+
+//*****************************************************************************
+void	espbootSpiEnd(void)
+{
+	SPCR	=	0;
+}
+#endif
+
+
 //*****************************************************************************
 int main(void)
 {
 	address_t		address			=	0;
-	address_t		eraseAddress	=	0;
+#ifndef REMOVE_FEH_FAST_UPLOAD
+	unsigned char	newBaudSelect	=	0;
+#endif
 	unsigned char	msgParseState;
 	unsigned int	ii				=	0;
 	unsigned char	checksum		=	0;
@@ -561,7 +661,10 @@ int main(void)
 	//*	Dec 29,	2011	<MLS> Issue #181, added watch dog timmer support
 	//*	handle the watch dog timer
 	uint8_t	mcuStatusReg;
+	uint8_t	appPresent		=	1;
 	mcuStatusReg	=	MCUSR;
+	//*	MCUSR is cleared below, so pass the reset cause on to the application
+	GPIOR1			=	mcuStatusReg;
 
 	__asm__ __volatile__ ("cli");
 	__asm__ __volatile__ ("wdr");
@@ -569,8 +672,16 @@ int main(void)
 	WDTCSR	|=	_BV(WDCE) | _BV(WDE);
 	WDTCSR	=	0;
 	__asm__ __volatile__ ("sei");
+#ifdef ENABLE_ESP32_UPDATE
+	//*	A pending update runs before the application, and resumes after any reset
+	//*	but an external one, which is how avrdude asks for the UART bootloader.
+	//*	Until it commits, page 0 is erased and the later pages may be half
+	//*	written, so the application is not started: the bootloader waits for
+	//*	avrdude and tries the update again each time the wait times out.
+	appPresent	=	espbootStart(mcuStatusReg);
+#endif
 	// check if WDT generated the reset, if so, go straight to app
-	if (mcuStatusReg & _BV(WDRF))
+	if ((mcuStatusReg & _BV(WDRF)) && appPresent)
 	{
 		app_start();
 	}
@@ -647,6 +758,14 @@ int main(void)
 			if (boot_timer > boot_timeout)
 			{
 				boot_state	=	1; // (after ++ -> boot_state=2 bootloader timeout, jump to main 0x00000 )
+			#ifdef ENABLE_ESP32_UPDATE
+				//*	nothing to jump to while an update is pending: retry it, or keep waiting
+				if (!espbootStart(0))
+				{
+					boot_timer	=	0;
+					boot_state	=	0;
+				}
+			#endif
 			}
 		#ifdef BLINK_LED_WHILE_WAITING
 			if ((boot_timer % _BLINK_LOOP_COUNT_) == 0)
@@ -965,7 +1084,6 @@ int main(void)
 					break;
 	#endif
 				case CMD_CHIP_ERASE_ISP:
-					eraseAddress	=	0;
 					msgLength		=	2;
 				//	msgBuffer[1]	=	STATUS_CMD_OK;
 					msgBuffer[1]	=	STATUS_CMD_FAILED;	//*	isue 543, return FAILED instead of OK
@@ -994,11 +1112,12 @@ int main(void)
 						if ( msgBuffer[0] == CMD_PROGRAM_FLASH_ISP )
 						{
 							// erase only main section (bootloader protection)
-							if (eraseAddress < APP_END )
+							//*	erase the page being written rather than the next in order,
+							//*	so an uploader can skip pages that are already right
+							if (tempaddress < APP_END )
 							{
-								boot_page_erase(eraseAddress);	// Perform page erase
+								boot_page_erase(tempaddress);	// Perform page erase
 								boot_spm_busy_wait();		// Wait until the memory is erased.
-								eraseAddress += SPM_PAGESIZE;	// point to next page to be erase
 							}
 
 							/* Write FLASH */
@@ -1076,6 +1195,72 @@ int main(void)
 					}
 					break;
 
+	#ifndef REMOVE_FEH_FAST_UPLOAD
+			#if UART_BAUDRATE_DOUBLE_SPEED
+				//*	msgBuffer[1..4] = baud rate, MSB first. The answer goes out at the old
+				//*	rate and the UART switches once it is sent; the next message must come
+				//*	at the new rate. Reset returns to BAUDRATE.
+				case CMD_FEH_SET_BAUD:
+					{
+						uint32_t	baud	=	((uint32_t)msgBuffer[1]<<24)|((uint32_t)msgBuffer[2]<<16)|((uint32_t)msgBuffer[3]<<8)|msgBuffer[4];
+						uint32_t	select	=	0x100;
+
+						if ((baud != 0) && (baud <= (F_CPU / 8)))
+						{
+							select	=	(F_CPU / 4 / baud - 1) / 2;
+						}
+						msgLength	=	2;
+						if (select < 0x100)
+						{
+							newBaudSelect	=	select + 1;	//*	0 means no change
+							msgBuffer[1]	=	STATUS_CMD_OK;
+						}
+						else
+						{
+							msgBuffer[1]	=	STATUS_CMD_FAILED;
+						}
+					}
+					break;
+			#endif
+
+				//*	msgBuffer[1] = number of flash pages from the address set by
+				//*	CMD_LOAD_ADDRESS, at most 128. Answers the CRC-16 of each page
+				//*	(_crc16_update, start 0xFFFF, LSB first) and advances the address.
+				case CMD_FEH_PAGE_CRC:
+					{
+						unsigned char	pages	=	msgBuffer[1];
+						unsigned char	*p		=	msgBuffer+1;
+						unsigned int	size;
+						uint16_t		crc;
+
+						if ((pages == 0) || (pages > 128))
+						{
+							msgLength		=	2;
+							msgBuffer[1]	=	STATUS_CMD_FAILED;
+							break;
+						}
+						msgLength	=	(2 * pages) + 3;
+						*p++		=	STATUS_CMD_OK;
+						while (pages--)
+						{
+							crc		=	0xFFFF;
+							size	=	SPM_PAGESIZE;
+							do {
+						#if (FLASHEND > 0x10000)
+								crc	=	_crc16_update(crc, pgm_read_byte_far(address));
+						#else
+								crc	=	_crc16_update(crc, pgm_read_byte_near(address));
+						#endif
+								address++;
+							} while (--size);
+							*p++	=	(unsigned char)crc;			//LSB
+							*p++	=	(unsigned char)(crc >> 8);	//MSB
+						}
+						*p++	=	STATUS_CMD_OK;
+					}
+					break;
+	#endif
+
 				default:
 					msgLength		=	2;
 					msgBuffer[1]	=	STATUS_CMD_FAILED;
@@ -1112,6 +1297,16 @@ int main(void)
 			}
 			sendchar(checksum);
 			seqNum++;
+
+		#if !defined(REMOVE_FEH_FAST_UPLOAD) && UART_BAUDRATE_DOUBLE_SPEED
+			//*	sendchar() waits for each byte to leave, so the answer is out
+			if (newBaudSelect)
+			{
+				UART_BAUD_RATE_LOW	=	newBaudSelect - 1;
+				UART_STATUS_REG		|=	(1 << UART_DOUBLE_SPEED);
+				newBaudSelect		=	0;
+			}
+		#endif
 	
 		#ifndef REMOVE_BOOTLOADER_LED
 			//*	<MLS>	toggle the LED
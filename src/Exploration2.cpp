@@ -101,9 +101,9 @@ void ERCMain()
                 boolean turnState = true;
             }
             LCD.WriteLine("Something is going wrong. Looking for line...");
-            LCD.WriteLine("Left Optosensor Value:" + String(left_opto.Value()));
-            LCD.WriteLine("Middle Optosensor Value:" + String(middle_opto.Value()));
-            LCD.WriteLine("Right Optosensor Value:" + String(right_opto.Value()));
+            LCD.WriteLinef("Left Optosensor Value:%.2f", left_opto.Value());
+            LCD.WriteLinef("Middle Optosensor Value:%.2f", middle_opto.Value());
+            LCD.WriteLinef("Right Optosensor Value:%.2f", right_opto.Value());
             LCD.Clear(BLACK);
         }
         Sleep(0.1);